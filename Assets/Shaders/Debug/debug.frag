@@ -0,0 +1,8 @@
+#version 450
+
+layout (location = 0) out vec4 outFragColor;
+
+void main() 
+{
+	outFragColor = vec4(0.0, 1.0, 0.0, 1.0);
+}
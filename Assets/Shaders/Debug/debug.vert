@@ -0,0 +1,25 @@
+#version 450
+
+// Only the position is used, so this reads both Vertex and PackedVertex. See @Vertex.h
+layout(location = 0) in vec4 inPos;
+
+layout (binding = 0) uniform UBO 
+{
+	mat4 projection;
+	mat4 model;
+	vec4 posOffset;
+	vec4 posScale;
+} ubo;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+void main() 
+{
+	// Packed positions are unorm inside the mesh's bounding box, full ones have an offset of 0 and a scale of 1
+	vec3 pos = ubo.posOffset.xyz + inPos.xyz * ubo.posScale.xyz;
+
+	gl_Position = ubo.projection * ubo.model * vec4(pos, 1.0);
+}
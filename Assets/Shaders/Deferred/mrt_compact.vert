@@ -0,0 +1,59 @@
+#version 450
+
+// Packed vertex bindings, see PackedVertex in @Vertex.h
+layout(location = 0) in vec4 inPos;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec2 inTangent;
+layout(location = 3) in vec2 inNormal;
+layout(location = 4) in vec2 inUV;
+
+layout (binding = 0) uniform UBO 
+{
+	mat4 projection;
+	mat4 model;
+	mat4 view;
+	vec3 objPos;
+	vec4 posOffset;
+	vec4 posScale;
+} ubo;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec2 outUV;
+layout (location = 2) out vec3 outColor;
+layout (location = 3) out vec3 outWorldPos;
+layout (location = 4) out vec3 outTangent;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+// Octahedral decode, matches VertexPacking::OctDecode
+vec3 OctDecode(vec2 oct)
+{
+	vec3 dir = vec3(oct.xy, 1.0 - abs(oct.x) - abs(oct.y));
+	if (dir.z < 0.0)
+	{
+		dir.xy = (1.0 - abs(dir.yx)) * vec2(dir.x >= 0.0 ? 1.0 : -1.0, dir.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(dir);
+}
+
+void main() 
+{
+	// GL UV Coords to Vulkan coord space
+	outUV = inUV;
+	outUV.t = 1.0 - outUV.t;
+	
+	// Currently just vertex color
+	outColor = inColor.rgb;
+	
+	// Positions are unorm inside the mesh's bounding box
+	vec3 pos = ubo.posOffset.xyz + inPos.xyz * ubo.posScale.xyz;
+
+	outWorldPos = (ubo.model * vec4(pos, 1.0)).rgb;
+	outNormal = mat3(ubo.model) * OctDecode(inNormal);
+
+	gl_Position =  ubo.projection * ubo.view * vec4(outWorldPos, 1.0);
+	outTangent = normalize( OctDecode(inTangent) * mat3(ubo.model) );
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "NonCopyable.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Fling
+{
+	/** How a BatchFileReader gets the data off of the disk */
+	enum class FileReadBackend : uint8
+	{
+		/** io_uring if the kernel has it, the thread pool otherwise */
+		Auto,
+
+		/** Every read goes to the kernel in one io_uring submission. Linux only */
+		IoUring,
+
+		/** Blocking reads shared out over the job system */
+		ThreadPool
+	};
+
+	/** Parse "Auto", "IoUring" or "ThreadPool", Auto if it is none of them */
+	FileReadBackend ParseFileReadBackend(const std::string& t_Name);
+
+	const char* GetFileReadBackendName(FileReadBackend t_Backend);
+
+	/**
+	 * Reads lots of whole files at once. Every file is opened and sized up front, then all of the
+	 * reads are handed to the kernel together and the completions drained, instead of one
+	 * blocking read after another. With io_uring that is a single system call for the whole batch
+	 * (as long as it fits in the queue), otherwise the job system's workers share the reads.
+	 *
+	 * Reads bypass the page cache (O_DIRECT) where the file system allows it, so they go
+	 * straight into buffers aligned to DirectIOAlignment. The buffers can either be allocated by
+	 * the reader, or passed in with the read so that the data lands right where it will be used
+	 * (i.e. a mapped staging buffer that the GPU upload reads from).
+	 *
+	 * io_uring is only compiled in with WITH_IO_URING. The ring is set up once, so keep a reader
+	 * around instead of making one for every batch. Not thread safe, use one reader per thread.
+	 */
+	class BatchFileReader : public NonCopyable
+	{
+	public:
+
+		/** Buffers for direct reads have to be aligned to this, and are rounded up to a multiple of it */
+		static constexpr size_t DirectIOAlignment = 4096;
+
+		/** Most reads that are in flight at once */
+		static constexpr uint32 DefaultQueueDepth = 128;
+
+		/** What happened to one file */
+		struct Result
+		{
+			bool bSuccess = false;
+
+			/** The contents of the file, DirectIOAlignment aligned */
+			const char* Data = nullptr;
+
+			uint64 Size = 0;
+		};
+
+		/**
+		 * @param t_Backend		Falls back to the thread pool if io_uring is asked for but isn't available
+		 */
+		explicit BatchFileReader(FileReadBackend t_Backend = FileReadBackend::Auto, uint32 t_QueueDepth = DefaultQueueDepth);
+
+		virtual ~BatchFileReader();
+
+		/** The backend that is actually being used, never Auto */
+		inline FileReadBackend GetBackend() const { return m_Backend; }
+
+		/** Size that a buffer has to be to read a file of t_FileSize into it */
+		static inline size_t GetBufferSize(uint64 t_FileSize)
+		{
+			return static_cast<size_t>((t_FileSize + DirectIOAlignment - 1) & ~static_cast<uint64>(DirectIOAlignment - 1));
+		}
+
+		/**
+		 * Add a file to the next ReadAll
+		 *
+		 * @param t_Path			Full path to the file
+		 * @param t_Dest			Optional buffer to read into. Must be DirectIOAlignment aligned and at least GetBufferSize(file size) bytes
+		 * @param t_DestCapacity	Size of t_Dest. The read fails if the file doesn't fit
+		 * @return Index of the read, to pass to GetResult
+		 */
+		size_t Add(const std::string& t_Path, void* t_Dest = nullptr, size_t t_DestCapacity = 0);
+
+		inline size_t GetNumReads() const { return m_Reads.size(); }
+
+		/**
+		 * Read every file that was added since the last ReadAll, blocking until they are all done
+		 *
+		 * @return Number of those files that were read successfully
+		 */
+		size_t ReadAll();
+
+		inline const Result& GetResult(size_t t_Index) const { return m_Reads[t_Index].Out; }
+
+		/**
+		 * Take ownership of the buffer that the reader allocated for a read. The result's data
+		 * stays where it is. nullptr if the read was into a buffer that was passed in.
+		 */
+		std::shared_ptr<char> TakeBuffer(size_t t_Index);
+
+		/** Forget every read and free the buffers that haven't been taken */
+		void Clear();
+
+	private:
+
+		struct Read
+		{
+			std::string Path;
+			void* Dest = nullptr;
+			size_t DestCapacity = 0;
+
+			std::shared_ptr<char> OwnedBuffer;
+
+			/** Platform file handle, or -1 */
+			intptr_t File = -1;
+			bool bDirect = false;
+
+			/** Set once ReadAll has tried it, so that the next ReadAll only reads what was added since */
+			bool bDone = false;
+
+			Result Out;
+		};
+
+		/** Open the file, get its size and find somewhere to read it to */
+		bool Prepare(Read& t_Read);
+
+		/** Read the file with blocking reads, starting t_Offset bytes in */
+		static bool ReadBlocking(Read& t_Read, uint64 t_Offset);
+
+		static void CloseFile(Read& t_Read);
+
+		void ReadAllThreadPool(std::vector<Read*>& t_Reads);
+
+#if FLING_LINUX
+
+		bool InitIoUring(uint32 t_QueueDepth);
+		void ShutdownIoUring();
+		void ReadAllIoUring(std::vector<Read*>& t_Reads);
+
+		/** io_uring submission and completion rings, mapped from the kernel */
+		struct IoUring;
+		std::unique_ptr<IoUring> m_Ring;
+
+#endif
+
+		std::vector<Read> m_Reads;
+
+		FileReadBackend m_Backend = FileReadBackend::ThreadPool;
+
+		uint32 m_QueueDepth = DefaultQueueDepth;
+	};
+}   // namespace Fling
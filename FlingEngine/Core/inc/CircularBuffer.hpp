@@ -8,6 +8,7 @@ namespace Fling
 	/**
 	 * A simple circular buffer that will allow you get the next element in a buffer
 	 *			It does not ensure that the item is not in use, but simply loops around.
+	 *			Use SpscQueue or MpmcQueue to pass items between threads.
 	 * 
 	 * @tparam T 		the type inside this circular buffer. Stack allocated
 	 * @tparam t_Size 	The max size of this buffer, must be a power of 2!
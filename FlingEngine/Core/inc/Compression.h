@@ -0,0 +1,42 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+namespace Fling
+{
+	/**
+	 * A small LZ77 codec for asset data, laid out like an LZ4 block. Compression is a single greedy
+	 * pass with a hash table of recent positions, so it is quick but doesn't squeeze out every byte.
+	 * Decompression is a tight copy loop that checks every read and write against the buffers it
+	 * is given, so corrupt data fails instead of running off the end.
+	 *
+	 * Every sequence is a token byte (literal count in the high 4 bits, match length - 4 in the low 4
+	 * bits), any extra length bytes for the literals, the literals, a 16 bit offset back to the match
+	 * and any extra length bytes for the match. The last sequence is only literals.
+	 */
+	namespace Compression
+	{
+		/** Biggest that Compress can make t_SrcSize bytes of data that doesn't compress at all */
+		inline size_t GetMaxCompressedSize(size_t t_SrcSize)
+		{
+			return t_SrcSize + (t_SrcSize / 255) + 16;
+		}
+
+		/**
+		 * Compress a block of memory
+		 *
+		 * @param t_Dst			Where to write the compressed data
+		 * @param t_DstCapacity	Size of t_Dst, should be at least GetMaxCompressedSize(t_SrcSize)
+		 * @return Number of bytes written, or 0 if t_Dst is too small
+		 */
+		size_t Compress(const void* t_Src, size_t t_SrcSize, void* t_Dst, size_t t_DstCapacity);
+
+		/**
+		 * Decompress a block that was made with Compress
+		 *
+		 * @param t_DstSize		Exact size of the data before it was compressed
+		 * @return False if the data is corrupt or doesn't decompress to exactly t_DstSize bytes
+		 */
+		bool Decompress(const void* t_Src, size_t t_SrcSize, void* t_Dst, size_t t_DstSize);
+	}
+}   // namespace Fling
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "Memory.h"
+#include "NonCopyable.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * A thread safe version of the PoolAllocator. Allocate and Free are lock-free, the free
+	 * list is a Treiber stack whose head pointer is tagged with a counter to avoid the ABA problem.
+	 * Growing the pool takes a lock, but that only happens when the pool has run dry.
+	 *
+	 * @tparam T 				The type of object that this pool allocates
+	 * @tparam t_ElmsPerChunk 	How many elements to allocate each time the pool grows
+	 *
+	 * @see https://en.wikipedia.org/wiki/ABA_problem#Tagged_state_reference
+	 */
+	template<typename T, size_t t_ElmsPerChunk = 64>
+	class ConcurrentPoolAllocator : public NonCopyable
+	{
+		static_assert(t_ElmsPerChunk > 0, "ConcurrentPoolAllocator::t_ElmsPerChunk must be greater than 0");
+		static_assert(sizeof(void*) == 8, "The tagged free list packs a 48 bit pointer and 16 bit tag into 64 bits");
+
+		/** Free elements are reused as a node in the free list */
+		struct FreeNode
+		{
+			std::atomic<FreeNode*> m_Next;
+		};
+
+	public:
+
+		static constexpr size_t ElementAlignment = std::max(alignof(T), alignof(FreeNode));
+
+		static constexpr size_t ElementSize =
+			((std::max(sizeof(T), sizeof(FreeNode)) + ElementAlignment - 1) / ElementAlignment) * ElementAlignment;
+
+		ConcurrentPoolAllocator() = default;
+
+		/** Frees every chunk of this pool. Everything allocated from it must have already been freed */
+		virtual ~ConcurrentPoolAllocator();
+
+		/** Get uninitialized memory for a single T, growing the pool if needed */
+		void* Allocate();
+
+		/** Give memory that was obtained with Allocate back to the pool */
+		void Free(void* t_Ptr);
+
+		/** Allocate and construct a T from this pool */
+		template<typename ...ARGS>
+		T* New(ARGS&&... t_Args);
+
+		/** Destruct a T that was created with New and give its memory back to the pool */
+		void Delete(T* t_Obj);
+
+		/** Total number of elements this pool can hold before it has to grow */
+		size_t GetCapacity() const;
+
+		/** Number of elements currently in use. This is only a snapshot if other threads are using the pool */
+		inline size_t GetNumAllocated() const { return m_NumAllocated.load(std::memory_order_relaxed); }
+
+	private:
+
+		static constexpr uint64 PointerBits = 48;
+		static constexpr uint64 PointerMask = (uint64(1) << PointerBits) - 1;
+
+		static inline uint64 Pack(FreeNode* t_Node, uint64 t_Tag)
+		{
+			return (reinterpret_cast<uint64>(t_Node) & PointerMask) | (t_Tag << PointerBits);
+		}
+
+		static inline FreeNode* GetNode(uint64 t_Tagged)
+		{
+			return reinterpret_cast<FreeNode*>(t_Tagged & PointerMask);
+		}
+
+		static inline uint64 GetTag(uint64 t_Tagged)
+		{
+			return t_Tagged >> PointerBits;
+		}
+
+		/** Push a linked list of nodes onto the free list */
+		void PushList(FreeNode* t_First, FreeNode* t_Last);
+
+		/** Allocate another chunk of memory and add all of its elements to the free list */
+		void Grow();
+
+		/** Head of the free list, the upper 16 bits are a tag that is incremented on every change */
+		alignas(64) std::atomic<uint64> m_Head { 0 };
+
+		alignas(64) std::atomic<size_t> m_NumAllocated { 0 };
+
+		/** Guards growing the pool */
+		mutable std::mutex m_ChunkMutex;
+
+		std::vector<void*> m_Chunks;
+	};
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline ConcurrentPoolAllocator<T, t_ElmsPerChunk>::~ConcurrentPoolAllocator()
+	{
+		assert(GetNumAllocated() == 0 && "A pool allocator was destroyed while some of its memory is still in use!");
+
+		for (void* Chunk : m_Chunks)
+		{
+			AlignedFree(Chunk);
+		}
+		m_Chunks.clear();
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline void* ConcurrentPoolAllocator<T, t_ElmsPerChunk>::Allocate()
+	{
+		uint64 Head = m_Head.load(std::memory_order_acquire);
+		while (true)
+		{
+			FreeNode* Node = GetNode(Head);
+			if (Node == nullptr)
+			{
+				Grow();
+				Head = m_Head.load(std::memory_order_acquire);
+				continue;
+			}
+
+			// Memory is never given back while the pool is alive, so reading this is safe even if
+			// another thread has popped the node already. The tag makes the CAS fail in that case
+			FreeNode* Next = Node->m_Next.load(std::memory_order_relaxed);
+			if (m_Head.compare_exchange_weak(Head, Pack(Next, GetTag(Head) + 1), std::memory_order_acquire, std::memory_order_acquire))
+			{
+				m_NumAllocated.fetch_add(1, std::memory_order_relaxed);
+				return Node;
+			}
+		}
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline void ConcurrentPoolAllocator<T, t_ElmsPerChunk>::Free(void* t_Ptr)
+	{
+		if (t_Ptr == nullptr)
+		{
+			return;
+		}
+
+		m_NumAllocated.fetch_sub(1, std::memory_order_relaxed);
+
+		FreeNode* Node = new (t_Ptr) FreeNode();
+		PushList(Node, Node);
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	template<typename ...ARGS>
+	inline T* ConcurrentPoolAllocator<T, t_ElmsPerChunk>::New(ARGS&&... t_Args)
+	{
+		return new (Allocate()) T(std::forward<ARGS>(t_Args)...);
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline void ConcurrentPoolAllocator<T, t_ElmsPerChunk>::Delete(T* t_Obj)
+	{
+		if (t_Obj == nullptr)
+		{
+			return;
+		}
+
+		t_Obj->~T();
+		Free(t_Obj);
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline size_t ConcurrentPoolAllocator<T, t_ElmsPerChunk>::GetCapacity() const
+	{
+		std::lock_guard<std::mutex> Lock(m_ChunkMutex);
+		return m_Chunks.size() * t_ElmsPerChunk;
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline void ConcurrentPoolAllocator<T, t_ElmsPerChunk>::PushList(FreeNode* t_First, FreeNode* t_Last)
+	{
+		uint64 Head = m_Head.load(std::memory_order_relaxed);
+		do
+		{
+			t_Last->m_Next.store(GetNode(Head), std::memory_order_relaxed);
+		}
+		while (!m_Head.compare_exchange_weak(Head, Pack(t_First, GetTag(Head) + 1), std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline void ConcurrentPoolAllocator<T, t_ElmsPerChunk>::Grow()
+	{
+		std::lock_guard<std::mutex> Lock(m_ChunkMutex);
+
+		// Another thread may have grown the pool while we were waiting for the lock
+		if (GetNode(m_Head.load(std::memory_order_acquire)) != nullptr)
+		{
+			return;
+		}
+
+		char* Chunk = static_cast<char*>(AlignedAlloc(ElementSize * t_ElmsPerChunk, ElementAlignment));
+		if (Chunk == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		assert((reinterpret_cast<uint64>(Chunk) & ~PointerMask) == 0 && "Pointer does not fit in 48 bits");
+		m_Chunks.push_back(Chunk);
+
+		// Link the whole chunk together before publishing it so that we only need one CAS
+		FreeNode* First = new (Chunk) FreeNode();
+		FreeNode* Prev = First;
+		for (size_t i = 1; i < t_ElmsPerChunk; ++i)
+		{
+			FreeNode* Node = new (Chunk + i * ElementSize) FreeNode();
+			Prev->m_Next.store(Node, std::memory_order_relaxed);
+			Prev = Node;
+		}
+
+		PushList(First, Prev);
+	}
+}   // namespace Fling
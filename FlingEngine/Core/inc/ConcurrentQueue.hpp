@@ -0,0 +1,279 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+namespace Fling
+{
+	/**
+	 * A bounded, lock-free single producer single consumer ring queue. Like the CircularBuffer
+	 * it wraps around a fixed array, but it never hands out a slot that is still in use.
+	 *
+	 * Exactly one thread may push and exactly one (other) thread may pop. Each side keeps a
+	 * cached copy of the other side's index so that it only touches the shared cache line
+	 * when the queue looks full or empty.
+	 *
+	 * @tparam T 			Type stored in the queue, must be default constructible and movable
+	 * @tparam t_NumElms 	The max size of this queue, must be a power of 2!
+	 */
+	template<typename T, size_t t_NumElms>
+	class SpscQueue
+	{
+		static_assert((t_NumElms != 0 && (t_NumElms & (t_NumElms - 1)) == 0), "SpscQueue::t_NumElms must be a power of 2!");
+		static_assert(std::is_default_constructible<T>::value, "SpscQueue items must be default constructible");
+
+	public:
+
+		SpscQueue() = default;
+		~SpscQueue() = default;
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		/**
+		 * Push an item onto the back of the queue. Only call this from the producer thread.
+		 *
+		 * @return False if the queue is full
+		 */
+		template<typename U>
+		bool TryPush(U&& t_Item);
+
+		/**
+		 * Pop an item off the front of the queue. Only call this from the consumer thread.
+		 *
+		 * @param t_OutItem		Set to the popped item if there was one
+		 * @return False if the queue is empty
+		 */
+		bool TryPop(T& t_OutItem);
+
+		/** Approximate number of items in the queue. Only exact when both sides are idle. */
+		size_t Size() const
+		{
+			const size_t Tail = m_Tail.load(std::memory_order_acquire);
+			const size_t Head = m_Head.load(std::memory_order_acquire);
+			return Tail - Head;
+		}
+
+		inline bool Empty() const { return Size() == 0; }
+
+		static constexpr size_t Capacity() { return t_NumElms; }
+
+	private:
+
+		static constexpr size_t Mask = t_NumElms - 1;
+
+		/** Next slot to write to, only written by the producer */
+		alignas(64) std::atomic<size_t> m_Tail { 0 };
+
+		/** The producer's last look at m_Head */
+		size_t m_CachedHead = 0;
+
+		/** Next slot to read from, only written by the consumer */
+		alignas(64) std::atomic<size_t> m_Head { 0 };
+
+		/** The consumer's last look at m_Tail */
+		size_t m_CachedTail = 0;
+
+		alignas(64) T m_Items[t_NumElms] {};
+	};
+
+	template<typename T, size_t t_NumElms>
+	template<typename U>
+	inline bool SpscQueue<T, t_NumElms>::TryPush(U&& t_Item)
+	{
+		const size_t Tail = m_Tail.load(std::memory_order_relaxed);
+		if (Tail - m_CachedHead >= t_NumElms)
+		{
+			// Looks full, see if the consumer has made some room since we last checked
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+			if (Tail - m_CachedHead >= t_NumElms)
+			{
+				return false;
+			}
+		}
+
+		m_Items[Tail & Mask] = std::forward<U>(t_Item);
+		m_Tail.store(Tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<typename T, size_t t_NumElms>
+	inline bool SpscQueue<T, t_NumElms>::TryPop(T& t_OutItem)
+	{
+		const size_t Head = m_Head.load(std::memory_order_relaxed);
+		if (Head == m_CachedTail)
+		{
+			m_CachedTail = m_Tail.load(std::memory_order_acquire);
+			if (Head == m_CachedTail)
+			{
+				return false;
+			}
+		}
+
+		t_OutItem = std::move(m_Items[Head & Mask]);
+		m_Head.store(Head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * A bounded, lock-free multi producer multi consumer ring queue. Any thread may push or pop.
+	 *
+	 * Every slot has a sequence number that says whose turn it is to use it. A producer claims
+	 * a slot by bumping the tail only when the slot's sequence says it is free, writes the item,
+	 * and then publishes it by bumping the sequence. Consumers do the same thing on the head.
+	 * Threads never wait on each other with a lock, but a push or pop can briefly spin while
+	 * another thread is in the middle of writing or reading the slot it wants.
+	 *
+	 * @tparam T 			Type stored in the queue, must be default constructible and movable
+	 * @tparam t_NumElms 	The max size of this queue, must be a power of 2!
+	 *
+	 * @see https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+	 */
+	template<typename T, size_t t_NumElms>
+	class MpmcQueue
+	{
+		static_assert((t_NumElms >= 2 && (t_NumElms & (t_NumElms - 1)) == 0), "MpmcQueue::t_NumElms must be a power of 2 and at least 2!");
+		static_assert(std::is_default_constructible<T>::value, "MpmcQueue items must be default constructible");
+
+	public:
+
+		MpmcQueue()
+		{
+			for (size_t i = 0; i < t_NumElms; ++i)
+			{
+				m_Cells[i].m_Sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		~MpmcQueue() = default;
+
+		MpmcQueue(const MpmcQueue&) = delete;
+		MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+		/**
+		 * Push an item onto the back of the queue. Safe to call from any thread.
+		 *
+		 * @return False if the queue is full
+		 */
+		template<typename U>
+		bool TryPush(U&& t_Item);
+
+		/**
+		 * Pop an item off the front of the queue. Safe to call from any thread.
+		 *
+		 * @param t_OutItem		Set to the popped item if there was one
+		 * @return False if the queue is empty
+		 */
+		bool TryPop(T& t_OutItem);
+
+		/** Approximate number of items in the queue. Only exact when no other thread is using it. */
+		size_t Size() const
+		{
+			const size_t Tail = m_Tail.load(std::memory_order_acquire);
+			const size_t Head = m_Head.load(std::memory_order_acquire);
+			return Tail >= Head ? Tail - Head : 0;
+		}
+
+		inline bool Empty() const { return Size() == 0; }
+
+		static constexpr size_t Capacity() { return t_NumElms; }
+
+	private:
+
+		static constexpr size_t Mask = t_NumElms - 1;
+
+		struct Cell
+		{
+			/**
+			 * Equal to the position when the slot is free for a producer at that position,
+			 * and position + 1 when it holds an item for the consumer at that position.
+			 */
+			std::atomic<size_t> m_Sequence { 0 };
+			T m_Item {};
+		};
+
+		alignas(64) Cell m_Cells[t_NumElms];
+
+		/** Producers and consumers live on separate cache lines so that they don't thrash each other */
+		alignas(64) std::atomic<size_t> m_Tail { 0 };
+		alignas(64) std::atomic<size_t> m_Head { 0 };
+	};
+
+	template<typename T, size_t t_NumElms>
+	template<typename U>
+	inline bool MpmcQueue<T, t_NumElms>::TryPush(U&& t_Item)
+	{
+		Cell* Target = nullptr;
+		size_t Pos = m_Tail.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Target = &m_Cells[Pos & Mask];
+			const size_t Seq = Target->m_Sequence.load(std::memory_order_acquire);
+			const intptr_t Diff = static_cast<intptr_t>(Seq) - static_cast<intptr_t>(Pos);
+
+			if (Diff == 0)
+			{
+				// The slot is free, try and claim it
+				if (m_Tail.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (Diff < 0)
+			{
+				// The consumer from one lap ago hasn't taken this item yet, so we are full
+				return false;
+			}
+			else
+			{
+				// Another producer beat us to this slot
+				Pos = m_Tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		Target->m_Item = std::forward<U>(t_Item);
+		Target->m_Sequence.store(Pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<typename T, size_t t_NumElms>
+	inline bool MpmcQueue<T, t_NumElms>::TryPop(T& t_OutItem)
+	{
+		Cell* Target = nullptr;
+		size_t Pos = m_Head.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Target = &m_Cells[Pos & Mask];
+			const size_t Seq = Target->m_Sequence.load(std::memory_order_acquire);
+			const intptr_t Diff = static_cast<intptr_t>(Seq) - static_cast<intptr_t>(Pos + 1);
+
+			if (Diff == 0)
+			{
+				// There is an item here, try and claim it
+				if (m_Head.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (Diff < 0)
+			{
+				// Nothing has been published to this slot yet, so we are empty
+				return false;
+			}
+			else
+			{
+				// Another consumer beat us to this slot
+				Pos = m_Head.load(std::memory_order_relaxed);
+			}
+		}
+
+		t_OutItem = std::move(Target->m_Item);
+
+		// Free the slot up for the producer one lap ahead
+		Target->m_Sequence.store(Pos + t_NumElms, std::memory_order_release);
+		return true;
+	}
+}   // namespace Fling
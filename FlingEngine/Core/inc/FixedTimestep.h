@@ -0,0 +1,67 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+namespace Fling
+{
+	/**
+	 * Accumulator for running a simulation at a fixed rate regardless of the frame rate.
+	 * Every frame, pass the frame's delta time to Advance and run that many simulation steps.
+	 * Whatever time is left over is exposed as an interpolation alpha between the last two
+	 * simulation states so that rendering can be smooth at any frame rate.
+	 *
+	 * To avoid the "spiral of death" (a slow step causing more steps next frame, which are
+	 * even slower) only t_MaxStepsPerFrame steps are ever run in one frame and any time past
+	 * that is thrown out, which makes the simulation run slower instead of falling further behind.
+	 *
+	 * @see https://gafferongames.com/post/fix_your_timestep/
+	 */
+	class FixedTimestep
+	{
+	public:
+
+		/**
+		 * @param t_StepRate			Number of simulation steps per second
+		 * @param t_MaxStepsPerFrame	Max number of steps that can be run in one frame to catch up
+		 */
+		explicit FixedTimestep(float t_StepRate = 60.0f, uint32 t_MaxStepsPerFrame = 5);
+
+		/**
+		 * Add a frame's worth of time to the accumulator.
+		 *
+		 * @param t_FrameTime	Time since the last frame, in seconds
+		 * @return Number of simulation steps that should be run this frame
+		 */
+		uint32 Advance(float t_FrameTime);
+
+		/** How far between the previous and current simulation state we are, from 0 to 1 */
+		inline float GetAlpha() const { return static_cast<float>(m_Accumulator / m_StepSize); }
+
+		/** Length of a single simulation step, in seconds */
+		inline float GetStepSize() const { return static_cast<float>(m_StepSize); }
+
+		inline uint32 GetMaxStepsPerFrame() const { return m_MaxStepsPerFrame; }
+
+		/** Total number of steps that Advance has asked for */
+		inline uint64 GetTotalSteps() const { return m_TotalSteps; }
+
+		/** Total simulation time that was thrown out because we could not keep up, in seconds */
+		inline double GetDroppedTime() const { return m_DroppedTime; }
+
+		/** Throw away any accumulated time */
+		inline void Reset() { m_Accumulator = 0.0; }
+
+	private:
+
+		double m_StepSize = 1.0 / 60.0;
+
+		/** Time that has not been simulated yet. Double so that it doesn't drift over long sessions */
+		double m_Accumulator = 0.0;
+
+		double m_DroppedTime = 0.0;
+
+		uint64 m_TotalSteps = 0;
+
+		uint32 m_MaxStepsPerFrame = 5;
+	};
+}   // namespace Fling
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Singleton.hpp"
+#include "FlingTypes.h"
+
+#include <atomic>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * Linear allocator for transient data that only has to live for the current frame.
+	 * There is one block of memory per buffered frame with an atomic offset into it, and the
+	 * engine resets the oldest one at the start of every frame. This means that memory allocated during frame N is valid
+	 * until the start of frame N + NumBufferedFrames.
+	 *
+	 * If a frame runs out of space then allocations fall back to the heap and a warning is logged,
+	 * the size can be increased with the "FrameAllocatorSize" command line/console variable (in bytes).
+	 */
+	class FrameAllocator : public Singleton<FrameAllocator>
+	{
+	public:
+
+		/** How many frames worth of memory we keep around */
+		static constexpr uint32 NumBufferedFrames = 2;
+
+		/** Default size of each frame's memory, in bytes */
+		static constexpr size_t DefaultFrameSize = 1024 * 1024;
+
+		virtual void Init() override;
+
+		virtual void Shutdown() override;
+
+		/** Move on to the next frame's memory, anything allocated from it in the past is now invalid */
+		void BeginFrame();
+
+		/**
+		 * Allocate some memory that will be valid until this frame's memory is reset.
+		 * Safe to call from any thread, it only bumps an atomic offset and never takes a lock.
+		 *
+		 * @param t_Size		Size of the allocation in bytes
+		 * @param t_Alignment	Alignment of the allocation, must be a power of 2 (Default = 8)
+		 */
+		void* Allocate(size_t t_Size, size_t t_Alignment = 8);
+
+		/**
+		 * Memory from the frame allocator is freed all at once when it is reset, so this only
+		 * does anything for allocations that had to fall back to the heap.
+		 */
+		void Free(void* t_Ptr);
+
+		/** Bytes used by the current frame so far */
+		size_t GetCurrentFrameUsage() const;
+
+		/** Number of allocations that did not fit in the frame allocator and went to the heap instead */
+		inline uint64 GetHeapFallbackCount() const { return m_HeapFallbackCount.load(std::memory_order_relaxed); }
+
+		/** True if the given pointer is inside of the memory owned by this allocator */
+		bool Owns(const void* t_Ptr) const;
+
+	private:
+
+		/** Bytes used by each frame, allocating moves it up with a compare and swap */
+		std::atomic<size_t> m_FrameOffsets[NumBufferedFrames] = {};
+
+		/** One block of memory that is split up between each frame */
+		char* m_Memory = nullptr;
+
+		size_t m_FrameSize = 0;
+
+		std::atomic<uint32> m_CurrentFrame { 0 };
+
+		std::atomic<uint64> m_HeapFallbackCount { 0 };
+	};
+
+	/**
+	 * STL compatible allocator that gets its memory from the FrameAllocator.
+	 * Containers using this must not live past the frame they were created in.
+	 */
+	template<typename T>
+	struct FrameStlAllocator
+	{
+		typedef T value_type;
+
+		FrameStlAllocator() noexcept = default;
+
+		template<typename U>
+		FrameStlAllocator(const FrameStlAllocator<U>&) noexcept {}
+
+		T* allocate(size_t t_Count)
+		{
+			return static_cast<T*>(FrameAllocator::Get().Allocate(t_Count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* t_Ptr, size_t) noexcept
+		{
+			FrameAllocator::Get().Free(t_Ptr);
+		}
+
+		template<typename U>
+		bool operator==(const FrameStlAllocator<U>&) const noexcept { return true; }
+
+		template<typename U>
+		bool operator!=(const FrameStlAllocator<U>&) const noexcept { return false; }
+	};
+
+	/** A vector for temporary per-frame data that never touches the heap */
+	template<typename T>
+	using ScratchVector = std::vector<T, FrameStlAllocator<T>>;
+}   // namespace Fling
@@ -18,6 +18,11 @@ namespace Fling
     {
     public:
 
+        /**
+         * Create an empty free list. Memory can be added to it later with Return.
+         */
+        FreeList() = default;
+
         /**
          * Create a free list over the given memory region for fixed-size elements.
          *
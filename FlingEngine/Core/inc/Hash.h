@@ -0,0 +1,28 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+namespace Fling
+{
+	/**
+	 * Spread the bits of a 32 bit hash out so that similar keys land in different buckets.
+	 * Guid_Handles are FNV hashes of similar looking paths, so mix them before masking off the low bits.
+	 */
+	inline uint32 MixHash32(uint32 t_Hash)
+	{
+		t_Hash ^= t_Hash >> 16;
+		t_Hash *= 0x7FEB352Du;
+		t_Hash ^= t_Hash >> 15;
+		t_Hash *= 0x846CA68Bu;
+		t_Hash ^= t_Hash >> 16;
+		return t_Hash;
+	}
+
+	/**
+	 * 64 bit hash of a block of memory (xxHash64). Fast enough to checksum whole assets as they
+	 * are loaded, but it only catches corruption and stale data, it isn't cryptographic.
+	 *
+	 * @see https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+	 */
+	uint64 HashBytes64(const void* t_Data, size_t t_Size, uint64 t_Seed = 0);
+}   // namespace Fling
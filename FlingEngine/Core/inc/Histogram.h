@@ -0,0 +1,184 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+#include <ostream>
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
+namespace Fling
+{
+	/**
+	 * A fixed size histogram with log scale buckets, in the style of an HDR histogram.
+	 * Every power of two range is split into SubBucketCount linear buckets, so any recorded
+	 * value is off by at most 1 / SubBucketCount (~3%) no matter how big it is.
+	 *
+	 * Recording is O(1) and never allocates, which makes this cheap enough to use every frame.
+	 * Values are unit-less, but the engine uses microseconds for anything time related.
+	 *
+	 * @see http://hdrhistogram.org/
+	 */
+	class Histogram
+	{
+	public:
+
+		/** Number of bits of precision we keep for each value */
+		static constexpr uint32 SubBucketBits = 5;
+		static constexpr uint32 SubBucketCount = 1u << SubBucketBits;
+
+		/** Anything above MaxTrackableValue goes into a single overflow bucket (~67 seconds in microseconds) */
+		static constexpr uint32 MaxValueBits = 26;
+		static constexpr uint64 MaxTrackableValue = (uint64(1) << MaxValueBits) - 1;
+
+		/** Every power of two range gets SubBucketCount buckets, plus one for overflow */
+		static constexpr uint32 NumBuckets = (MaxValueBits - SubBucketBits + 1) * SubBucketCount + 1;
+
+		Histogram() { Reset(); }
+
+		/** Add a value to the histogram */
+		inline void Record(uint64 t_Value)
+		{
+			++m_Buckets[GetBucketIndex(t_Value)];
+			++m_Count;
+			m_Sum += t_Value;
+			m_Min = t_Value < m_Min ? t_Value : m_Min;
+			m_Max = t_Value > m_Max ? t_Value : m_Max;
+		}
+
+		/** Remove every recorded value */
+		void Reset();
+
+		/** Add every value that was recorded in another histogram to this one */
+		void Add(const Histogram& t_Other);
+
+		/**
+		 * Get the value that the given percent of recorded values are at or below.
+		 * This is the upper bound of the bucket that the percentile lands in, so it may be
+		 * slightly higher than the real value.
+		 *
+		 * @param t_Percentile		Percentile to get, from 0 to 100
+		 * @return The percentile value, or 0 if nothing has been recorded
+		 */
+		uint64 GetPercentile(double t_Percentile) const;
+
+		inline uint64 GetCount() const { return m_Count; }
+		inline uint64 GetMin() const { return m_Count > 0 ? m_Min : 0; }
+		inline uint64 GetMax() const { return m_Max; }
+		inline double GetMean() const { return m_Count > 0 ? static_cast<double>(m_Sum) / static_cast<double>(m_Count) : 0.0; }
+
+		inline uint64 GetBucketCount(uint32 t_Index) const { return m_Buckets[t_Index]; }
+
+		/** Get what bucket a value would be recorded in */
+		static inline uint32 GetBucketIndex(uint64 t_Value)
+		{
+			if (t_Value > MaxTrackableValue)
+			{
+				return NumBuckets - 1;
+			}
+
+			if (t_Value < SubBucketCount)
+			{
+				return static_cast<uint32>(t_Value);
+			}
+
+			// The highest bit picks the power of two range, the next few bits pick a bucket inside of it
+			const uint32 Exponent = FloorLog2(t_Value);
+			const uint32 Shift = Exponent - SubBucketBits;
+			const uint32 Mantissa = static_cast<uint32>(t_Value >> Shift) - SubBucketCount;
+			return (Shift + 1) * SubBucketCount + Mantissa;
+		}
+
+		/** Smallest value that is recorded in the given bucket */
+		static uint64 GetBucketLowerBound(uint32 t_Index);
+
+		/** Largest value that is recorded in the given bucket */
+		static uint64 GetBucketUpperBound(uint32 t_Index);
+
+		/**
+		 * Write out the raw buckets as CSV lines of "Name,LowerBound,UpperBound,Count".
+		 * Empty buckets are skipped.
+		 */
+		void WriteCsv(std::ostream& t_Out, const char* t_Name) const;
+
+	private:
+
+		static inline uint32 FloorLog2(uint64 t_Value)
+		{
+#if defined(_MSC_VER)
+			unsigned long Index = 0;
+			_BitScanReverse64(&Index, t_Value);
+			return static_cast<uint32>(Index);
+#else
+			return 63u - static_cast<uint32>(__builtin_clzll(t_Value));
+#endif
+		}
+
+		uint64 m_Buckets[NumBuckets];
+
+		uint64 m_Count = 0;
+		uint64 m_Sum = 0;
+		uint64 m_Min = 0;
+		uint64 m_Max = 0;
+	};
+
+	/**
+	 * A histogram of the most recent values only. Time is split up into t_NumWindows windows,
+	 * calling Rotate starts a new window and throws out the oldest one. Recording stays O(1),
+	 * rotating re-adds the remaining windows, so only do it every so often (i.e. once a second).
+	 *
+	 * @tparam t_NumWindows		How many windows are kept around
+	 */
+	template<uint32 t_NumWindows>
+	class RollingHistogram
+	{
+		static_assert(t_NumWindows > 0, "RollingHistogram needs at least one window");
+
+	public:
+
+		inline void Record(uint64 t_Value)
+		{
+			m_Windows[m_CurrentWindow].Record(t_Value);
+			m_Combined.Record(t_Value);
+		}
+
+		/** Start a new window, forgetting about anything in the oldest one */
+		void Rotate()
+		{
+			m_CurrentWindow = (m_CurrentWindow + 1) % t_NumWindows;
+			m_Windows[m_CurrentWindow].Reset();
+
+			// Rebuild the combined histogram instead of subtracting so that min and max stay exact
+			m_Combined.Reset();
+			for (const Histogram& Window : m_Windows)
+			{
+				m_Combined.Add(Window);
+			}
+		}
+
+		void Reset()
+		{
+			for (Histogram& Window : m_Windows)
+			{
+				Window.Reset();
+			}
+			m_Combined.Reset();
+			m_CurrentWindow = 0;
+		}
+
+		/** Every value that was recorded over the last t_NumWindows windows */
+		inline const Histogram& GetCombined() const { return m_Combined; }
+
+		/** Only the values in the window that is being recorded to right now */
+		inline const Histogram& GetCurrentWindow() const { return m_Windows[m_CurrentWindow]; }
+
+	private:
+
+		Histogram m_Windows[t_NumWindows];
+
+		Histogram m_Combined;
+
+		uint32 m_CurrentWindow = 0;
+	};
+}   // namespace Fling
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "Singleton.hpp"
+#include "FlingTypes.h"
+#include "CircularBuffer.hpp"
+#include "WorkStealingQueue.hpp"
+#include "ConcurrentQueue.hpp"
+#include "FrameAllocator.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * Keeps track of how many jobs are still outstanding. Pass one to JobSystem::CreateJob
+	 * and then JobSystem::Wait on it, or use it as a dependency for another job.
+	 * A counter must outlive every job that references it.
+	 */
+	struct JobCounter
+	{
+		std::atomic<int32> m_Value { 0 };
+
+		inline bool IsDone() const { return m_Value.load(std::memory_order_acquire) == 0; }
+	};
+
+	/**
+	 * A single unit of work for the job system. Jobs are exactly one cache line and carry
+	 * their function arguments (usually a small lambda) inline, so creating one never allocates.
+	 * Every job that is created has to be passed to JobSystem::Run, or its slot is never freed.
+	 */
+	struct alignas(64) Job
+	{
+		typedef void (*JobFunction)(Job&);
+
+		static constexpr size_t PayloadSize = 32;
+
+		/** Inline storage for the data that this job needs, see JobSystem::CreateJob */
+		alignas(16) char m_Payload[PayloadSize];
+
+		JobFunction m_Function = nullptr;
+
+		/** Counter that is decremented once this job has finished. Can be null */
+		JobCounter* m_Counter = nullptr;
+
+		/** This job will not start until this counter has reached zero. Can be null */
+		const JobCounter* m_Dependency = nullptr;
+
+		/** False from when the job is created until it has run, so its slot isn't handed out again */
+		std::atomic<bool> m_bFinished { true };
+	};
+
+	static_assert(sizeof(Job) == 64, "A job should be exactly one cache line");
+
+	/**
+	 * Work stealing job system. Every worker thread (and the main thread) owns a lock-free
+	 * deque of jobs. Threads push and pop work from their own deque and steal from the other
+	 * threads when they run dry. The main thread is always worker 0 and helps execute jobs
+	 * while it waits on a counter.
+	 *
+	 * Threads that aren't workers (like the resource loading threads) can use the job system too.
+	 * Their jobs go through one shared queue that workers check once they have nothing else to do.
+	 * They have to be done with it before Shutdown.
+	 *
+	 * @see https://blog.molecular-matters.com/2015/08/24/job-system-2-0-lock-free-work-stealing-part-1-basics/
+	 */
+	class JobSystem : public Singleton<JobSystem>
+	{
+	public:
+
+		/** Max number of jobs a single thread can have queued or in flight at once */
+		static constexpr size_t MaxJobsPerThread = 4096;
+
+		/**
+		 * Spin up the worker threads. The calling thread becomes worker 0.
+		 * The number of workers can be set with the "JobWorkerCount" command line/console variable,
+		 * and defaults to one less than the number of hardware threads.
+		 */
+		virtual void Init() override;
+
+		/** Wakes up and joins all the worker threads. Any jobs still queued are dropped. */
+		virtual void Shutdown() override;
+
+		/**
+		 * Create a job that will call t_Func when it is run. The job is not scheduled
+		 * until it is passed to JobSystem::Run.
+		 *
+		 * @param t_Counter	Counter to decrement once this job is done (optional)
+		 * @param t_Func	Callable with the signature void(). Must fit in Job::PayloadSize
+		 */
+		template<typename T_Func>
+		Job* CreateJob(JobCounter* t_Counter, T_Func&& t_Func);
+
+		/**
+		 * Schedule a job on the calling thread's queue, where idle workers may steal it.
+		 * Jobs from threads that aren't workers go on the shared queue, and can't have a dependency.
+		 *
+		 * @param t_Job			Job created with CreateJob on this thread
+		 * @param t_Dependency	If not null, then the job will not start until this counter is done
+		 */
+		void Run(Job* t_Job, const JobCounter* t_Dependency = nullptr);
+
+		/**
+		 * Block until the given counter reaches zero. The calling thread executes other
+		 * jobs while it is waiting instead of going idle.
+		 */
+		void Wait(const JobCounter& t_Counter);
+
+		/**
+		 * Split the range [0, t_Count) into chunks of t_ChunkSize and execute them across all workers.
+		 * Returns once every chunk is done. Can be called from any thread.
+		 *
+		 * @param t_Func	Callable with the signature void(uint32 Begin, uint32 End)
+		 */
+		template<typename T_Func>
+		void ParallelFor(uint32 t_Count, uint32 t_ChunkSize, T_Func&& t_Func);
+
+		/**
+		 * Execute t_Func for every entity in an entt view or group, split across all workers.
+		 * Components may be fetched and written with t_View.get inside of t_Func, but the
+		 * registry must not be structurally changed (no create/destroy/assign/remove) until this returns.
+		 *
+		 * @param t_Func	Callable with the signature void(entt::entity)
+		 */
+		template<typename T_View, typename T_Func>
+		void ParallelForEach(T_View& t_View, uint32 t_ChunkSize, T_Func&& t_Func);
+
+		/** Number of threads that execute jobs, including the main thread */
+		inline uint32 GetWorkerCount() const { return static_cast<uint32>(m_Workers.size()); }
+
+		/** True if the job system has been initalized and can accept jobs */
+		inline bool IsRunning() const { return m_IsRunning.load(std::memory_order_acquire); }
+
+		/** True if the calling thread is one of the job system threads */
+		bool IsWorkerThread() const;
+
+	private:
+
+		struct Worker
+		{
+			WorkStealingQueue<Job*, MaxJobsPerThread> m_Queue;
+
+			/** Ring buffer allocator of jobs created on this thread, see AllocateJob */
+			CircularBuffer<Job, MaxJobsPerThread> m_JobPool;
+
+			/** Jobs that were picked up before their dependency was done. Only touched by the owning thread */
+			std::vector<Job*> m_Deferred;
+
+			std::thread m_Thread;
+		};
+
+		void WorkerThreadLoop(uint32 t_WorkerIndex);
+
+		/** Grab a job from this thread's queue, or steal one from another worker */
+		Job* GetJob(Worker& t_Worker);
+
+		/**
+		 * Execute the job if its dependency is met, otherwise defer it to try again later
+		 * @return True if the job was executed
+		 */
+		bool TryExecute(Worker& t_Worker, Job* t_Job);
+
+		void Execute(Job* t_Job);
+
+		/** Take the next job slot of this thread, working on other jobs until it is free */
+		Job* AllocateJob();
+
+		/** Take the next slot of the shared pool for a thread that isn't a worker */
+		Job* AllocateExternalJob();
+
+		/**
+		 * Execute a job from the shared queue, for threads that aren't workers to help while they wait
+		 * @return True if there was one
+		 */
+		bool ExecuteExternalJob();
+
+		Worker& GetCurrentWorker();
+
+		std::vector<std::unique_ptr<Worker>> m_Workers;
+
+		/** Jobs created on threads that aren't workers. Those threads share one pool and queue */
+		struct ExternalJobs
+		{
+			MpmcQueue<Job*, MaxJobsPerThread> m_Queue;
+
+			CircularBuffer<Job, MaxJobsPerThread> m_JobPool;
+			std::mutex m_PoolMutex;
+		};
+
+		std::unique_ptr<ExternalJobs> m_External;
+
+		std::atomic<bool> m_IsRunning { false };
+
+		/** Idle workers sleep on this until new jobs are pushed */
+		std::mutex m_WakeMutex;
+		std::condition_variable m_WakeCondition;
+	};
+
+	template<typename T_Func>
+	inline Job* JobSystem::CreateJob(JobCounter* t_Counter, T_Func&& t_Func)
+	{
+		typedef typename std::decay<T_Func>::type FuncType;
+		static_assert(sizeof(FuncType) <= Job::PayloadSize, "Job data is too large, capture less or capture by reference");
+		static_assert(alignof(FuncType) <= 16, "Job data is over aligned");
+		static_assert(std::is_trivially_destructible<FuncType>::value, "Job data must be trivially destructible");
+
+		Job* NewJob = AllocateJob();
+
+		new (NewJob->m_Payload) FuncType(std::forward<T_Func>(t_Func));
+		NewJob->m_Function = [](Job& t_Job)
+		{
+			(*reinterpret_cast<FuncType*>(t_Job.m_Payload))();
+		};
+		NewJob->m_Counter = t_Counter;
+		NewJob->m_Dependency = nullptr;
+
+		return NewJob;
+	}
+
+	template<typename T_Func>
+	inline void JobSystem::ParallelFor(uint32 t_Count, uint32 t_ChunkSize, T_Func&& t_Func)
+	{
+		if (t_ChunkSize == 0)
+		{
+			t_ChunkSize = 1;
+		}
+
+		// Nothing to split up, just do the work right here
+		if (t_Count <= t_ChunkSize || !IsRunning() || GetWorkerCount() <= 1)
+		{
+			if (t_Count > 0)
+			{
+				t_Func(0u, t_Count);
+			}
+			return;
+		}
+
+		JobCounter Counter;
+		T_Func* Func = &t_Func;
+
+		// Kick off every chunk except the last one, which the calling thread will do itself
+		uint32 Begin = 0;
+		for (; Begin + t_ChunkSize < t_Count; Begin += t_ChunkSize)
+		{
+			const uint32 End = Begin + t_ChunkSize;
+			Run(CreateJob(&Counter, [Func, Begin, End]() { (*Func)(Begin, End); }));
+		}
+
+		t_Func(Begin, t_Count);
+
+		Wait(Counter);
+	}
+
+	template<typename T_View, typename T_Func>
+	inline void JobSystem::ParallelForEach(T_View& t_View, uint32 t_ChunkSize, T_Func&& t_Func)
+	{
+		typedef typename std::decay<decltype(*t_View.begin())>::type EntityType;
+
+		// Views can't be randomly accessed, so take a snapshot of the entities that we can split up
+		ScratchVector<EntityType> Entities;
+		Entities.reserve(t_View.size());
+		for (const EntityType Ent : t_View)
+		{
+			Entities.push_back(Ent);
+		}
+
+		ParallelFor(static_cast<uint32>(Entities.size()), t_ChunkSize, [&Entities, &t_Func](uint32 t_Begin, uint32 t_End)
+		{
+			for (uint32 i = t_Begin; i < t_End; ++i)
+			{
+				t_Func(Entities[i]);
+			}
+		});
+	}
+}   // namespace Fling
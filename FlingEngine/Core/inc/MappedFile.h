@@ -0,0 +1,76 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+#include <string>
+#include <string_view>
+
+namespace Fling
+{
+	/** How a mapped file is going to be read, passed on to the OS as a hint */
+	enum class MappedFileAccess : uint8
+	{
+		/** No hint, pages are read in as they are touched */
+		Random,
+
+		/** Read front to back, so the OS can read further ahead */
+		Sequential,
+
+		/** All of it is going to be read soon, start reading it in right away */
+		WillNeed
+	};
+
+	/**
+	 * A read only view of a whole file that is mapped straight into memory. Reading it reads
+	 * the OS page cache directly, so the file is never copied into a buffer of our own and
+	 * nothing comes off of the disk until it is touched. The data is page aligned.
+	 *
+	 * The data is only valid while the MappedFile is around. Don't write to a file while it is mapped.
+	 * Copying is deleted here rather than through NonCopyable so the class has no vtable.
+	 */
+	class MappedFile final
+	{
+	public:
+
+		MappedFile() = default;
+
+		/** Map a file. Check IsOpen to see if it worked */
+		explicit MappedFile(const std::string& t_Path, MappedFileAccess t_Access = MappedFileAccess::Sequential);
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& t_Other) noexcept;
+		MappedFile& operator=(MappedFile&& t_Other) noexcept;
+
+		~MappedFile();
+
+		/**
+		 * Map a file, unmapping whatever was mapped before
+		 *
+		 * @param t_Path	Full path to the file
+		 * @param t_Access	How the file will be read
+		 * @return False if the file couldn't be opened or mapped
+		 */
+		bool Open(const std::string& t_Path, MappedFileAccess t_Access = MappedFileAccess::Sequential);
+
+		void Close();
+
+		/** True if a file is mapped. An empty file is open, but has no data */
+		inline bool IsOpen() const { return m_bOpen; }
+
+		inline const char* GetData() const { return m_Data; }
+
+		inline size_t GetSize() const { return m_Size; }
+
+		inline std::string_view GetView() const { return std::string_view(m_Data, m_Size); }
+
+	private:
+
+		const char* m_Data = nullptr;
+
+		size_t m_Size = 0;
+
+		bool m_bOpen = false;
+	};
+}   // namespace Fling
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FreeList.h"
+#include "Memory.h"
+#include "NonCopyable.hpp"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * A typed pool allocator for objects of type T. Memory is owned by the pool and
+	 * allocated in chunks of t_ElmsPerChunk elements, a new chunk is added whenever
+	 * the pool runs out of free elements. Chunks are only given back when the pool is destroyed.
+	 *
+	 * This is NOT thread safe, see ConcurrentPoolAllocator for that.
+	 *
+	 * @tparam T 				The type of object that this pool allocates
+	 * @tparam t_ElmsPerChunk 	How many elements to allocate each time the pool grows
+	 */
+	template<typename T, size_t t_ElmsPerChunk = 64>
+	class PoolAllocator : public NonCopyable
+	{
+		static_assert(t_ElmsPerChunk > 0, "PoolAllocator::t_ElmsPerChunk must be greater than 0");
+
+	public:
+
+		/** Alignment of every element in the pool. Each free element has to be able to store a pointer */
+		static constexpr size_t ElementAlignment = std::max(alignof(T), alignof(void*));
+
+		/** Size of every element in the pool, rounded up so that every element is aligned */
+		static constexpr size_t ElementSize =
+			((std::max(sizeof(T), sizeof(void*)) + ElementAlignment - 1) / ElementAlignment) * ElementAlignment;
+
+		PoolAllocator() = default;
+
+		/** Frees every chunk of this pool. Everything allocated from it must have already been freed */
+		virtual ~PoolAllocator();
+
+		/** Get uninitialized memory for a single T, growing the pool if needed */
+		void* Allocate();
+
+		/** Give memory that was obtained with Allocate back to the pool */
+		void Free(void* t_Ptr);
+
+		/** Allocate and construct a T from this pool */
+		template<typename ...ARGS>
+		T* New(ARGS&&... t_Args);
+
+		/** Destruct a T that was created with New and give its memory back to the pool */
+		void Delete(T* t_Obj);
+
+		/** Total number of elements this pool can hold before it has to grow */
+		inline size_t GetCapacity() const { return m_Chunks.size() * t_ElmsPerChunk; }
+
+		/** Number of elements currently in use */
+		inline size_t GetNumAllocated() const { return m_NumAllocated; }
+
+	private:
+
+		/** Allocate another chunk of memory and add all of its elements to the free list */
+		void Grow();
+
+		FreeList m_FreeList;
+
+		std::vector<void*> m_Chunks;
+
+		size_t m_NumAllocated = 0;
+	};
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline PoolAllocator<T, t_ElmsPerChunk>::~PoolAllocator()
+	{
+		assert(m_NumAllocated == 0 && "A pool allocator was destroyed while some of its memory is still in use!");
+
+		for (void* Chunk : m_Chunks)
+		{
+			AlignedFree(Chunk);
+		}
+		m_Chunks.clear();
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline void* PoolAllocator<T, t_ElmsPerChunk>::Allocate()
+	{
+		void* Mem = m_FreeList.Obtain();
+		if (Mem == nullptr)
+		{
+			Grow();
+			Mem = m_FreeList.Obtain();
+		}
+
+		assert(Mem);
+		++m_NumAllocated;
+		return Mem;
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline void PoolAllocator<T, t_ElmsPerChunk>::Free(void* t_Ptr)
+	{
+		if (t_Ptr == nullptr)
+		{
+			return;
+		}
+
+		assert(m_NumAllocated > 0);
+		--m_NumAllocated;
+		m_FreeList.Return(t_Ptr);
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	template<typename ...ARGS>
+	inline T* PoolAllocator<T, t_ElmsPerChunk>::New(ARGS&&... t_Args)
+	{
+		return new (Allocate()) T(std::forward<ARGS>(t_Args)...);
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline void PoolAllocator<T, t_ElmsPerChunk>::Delete(T* t_Obj)
+	{
+		if (t_Obj == nullptr)
+		{
+			return;
+		}
+
+		t_Obj->~T();
+		Free(t_Obj);
+	}
+
+	template<typename T, size_t t_ElmsPerChunk>
+	inline void PoolAllocator<T, t_ElmsPerChunk>::Grow()
+	{
+		char* Chunk = static_cast<char*>(AlignedAlloc(ElementSize * t_ElmsPerChunk, ElementAlignment));
+		if (Chunk == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		m_Chunks.push_back(Chunk);
+
+		// Return them backwards so that the lowest addresses are handed out first
+		for (size_t i = t_ElmsPerChunk; i > 0; --i)
+		{
+			m_FreeList.Return(Chunk + (i - 1) * ElementSize);
+		}
+	}
+}   // namespace Fling
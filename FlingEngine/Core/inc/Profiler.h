@@ -0,0 +1,178 @@
+#pragma once
+
+#include "Singleton.hpp"
+#include "FlingTypes.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Fling
+{
+	/** A single timed zone, times are in nanoseconds from an arbitrary point */
+	struct ProfileZone
+	{
+		const char* m_Name = nullptr;
+		uint64 m_Start = 0;
+		uint64 m_End = 0;
+	};
+
+	/**
+	 * A simple CPU profiler. Zones are marked with FLING_PROFILE_SCOPE and are only recorded
+	 * while a capture is in progress, so leaving them in the code is close to free.
+	 *
+	 * Every thread writes its zones into its own lock-free ring buffer. The main thread drains
+	 * those buffers once a frame and when the capture is over the results are written out in the
+	 * Chrome trace event format, which can be opened in chrome://tracing or https://ui.perfetto.dev
+	 *
+	 * Use "ProfileFrames=N" on the command line (or in the [ConsoleVariables] config section) to capture
+	 * the first N frames, and "ProfileOutput=<path>" to change where the trace is written.
+	 */
+	class Profiler : public Singleton<Profiler>
+	{
+	public:
+
+		/** Max number of zones a thread can record between two calls to BeginFrame */
+		static constexpr uint32 ThreadBufferSize = 16 * 1024;
+
+		virtual void Init() override;
+
+		/** Writes out any capture that is still in progress */
+		virtual void Shutdown() override;
+
+		/**
+		 * Start recording zones on every thread.
+		 *
+		 * @param t_NumFrames		Number of frames to capture before the trace is written out
+		 * @param t_OutputPath		Path of the JSON file to write the trace to
+		 */
+		void BeginCapture(uint32 t_NumFrames, const std::string& t_OutputPath);
+
+		/** Stop recording and write the trace file. Does nothing if there is no capture in progress */
+		void EndCapture();
+
+		/**
+		 * Marks the start of a new frame. Collects the zones from every thread and ends
+		 * the capture once enough frames have been recorded. Call from the main thread.
+		 */
+		void BeginFrame();
+
+		inline bool IsCapturing() const { return m_Capturing.load(std::memory_order_relaxed); }
+
+		/** Give the calling thread a name that shows up in the trace. Doesn't make a zone buffer for it */
+		void SetThreadName(const std::string& t_Name);
+
+		/** Write every zone that has been collected so far to a Chrome trace JSON file */
+		bool WriteChromeTrace(const std::string& t_OutputPath);
+
+		/** Number of zones that have been collected from the thread buffers */
+		size_t GetNumCapturedZones() const;
+
+		/** Number of threads that have recorded zones and haven't exited */
+		size_t GetNumThreadBuffers() const;
+
+		/** Number of zones that were thrown out because a thread's buffer was full */
+		inline uint64 GetNumDroppedZones() const { return m_DroppedZones.load(std::memory_order_relaxed); }
+
+		/** Current time in nanoseconds */
+		static uint64 Now();
+
+		/** Record a finished zone for the calling thread. Use FLING_PROFILE_SCOPE instead of calling this */
+		void RecordZone(const ProfileZone& t_Zone);
+
+	private:
+
+		/** Single producer single consumer ring of zones for one thread */
+		struct ThreadBuffer
+		{
+			ProfileZone m_Zones[ThreadBufferSize];
+
+			/** Written by the owning thread */
+			alignas(64) std::atomic<uint32> m_Head { 0 };
+
+			/** Written by the thread that drains the buffer */
+			alignas(64) std::atomic<uint32> m_Tail { 0 };
+
+			/** Set to false once the owning thread has exited */
+			std::atomic<bool> m_InUse { true };
+
+			uint32 m_ThreadId = 0;
+		};
+
+		/** A zone that has been pulled out of a thread buffer */
+		struct CapturedZone
+		{
+			ProfileZone m_Zone;
+			uint32 m_ThreadId = 0;
+		};
+
+		/** Get the calling thread's buffer, creating it if needed */
+		ThreadBuffer* GetThreadBuffer();
+
+		/** Id of the calling thread in the trace, given out the first time a thread asks */
+		uint32 GetThreadId();
+
+		/** Move any finished zones from the thread buffers into m_Captured */
+		void CollectZones();
+
+		std::atomic<bool> m_Capturing { false };
+
+		std::atomic<uint64> m_DroppedZones { 0 };
+
+		uint32 m_FramesToCapture = 0;
+		uint32 m_FramesCaptured = 0;
+
+		std::string m_OutputPath;
+
+		/** Guards the thread buffer list, the captured zones, and thread names */
+		mutable std::mutex m_Mutex;
+
+		std::vector<std::unique_ptr<ThreadBuffer>> m_ThreadBuffers;
+
+		std::vector<CapturedZone> m_Captured;
+
+		std::unordered_map<uint32, std::string> m_ThreadNames;
+
+		std::atomic<uint32> m_NextThreadId { 0 };
+	};
+
+	/** Times the scope that it lives in, see FLING_PROFILE_SCOPE */
+	class ProfileScope
+	{
+	public:
+
+		explicit ProfileScope(const char* t_Name)
+		{
+			if (Profiler::Get().IsCapturing())
+			{
+				m_Zone.m_Name = t_Name;
+				m_Zone.m_Start = Profiler::Now();
+			}
+		}
+
+		~ProfileScope()
+		{
+			if (m_Zone.m_Name != nullptr)
+			{
+				m_Zone.m_End = Profiler::Now();
+				Profiler::Get().RecordZone(m_Zone);
+			}
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+
+		ProfileZone m_Zone;
+	};
+}   // namespace Fling
+
+#define FLING_PROFILE_CONCAT_IMPL(a, b) a##b
+#define FLING_PROFILE_CONCAT(a, b) FLING_PROFILE_CONCAT_IMPL(a, b)
+
+/** Time the current scope. The name must be a string literal (or otherwise outlive the capture) */
+#define FLING_PROFILE_SCOPE(name) Fling::ProfileScope FLING_PROFILE_CONCAT(ProfileScope_, __LINE__) (name)
@@ -18,22 +18,23 @@ namespace Fling
     public:
         /**
          * Create a stack allocator over the memory between t_Start and t_End.
+         * The memory is not owned by the allocator and must outlive it.
          *
          * @param t_Start  Start of the memory block to use for this stack allocator
          * @param t_End    End of the memory block to use for this stack allocator
          */
         StackAllocator(void* t_Start, void* t_End);
-        ~StackAllocator();
+        ~StackAllocator() = default;
 
         /**
          * Allocate a block from the top of the stack.
          *
          * @param t_Size        Size of the block of memory
-         * @param t_Alignment   Alignment of the element (Default = 8)
+         * @param t_Alignment   Alignment of the element, must be a power of 2 (Default = 8)
          * @param t_Offset      Offset of the element (Default = 0)
-         * @return Pointer to the allocated block (asserts when we exceed the preallocated size)
+         * @return Pointer to the allocated block, or nullptr if there is not enough space left
          */
-        void* Allocate(size_t t_Size, size_t t_Alignment = 0, size_t t_Offset = 0);
+        void* Allocate(size_t t_Size, size_t t_Alignment = 8, size_t t_Offset = 0);
 
         /**
          * Return a block of memory to the stack in LIFO order.
@@ -42,6 +43,15 @@ namespace Fling
          */
         void Free(void* t_Ptr);
 
+        /** Free everything that has been allocated from this stack at once */
+        inline void Reset() { m_Current = m_Start; }
+
+        /** Number of bytes currently in use, including alignment and bookkeeping overhead */
+        inline size_t GetUsedSize() const { return static_cast<size_t>(m_Current - m_Start); }
+
+        /** Total size of the memory region this allocator was created with */
+        inline size_t GetCapacity() const { return static_cast<size_t>(m_End - m_Start); }
+
     private:
         char* m_Start = nullptr;
         char* m_End = nullptr;
@@ -1,6 +1,10 @@
 #pragma once
 
-#include "MovingAverage.hpp"
+#include "Histogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
 
 namespace Fling
 {
@@ -8,19 +12,148 @@ namespace Fling
 
     namespace Stats
     {
+        /** Parts of the frame that we keep timing stats for */
+        enum class Phase : uint8
+        {
+            Frame,
+            Input,
+            World,
+            Render,
+
+            Count
+        };
+
+        /** Get a printable name for a phase */
+        const char* GetPhaseName(Phase t_Phase);
+
+        /**
+         * Frame time stats for the whole frame and each major phase of it. Times are kept in
+         * log scale histograms (in microseconds) so that we can see the hitches and not just the average.
+         *
+         * Every phase has a rolling histogram covering the last NumWindows seconds and
+         * one that covers the entire run, which is written out on shutdown.
+         * These are only meant to be used from the main thread.
+         */
         struct Frames
         {
         friend class Engine;
         public:
+
+            /** Number of one second windows that the rolling histograms cover */
+            static constexpr uint32 NumWindows = 10;
+
+            /** Mean frame time over the rolling window, in seconds */
             static float GetAverageFrameTime();
 
             static float GetAverageFPS();
-        
+
+            /**
+             * Get a frame time percentile over the rolling window, in seconds
+             * @param t_Percentile  Percentile from 0 to 100 (i.e. 99 for p99)
+             */
+            static float GetFrameTimePercentile(double t_Percentile);
+
+            /** Max frame time over the rolling window, in seconds */
+            static float GetMaxFrameTime();
+
             static void TickStats(float t_DeltaTime);
 
+            /** Record how long a phase took this frame */
+            static void RecordPhase(Phase t_Phase, uint64 t_Microseconds);
+
+            /** Stats for the last NumWindows seconds */
+            static const Histogram& GetRollingHistogram(Phase t_Phase);
+
+            /** Stats since the engine started (or since the last Reset) */
+            static const Histogram& GetTotalHistogram(Phase t_Phase);
+
+            static void Reset();
+
+            /** Log p50/p95/p99/max of every phase */
+            static void LogSummary();
+
+            /**
+             * Write the raw buckets of the total histograms to a CSV file so that runs can be compared
+             * @see Histogram::WriteCsv
+             */
+            static bool WriteHistograms(const std::string& t_FilePath);
+
 		private:
 
-            static MovingAverage<float, 100> FPSCounter;
+            static RollingHistogram<NumWindows> RollingPhases[static_cast<size_t>(Phase::Count)];
+
+            static Histogram TotalPhases[static_cast<size_t>(Phase::Count)];
+
+            /** Time since the rolling window was last rotated */
+            static float WindowTime;
+        };
+
+        /**
+         * How much geometry the renderer submits. The render thread records every frame it draws. The
+         * last frame's numbers are atomics that can be read from any thread. The histogram covers the
+         * whole run, and should only be read once the renderer has stopped.
+         */
+        struct Draws
+        {
+        public:
+
+            /**
+             * Record a frame that was drawn
+             *
+             * @param t_Triangles               Triangles that were submitted
+             * @param t_FullDetailTriangles     Triangles there would have been if every mesh was drawn whole at LOD 0
+             * @param t_DrawCount               Number of draw calls
+             */
+            static void RecordFrame(uint64 t_Triangles, uint64 t_FullDetailTriangles, uint32 t_DrawCount);
+
+            static uint64 GetLastFrameTriangles() { return LastTriangles.load(std::memory_order_relaxed); }
+            static uint64 GetLastFrameFullDetailTriangles() { return LastFullDetailTriangles.load(std::memory_order_relaxed); }
+            static uint32 GetLastFrameDrawCount() { return LastDrawCount.load(std::memory_order_relaxed); }
+
+            /** Triangles submitted in each frame since the engine started (or since the last Reset) */
+            static const Histogram& GetTriangleHistogram() { return Triangles; }
+
+            static void Reset();
+
+            /** Log p50/p99/max triangles per frame, and how many LODs and culling saved */
+            static void LogSummary();
+
+        private:
+
+            static std::atomic<uint64> LastTriangles;
+            static std::atomic<uint64> LastFullDetailTriangles;
+            static std::atomic<uint32> LastDrawCount;
+
+            static Histogram Triangles;
+
+            /** Totals for the whole run */
+            static uint64 TotalTriangles;
+            static uint64 TotalFullDetailTriangles;
+        };
+
+        /** Records how long the scope it lives in took for the given phase */
+        class ScopedPhaseTimer
+        {
+        public:
+
+            explicit ScopedPhaseTimer(Phase t_Phase)
+                : m_Phase(t_Phase)
+                , m_Start(std::chrono::steady_clock::now())
+            {}
+
+            ~ScopedPhaseTimer()
+            {
+                const auto Elapsed = std::chrono::steady_clock::now() - m_Start;
+                Frames::RecordPhase(m_Phase, static_cast<uint64>(std::chrono::duration_cast<std::chrono::microseconds>(Elapsed).count()));
+            }
+
+            ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+            ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+        private:
+
+            Phase m_Phase;
+            std::chrono::steady_clock::time_point m_Start;
         };
     }
-}
\ No newline at end of file
+}
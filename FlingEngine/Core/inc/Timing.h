@@ -67,6 +67,14 @@ namespace Fling
 		 */
 		float FLING_API GetFrameTime() const { return 1000.0f / static_cast<float>(m_fpsFrameCount); }
 
+		/**
+		 * How far between the last two fixed simulation steps this frame is (0 to 1).
+		 * The renderer uses this to interpolate transforms. Always 1 when not using a fixed timestep
+		 */
+		float FLING_API GetInterpolationAlpha() const { return m_InterpolationAlpha; }
+
+		void SetInterpolationAlpha(float t_Alpha) { m_InterpolationAlpha = t_Alpha; }
+
 	private:
 
 		// Initialize delta time at 60 FPS to avoid an ImGUI assertion
@@ -81,5 +89,7 @@ namespace Fling
 
 		/** The time that the program started */
 		double m_startTime = 0.0;
+
+		float m_InterpolationAlpha = 1.0f;
 	};
 }	// namespace Fling
\ No newline at end of file
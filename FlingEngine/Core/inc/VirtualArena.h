@@ -0,0 +1,151 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "NonCopyable.hpp"
+
+#include <new>
+#include <stddef.h>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * A linear allocator over a large reserved range of virtual address space. Reserving costs
+	 * nothing but address space, physical pages are only committed as the arena grows into them.
+	 * This means that an arena can be sized for the worst case (gigabytes) without using that much memory.
+	 *
+	 * Optionally the arena can ask the OS to back it with transparent huge pages, which cuts down
+	 * on TLB misses when bump allocating large amounts of data.
+	 *
+	 * Allocations are freed in bulk by rewinding to a Marker, or with a Scope that does it for you.
+	 * This is NOT thread safe.
+	 */
+	class VirtualArena : public NonCopyable
+	{
+	public:
+
+		/** A position in the arena that can be rewound to */
+		struct Marker
+		{
+			size_t m_Offset = 0;
+		};
+
+		/** Rewinds the arena to where it was when the scope was created */
+		class Scope
+		{
+		public:
+			explicit Scope(VirtualArena& t_Arena)
+				: m_Arena(t_Arena)
+				, m_Marker(t_Arena.GetMarker())
+			{}
+
+			~Scope() { m_Arena.Rewind(m_Marker); }
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			VirtualArena& m_Arena;
+			Marker m_Marker;
+		};
+
+		/**
+		 * Reserve address space for a new arena. Nothing is committed until it is used.
+		 *
+		 * @param t_ReserveSize		Max number of bytes this arena can ever hold
+		 * @param t_UseHugePages	If true, ask the OS to use huge pages for this arena when it can
+		 */
+		explicit VirtualArena(size_t t_ReserveSize, bool t_UseHugePages = false);
+
+		virtual ~VirtualArena();
+
+		/**
+		 * Bump allocate some memory from the arena, committing more pages if needed.
+		 *
+		 * @param t_Size		Size of the allocation in bytes
+		 * @param t_Alignment	Alignment of the allocation, must be a power of 2 (Default = 8)
+		 * @return Pointer to the memory, or nullptr if the reserved range is used up
+		 */
+		void* Allocate(size_t t_Size, size_t t_Alignment = 8);
+
+		/** Allocate uninitialized space for t_Count elements of type T */
+		template<typename T>
+		T* AllocateArray(size_t t_Count) { return static_cast<T*>(Allocate(sizeof(T) * t_Count, alignof(T))); }
+
+		inline Marker GetMarker() const { return Marker { m_Used }; }
+
+		/** Free everything that was allocated after the given marker. Pages stay committed for reuse */
+		void Rewind(Marker t_Marker);
+
+		/** Free everything in the arena */
+		inline void Reset() { Rewind(Marker {}); }
+
+		/** Give any committed pages past the current allocation back to the OS */
+		void Decommit();
+
+		inline bool IsValid() const { return m_Base != nullptr; }
+		inline size_t GetReservedSize() const { return m_Reserved; }
+		inline size_t GetCommittedSize() const { return m_Committed; }
+		inline size_t GetUsedSize() const { return m_Used; }
+		inline bool IsUsingHugePages() const { return m_UseHugePages; }
+
+	private:
+
+		/** Make sure that at least t_Size bytes from the base are committed */
+		bool Commit(size_t t_Size);
+
+		char* m_Base = nullptr;
+
+		size_t m_Reserved = 0;
+		size_t m_Committed = 0;
+		size_t m_Used = 0;
+
+		/** Pages are committed in multiples of this many bytes */
+		size_t m_CommitGranularity = 0;
+
+		bool m_UseHugePages = false;
+	};
+
+	/**
+	 * STL compatible allocator that bump allocates from a VirtualArena.
+	 * Deallocation does nothing, memory is given back when the arena is rewound.
+	 */
+	template<typename T>
+	struct ArenaStlAllocator
+	{
+		typedef T value_type;
+
+		explicit ArenaStlAllocator(VirtualArena& t_Arena) noexcept
+			: m_Arena(&t_Arena)
+		{}
+
+		template<typename U>
+		ArenaStlAllocator(const ArenaStlAllocator<U>& t_Other) noexcept
+			: m_Arena(t_Other.m_Arena)
+		{}
+
+		T* allocate(size_t t_Count)
+		{
+			T* Mem = m_Arena->AllocateArray<T>(t_Count);
+			if (Mem == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+			return Mem;
+		}
+
+		void deallocate(T*, size_t) noexcept {}
+
+		template<typename U>
+		bool operator==(const ArenaStlAllocator<U>& t_Other) const noexcept { return m_Arena == t_Other.m_Arena; }
+
+		template<typename U>
+		bool operator!=(const ArenaStlAllocator<U>& t_Other) const noexcept { return m_Arena != t_Other.m_Arena; }
+
+		VirtualArena* m_Arena;
+	};
+
+	/** A vector that lives in a VirtualArena */
+	template<typename T>
+	using ArenaVector = std::vector<T, ArenaStlAllocator<T>>;
+}   // namespace Fling
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+#include <atomic>
+#include <type_traits>
+
+namespace Fling
+{
+	/**
+	 * A bounded, lock-free work stealing deque (Chase-Lev). The owning thread pushes and pops
+	 * from the bottom in LIFO order, while any other thread may steal from the top in FIFO order.
+	 *
+	 * @tparam T 			Pointer type that is stored in the queue
+	 * @tparam t_NumElms 	The max size of this queue, must be a power of 2!
+	 *
+	 * @see https://blog.molecular-matters.com/2015/09/25/job-system-2-0-lock-free-work-stealing-part-3-going-lock-free/
+	 * @see https://fzn.fr/readings/ppopp13.pdf
+	 */
+	template<typename T, size_t t_NumElms>
+	class WorkStealingQueue
+	{
+		static_assert((t_NumElms != 0 && (t_NumElms & (t_NumElms - 1)) == 0), "WorkStealingQueue::t_NumElms must be a power of 2!");
+		static_assert(std::is_pointer<T>::value, "WorkStealingQueue only stores pointer types");
+
+	public:
+
+		WorkStealingQueue() = default;
+		~WorkStealingQueue() = default;
+
+		/**
+		 * Push an item onto the bottom of the queue. Only call this from the owning thread.
+		 *
+		 * @return False if the queue is full
+		 */
+		bool Push(T t_Item);
+
+		/**
+		 * Pop an item off the bottom of the queue. Only call this from the owning thread.
+		 *
+		 * @return The item, or nullptr if the queue is empty
+		 */
+		T Pop();
+
+		/**
+		 * Steal an item from the top of the queue. Safe to call from any thread.
+		 *
+		 * @return The item, or nullptr if the queue is empty or we lost a race with another thread
+		 */
+		T Steal();
+
+		/** Approximate number of items in the queue. Only exact from the owning thread. */
+		size_t Size() const
+		{
+			const int64 Bottom = m_Bottom.load(std::memory_order_relaxed);
+			const int64 Top = m_Top.load(std::memory_order_relaxed);
+			return Bottom >= Top ? static_cast<size_t>(Bottom - Top) : 0;
+		}
+
+	private:
+
+		static constexpr int64 Mask = static_cast<int64>(t_NumElms) - 1;
+
+		/** Top and bottom live on separate cache lines so that stealing threads don't thrash the owner */
+		alignas(64) std::atomic<int64> m_Top { 0 };
+		alignas(64) std::atomic<int64> m_Bottom { 0 };
+
+		alignas(64) std::atomic<T> m_Items[t_NumElms] {};
+	};
+
+	template<typename T, size_t t_NumElms>
+	inline bool WorkStealingQueue<T, t_NumElms>::Push(T t_Item)
+	{
+		const int64 Bottom = m_Bottom.load(std::memory_order_relaxed);
+		const int64 Top = m_Top.load(std::memory_order_acquire);
+
+		if (Bottom - Top >= static_cast<int64>(t_NumElms))
+		{
+			return false;
+		}
+
+		m_Items[Bottom & Mask].store(t_Item, std::memory_order_relaxed);
+		m_Bottom.store(Bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<typename T, size_t t_NumElms>
+	inline T WorkStealingQueue<T, t_NumElms>::Pop()
+	{
+		const int64 Bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		m_Bottom.store(Bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64 Top = m_Top.load(std::memory_order_relaxed);
+
+		if (Top > Bottom)
+		{
+			// The queue was already empty
+			m_Bottom.store(Bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		T Item = m_Items[Bottom & Mask].load(std::memory_order_relaxed);
+		if (Top == Bottom)
+		{
+			// This is the last item in the queue, so we may be racing a stealing thread for it
+			if (!m_Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				Item = nullptr;
+			}
+			m_Bottom.store(Bottom + 1, std::memory_order_relaxed);
+		}
+
+		return Item;
+	}
+
+	template<typename T, size_t t_NumElms>
+	inline T WorkStealingQueue<T, t_NumElms>::Steal()
+	{
+		int64 Top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64 Bottom = m_Bottom.load(std::memory_order_acquire);
+
+		if (Top >= Bottom)
+		{
+			return nullptr;
+		}
+
+		T Item = m_Items[Top & Mask].load(std::memory_order_relaxed);
+		if (!m_Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			// Another thread stole this item (or the owner popped it) first
+			return nullptr;
+		}
+
+		return Item;
+	}
+}   // namespace Fling
@@ -0,0 +1,576 @@
+#include "pch.h"
+#include "BatchFileReader.h"
+#include "JobSystem.h"
+#include "Memory.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if FLING_WINDOWS
+#	include <windows.h>
+#else
+#	include <cerrno>
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#ifndef WITH_IO_URING
+#	define WITH_IO_URING 0
+#endif
+
+#if FLING_LINUX && WITH_IO_URING
+#	include <linux/io_uring.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <sys/uio.h>
+#endif
+
+namespace Fling
+{
+	FileReadBackend ParseFileReadBackend(const std::string& t_Name)
+	{
+		if (t_Name == "IoUring")
+		{
+			return FileReadBackend::IoUring;
+		}
+		else if (t_Name == "ThreadPool")
+		{
+			return FileReadBackend::ThreadPool;
+		}
+		return FileReadBackend::Auto;
+	}
+
+	const char* GetFileReadBackendName(FileReadBackend t_Backend)
+	{
+		switch (t_Backend)
+		{
+		case FileReadBackend::IoUring:		return "IoUring";
+		case FileReadBackend::ThreadPool:	return "ThreadPool";
+		default:							return "Auto";
+		}
+	}
+
+#if FLING_LINUX
+
+	struct BatchFileReader::IoUring
+	{
+#if WITH_IO_URING
+		int Fd = -1;
+
+		void* SqRing = nullptr;
+		size_t SqRingSize = 0;
+		void* CqRing = nullptr;
+		size_t CqRingSize = 0;
+		io_uring_sqe* Sqes = nullptr;
+		size_t SqesSize = 0;
+
+		uint32* SqHead = nullptr;
+		uint32* SqTail = nullptr;
+		uint32* SqArray = nullptr;
+		uint32 SqMask = 0;
+		uint32 SqEntries = 0;
+
+		uint32* CqHead = nullptr;
+		uint32* CqTail = nullptr;
+		io_uring_cqe* Cqes = nullptr;
+		uint32 CqMask = 0;
+#endif
+	};
+
+#endif
+
+	BatchFileReader::BatchFileReader(FileReadBackend t_Backend, uint32 t_QueueDepth)
+		: m_QueueDepth(t_QueueDepth)
+	{
+		m_Backend = FileReadBackend::ThreadPool;
+
+#if FLING_LINUX
+		if (t_Backend != FileReadBackend::ThreadPool)
+		{
+			if (InitIoUring(t_QueueDepth))
+			{
+				m_Backend = FileReadBackend::IoUring;
+			}
+			else if (t_Backend == FileReadBackend::IoUring)
+			{
+				F_LOG_WARN("io_uring isn't available, file reads will use the thread pool");
+			}
+		}
+#else
+		if (t_Backend == FileReadBackend::IoUring)
+		{
+			F_LOG_WARN("io_uring is only on Linux, file reads will use the thread pool");
+		}
+#endif
+	}
+
+	BatchFileReader::~BatchFileReader()
+	{
+		Clear();
+
+#if FLING_LINUX
+		ShutdownIoUring();
+#endif
+	}
+
+	size_t BatchFileReader::Add(const std::string& t_Path, void* t_Dest, size_t t_DestCapacity)
+	{
+		Read& NewRead = m_Reads.emplace_back();
+		NewRead.Path = t_Path;
+		NewRead.Dest = t_Dest;
+		NewRead.DestCapacity = t_DestCapacity;
+		return m_Reads.size() - 1;
+	}
+
+	size_t BatchFileReader::ReadAll()
+	{
+		// Open everything first so that the reads can all go out together
+		std::vector<Read*> Batch;
+		std::vector<Read*> ToRead;
+		ToRead.reserve(m_Reads.size());
+		for (Read& Pending : m_Reads)
+		{
+			if (Pending.bDone)
+			{
+				continue;
+			}
+			Pending.bDone = true;
+			Batch.push_back(&Pending);
+
+			if (!Prepare(Pending))
+			{
+				CloseFile(Pending);
+				continue;
+			}
+
+			// Empty files are done already
+			if (Pending.Out.Size == 0)
+			{
+				Pending.Out.bSuccess = true;
+				CloseFile(Pending);
+				continue;
+			}
+			ToRead.push_back(&Pending);
+		}
+
+#if FLING_LINUX
+		if (m_Backend == FileReadBackend::IoUring)
+		{
+			ReadAllIoUring(ToRead);
+		}
+		else
+#endif
+		{
+			ReadAllThreadPool(ToRead);
+		}
+
+		size_t NumSucceeded = 0;
+		for (Read* Done : Batch)
+		{
+			CloseFile(*Done);
+			if (Done->Out.bSuccess)
+			{
+				++NumSucceeded;
+			}
+			else
+			{
+				Done->Out.Data = nullptr;
+				Done->Out.Size = 0;
+			}
+		}
+		return NumSucceeded;
+	}
+
+	std::shared_ptr<char> BatchFileReader::TakeBuffer(size_t t_Index)
+	{
+		return std::move(m_Reads[t_Index].OwnedBuffer);
+	}
+
+	void BatchFileReader::Clear()
+	{
+		for (Read& Pending : m_Reads)
+		{
+			CloseFile(Pending);
+		}
+		m_Reads.clear();
+	}
+
+	bool BatchFileReader::Prepare(Read& t_Read)
+	{
+		uint64 FileSize = 0;
+
+#if FLING_WINDOWS
+		HANDLE FileHandle = CreateFileA(t_Read.Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (FileHandle == INVALID_HANDLE_VALUE)
+		{
+			F_LOG_ERROR("Failed to open file: {}", t_Read.Path);
+			return false;
+		}
+		t_Read.File = reinterpret_cast<intptr_t>(FileHandle);
+
+		LARGE_INTEGER Size = {};
+		if (!GetFileSizeEx(FileHandle, &Size))
+		{
+			return false;
+		}
+		FileSize = static_cast<uint64>(Size.QuadPart);
+#else
+		// Not every file system can skip the page cache (i.e. tmpfs), those read it normally
+		t_Read.bDirect = true;
+		int FileDesc = open(t_Read.Path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+		if (FileDesc < 0 && errno == EINVAL)
+		{
+			t_Read.bDirect = false;
+			FileDesc = open(t_Read.Path.c_str(), O_RDONLY | O_CLOEXEC);
+		}
+		if (FileDesc < 0)
+		{
+			F_LOG_ERROR("Failed to open file: {}", t_Read.Path);
+			return false;
+		}
+		t_Read.File = FileDesc;
+
+		struct stat FileStat = {};
+		if (fstat(FileDesc, &FileStat) != 0 || !S_ISREG(FileStat.st_mode))
+		{
+			F_LOG_ERROR("Failed to read {}, it isn't a regular file", t_Read.Path);
+			return false;
+		}
+		FileSize = static_cast<uint64>(FileStat.st_size);
+#endif
+
+		const size_t BufferSize = GetBufferSize(FileSize);
+		if (t_Read.Dest)
+		{
+			if (reinterpret_cast<uintptr_t>(t_Read.Dest) % DirectIOAlignment != 0 || t_Read.DestCapacity < BufferSize)
+			{
+				F_LOG_ERROR("Can't read {} into a buffer that is misaligned or smaller than {} bytes", t_Read.Path, BufferSize);
+				return false;
+			}
+			t_Read.Out.Data = static_cast<const char*>(t_Read.Dest);
+		}
+		else
+		{
+			char* Buffer = static_cast<char*>(AlignedAlloc(BufferSize > 0 ? BufferSize : DirectIOAlignment, DirectIOAlignment));
+			if (!Buffer)
+			{
+				F_LOG_ERROR("Failed to allocate {} bytes to read {}", BufferSize, t_Read.Path);
+				return false;
+			}
+			t_Read.OwnedBuffer = std::shared_ptr<char>(Buffer, [](char* t_Buffer) { AlignedFree(t_Buffer); });
+			t_Read.Out.Data = Buffer;
+		}
+
+		t_Read.Out.Size = FileSize;
+		return true;
+	}
+
+	bool BatchFileReader::ReadBlocking(Read& t_Read, uint64 t_Offset)
+	{
+		char* const Buffer = const_cast<char*>(t_Read.Out.Data);
+		const uint64 FileSize = t_Read.Out.Size;
+
+		while (t_Offset < FileSize)
+		{
+#if FLING_WINDOWS
+			const uint64 Remaining = FileSize - t_Offset;
+			const DWORD ToRead = static_cast<DWORD>(Remaining < 0x40000000ull ? Remaining : 0x40000000ull);
+
+			OVERLAPPED Overlapped = {};
+			Overlapped.Offset = static_cast<DWORD>(t_Offset);
+			Overlapped.OffsetHigh = static_cast<DWORD>(t_Offset >> 32);
+
+			DWORD NumRead = 0;
+			if (!ReadFile(reinterpret_cast<HANDLE>(t_Read.File), Buffer + t_Offset, ToRead, &NumRead, &Overlapped) || NumRead == 0)
+			{
+				return false;
+			}
+			t_Offset += NumRead;
+#else
+			// Direct reads have to stay block aligned, so read whole blocks right up to the end of the buffer
+			const uint64 ToRead = GetBufferSize(FileSize) - t_Offset;
+			const ssize_t NumRead = pread(static_cast<int>(t_Read.File), Buffer + t_Offset, static_cast<size_t>(ToRead), static_cast<off_t>(t_Offset));
+			if (NumRead < 0 && errno == EINTR)
+			{
+				continue;
+			}
+
+			if (NumRead < 0 && errno == EINVAL && t_Read.bDirect)
+			{
+				// The file system wouldn't do this direct read after all, read it normally
+				const int Buffered = open(t_Read.Path.c_str(), O_RDONLY | O_CLOEXEC);
+				if (Buffered < 0)
+				{
+					return false;
+				}
+				close(static_cast<int>(t_Read.File));
+				t_Read.File = Buffered;
+				t_Read.bDirect = false;
+				continue;
+			}
+
+			if (NumRead <= 0)
+			{
+				return false;
+			}
+			t_Offset += static_cast<uint64>(NumRead);
+#endif
+		}
+		return true;
+	}
+
+	void BatchFileReader::CloseFile(Read& t_Read)
+	{
+		if (t_Read.File == -1)
+		{
+			return;
+		}
+
+#if FLING_WINDOWS
+		CloseHandle(reinterpret_cast<HANDLE>(t_Read.File));
+#else
+		close(static_cast<int>(t_Read.File));
+#endif
+		t_Read.File = -1;
+	}
+
+	void BatchFileReader::ReadAllThreadPool(std::vector<Read*>& t_Reads)
+	{
+		// One file per job, files are different sizes so bigger chunks would leave workers idle.
+		// Runs on the calling thread if the job system isn't running
+		JobSystem::Get().ParallelFor(static_cast<uint32>(t_Reads.size()), 1, [&](uint32 t_Begin, uint32 t_End)
+		{
+			for (uint32 i = t_Begin; i < t_End; ++i)
+			{
+				t_Reads[i]->Out.bSuccess = ReadBlocking(*t_Reads[i], 0);
+			}
+		});
+	}
+
+#if FLING_LINUX
+
+#if WITH_IO_URING
+
+	bool BatchFileReader::InitIoUring(uint32 t_QueueDepth)
+	{
+		io_uring_params Params = {};
+		const int RingFd = static_cast<int>(syscall(__NR_io_uring_setup, t_QueueDepth, &Params));
+		if (RingFd < 0)
+		{
+			// Old kernels don't have it and some sandboxes block it
+			return false;
+		}
+
+		std::unique_ptr<IoUring> Ring = std::make_unique<IoUring>();
+		Ring->Fd = RingFd;
+		Ring->SqRingSize = Params.sq_off.array + Params.sq_entries * sizeof(uint32);
+		Ring->CqRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+
+		// Newer kernels map both rings at once
+		if (Params.features & IORING_FEAT_SINGLE_MMAP)
+		{
+			Ring->SqRingSize = std::max(Ring->SqRingSize, Ring->CqRingSize);
+			Ring->CqRingSize = Ring->SqRingSize;
+		}
+
+		Ring->SqRing = mmap(nullptr, Ring->SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, IORING_OFF_SQ_RING);
+		if (Ring->SqRing == MAP_FAILED)
+		{
+			close(RingFd);
+			return false;
+		}
+
+		if (Params.features & IORING_FEAT_SINGLE_MMAP)
+		{
+			Ring->CqRing = Ring->SqRing;
+		}
+		else
+		{
+			Ring->CqRing = mmap(nullptr, Ring->CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, IORING_OFF_CQ_RING);
+			if (Ring->CqRing == MAP_FAILED)
+			{
+				munmap(Ring->SqRing, Ring->SqRingSize);
+				close(RingFd);
+				return false;
+			}
+		}
+
+		Ring->SqesSize = Params.sq_entries * sizeof(io_uring_sqe);
+		void* Sqes = mmap(nullptr, Ring->SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, IORING_OFF_SQES);
+		if (Sqes == MAP_FAILED)
+		{
+			if (Ring->CqRing != Ring->SqRing)
+			{
+				munmap(Ring->CqRing, Ring->CqRingSize);
+			}
+			munmap(Ring->SqRing, Ring->SqRingSize);
+			close(RingFd);
+			return false;
+		}
+		Ring->Sqes = static_cast<io_uring_sqe*>(Sqes);
+
+		char* SqBase = static_cast<char*>(Ring->SqRing);
+		Ring->SqHead = reinterpret_cast<uint32*>(SqBase + Params.sq_off.head);
+		Ring->SqTail = reinterpret_cast<uint32*>(SqBase + Params.sq_off.tail);
+		Ring->SqArray = reinterpret_cast<uint32*>(SqBase + Params.sq_off.array);
+		Ring->SqMask = *reinterpret_cast<uint32*>(SqBase + Params.sq_off.ring_mask);
+		Ring->SqEntries = Params.sq_entries;
+
+		char* CqBase = static_cast<char*>(Ring->CqRing);
+		Ring->CqHead = reinterpret_cast<uint32*>(CqBase + Params.cq_off.head);
+		Ring->CqTail = reinterpret_cast<uint32*>(CqBase + Params.cq_off.tail);
+		Ring->Cqes = reinterpret_cast<io_uring_cqe*>(CqBase + Params.cq_off.cqes);
+		Ring->CqMask = *reinterpret_cast<uint32*>(CqBase + Params.cq_off.ring_mask);
+
+		m_Ring = std::move(Ring);
+		return true;
+	}
+
+	void BatchFileReader::ShutdownIoUring()
+	{
+		if (!m_Ring)
+		{
+			return;
+		}
+
+		munmap(m_Ring->Sqes, m_Ring->SqesSize);
+		if (m_Ring->CqRing != m_Ring->SqRing)
+		{
+			munmap(m_Ring->CqRing, m_Ring->CqRingSize);
+		}
+		munmap(m_Ring->SqRing, m_Ring->SqRingSize);
+		close(m_Ring->Fd);
+		m_Ring.reset();
+	}
+
+	void BatchFileReader::ReadAllIoUring(std::vector<Read*>& t_Reads)
+	{
+		IoUring& Ring = *m_Ring;
+
+		// The kernel reads these when the request is submitted, so they have to stay put until then
+		std::vector<iovec> Buffers(t_Reads.size());
+
+		size_t NextToQueue = 0;
+		size_t NumInFlight = 0;
+		size_t NumDone = 0;
+
+		// Reads the kernel has taken off the submission queue and not completed yet
+		size_t NumSubmitted = 0;
+		while (NumDone < t_Reads.size())
+		{
+			// Fill up the submission queue. Only this thread writes the tail
+			uint32 SqTail = *Ring.SqTail;
+			const uint32 SqHead = __atomic_load_n(Ring.SqHead, __ATOMIC_ACQUIRE);
+			while (NextToQueue < t_Reads.size() && NumInFlight < Ring.SqEntries && SqTail - SqHead < Ring.SqEntries)
+			{
+				Read& Pending = *t_Reads[NextToQueue];
+				Buffers[NextToQueue].iov_base = const_cast<char*>(Pending.Out.Data);
+				Buffers[NextToQueue].iov_len = GetBufferSize(Pending.Out.Size);
+
+				const uint32 Index = SqTail & Ring.SqMask;
+				io_uring_sqe& Sqe = Ring.Sqes[Index];
+				std::memset(&Sqe, 0, sizeof(Sqe));
+				Sqe.opcode = IORING_OP_READV;
+				Sqe.fd = static_cast<int>(Pending.File);
+				Sqe.addr = reinterpret_cast<uint64>(&Buffers[NextToQueue]);
+				Sqe.len = 1;
+				Sqe.off = 0;
+				Sqe.user_data = NextToQueue;
+				Ring.SqArray[Index] = Index;
+
+				++SqTail;
+				++NextToQueue;
+				++NumInFlight;
+			}
+			__atomic_store_n(Ring.SqTail, SqTail, __ATOMIC_RELEASE);
+
+			// Hand over everything the kernel hasn't taken yet, then wait for all of it
+			// unless there is more to queue up once some of it finishes
+			const uint32 ToSubmit = SqTail - __atomic_load_n(Ring.SqHead, __ATOMIC_ACQUIRE);
+			const uint32 WaitFor = NextToQueue < t_Reads.size() ? 1 : static_cast<uint32>(NumInFlight);
+			const int Entered = static_cast<int>(syscall(__NR_io_uring_enter, Ring.Fd, ToSubmit, WaitFor, IORING_ENTER_GETEVENTS, nullptr, 0));
+			if (Entered < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			{
+				F_LOG_ERROR("io_uring_enter failed ({}), finishing the batch with blocking reads", errno);
+				break;
+			}
+			if (Entered > 0)
+			{
+				NumSubmitted += static_cast<size_t>(Entered);
+			}
+
+			// Drain the completions
+			uint32 CqHead = *Ring.CqHead;
+			const uint32 CqTail = __atomic_load_n(Ring.CqTail, __ATOMIC_ACQUIRE);
+			for (; CqHead != CqTail; ++CqHead)
+			{
+				const io_uring_cqe& Cqe = Ring.Cqes[CqHead & Ring.CqMask];
+				Read& Completed = *t_Reads[static_cast<size_t>(Cqe.user_data)];
+
+				if (Cqe.res >= 0 && static_cast<uint64>(Cqe.res) >= Completed.Out.Size)
+				{
+					Completed.Out.bSuccess = true;
+				}
+				else if (Cqe.res > 0)
+				{
+					// A short read, finish the rest of it here
+					Completed.Out.bSuccess = ReadBlocking(Completed, static_cast<uint64>(Cqe.res));
+				}
+				else
+				{
+					// Retry with a blocking read, which also handles file systems that turn down direct reads
+					Completed.Out.bSuccess = ReadBlocking(Completed, 0);
+				}
+
+				--NumInFlight;
+				--NumSubmitted;
+				++NumDone;
+			}
+			__atomic_store_n(Ring.CqHead, CqHead, __ATOMIC_RELEASE);
+		}
+
+		if (NumDone < t_Reads.size())
+		{
+			// The ring is broken, wait out anything the kernel still has so that it doesn't write into a freed buffer.
+			// Reads that are still sitting in the submission queue will never complete, so don't wait for those
+			if (NumSubmitted > 0)
+			{
+				syscall(__NR_io_uring_enter, Ring.Fd, 0, static_cast<uint32>(NumSubmitted), IORING_ENTER_GETEVENTS, nullptr, 0);
+			}
+			ShutdownIoUring();
+			m_Backend = FileReadBackend::ThreadPool;
+
+			std::vector<Read*> Remaining;
+			for (Read* Pending : t_Reads)
+			{
+				if (!Pending->Out.bSuccess)
+				{
+					Remaining.push_back(Pending);
+				}
+			}
+			ReadAllThreadPool(Remaining);
+		}
+	}
+
+#else
+
+	bool BatchFileReader::InitIoUring(uint32)
+	{
+		// Compiled without WITH_IO_URING
+		return false;
+	}
+
+	void BatchFileReader::ShutdownIoUring()
+	{
+	}
+
+	void BatchFileReader::ReadAllIoUring(std::vector<Read*>& t_Reads)
+	{
+		ReadAllThreadPool(t_Reads);
+	}
+
+#endif	// WITH_IO_URING
+
+#endif	// FLING_LINUX
+}   // namespace Fling
@@ -0,0 +1,236 @@
+#include "pch.h"
+#include "Compression.h"
+
+#include <cstring>
+#include <memory>
+
+namespace Fling
+{
+	namespace Compression
+	{
+		namespace
+		{
+			static constexpr size_t MinMatch = 4;
+
+			/** The end of the data is always literals, so matching stops this far from the end */
+			static constexpr size_t LastLiterals = 5;
+
+			static constexpr size_t MaxOffset = 65535;
+
+			static constexpr uint32 HashLog = 14;
+
+			inline uint32 Read32(const uint8* t_Ptr)
+			{
+				uint32 Value;
+				std::memcpy(&Value, t_Ptr, sizeof(Value));
+				return Value;
+			}
+
+			inline uint32 HashSequence(uint32 t_Sequence)
+			{
+				return (t_Sequence * 2654435761u) >> (32 - HashLog);
+			}
+
+			/** Writes compressed output, remembering if it ever ran out of room */
+			struct Writer
+			{
+				uint8* Ptr;
+				uint8* End;
+				bool bOverflow = false;
+
+				inline bool HasRoom(size_t t_Size)
+				{
+					bOverflow |= static_cast<size_t>(End - Ptr) < t_Size;
+					return !bOverflow;
+				}
+
+				inline void WriteLength(size_t t_Length)
+				{
+					while (t_Length >= 255 && HasRoom(1))
+					{
+						*Ptr++ = 255;
+						t_Length -= 255;
+					}
+					if (HasRoom(1))
+					{
+						*Ptr++ = static_cast<uint8>(t_Length);
+					}
+				}
+
+				void WriteSequence(const uint8* t_Literals, size_t t_NumLiterals, size_t t_Offset, size_t t_MatchLength)
+				{
+					if (!HasRoom(1))
+					{
+						return;
+					}
+
+					uint8& Token = *Ptr++;
+					Token = static_cast<uint8>((t_NumLiterals >= 15 ? 15 : t_NumLiterals) << 4);
+					if (t_NumLiterals >= 15)
+					{
+						WriteLength(t_NumLiterals - 15);
+					}
+
+					if (!HasRoom(t_NumLiterals))
+					{
+						return;
+					}
+					std::memcpy(Ptr, t_Literals, t_NumLiterals);
+					Ptr += t_NumLiterals;
+
+					// The last sequence doesn't have a match
+					if (t_MatchLength == 0 || !HasRoom(2))
+					{
+						return;
+					}
+
+					*Ptr++ = static_cast<uint8>(t_Offset & 0xFF);
+					*Ptr++ = static_cast<uint8>(t_Offset >> 8);
+
+					const size_t ExtraMatch = t_MatchLength - MinMatch;
+					Token |= static_cast<uint8>(ExtraMatch >= 15 ? 15 : ExtraMatch);
+					if (ExtraMatch >= 15)
+					{
+						WriteLength(ExtraMatch - 15);
+					}
+				}
+			};
+
+			/** Read an extended length, returns false if it runs off the end of the input */
+			inline bool ReadLength(const uint8*& t_Ptr, const uint8* t_End, size_t& t_Length)
+			{
+				uint8 Byte = 0;
+				do
+				{
+					if (t_Ptr >= t_End)
+					{
+						return false;
+					}
+					Byte = *t_Ptr++;
+					t_Length += Byte;
+				} while (Byte == 255);
+				return true;
+			}
+		}
+
+		size_t Compress(const void* t_Src, size_t t_SrcSize, void* t_Dst, size_t t_DstCapacity)
+		{
+			const uint8* const Src = static_cast<const uint8*>(t_Src);
+			Writer Out { static_cast<uint8*>(t_Dst), static_cast<uint8*>(t_Dst) + t_DstCapacity };
+
+			size_t Anchor = 0;
+			if (t_SrcSize > MinMatch + LastLiterals)
+			{
+				// Position + 1 of the last time each hashed sequence was seen, 0 if never
+				std::unique_ptr<uint32[]> Table = std::make_unique<uint32[]>(size_t(1) << HashLog);
+
+				const size_t MatchLimit = t_SrcSize - LastLiterals;
+				size_t Pos = 0;
+				while (Pos + MinMatch <= MatchLimit && !Out.bOverflow)
+				{
+					const uint32 Sequence = Read32(Src + Pos);
+					uint32& Entry = Table[HashSequence(Sequence)];
+					const size_t Candidate = static_cast<size_t>(Entry) - 1;
+					const bool bHasCandidate = Entry != 0;
+					Entry = static_cast<uint32>(Pos + 1);
+
+					if (!bHasCandidate || Pos - Candidate > MaxOffset || Read32(Src + Candidate) != Sequence)
+					{
+						// Skip ahead faster the longer it has been since the last match
+						Pos += 1 + ((Pos - Anchor) >> 6);
+						continue;
+					}
+
+					size_t Length = MinMatch;
+					while (Pos + Length < MatchLimit && Src[Candidate + Length] == Src[Pos + Length])
+					{
+						++Length;
+					}
+
+					Out.WriteSequence(Src + Anchor, Pos - Anchor, Pos - Candidate, Length);
+					Pos += Length;
+					Anchor = Pos;
+				}
+			}
+
+			Out.WriteSequence(Src + Anchor, t_SrcSize - Anchor, 0, 0);
+			if (Out.bOverflow)
+			{
+				return 0;
+			}
+			return static_cast<size_t>(Out.Ptr - static_cast<uint8*>(t_Dst));
+		}
+
+		bool Decompress(const void* t_Src, size_t t_SrcSize, void* t_Dst, size_t t_DstSize)
+		{
+			const uint8* In = static_cast<const uint8*>(t_Src);
+			const uint8* const InEnd = In + t_SrcSize;
+			uint8* const Dst = static_cast<uint8*>(t_Dst);
+			uint8* Out = Dst;
+			uint8* const OutEnd = Dst + t_DstSize;
+
+			while (In < InEnd)
+			{
+				const uint8 Token = *In++;
+
+				size_t NumLiterals = Token >> 4;
+				if (NumLiterals == 15 && !ReadLength(In, InEnd, NumLiterals))
+				{
+					return false;
+				}
+				if (NumLiterals > static_cast<size_t>(InEnd - In) || NumLiterals > static_cast<size_t>(OutEnd - Out))
+				{
+					return false;
+				}
+				std::memcpy(Out, In, NumLiterals);
+				In += NumLiterals;
+				Out += NumLiterals;
+
+				// Only the last sequence ends right after its literals
+				if (In == InEnd)
+				{
+					break;
+				}
+
+				if (InEnd - In < 2)
+				{
+					return false;
+				}
+				const size_t Offset = static_cast<size_t>(In[0]) | (static_cast<size_t>(In[1]) << 8);
+				In += 2;
+				if (Offset == 0 || Offset > static_cast<size_t>(Out - Dst))
+				{
+					return false;
+				}
+
+				size_t Length = Token & 15;
+				if (Length == 15 && !ReadLength(In, InEnd, Length))
+				{
+					return false;
+				}
+				Length += MinMatch;
+				if (Length > static_cast<size_t>(OutEnd - Out))
+				{
+					return false;
+				}
+
+				const uint8* Match = Out - Offset;
+				if (Offset >= Length)
+				{
+					std::memcpy(Out, Match, Length);
+					Out += Length;
+				}
+				else
+				{
+					// Overlapping copies repeat the last Offset bytes, so they have to go a byte at a time
+					for (size_t i = 0; i < Length; ++i)
+					{
+						*Out++ = Match[i];
+					}
+				}
+			}
+
+			return Out == OutEnd;
+		}
+	}
+}   // namespace Fling
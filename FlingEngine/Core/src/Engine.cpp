@@ -4,6 +4,10 @@
 #include "File.h"
 #include "VulkanApp.h"
 #include "Misc/CommandLine.h"
+#include "JobSystem.h"
+#include "FrameAllocator.h"
+#include "Profiler.h"
+#include "FixedTimestep.h"
 #include "ComponentTypeRegistry.h"
 #include "RegisterGraphicsComponents.h"
 
@@ -54,6 +58,14 @@ namespace Fling
 		// only set in the config file. Command line args passed directly still win.
 		CommandLine::Get().LoadConfigFile(EngineConfigPath);
 
+		// Start profiling as early as possible so that "ProfileFrames" captures everything
+		Profiler::Get().Init();
+		Profiler::Get().SetThreadName("Main Thread");
+
+		// Start the job system after the config is loaded so that the worker count can be configured
+		JobSystem::Get().Init();
+		FrameAllocator::Get().Init();
+
 		VulkanApp::Get().Init(
 			static_cast<PipelineFlags>(PipelineFlags::DEFERRED | PipelineFlags::IMGUI),
 			g_Registry,
@@ -94,19 +106,62 @@ namespace Fling
 		// Once the world is initialized it allows the users to add their own components!
 		m_World->Init();
 
+		// Optionally run gameplay at a fixed rate and interpolate between steps when rendering
+		const bool bUseFixedTimestep = CommandLine::Get().GetValueAs<bool>("FixedTimestep", false);
+		FixedTimestep SimTimestep(
+			CommandLine::Get().GetValueAs<float>("SimulationHz", 60.0f),
+			CommandLine::Get().GetValueAs<uint32>("MaxSimStepsPerFrame", 5u)
+		);
+
+		if (bUseFixedTimestep)
+		{
+			F_LOG_TRACE("Fixed timestep: {} steps per second, max {} steps per frame", 1.0f / SimTimestep.GetStepSize(), SimTimestep.GetMaxStepsPerFrame());
+		}
+
 		while(!VkApp.GetCurrentWindow()->ShouldClose())
 		{
+            // If rendering is pipelined, wait for the render thread to catch up to the last frame
+            VkApp.BeginFrame(g_Registry);
+
+            // Anything allocated for transient data two frames ago can be thrown out now
+            FrameAllocator::Get().BeginFrame();
+
+            // Collect last frame's profile zones before we start timing this one
+            Profiler::Get().BeginFrame();
+            FLING_PROFILE_SCOPE("Engine::Tick");
+
             // Update timing
             Timing.Update();
             DeltaTime = Timing.GetDeltaTime();
 
-			// Update FPS Counter
+			// Update frame time stats
             Stats::Frames::TickStats(DeltaTime);
 			
-			Input::Poll();
+			{
+				Stats::ScopedPhaseTimer InputTimer(Stats::Phase::Input);
+				Input::Poll();
+			}
+
+			// Finish off any resources that streamed in so that gameplay and rendering can use them
+			ResourceManager::Get().Update();
 
 			// World update will handle the starting, updating, and stopping of game logic
-			m_World->Update(DeltaTime);
+			{
+				Stats::ScopedPhaseTimer WorldTimer(Stats::Phase::World);
+				if (bUseFixedTimestep)
+				{
+					const uint32 NumSteps = SimTimestep.Advance(DeltaTime);
+					for (uint32 Step = 0; Step < NumSteps && !m_World->ShouldQuit(); ++Step)
+					{
+						m_World->FixedUpdate(SimTimestep.GetStepSize());
+					}
+					Timing.SetInterpolationAlpha(SimTimestep.GetAlpha());
+				}
+				else
+				{
+					m_World->Update(DeltaTime);
+				}
+			}
 
 			if(m_World->ShouldQuit())
 			{
@@ -114,10 +169,17 @@ namespace Fling
 				break;
 			}
 			
-			VkApp.Update(DeltaTime, g_Registry);
+			// When rendering is pipelined this only covers handing the frame off to the render thread
+			{
+				Stats::ScopedPhaseTimer RenderTimer(Stats::Phase::Render);
+				VkApp.Update(DeltaTime, g_Registry);
+			}
 
 			Timing.UpdateFps();
 		}
+
+		// Make sure nothing is still drawing with the world before it is shut down
+		VkApp.FlushRenderThread();
 	}
 
 	void Engine::Shutdown()
@@ -134,6 +196,16 @@ namespace Fling
     	delete m_World;
     	m_World = nullptr;
 		
+		// Write out any profile capture that didn't get to finish
+		Profiler::Get().Shutdown();
+
+		// Dump the frame time histograms so that runs can be compared against each other
+		Stats::Frames::LogSummary();
+		Stats::Draws::LogSummary();
+		const std::string FrameStatsPath = CommandLine::Get().GetValueAs<std::string>("FrameStatsOutput", FlingPaths::EngineLogDir() + "/FrameStats.csv");
+		Stats::Frames::WriteHistograms(FrameStatsPath);
+		ResourceManager::Get().LogResidency();
+
 		// Cleanup any resources
 		Input::Shutdown();
         ResourceManager::Get().Shutdown();
@@ -141,6 +213,8 @@ namespace Fling
         FlingConfig::Get().Shutdown();
 		Timing::Get().Shutdown();
 		VulkanApp::Get().Shutdown(g_Registry);
+		JobSystem::Get().Shutdown();
+		FrameAllocator::Get().Shutdown();
 
 		g_Registry.reset();
 	}
@@ -0,0 +1,43 @@
+#include "pch.h"
+#include "FixedTimestep.h"
+
+namespace Fling
+{
+	FixedTimestep::FixedTimestep(float t_StepRate, uint32 t_MaxStepsPerFrame)
+	{
+		if (t_StepRate <= 0.0f)
+		{
+			F_LOG_WARN("Invalid fixed timestep rate {}, using 60hz", t_StepRate);
+			t_StepRate = 60.0f;
+		}
+
+		m_StepSize = 1.0 / static_cast<double>(t_StepRate);
+		m_MaxStepsPerFrame = t_MaxStepsPerFrame > 0 ? t_MaxStepsPerFrame : 1;
+	}
+
+	uint32 FixedTimestep::Advance(float t_FrameTime)
+	{
+		if (t_FrameTime > 0.0f)
+		{
+			m_Accumulator += static_cast<double>(t_FrameTime);
+		}
+
+		uint32 Steps = static_cast<uint32>(m_Accumulator / m_StepSize);
+		m_Accumulator -= static_cast<double>(Steps) * m_StepSize;
+		if (m_Accumulator < 0.0)
+		{
+			// Rounding error, never let the alpha go negative
+			m_Accumulator = 0.0;
+		}
+
+		// Too far behind to catch up, drop the extra steps rather than spiraling
+		if (Steps > m_MaxStepsPerFrame)
+		{
+			m_DroppedTime += static_cast<double>(Steps - m_MaxStepsPerFrame) * m_StepSize;
+			Steps = m_MaxStepsPerFrame;
+		}
+
+		m_TotalSteps += Steps;
+		return Steps;
+	}
+}   // namespace Fling
@@ -0,0 +1,108 @@
+#include "pch.h"
+#include "FrameAllocator.h"
+#include "Memory.h"
+#include "Misc/CommandLine.h"
+
+namespace Fling
+{
+	void FrameAllocator::Init()
+	{
+		assert(m_Memory == nullptr);
+
+		const int64 RequestedSize = CommandLine::Get().GetValueAs<int64>("FrameAllocatorSize", static_cast<int64>(DefaultFrameSize));
+		m_FrameSize = RequestedSize > 0 ? static_cast<size_t>(RequestedSize) : DefaultFrameSize;
+
+		m_Memory = static_cast<char*>(AlignedAlloc(m_FrameSize * NumBufferedFrames, 64));
+		if (m_Memory == nullptr)
+		{
+			F_LOG_FATAL("Failed to allocate memory for the frame allocator");
+		}
+
+		for (std::atomic<size_t>& Offset : m_FrameOffsets)
+		{
+			Offset.store(0, std::memory_order_relaxed);
+		}
+
+		m_CurrentFrame = 0;
+		m_HeapFallbackCount = 0;
+	}
+
+	void FrameAllocator::Shutdown()
+	{
+		AlignedFree(m_Memory);
+		m_Memory = nullptr;
+	}
+
+	void FrameAllocator::BeginFrame()
+	{
+		// Empty the next frame before anyone can allocate from it
+		const uint32 NextFrame = (m_CurrentFrame.load(std::memory_order_relaxed) + 1) % NumBufferedFrames;
+		m_FrameOffsets[NextFrame].store(0, std::memory_order_relaxed);
+		m_CurrentFrame.store(NextFrame, std::memory_order_release);
+	}
+
+	void* FrameAllocator::Allocate(size_t t_Size, size_t t_Alignment)
+	{
+		assert((t_Alignment & (t_Alignment - 1)) == 0);
+
+		void* Mem = nullptr;
+		if (m_Memory != nullptr)
+		{
+			const uint32 Frame = m_CurrentFrame.load(std::memory_order_acquire);
+			const uintptr_t Start = reinterpret_cast<uintptr_t>(m_Memory) + Frame * m_FrameSize;
+			std::atomic<size_t>& Offset = m_FrameOffsets[Frame];
+
+			size_t Used = Offset.load(std::memory_order_relaxed);
+			while (true)
+			{
+				const size_t Aligned = ((Start + Used + t_Alignment - 1) & ~static_cast<uintptr_t>(t_Alignment - 1)) - Start;
+				if (Aligned + t_Size > m_FrameSize || Aligned + t_Size < Aligned)
+				{
+					break;
+				}
+
+				// Someone else got there first if this fails, try again after what they took
+				if (Offset.compare_exchange_weak(Used, Aligned + t_Size, std::memory_order_relaxed))
+				{
+					Mem = reinterpret_cast<void*>(Start + Aligned);
+					break;
+				}
+			}
+		}
+
+		if (Mem == nullptr)
+		{
+			if (m_HeapFallbackCount.fetch_add(1, std::memory_order_relaxed) == 0)
+			{
+				F_LOG_WARN("Frame allocator is out of memory, falling back to the heap. Consider increasing FrameAllocatorSize (currently {} bytes)", m_FrameSize);
+			}
+
+			Mem = AlignedAlloc(t_Size, std::max<size_t>(t_Alignment, sizeof(void*)));
+			if (Mem == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+		}
+
+		return Mem;
+	}
+
+	void FrameAllocator::Free(void* t_Ptr)
+	{
+		if (t_Ptr != nullptr && !Owns(t_Ptr))
+		{
+			AlignedFree(t_Ptr);
+		}
+	}
+
+	size_t FrameAllocator::GetCurrentFrameUsage() const
+	{
+		return m_FrameOffsets[m_CurrentFrame.load(std::memory_order_acquire)].load(std::memory_order_relaxed);
+	}
+
+	bool FrameAllocator::Owns(const void* t_Ptr) const
+	{
+		const char* Ptr = static_cast<const char*>(t_Ptr);
+		return m_Memory != nullptr && Ptr >= m_Memory && Ptr < m_Memory + m_FrameSize * NumBufferedFrames;
+	}
+}   // namespace Fling
@@ -0,0 +1,115 @@
+#include "pch.h"
+#include "Hash.h"
+
+#include <cstring>
+
+namespace Fling
+{
+	namespace
+	{
+		static constexpr uint64 Prime1 = 11400714785074694791ull;
+		static constexpr uint64 Prime2 = 14029467366897019727ull;
+		static constexpr uint64 Prime3 = 1609587929392839161ull;
+		static constexpr uint64 Prime4 = 9650029242287828579ull;
+		static constexpr uint64 Prime5 = 2870177450012600261ull;
+
+		inline uint64 RotateLeft(uint64 t_Value, uint32 t_Bits)
+		{
+			return (t_Value << t_Bits) | (t_Value >> (64 - t_Bits));
+		}
+
+		inline uint64 Read64(const uint8* t_Ptr)
+		{
+			uint64 Value;
+			std::memcpy(&Value, t_Ptr, sizeof(Value));
+			return Value;
+		}
+
+		inline uint32 Read32(const uint8* t_Ptr)
+		{
+			uint32 Value;
+			std::memcpy(&Value, t_Ptr, sizeof(Value));
+			return Value;
+		}
+
+		inline uint64 Round(uint64 t_Acc, uint64 t_Input)
+		{
+			t_Acc += t_Input * Prime2;
+			t_Acc = RotateLeft(t_Acc, 31);
+			return t_Acc * Prime1;
+		}
+
+		inline uint64 MergeRound(uint64 t_Acc, uint64 t_Value)
+		{
+			t_Acc ^= Round(0, t_Value);
+			return t_Acc * Prime1 + Prime4;
+		}
+	}
+
+	uint64 HashBytes64(const void* t_Data, size_t t_Size, uint64 t_Seed)
+	{
+		const uint8* Ptr = static_cast<const uint8*>(t_Data);
+		const uint8* const End = Ptr + t_Size;
+
+		uint64 Hash = 0;
+		if (t_Size >= 32)
+		{
+			// Four independent lanes so that the multiplies can overlap
+			uint64 V1 = t_Seed + Prime1 + Prime2;
+			uint64 V2 = t_Seed + Prime2;
+			uint64 V3 = t_Seed;
+			uint64 V4 = t_Seed - Prime1;
+
+			const uint8* const Limit = End - 32;
+			do
+			{
+				V1 = Round(V1, Read64(Ptr));
+				V2 = Round(V2, Read64(Ptr + 8));
+				V3 = Round(V3, Read64(Ptr + 16));
+				V4 = Round(V4, Read64(Ptr + 24));
+				Ptr += 32;
+			} while (Ptr <= Limit);
+
+			Hash = RotateLeft(V1, 1) + RotateLeft(V2, 7) + RotateLeft(V3, 12) + RotateLeft(V4, 18);
+			Hash = MergeRound(Hash, V1);
+			Hash = MergeRound(Hash, V2);
+			Hash = MergeRound(Hash, V3);
+			Hash = MergeRound(Hash, V4);
+		}
+		else
+		{
+			Hash = t_Seed + Prime5;
+		}
+
+		Hash += static_cast<uint64>(t_Size);
+
+		while (Ptr + 8 <= End)
+		{
+			Hash ^= Round(0, Read64(Ptr));
+			Hash = RotateLeft(Hash, 27) * Prime1 + Prime4;
+			Ptr += 8;
+		}
+
+		if (Ptr + 4 <= End)
+		{
+			Hash ^= static_cast<uint64>(Read32(Ptr)) * Prime1;
+			Hash = RotateLeft(Hash, 23) * Prime2 + Prime3;
+			Ptr += 4;
+		}
+
+		while (Ptr < End)
+		{
+			Hash ^= static_cast<uint64>(*Ptr) * Prime5;
+			Hash = RotateLeft(Hash, 11) * Prime1;
+			++Ptr;
+		}
+
+		// Avalanche
+		Hash ^= Hash >> 33;
+		Hash *= Prime2;
+		Hash ^= Hash >> 29;
+		Hash *= Prime3;
+		Hash ^= Hash >> 32;
+		return Hash;
+	}
+}   // namespace Fling
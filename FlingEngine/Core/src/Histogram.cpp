@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "Histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Fling
+{
+	void Histogram::Reset()
+	{
+		std::fill(std::begin(m_Buckets), std::end(m_Buckets), 0);
+		m_Count = 0;
+		m_Sum = 0;
+		m_Min = UINT64_MAX;
+		m_Max = 0;
+	}
+
+	void Histogram::Add(const Histogram& t_Other)
+	{
+		for (uint32 i = 0; i < NumBuckets; ++i)
+		{
+			m_Buckets[i] += t_Other.m_Buckets[i];
+		}
+
+		m_Count += t_Other.m_Count;
+		m_Sum += t_Other.m_Sum;
+		m_Min = std::min(m_Min, t_Other.m_Min);
+		m_Max = std::max(m_Max, t_Other.m_Max);
+	}
+
+	uint64 Histogram::GetPercentile(double t_Percentile) const
+	{
+		if (m_Count == 0)
+		{
+			return 0;
+		}
+
+		const double Clamped = std::min(std::max(t_Percentile, 0.0), 100.0);
+
+		// Number of values that have to be at or below the result, always at least one
+		const uint64 Target = std::max<uint64>(1, static_cast<uint64>(std::ceil(Clamped / 100.0 * static_cast<double>(m_Count))));
+
+		uint64 Seen = 0;
+		for (uint32 i = 0; i < NumBuckets; ++i)
+		{
+			Seen += m_Buckets[i];
+			if (Seen >= Target)
+			{
+				// Never report something outside of what was actually recorded
+				return std::min(std::max(GetBucketUpperBound(i), GetMin()), m_Max);
+			}
+		}
+
+		return m_Max;
+	}
+
+	uint64 Histogram::GetBucketLowerBound(uint32 t_Index)
+	{
+		if (t_Index < SubBucketCount)
+		{
+			return t_Index;
+		}
+
+		if (t_Index == NumBuckets - 1)
+		{
+			return MaxTrackableValue + 1;
+		}
+
+		const uint32 Shift = t_Index / SubBucketCount - 1;
+		const uint64 Mantissa = (t_Index % SubBucketCount) + SubBucketCount;
+		return Mantissa << Shift;
+	}
+
+	uint64 Histogram::GetBucketUpperBound(uint32 t_Index)
+	{
+		if (t_Index < SubBucketCount)
+		{
+			return t_Index;
+		}
+
+		// The overflow bucket holds everything that was too big to track
+		if (t_Index == NumBuckets - 1)
+		{
+			return UINT64_MAX;
+		}
+
+		const uint32 Shift = t_Index / SubBucketCount - 1;
+		const uint64 Mantissa = (t_Index % SubBucketCount) + SubBucketCount;
+		return ((Mantissa + 1) << Shift) - 1;
+	}
+
+	void Histogram::WriteCsv(std::ostream& t_Out, const char* t_Name) const
+	{
+		for (uint32 i = 0; i < NumBuckets; ++i)
+		{
+			if (m_Buckets[i] > 0)
+			{
+				t_Out << t_Name << ',' << GetBucketLowerBound(i) << ',' << GetBucketUpperBound(i) << ',' << m_Buckets[i] << '\n';
+			}
+		}
+	}
+}   // namespace Fling
@@ -0,0 +1,322 @@
+#include "pch.h"
+#include "JobSystem.h"
+#include "Misc/CommandLine.h"
+#include "Profiler.h"
+
+namespace Fling
+{
+	namespace
+	{
+		static constexpr uint32 InvalidWorkerIndex = ~0u;
+
+		/** Number of times an idle worker will spin looking for work before it goes to sleep */
+		static constexpr uint32 IdleSpinCount = 64;
+
+		/** Index of the worker that the current thread owns, the main thread is always 0 */
+		thread_local uint32 tl_WorkerIndex = InvalidWorkerIndex;
+
+		/** Rotates which worker we try to steal from first so that threads don't all hit the same victim */
+		thread_local uint32 tl_StealIndex = 0;
+	}
+
+	void JobSystem::Init()
+	{
+		assert(!IsRunning());
+
+		const uint32 HardwareThreads = std::max<uint32>(std::thread::hardware_concurrency(), 1u);
+		int32 NumWorkerThreads = CommandLine::Get().GetValueAs<int32>("JobWorkerCount", static_cast<int32>(HardwareThreads - 1));
+		NumWorkerThreads = std::max<int32>(NumWorkerThreads, 0);
+
+		// The main thread is always worker 0
+		m_Workers.reserve(NumWorkerThreads + 1);
+		for (int32 i = 0; i <= NumWorkerThreads; ++i)
+		{
+			m_Workers.emplace_back(std::make_unique<Worker>());
+		}
+		tl_WorkerIndex = 0;
+		m_External = std::make_unique<ExternalJobs>();
+
+		m_IsRunning.store(true, std::memory_order_release);
+
+		for (uint32 i = 1; i < GetWorkerCount(); ++i)
+		{
+			m_Workers[i]->m_Thread = std::thread(&JobSystem::WorkerThreadLoop, this, i);
+		}
+
+		F_LOG_TRACE("Job System: Started {} worker threads", NumWorkerThreads);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> Lock(m_WakeMutex);
+			m_IsRunning.store(false, std::memory_order_release);
+		}
+		m_WakeCondition.notify_all();
+
+		for (std::unique_ptr<Worker>& Work : m_Workers)
+		{
+			if (Work->m_Thread.joinable())
+			{
+				Work->m_Thread.join();
+			}
+		}
+
+		m_Workers.clear();
+		m_External.reset();
+		tl_WorkerIndex = InvalidWorkerIndex;
+	}
+
+	bool JobSystem::IsWorkerThread() const
+	{
+		return tl_WorkerIndex < GetWorkerCount();
+	}
+
+	JobSystem::Worker& JobSystem::GetCurrentWorker()
+	{
+		assert(IsWorkerThread() && "Jobs can only be created and run from job system threads");
+		return *m_Workers[tl_WorkerIndex];
+	}
+
+	Job* JobSystem::AllocateJob()
+	{
+		if (!IsWorkerThread())
+		{
+			return AllocateExternalJob();
+		}
+
+		Worker& Current = GetCurrentWorker();
+		Job* NewJob = Current.m_JobPool.GetItem();
+
+		// The pool wraps around, so the slot can still hold a job that is queued, deferred or running
+		// on another thread. Help out with other work until it is done instead of overwriting it
+		while (!NewJob->m_bFinished.load(std::memory_order_acquire))
+		{
+			if (Job* OtherJob = GetJob(Current))
+			{
+				TryExecute(Current, OtherJob);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		NewJob->m_bFinished.store(false, std::memory_order_relaxed);
+		return NewJob;
+	}
+
+	Job* JobSystem::AllocateExternalJob()
+	{
+		assert(IsRunning() && "Threads that aren't workers can only create jobs while the job system is running");
+
+		Job* NewJob = nullptr;
+		{
+			std::lock_guard<std::mutex> Lock(m_External->m_PoolMutex);
+			NewJob = m_External->m_JobPool.GetItem();
+		}
+
+		// Another thread may have wrapped around to the same slot, so only one of us gets to claim it
+		bool bFinished = true;
+		while (!NewJob->m_bFinished.compare_exchange_weak(bFinished, false, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			bFinished = true;
+			if (!ExecuteExternalJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+		return NewJob;
+	}
+
+	bool JobSystem::ExecuteExternalJob()
+	{
+		Job* NextJob = nullptr;
+		if (!m_External->m_Queue.TryPop(NextJob))
+		{
+			return false;
+		}
+
+		Execute(NextJob);
+		return true;
+	}
+
+	void JobSystem::Run(Job* t_Job, const JobCounter* t_Dependency)
+	{
+		assert(t_Job);
+		t_Job->m_Dependency = t_Dependency;
+
+		if (t_Job->m_Counter)
+		{
+			t_Job->m_Counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (!IsWorkerThread())
+		{
+			// Nothing would own the job while it was put off, so it can't wait on another one
+			assert(t_Dependency == nullptr && "Jobs from threads that aren't workers can't have dependencies");
+			if (!m_External->m_Queue.TryPush(t_Job))
+			{
+				Execute(t_Job);
+				return;
+			}
+
+			m_WakeCondition.notify_one();
+			return;
+		}
+
+		Worker& Current = GetCurrentWorker();
+		if (!Current.m_Queue.Push(t_Job))
+		{
+			// Our queue is full, so make some room by doing this job ourselves
+			if (t_Dependency)
+			{
+				Wait(*t_Dependency);
+			}
+			Execute(t_Job);
+			return;
+		}
+
+		m_WakeCondition.notify_one();
+	}
+
+	void JobSystem::Wait(const JobCounter& t_Counter)
+	{
+		if (!IsWorkerThread())
+		{
+			while (!t_Counter.IsDone())
+			{
+				if (!ExecuteExternalJob())
+				{
+					std::this_thread::yield();
+				}
+			}
+			return;
+		}
+
+		Worker& Current = GetCurrentWorker();
+
+		while (!t_Counter.IsDone())
+		{
+			if (Job* NextJob = GetJob(Current))
+			{
+				TryExecute(Current, NextJob);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	Job* JobSystem::GetJob(Worker& t_Worker)
+	{
+		// Give deferred jobs the first chance, their dependencies may be done by now
+		for (size_t i = 0; i < t_Worker.m_Deferred.size(); ++i)
+		{
+			Job* Deferred = t_Worker.m_Deferred[i];
+			if (Deferred->m_Dependency->IsDone())
+			{
+				t_Worker.m_Deferred[i] = t_Worker.m_Deferred.back();
+				t_Worker.m_Deferred.pop_back();
+				return Deferred;
+			}
+		}
+
+		if (Job* OwnJob = t_Worker.m_Queue.Pop())
+		{
+			return OwnJob;
+		}
+
+		// Our queue is empty, try and steal from the other workers
+		const uint32 WorkerCount = GetWorkerCount();
+		const uint32 Start = tl_StealIndex++ % WorkerCount;
+		for (uint32 i = 0; i < WorkerCount; ++i)
+		{
+			Worker& Victim = *m_Workers[(Start + i) % WorkerCount];
+			if (&Victim == &t_Worker)
+			{
+				continue;
+			}
+
+			if (Job* Stolen = Victim.m_Queue.Steal())
+			{
+				return Stolen;
+			}
+		}
+
+		// Last of all pick up work from threads that aren't workers
+		Job* External = nullptr;
+		if (m_External->m_Queue.TryPop(External))
+		{
+			return External;
+		}
+
+		return nullptr;
+	}
+
+	bool JobSystem::TryExecute(Worker& t_Worker, Job* t_Job)
+	{
+		if (t_Job->m_Dependency && !t_Job->m_Dependency->IsDone())
+		{
+			t_Worker.m_Deferred.push_back(t_Job);
+			return false;
+		}
+
+		Execute(t_Job);
+		return true;
+	}
+
+	void JobSystem::Execute(Job* t_Job)
+	{
+		{
+			FLING_PROFILE_SCOPE("Job");
+			t_Job->m_Function(*t_Job);
+		}
+
+		// The slot can be handed out again as soon as it is marked finished, so read the counter first
+		JobCounter* Counter = t_Job->m_Counter;
+		t_Job->m_bFinished.store(true, std::memory_order_release);
+
+		// This has to be the last thing we touch, the counter may go out of scope as soon as it hits zero
+		if (Counter)
+		{
+			Counter->m_Value.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+
+	void JobSystem::WorkerThreadLoop(uint32 t_WorkerIndex)
+	{
+		tl_WorkerIndex = t_WorkerIndex;
+		Profiler::Get().SetThreadName("Job Worker " + std::to_string(t_WorkerIndex));
+
+		Worker& Current = *m_Workers[t_WorkerIndex];
+		uint32 IdleSpins = 0;
+
+		while (IsRunning())
+		{
+			if (Job* NextJob = GetJob(Current))
+			{
+				if (TryExecute(Current, NextJob))
+				{
+					IdleSpins = 0;
+				}
+				continue;
+			}
+
+			if (++IdleSpins < IdleSpinCount || !Current.m_Deferred.empty())
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			// Nothing to do, sleep until somebody pushes a job. The timeout covers any
+			// wake ups that were missed while we were between GetJob and the wait
+			std::unique_lock<std::mutex> Lock(m_WakeMutex);
+			m_WakeCondition.wait_for(Lock, std::chrono::milliseconds(1));
+			IdleSpins = 0;
+		}
+
+		tl_WorkerIndex = InvalidWorkerIndex;
+	}
+}   // namespace Fling
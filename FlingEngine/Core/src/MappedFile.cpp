@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#include <utility>
+
+#if FLING_WINDOWS
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace Fling
+{
+	MappedFile::MappedFile(const std::string& t_Path, MappedFileAccess t_Access)
+	{
+		Open(t_Path, t_Access);
+	}
+
+	MappedFile::MappedFile(MappedFile&& t_Other) noexcept
+		: m_Data(std::exchange(t_Other.m_Data, nullptr))
+		, m_Size(std::exchange(t_Other.m_Size, 0))
+		, m_bOpen(std::exchange(t_Other.m_bOpen, false))
+	{
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& t_Other) noexcept
+	{
+		if (this != &t_Other)
+		{
+			Close();
+			m_Data = std::exchange(t_Other.m_Data, nullptr);
+			m_Size = std::exchange(t_Other.m_Size, 0);
+			m_bOpen = std::exchange(t_Other.m_bOpen, false);
+		}
+		return *this;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& t_Path, MappedFileAccess t_Access)
+	{
+		Close();
+
+#if FLING_WINDOWS
+		// Windows only takes an access hint when the file is opened
+		const DWORD Flags = t_Access == MappedFileAccess::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+		HANDLE FileHandle = CreateFileA(t_Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, Flags, nullptr);
+		if (FileHandle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER FileSize = {};
+		if (!GetFileSizeEx(FileHandle, &FileSize))
+		{
+			CloseHandle(FileHandle);
+			return false;
+		}
+
+		// Empty files can't be mapped
+		if (FileSize.QuadPart > 0)
+		{
+			HANDLE Mapping = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (Mapping != nullptr)
+			{
+				m_Data = static_cast<const char*>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0));
+
+				// The view keeps the mapping alive on its own
+				CloseHandle(Mapping);
+			}
+
+			if (m_Data == nullptr)
+			{
+				CloseHandle(FileHandle);
+				return false;
+			}
+			m_Size = static_cast<size_t>(FileSize.QuadPart);
+		}
+		CloseHandle(FileHandle);
+#else
+		const int FileDesc = open(t_Path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (FileDesc < 0)
+		{
+			return false;
+		}
+
+		struct stat FileStat = {};
+		if (fstat(FileDesc, &FileStat) != 0 || !S_ISREG(FileStat.st_mode))
+		{
+			close(FileDesc);
+			return false;
+		}
+
+		// Empty files can't be mapped
+		if (FileStat.st_size > 0)
+		{
+			void* Mapped = mmap(nullptr, static_cast<size_t>(FileStat.st_size), PROT_READ, MAP_PRIVATE, FileDesc, 0);
+			if (Mapped == MAP_FAILED)
+			{
+				close(FileDesc);
+				return false;
+			}
+
+			m_Data = static_cast<const char*>(Mapped);
+			m_Size = static_cast<size_t>(FileStat.st_size);
+
+			// Only a hint, it doesn't matter if the OS ignores it
+			if (t_Access == MappedFileAccess::Sequential)
+			{
+				madvise(Mapped, m_Size, MADV_SEQUENTIAL);
+			}
+			else if (t_Access == MappedFileAccess::WillNeed)
+			{
+				madvise(Mapped, m_Size, MADV_WILLNEED);
+			}
+		}
+
+		// The mapping keeps the file open on its own
+		close(FileDesc);
+#endif
+
+		m_bOpen = true;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_Data != nullptr)
+		{
+#if FLING_WINDOWS
+			UnmapViewOfFile(m_Data);
+#else
+			munmap(const_cast<char*>(m_Data), m_Size);
+#endif
+		}
+
+		m_Data = nullptr;
+		m_Size = 0;
+		m_bOpen = false;
+	}
+}   // namespace Fling
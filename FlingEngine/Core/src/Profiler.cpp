@@ -0,0 +1,276 @@
+#include "pch.h"
+#include "Profiler.h"
+#include "Misc/CommandLine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace Fling
+{
+	namespace
+	{
+		/** Marks a thread's buffer as unused when the thread exits so that it can be cleaned up */
+		struct ThreadBufferHandle
+		{
+			std::atomic<bool>* m_InUse = nullptr;
+
+			~ThreadBufferHandle()
+			{
+				if (m_InUse)
+				{
+					m_InUse->store(false, std::memory_order_release);
+				}
+			}
+		};
+
+		static constexpr uint32 InvalidThreadId = ~0u;
+
+		thread_local void* tl_ThreadBuffer = nullptr;
+		thread_local ThreadBufferHandle tl_ThreadBufferHandle;
+		thread_local uint32 tl_ThreadId = InvalidThreadId;
+
+		void WriteJsonString(std::ostream& t_Out, const char* t_Str)
+		{
+			t_Out << '"';
+			for (const char* c = t_Str; *c != '\0'; ++c)
+			{
+				switch (*c)
+				{
+				case '"':	t_Out << "\\\""; break;
+				case '\\':	t_Out << "\\\\"; break;
+				case '\n':	t_Out << "\\n"; break;
+				case '\t':	t_Out << "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(*c) >= 0x20)
+					{
+						t_Out << *c;
+					}
+					break;
+				}
+			}
+			t_Out << '"';
+		}
+	}
+
+	void Profiler::Init()
+	{
+		const int32 FramesToCapture = CommandLine::Get().GetValueAs<int32>("ProfileFrames", 0);
+		if (FramesToCapture > 0)
+		{
+			const std::string OutputPath = CommandLine::Get().GetValueAs<std::string>("ProfileOutput", FlingPaths::EngineLogDir() + "/FlingTrace.json");
+			BeginCapture(static_cast<uint32>(FramesToCapture), OutputPath);
+		}
+	}
+
+	void Profiler::Shutdown()
+	{
+		EndCapture();
+	}
+
+	void Profiler::BeginCapture(uint32 t_NumFrames, const std::string& t_OutputPath)
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+
+		m_Captured.clear();
+		m_FramesToCapture = t_NumFrames;
+		m_FramesCaptured = 0;
+		m_OutputPath = t_OutputPath;
+		m_DroppedZones.store(0, std::memory_order_relaxed);
+
+		// Throw out anything left over from the last capture
+		for (std::unique_ptr<ThreadBuffer>& Buffer : m_ThreadBuffers)
+		{
+			Buffer->m_Tail.store(Buffer->m_Head.load(std::memory_order_acquire), std::memory_order_release);
+		}
+
+		m_Capturing.store(true, std::memory_order_release);
+
+		F_LOG_TRACE("Profiler: Capturing {} frames to {}", t_NumFrames, t_OutputPath);
+	}
+
+	void Profiler::EndCapture()
+	{
+		if (!IsCapturing())
+		{
+			return;
+		}
+
+		CollectZones();
+		m_Capturing.store(false, std::memory_order_release);
+
+		if (GetNumDroppedZones() > 0)
+		{
+			F_LOG_WARN("Profiler: {} zones were dropped because a thread's buffer was full", GetNumDroppedZones());
+		}
+
+		WriteChromeTrace(m_OutputPath);
+	}
+
+	void Profiler::BeginFrame()
+	{
+		if (!IsCapturing())
+		{
+			return;
+		}
+
+		CollectZones();
+
+		if (m_FramesCaptured++ >= m_FramesToCapture)
+		{
+			EndCapture();
+		}
+	}
+
+	void Profiler::SetThreadName(const std::string& t_Name)
+	{
+		// Only the id is needed, the zone buffer is big and threads that never record zones don't need one
+		const uint32 ThreadId = GetThreadId();
+
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_ThreadNames[ThreadId] = t_Name;
+	}
+
+	uint64 Profiler::Now()
+	{
+		return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	void Profiler::RecordZone(const ProfileZone& t_Zone)
+	{
+		// The capture might have ended while this zone was open
+		if (!IsCapturing())
+		{
+			return;
+		}
+
+		ThreadBuffer* Buffer = GetThreadBuffer();
+		const uint32 Head = Buffer->m_Head.load(std::memory_order_relaxed);
+		const uint32 Tail = Buffer->m_Tail.load(std::memory_order_acquire);
+
+		if (Head - Tail >= ThreadBufferSize)
+		{
+			m_DroppedZones.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		Buffer->m_Zones[Head % ThreadBufferSize] = t_Zone;
+		Buffer->m_Head.store(Head + 1, std::memory_order_release);
+	}
+
+	Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+	{
+		if (tl_ThreadBuffer == nullptr)
+		{
+			std::unique_ptr<ThreadBuffer> Buffer = std::make_unique<ThreadBuffer>();
+			Buffer->m_ThreadId = GetThreadId();
+
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			tl_ThreadBuffer = Buffer.get();
+			tl_ThreadBufferHandle.m_InUse = &Buffer->m_InUse;
+			m_ThreadBuffers.emplace_back(std::move(Buffer));
+		}
+
+		return static_cast<ThreadBuffer*>(tl_ThreadBuffer);
+	}
+
+	uint32 Profiler::GetThreadId()
+	{
+		if (tl_ThreadId == InvalidThreadId)
+		{
+			tl_ThreadId = m_NextThreadId.fetch_add(1, std::memory_order_relaxed);
+		}
+		return tl_ThreadId;
+	}
+
+	void Profiler::CollectZones()
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+
+		for (auto Itr = m_ThreadBuffers.begin(); Itr != m_ThreadBuffers.end();)
+		{
+			ThreadBuffer& Buffer = **Itr;
+
+			// Check this before reading the head so that we see every zone written before the thread exited
+			const bool bRetired = !Buffer.m_InUse.load(std::memory_order_acquire);
+
+			const uint32 Head = Buffer.m_Head.load(std::memory_order_acquire);
+			for (uint32 i = Buffer.m_Tail.load(std::memory_order_relaxed); i != Head; ++i)
+			{
+				m_Captured.push_back({ Buffer.m_Zones[i % ThreadBufferSize], Buffer.m_ThreadId });
+			}
+			Buffer.m_Tail.store(Head, std::memory_order_release);
+
+			Itr = bRetired ? m_ThreadBuffers.erase(Itr) : Itr + 1;
+		}
+	}
+
+	size_t Profiler::GetNumThreadBuffers() const
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		return m_ThreadBuffers.size();
+	}
+
+	size_t Profiler::GetNumCapturedZones() const
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		return m_Captured.size();
+	}
+
+	bool Profiler::WriteChromeTrace(const std::string& t_OutputPath)
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+
+		std::ofstream Out(t_OutputPath, std::ios::out | std::ios::trunc);
+		if (!Out.is_open())
+		{
+			F_LOG_ERROR("Profiler: Failed to open {} to write the trace to", t_OutputPath);
+			return false;
+		}
+
+		// Sort by start time with parents before their children so that viewers nest them properly
+		std::sort(m_Captured.begin(), m_Captured.end(), [](const CapturedZone& A, const CapturedZone& B)
+		{
+			if (A.m_ThreadId != B.m_ThreadId) return A.m_ThreadId < B.m_ThreadId;
+			if (A.m_Zone.m_Start != B.m_Zone.m_Start) return A.m_Zone.m_Start < B.m_Zone.m_Start;
+			return A.m_Zone.m_End > B.m_Zone.m_End;
+		});
+
+		uint64 CaptureStart = UINT64_MAX;
+		for (const CapturedZone& Captured : m_Captured)
+		{
+			CaptureStart = std::min(CaptureStart, Captured.m_Zone.m_Start);
+		}
+
+		Out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		Out.setf(std::ios::fixed);
+		Out.precision(3);
+
+		bool bFirst = true;
+		for (const auto& Name : m_ThreadNames)
+		{
+			Out << (bFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << Name.first << ",\"args\":{\"name\":";
+			WriteJsonString(Out, Name.second.c_str());
+			Out << "}}";
+			bFirst = false;
+		}
+
+		// Chrome expects timestamps in microseconds
+		for (const CapturedZone& Captured : m_Captured)
+		{
+			const ProfileZone& Zone = Captured.m_Zone;
+			Out << (bFirst ? "" : ",\n") << "{\"name\":";
+			WriteJsonString(Out, Zone.m_Name);
+			Out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << Captured.m_ThreadId
+				<< ",\"ts\":" << static_cast<double>(Zone.m_Start - CaptureStart) / 1000.0
+				<< ",\"dur\":" << static_cast<double>(Zone.m_End - Zone.m_Start) / 1000.0 << "}";
+			bFirst = false;
+		}
+
+		Out << "\n]}\n";
+
+		F_LOG_TRACE("Profiler: Wrote {} zones to {}", m_Captured.size(), t_OutputPath);
+		return Out.good();
+	}
+}   // namespace Fling
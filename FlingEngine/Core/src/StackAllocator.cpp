@@ -9,17 +9,11 @@ namespace
 
 
 Fling::StackAllocator::StackAllocator(void* t_Start, void* t_End)
+    : m_Start(static_cast<char*>(t_Start))
+    , m_End(static_cast<char*>(t_End))
+    , m_Current(static_cast<char*>(t_Start))
 {
-    std::ptrdiff_t bufferSize = ((const char*)t_End - (const char*)t_Start);
-
-    m_Start = static_cast<char*>(AlignedAlloc(bufferSize, SIZE_OF_ALLOCATION_OFFSET));
-    m_End = m_Start + bufferSize;
-    m_Current = m_Start;
-}
-
-Fling::StackAllocator::~StackAllocator()
-{
-    AlignedFree(m_Start);
+    assert(m_Start && m_End > m_Start);
 }
 
 void* Fling::StackAllocator::Allocate(size_t t_Size, size_t t_Alignment, size_t t_Offset)
@@ -28,15 +22,16 @@ void* Fling::StackAllocator::Allocate(size_t t_Size, size_t t_Alignment, size_t
     t_Offset += SIZE_OF_ALLOCATION_OFFSET;
 
     const uint32 allocationOffset = static_cast<uint32>(m_Current - m_Start);
-    
+
     //offset the pointer first, align it, and then offset it back
-    // This is a problem on Linux!!
-    m_Current = AlignPointer<char>(m_Current + t_Offset, t_Alignment) - t_Offset;
+    char* alignedCurrent = AlignPointer<char>(m_Current + t_Offset, t_Alignment) - t_Offset;
 
-    if (m_Current + t_Size > m_End)
+    if (alignedCurrent + t_Size > m_End)
     {
-        assert("Stack Allocator out of memory");
+        // Out of memory, leave the stack untouched so the caller can fall back to something else
+        return nullptr;
     }
+    m_Current = alignedCurrent;
 
     union
     {
@@ -1,25 +1,180 @@
 #include "pch.h"
 #include "Stats.h"
 
+#include <fstream>
+
 namespace Fling
 {
     namespace Stats
     {
-        MovingAverage<float, 100> Frames::FPSCounter = {};
+        RollingHistogram<Frames::NumWindows> Frames::RollingPhases[static_cast<size_t>(Phase::Count)] = {};
+        Histogram Frames::TotalPhases[static_cast<size_t>(Phase::Count)] = {};
+        float Frames::WindowTime = 0.0f;
+
+        std::atomic<uint64> Draws::LastTriangles { 0 };
+        std::atomic<uint64> Draws::LastFullDetailTriangles { 0 };
+        std::atomic<uint32> Draws::LastDrawCount { 0 };
+        Histogram Draws::Triangles = {};
+        uint64 Draws::TotalTriangles = 0;
+        uint64 Draws::TotalFullDetailTriangles = 0;
+
+        static constexpr double MicrosecondsToSeconds = 1.0 / 1000000.0;
+
+        const char* GetPhaseName(Phase t_Phase)
+        {
+            switch (t_Phase)
+            {
+            case Phase::Frame:  return "Frame";
+            case Phase::Input:  return "Input";
+            case Phase::World:  return "World";
+            case Phase::Render: return "Render";
+            default:            return "Unknown";
+            }
+        }
 
         float Frames::GetAverageFrameTime()
         {
-            return FPSCounter.GetAverage();
+            return static_cast<float>(GetRollingHistogram(Phase::Frame).GetMean() * MicrosecondsToSeconds);
         }
 
         float Frames::GetAverageFPS()
         {
-            return 1.0f / FPSCounter.GetAverage();
+            const float AverageFrameTime = GetAverageFrameTime();
+            return AverageFrameTime > 0.0f ? 1.0f / AverageFrameTime : 0.0f;
+        }
+
+        float Frames::GetFrameTimePercentile(double t_Percentile)
+        {
+            return static_cast<float>(GetRollingHistogram(Phase::Frame).GetPercentile(t_Percentile) * MicrosecondsToSeconds);
+        }
+
+        float Frames::GetMaxFrameTime()
+        {
+            return static_cast<float>(GetRollingHistogram(Phase::Frame).GetMax() * MicrosecondsToSeconds);
         }
 
         void Frames::TickStats(float t_DeltaTime)
         {
-            FPSCounter.Push(t_DeltaTime);
+            // Start a new window every second so that the rolling stats cover the last NumWindows seconds
+            WindowTime += t_DeltaTime;
+            if (WindowTime >= 1.0f)
+            {
+                WindowTime = 0.0f;
+                for (RollingHistogram<NumWindows>& Rolling : RollingPhases)
+                {
+                    Rolling.Rotate();
+                }
+            }
+
+            RecordPhase(Phase::Frame, static_cast<uint64>(static_cast<double>(t_DeltaTime) / MicrosecondsToSeconds));
+        }
+
+        void Frames::RecordPhase(Phase t_Phase, uint64 t_Microseconds)
+        {
+            assert(t_Phase < Phase::Count);
+            RollingPhases[static_cast<size_t>(t_Phase)].Record(t_Microseconds);
+            TotalPhases[static_cast<size_t>(t_Phase)].Record(t_Microseconds);
+        }
+
+        const Histogram& Frames::GetRollingHistogram(Phase t_Phase)
+        {
+            assert(t_Phase < Phase::Count);
+            return RollingPhases[static_cast<size_t>(t_Phase)].GetCombined();
+        }
+
+        const Histogram& Frames::GetTotalHistogram(Phase t_Phase)
+        {
+            assert(t_Phase < Phase::Count);
+            return TotalPhases[static_cast<size_t>(t_Phase)];
+        }
+
+        void Frames::Reset()
+        {
+            for (RollingHistogram<NumWindows>& Rolling : RollingPhases)
+            {
+                Rolling.Reset();
+            }
+
+            for (Histogram& Total : TotalPhases)
+            {
+                Total.Reset();
+            }
+
+            WindowTime = 0.0f;
+        }
+
+        void Frames::LogSummary()
+        {
+            for (size_t i = 0; i < static_cast<size_t>(Phase::Count); ++i)
+            {
+                const Histogram& Total = TotalPhases[i];
+                if (Total.GetCount() == 0)
+                {
+                    continue;
+                }
+
+                F_LOG_TRACE("{} time (us): p50 {} p95 {} p99 {} max {} over {} frames",
+                    GetPhaseName(static_cast<Phase>(i)),
+                    Total.GetPercentile(50.0),
+                    Total.GetPercentile(95.0),
+                    Total.GetPercentile(99.0),
+                    Total.GetMax(),
+                    Total.GetCount());
+            }
+        }
+
+        bool Frames::WriteHistograms(const std::string& t_FilePath)
+        {
+            std::ofstream Out(t_FilePath, std::ios::out | std::ios::trunc);
+            if (!Out.is_open())
+            {
+                F_LOG_ERROR("Failed to open {} to write frame stats to", t_FilePath);
+                return false;
+            }
+
+            Out << "Phase,LowerBoundUs,UpperBoundUs,Count\n";
+            for (size_t i = 0; i < static_cast<size_t>(Phase::Count); ++i)
+            {
+                TotalPhases[i].WriteCsv(Out, GetPhaseName(static_cast<Phase>(i)));
+            }
+
+            return Out.good();
+        }
+
+        void Draws::RecordFrame(uint64 t_Triangles, uint64 t_FullDetailTriangles, uint32 t_DrawCount)
+        {
+            LastTriangles.store(t_Triangles, std::memory_order_relaxed);
+            LastFullDetailTriangles.store(t_FullDetailTriangles, std::memory_order_relaxed);
+            LastDrawCount.store(t_DrawCount, std::memory_order_relaxed);
+
+            Triangles.Record(t_Triangles);
+            TotalTriangles += t_Triangles;
+            TotalFullDetailTriangles += t_FullDetailTriangles;
+        }
+
+        void Draws::Reset()
+        {
+            LastTriangles = 0;
+            LastFullDetailTriangles = 0;
+            LastDrawCount = 0;
+            Triangles.Reset();
+            TotalTriangles = 0;
+            TotalFullDetailTriangles = 0;
+        }
+
+        void Draws::LogSummary()
+        {
+            if (Triangles.GetCount() == 0)
+            {
+                return;
+            }
+
+            F_LOG_TRACE("Triangles per frame: p50 {} p99 {} max {} over {} frames, {:.1f}% of full detail",
+                Triangles.GetPercentile(50.0),
+                Triangles.GetPercentile(99.0),
+                Triangles.GetMax(),
+                Triangles.GetCount(),
+                TotalFullDetailTriangles > 0 ? 100.0 * static_cast<double>(TotalTriangles) / static_cast<double>(TotalFullDetailTriangles) : 100.0);
         }
     }
-}
\ No newline at end of file
+}
@@ -49,9 +49,8 @@ namespace Fling
 
 	double Timing::GetTime() const
 	{
-		auto now = std::chrono::high_resolution_clock::now();
-		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>( now - sStartTime ).count();
-		//a little uncool to then convert into a double just to go back, but oh well.
-		return static_cast<double>( ms ) / 1000;
+		// Keep the full clock resolution, rounding to milliseconds makes frame times useless for stats
+		const std::chrono::duration<double> Seconds = std::chrono::high_resolution_clock::now() - sStartTime;
+		return Seconds.count();
 	}
 }	// namespace Fling
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "pch.h"
+#include "VirtualArena.h"
+
+#if FLING_WINDOWS
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+namespace Fling
+{
+	namespace
+	{
+		/** Commit at least this much at a time so we aren't calling into the OS on every allocation */
+		static constexpr size_t MinCommitSize = 64 * 1024;
+
+		/** Size of a transparent huge page on x64 */
+		static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+		inline size_t RoundUp(size_t t_Value, size_t t_Multiple)
+		{
+			return ((t_Value + t_Multiple - 1) / t_Multiple) * t_Multiple;
+		}
+
+		size_t GetPageSize()
+		{
+#if FLING_WINDOWS
+			SYSTEM_INFO Info = {};
+			GetSystemInfo(&Info);
+			return static_cast<size_t>(Info.dwAllocationGranularity);
+#else
+			return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+		}
+	}
+
+	VirtualArena::VirtualArena(size_t t_ReserveSize, bool t_UseHugePages)
+	{
+		const size_t PageSize = GetPageSize();
+		m_CommitGranularity = RoundUp(MinCommitSize, PageSize);
+		m_UseHugePages = t_UseHugePages;
+
+#if FLING_WINDOWS
+		// Large pages on Windows need a special privilege and can't be committed lazily, so just use normal pages
+		m_UseHugePages = false;
+		m_Reserved = RoundUp(t_ReserveSize, m_CommitGranularity);
+		m_Base = static_cast<char*>(VirtualAlloc(nullptr, m_Reserved, MEM_RESERVE, PAGE_NOACCESS));
+#else
+		if (m_UseHugePages)
+		{
+			m_CommitGranularity = HugePageSize;
+		}
+		m_Reserved = RoundUp(t_ReserveSize, m_CommitGranularity);
+
+		// Over reserve by a huge page so that the base can be aligned to one
+		const size_t MapSize = m_UseHugePages ? m_Reserved + HugePageSize : m_Reserved;
+		void* Mapped = mmap(nullptr, MapSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+		if (Mapped != MAP_FAILED)
+		{
+			char* Start = static_cast<char*>(Mapped);
+			m_Base = Start;
+
+			if (m_UseHugePages)
+			{
+				// Trim the unaligned bits off each end of the mapping
+				m_Base = reinterpret_cast<char*>(RoundUp(reinterpret_cast<size_t>(Start), HugePageSize));
+				const size_t Head = static_cast<size_t>(m_Base - Start);
+				const size_t Tail = MapSize - Head - m_Reserved;
+				if (Head > 0)
+				{
+					munmap(Start, Head);
+				}
+				if (Tail > 0)
+				{
+					munmap(m_Base + m_Reserved, Tail);
+				}
+
+#ifdef MADV_HUGEPAGE
+				if (madvise(m_Base, m_Reserved, MADV_HUGEPAGE) != 0)
+				{
+					F_LOG_WARN("VirtualArena: Transparent huge pages are not available, using normal pages");
+					m_UseHugePages = false;
+				}
+#else
+				m_UseHugePages = false;
+#endif
+			}
+		}
+#endif
+
+		if (m_Base == nullptr)
+		{
+			F_LOG_ERROR("VirtualArena: Failed to reserve {} bytes of address space", t_ReserveSize);
+			m_Reserved = 0;
+		}
+	}
+
+	VirtualArena::~VirtualArena()
+	{
+		if (m_Base == nullptr)
+		{
+			return;
+		}
+
+#if FLING_WINDOWS
+		VirtualFree(m_Base, 0, MEM_RELEASE);
+#else
+		munmap(m_Base, m_Reserved);
+#endif
+		m_Base = nullptr;
+	}
+
+	void* VirtualArena::Allocate(size_t t_Size, size_t t_Alignment)
+	{
+		assert(t_Alignment != 0 && (t_Alignment & (t_Alignment - 1)) == 0);
+
+		const size_t Start = RoundUp(m_Used, t_Alignment);
+		const size_t End = Start + t_Size;
+
+		if (End > m_Reserved || End < Start)
+		{
+			F_LOG_ERROR("VirtualArena: Out of reserved memory ({} bytes reserved, {} requested)", m_Reserved, End);
+			return nullptr;
+		}
+
+		if (End > m_Committed && !Commit(End))
+		{
+			return nullptr;
+		}
+
+		m_Used = End;
+		return m_Base + Start;
+	}
+
+	void VirtualArena::Rewind(Marker t_Marker)
+	{
+		assert(t_Marker.m_Offset <= m_Used && "Can only rewind the arena backwards");
+		m_Used = t_Marker.m_Offset;
+	}
+
+	bool VirtualArena::Commit(size_t t_Size)
+	{
+		const size_t NewCommitted = std::min(RoundUp(t_Size, m_CommitGranularity), m_Reserved);
+		char* CommitStart = m_Base + m_Committed;
+		const size_t CommitSize = NewCommitted - m_Committed;
+
+#if FLING_WINDOWS
+		const bool bSuccess = VirtualAlloc(CommitStart, CommitSize, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+		const bool bSuccess = mprotect(CommitStart, CommitSize, PROT_READ | PROT_WRITE) == 0;
+#endif
+
+		if (!bSuccess)
+		{
+			F_LOG_ERROR("VirtualArena: Failed to commit {} bytes", CommitSize);
+			return false;
+		}
+
+		m_Committed = NewCommitted;
+		return true;
+	}
+
+	void VirtualArena::Decommit()
+	{
+		const size_t KeepCommitted = RoundUp(m_Used, m_CommitGranularity);
+		if (KeepCommitted >= m_Committed)
+		{
+			return;
+		}
+
+		char* DecommitStart = m_Base + KeepCommitted;
+		const size_t DecommitSize = m_Committed - KeepCommitted;
+
+#if FLING_WINDOWS
+		VirtualFree(DecommitStart, DecommitSize, MEM_DECOMMIT);
+#else
+		madvise(DecommitStart, DecommitSize, MADV_DONTNEED);
+		mprotect(DecommitStart, DecommitSize, PROT_NONE);
+#endif
+
+		m_Committed = KeepCommitted;
+	}
+}   // namespace Fling
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <string>
-#include <filesystem>
+#include <vector>
 #if WITH_IMGUI
 #include <imgui.h>
 #endif
 namespace Fling
 {
+    /**
+     * Lets you pick an asset out of the resource manager's file system. Paths are relative
+     * to the assets directory, and directories are listed from the file system's index
+     * instead of being scanned off of the disk.
+     */
     class FileBrowser
     {
     public: 
@@ -34,8 +39,16 @@ namespace Fling
         /** The selected file in this dialog */
         std::string m_SelectedFile = std::string();
 
+        /** Change directories and list what is in the new one */
+        void SetCurrentDir(const std::string& t_Dir);
+
+		/** Relative to the assets directory, empty for the root */
 		std::string m_CurrentWorkingDir = std::string();
 
+        /** What is in m_CurrentWorkingDir, only listed when it changes */
+        std::vector<std::string> m_Files;
+        std::vector<std::string> m_Dirs;
+
         bool m_IsOpen = false;
 
         bool m_HasSelected = false;
@@ -9,6 +9,7 @@
 // We have to draw the ImGUI stuff somewhere, so we miind as well keep it all here!
 #include "Components/Transform.h"
 #include "MeshRenderer.h"
+#include "ResourceManager.h"
 #include "Lighting/DirectionalLight.hpp"
 #include "Lighting/PointLight.hpp"
 #include "ImFileBrowser.hpp"
@@ -48,9 +49,9 @@ namespace Fling
             // Model -----------------------
             {
                 std::string ModelName = "None";
-                if (t_MeshRend.m_Model)
+                if (t_MeshRend.m_Model.IsValid())
                 {
-                    ModelName = t_MeshRend.m_Model->GetGuidString();
+                    ModelName = ResourceManager::GetHandlePath(t_MeshRend.m_Model);
                 }
 
                 ImGui::LabelText("Model", ModelName.c_str(), "%s");
@@ -81,9 +82,9 @@ namespace Fling
             // Material ----------------------
             {
                 std::string MaterialName = "None";
-                if (t_MeshRend.m_Material)
+                if (t_MeshRend.m_Material.IsValid())
                 {
-                    MaterialName = t_MeshRend.m_Material->GetGuidString();
+                    MaterialName = ResourceManager::GetHandlePath(t_MeshRend.m_Material);
                 }
 
                 const char* m = MaterialName.c_str();
@@ -444,6 +445,18 @@ namespace Fling
         {
             ImGui::Text("FPS: %f", frameTime);
             ImGui::PlotLines("FPS", &fpsGraph[0], fpsGraph.size(), 0, "", m_FrameTimeMin, m_FrameTimeMax, ImVec2(0, 80));
+
+            // Resource memory
+            for (size_t i = 0; i < static_cast<size_t>(ResourceMemoryType::Count); ++i)
+            {
+                const ResourceMemoryType Type = static_cast<ResourceMemoryType>(i);
+                const ResourceResidency Residency = ResourceManager::Get().GetResidency(Type);
+                ImGui::Text("%s: %.1f MB (peak %.1f MB, budget %.0f MB)",
+                    ResourceManager::GetMemoryTypeName(Type),
+                    static_cast<double>(Residency.CurrentBytes) / (1024.0 * 1024.0),
+                    static_cast<double>(Residency.PeakBytes) / (1024.0 * 1024.0),
+                    static_cast<double>(Residency.BudgetBytes) / (1024.0 * 1024.0));
+            }
         }
         ImGui::End();
     }
@@ -2,15 +2,22 @@
 
 #include "pch.h"
 #include "FileBrowser.h"
+#include "ResourceManager.h"
 
 namespace Fling
 {
     FileBrowser::FileBrowser(std::string t_Title)
 		: m_Title(t_Title)
     {
-		m_CurrentWorkingDir = FlingPaths::EngineAssetsDir();
+		SetCurrentDir(std::string());
     }
 
+	void FileBrowser::SetCurrentDir(const std::string& t_Dir)
+	{
+		m_CurrentWorkingDir = t_Dir;
+		ResourceManager::Get().GetFileSystem().ListDirectory(m_CurrentWorkingDir, m_Files, m_Dirs);
+	}
+
 	void FileBrowser::SetTitle(std::string t_Title)
 	{
 		m_Title = t_Title;
@@ -18,6 +25,8 @@ namespace Fling
 
 	void FileBrowser::Open()
 	{
+		// Pick up anything that was mounted since last time
+		SetCurrentDir(m_CurrentWorkingDir);
 		ImGui::OpenPopup(m_Title.c_str());
 	}
 
@@ -34,33 +43,38 @@ namespace Fling
 
 		if (ImGui::BeginPopupModal(m_Title.c_str(), &open))
 		{
-			namespace fs = std::filesystem;
+			std::string NextDir = m_CurrentWorkingDir;
 
-			// For each file in 
-			for (const auto& entry : fs::directory_iterator(m_CurrentWorkingDir))
+			for (const std::string& Dir : m_Dirs)
+			{
+				std::string DisplayName = "[D] " + Dir;
+				if (ImGui::Selectable(DisplayName.c_str(), false, ImGuiSelectableFlags_DontClosePopups))
+				{
+					// Go deeper into this dir
+					NextDir = Dir;
+				}
+			}
+
+			for (const std::string& FilePath : m_Files)
 			{
-				std::string FilePath = entry.path().generic_string();
 				const bool IsSelected = m_SelectedFile == FilePath;
-				std::string DisplayName = (entry.is_directory() ? "[D] " : "[F] ") + FilePath;
+				std::string DisplayName = "[F] " + FilePath;
 				if (ImGui::Selectable(DisplayName.c_str(), IsSelected, ImGuiSelectableFlags_DontClosePopups))
 				{
-					if (entry.is_directory())
-					{
-						// Do deeper into this dir
-						m_CurrentWorkingDir = FilePath;
-						break;
-					}
-					else if (entry.is_regular_file())
-					{
-						m_SelectedFile = std::string(FilePath);
-					}
+					m_SelectedFile = FilePath;
 				}
 			}
 
-			if (ImGui::Selectable("..", false, ImGuiSelectableFlags_DontClosePopups))
+			if (!m_CurrentWorkingDir.empty() && ImGui::Selectable("..", false, ImGuiSelectableFlags_DontClosePopups))
 			{
 				// Go back a directory
-				
+				const size_t Slash = m_CurrentWorkingDir.find_last_of('/');
+				NextDir = Slash == std::string::npos ? std::string() : m_CurrentWorkingDir.substr(0, Slash);
+			}
+
+			if (NextDir != m_CurrentWorkingDir)
+			{
+				SetCurrentDir(NextDir);
 			}
 
 			ImGui::Text("------");
@@ -136,14 +136,13 @@ namespace Fling
 			JsonArchive ar(inCopy, JsonArchive::Mode::Loading);
 			comp.Serialize(ar);
 
+			// Replacing doesn't fire on_destroy, so anything the old component owns (like the resource
+			// handles of a MeshRenderer) would never be released. Remove it and assign the new one instead
 			if (reg.has<T>(e))
 			{
-				reg.replace<T>(e, std::move(comp));
-			}
-			else
-			{
-				reg.assign<T>(e, std::move(comp));
+				reg.remove<T>(e);
 			}
+			reg.assign<T>(e, std::move(comp));
 		};
 		info.create = [](entt::registry& reg, entt::entity e)
 		{
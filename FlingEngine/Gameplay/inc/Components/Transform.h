@@ -13,6 +13,27 @@ namespace Fling
 
 		static void CalculateWorldMatrix(Transform& t_Trans);
 
+		/**
+		 * Calculate the world matrix blended between the previous simulation state and the current one.
+		 * Position and scale are lerped and rotation is slerped.
+		 *
+		 * @param t_Alpha	0 is the previous state, 1 is the current state
+		 * @see World::FixedUpdate
+		 */
+		static void CalculateInterpolatedWorldMatrix(Transform& t_Trans, float t_Alpha);
+
+		/** Same as CalculateInterpolatedWorldMatrix, but returns the matrix instead of storing it */
+		glm::mat4 GetInterpolatedWorldMatrix(float t_Alpha) const;
+
+		/** Remember the current state as the previous one, called before every fixed simulation step */
+		inline void SavePreviousState()
+		{
+			m_PrevPos = m_Pos;
+			m_PrevRotation = m_Rotation;
+			m_PrevScale = m_Scale;
+			m_HasPrevState = true;
+		}
+
 		bool operator==(const Transform &other) const;
 		bool operator!=(const Transform &other) const;
 		friend std::ostream& operator << (std::ostream& t_OutStream, const Fling::Transform& t_Transform);
@@ -33,5 +54,13 @@ namespace Fling
 		glm::vec3 m_Rotation { 0.0f, 0.0f, 0.0f };
 		glm::vec3 m_Scale { 1.0f, 1.0f, 1.0f };
 		glm::mat4 m_worldMat {};
+
+		/** State as of the last fixed simulation step, used for render interpolation */
+		glm::vec3 m_PrevPos { 0.0f, 0.0f, 0.0f };
+		glm::vec3 m_PrevRotation { 0.0f, 0.0f, 0.0f };
+		glm::vec3 m_PrevScale { 1.0f, 1.0f, 1.0f };
+
+		/** False until the first simulation step, so that new transforms don't interpolate from the origin */
+		bool m_HasPrevState = false;
 	};
 }	// namespace Fling
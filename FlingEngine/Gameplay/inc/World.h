@@ -36,6 +36,15 @@ namespace Fling
 		 */
 		void Update(float t_DeltaTime);
 
+		/**
+		 * Run a single fixed simulation step. Saves the state of every transform before
+		 * updating so that the renderer can interpolate between the two.
+		 * @see Transform::CalculateInterpolatedWorldMatrix
+		 *
+		 * @param t_StepSize	Length of the simulation step in seconds
+		 */
+		void FixedUpdate(float t_StepSize);
+
 		/**
 		 * Called just before destruction.
 		 */
@@ -2,6 +2,8 @@
 
 #include "Components/Transform.h"
 
+#include <glm/gtc/quaternion.hpp>
+
 namespace Fling
 {
     bool Transform::operator==(const Transform &other) const 
@@ -45,6 +47,30 @@ namespace Fling
 		t_Trans.m_worldMat = glm::scale(t_Trans.m_worldMat, t_Trans.m_Scale);
 	}
 
+	void Transform::CalculateInterpolatedWorldMatrix(Transform& t_Trans, float t_Alpha)
+	{
+		t_Trans.m_worldMat = t_Trans.GetInterpolatedWorldMatrix(t_Alpha);
+	}
+
+	glm::mat4 Transform::GetInterpolatedWorldMatrix(float t_Alpha) const
+	{
+		if (t_Alpha >= 1.0f || !m_HasPrevState)
+		{
+			return GetWorldMatrix();
+		}
+
+		const glm::vec3 Pos = glm::mix(m_PrevPos, m_Pos, t_Alpha);
+		const glm::vec3 Scale = glm::mix(m_PrevScale, m_Scale, t_Alpha);
+
+		// Slerp the rotation so that angles wrapping around don't spin the long way
+		const glm::quat PrevRot = glm::quat_cast(glm::yawPitchRoll(glm::radians(m_PrevRotation.y), glm::radians(m_PrevRotation.x), glm::radians(m_PrevRotation.z)));
+		const glm::quat CurrentRot = glm::quat_cast(glm::yawPitchRoll(glm::radians(m_Rotation.y), glm::radians(m_Rotation.x), glm::radians(m_Rotation.z)));
+
+		glm::mat4 WorldMat = glm::translate(glm::mat4(1.0f), Pos);
+		WorldMat = WorldMat * glm::mat4_cast(glm::slerp(PrevRot, CurrentRot, t_Alpha));
+		return glm::scale(WorldMat, Scale);
+	}
+
     void Transform::SetPos(const glm::vec3& t_Pos)
     {
         m_Pos = t_Pos;
@@ -68,6 +94,8 @@ namespace Fling
 
 		if (Ar.IsLoading())
 		{
+			// Don't interpolate from wherever this transform was before it was loaded
+			SavePreviousState();
 			CalculateWorldMatrix(*this);
 		}
 	}
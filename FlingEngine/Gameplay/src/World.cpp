@@ -2,9 +2,13 @@
 #include "World.h"
 #include "ComponentTypeRegistry.h"
 #include "Components/Name.hpp"
+#include "Components/Transform.h"
+#include "CookedMesh.h"
 #include "FlingConfig.h"
 #include "FlingPaths.h"
 #include "Json.h"
+#include "Profiler.h"
+#include "ResourceManager.h"
 
 #include <algorithm>
 #include <utility>
@@ -85,6 +89,8 @@ namespace Fling
 
 	void World::Update(float t_DeltaTime)
 	{
+		FLING_PROFILE_SCOPE("World::Update");
+
 		if(m_CurrentState == WorldState::Playing)
 		{
 			// Once we are done with core updates, then call the game!
@@ -94,6 +100,16 @@ namespace Fling
 		}
 	}
 
+	void World::FixedUpdate(float t_StepSize)
+	{
+		m_Registry.view<Transform>().each([](Transform& t_Trans)
+		{
+			t_Trans.SavePreviousState();
+		});
+
+		Update(t_StepSize);
+	}
+
 	bool World::OutputLevelFile(const std::string& t_LevelToLoad)
 	{
 		ComponentTypeRegistry& typeRegistry = ComponentTypeRegistry::Get();
@@ -166,6 +182,8 @@ namespace Fling
 			return false;
 		}
 
+		// The assets directory was indexed when it was mounted, so let it know about the new file
+		ResourceManager::Get().GetFileSystem().RefreshPath(t_LevelToLoad);
 		return true;
 	}
 
@@ -189,6 +207,21 @@ namespace Fling
 
 		m_Registry.reset();
 
+		// Read every asset the level mentions in one batch, instead of one at a time as each component loads
+		VirtualFileSystem& FileSystem = ResourceManager::Get().GetFileSystem();
+		std::vector<std::string> assetPaths;
+		doc.CollectStrings(assetPaths);
+		for (std::string& path : assetPaths)
+		{
+			// Models only read their source file when the cooked mesh is stale, so read the cooked mesh instead
+			const std::string cookedPath = CookedMesh::GetCookedPath(path);
+			if (cookedPath != path && FileSystem.Exists(cookedPath))
+			{
+				path = cookedPath;
+			}
+		}
+		FileSystem.Prefetch(assetPaths);
+
 		const std::string title = doc.GetString("title", t_LevelToLoad);
 		F_LOG_TRACE("Level Title: {}", title);
 
@@ -196,6 +229,7 @@ namespace Fling
 		if (!entities.IsArray())
 		{
 			F_LOG_ERROR("Level file '{}' is missing an entities array", FullPath);
+			FileSystem.ClearPrefetched();
 			return false;
 		}
 
@@ -249,6 +283,8 @@ namespace Fling
 			}
 		}
 
+		// Anything that wasn't read while loading the components isn't going to be
+		FileSystem.ClearPrefetched();
 		return true;
 	}
 } // namespace Fling
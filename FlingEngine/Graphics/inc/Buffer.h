@@ -47,6 +47,10 @@ namespace Fling
          */
         ~Buffer();
 
+        /** Buffers are created and destroyed constantly, so they come from a pool instead of the heap */
+        static void* operator new(size_t t_Size);
+        static void operator delete(void* t_Ptr, size_t t_Size);
+
 		bool operator==(const Buffer& other) const;
 		bool operator!=(const Buffer& other) const;
 
@@ -2,6 +2,8 @@
 
 #include "FlingVulkan.h"
 
+#include <initializer_list>
+
 namespace Fling
 {
 	class LogicalDevice;
@@ -34,6 +36,10 @@ namespace Fling
 		CommandBuffer(const LogicalDevice* t_Device, VkCommandPool t_CmdPool);
 		~CommandBuffer();
 
+		/** Command buffers are allocated from a pool instead of the heap */
+		static void* operator new(size_t t_Size);
+		static void operator delete(void* t_Ptr, size_t t_Size);
+
 		inline VkCommandBuffer GetHandle() const { return m_Handle; }
 		inline const LogicalDevice* GetDevice() const { return m_Device; }
 		inline const VkCommandPool& GetPoolHandle() const { return m_Pool; }
@@ -47,9 +53,9 @@ namespace Fling
 
 		void BindPipeline(VkPipelineBindPoint t_BindPoint, VkPipeline t_Pipeline);
 
-		void SetViewport(uint32 first_viewport, const std::vector<VkViewport>& viewports);
+		void SetViewport(uint32 first_viewport, std::initializer_list<VkViewport> viewports);
 
-		void SetScissor(uint32 first_scissor, const std::vector<VkRect2D> &scissors);
+		void SetScissor(uint32 first_scissor, std::initializer_list<VkRect2D> scissors);
 
 		void EndRenderPass();
 
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "AssetData.h"
+#include "Vertex.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+
+#include <string>
+#include <vector>
+
+namespace Fling
+{
+	/** First thing in a cooked mesh file */
+	struct CookedMeshHeader
+	{
+		uint32 Magic = 0;
+		uint32 Version = 0;
+
+		/** sizeof(Vertex) and sizeof(uint32) when the mesh was cooked */
+		uint32 VertexStride = 0;
+		uint32 IndexStride = 0;
+
+		uint32 NumVerts = 0;
+		uint32 NumIndices = 0;
+
+		/** HashBytes64 and size of the file that this was cooked from, to tell if it is stale */
+		uint64 SourceHash = 0;
+		uint64 SourceSize = 0;
+
+		/** Model space bounding sphere */
+		float BoundsCenter[3] = {};
+		float BoundsRadius = 0.0f;
+
+		/** Where the vertices and indices start from the beginning of the file, always aligned */
+		uint64 VertexOffset = 0;
+		uint64 IndexOffset = 0;
+
+		/** HashBytes64 of the vertices, indices, LODs and meshlets */
+		uint64 Checksum = 0;
+
+		/** The LOD table, one MeshLod for each level of detail, starting with the full detail mesh */
+		uint32 NumLods = 0;
+
+		/** The meshlets of the full detail mesh, see Meshlets::Build */
+		uint32 NumMeshlets = 0;
+		uint64 LodOffset = 0;
+		uint64 MeshletOffset = 0;
+
+		/** Hash of the import settings the mesh was cooked with, like how many LODs to make */
+		uint64 SettingsHash = 0;
+
+		/** VfsFileInfo::ModifiedTime of the source file, so a loose source that hasn't changed doesn't have to be hashed */
+		uint64 SourceModifiedTime = 0;
+	};
+
+	static_assert(sizeof(CookedMeshHeader) == 120, "CookedMeshHeader is written straight to disk, don't change its size");
+
+	/**
+	 * A mesh that has already been imported, stored exactly how the GPU wants it so that loading
+	 * it is a memory map and a copy into a staging buffer instead of parsing text. Holds the final
+	 * vertices (with tangents already calculated), the index buffer with every LOD in it, the LOD
+	 * table, the meshlets and the bounds.
+	 *
+	 * Layout: a CookedMeshHeader, then the vertices, then the indices, then the LODs, then the meshlets, each aligned to DataAlignment.
+	 * Everything is little endian. A cooked mesh sits next to its source with the Extension
+	 * swapped in (Models/cube.obj -> Models/cube.flmesh), so it is packed into archives like any other asset.
+	 *
+	 * @see Model::LoadModel
+	 */
+	class CookedMesh : public NonCopyable
+	{
+	public:
+
+		static constexpr uint32 Magic = 0x534D4C46;	// "FLMS"
+
+		/** Bump this whenever Vertex or the import changes, so old cooked meshes are imported again */
+		static constexpr uint32 Version = 7;
+
+		static constexpr const char* Extension = ".flmesh";
+
+		static constexpr size_t DataAlignment = 16;
+
+		CookedMesh() = default;
+		virtual ~CookedMesh() = default;
+
+		/** Path of the cooked mesh for a source file */
+		static std::string GetCookedPath(const std::string& t_SourcePath);
+
+		/**
+		 * Take over the data of a cooked mesh file and check that it is intact. The vertices and
+		 * indices point straight into it.
+		 *
+		 * @param t_bVerify		Check the vertices and indices against the checksum they were cooked with
+		 * @return False if it isn't a cooked mesh of this version, or it is corrupt
+		 */
+		bool Load(AssetData&& t_Data, bool t_bVerify = true);
+
+		inline bool IsLoaded() const { return m_Header != nullptr; }
+
+		/** Let go of the file */
+		void Reset();
+
+		/** True if this was cooked from a source file with this hash and size */
+		inline bool IsCookedFrom(uint64 t_SourceHash, uint64 t_SourceSize) const
+		{
+			return m_Header && m_Header->SourceHash == t_SourceHash && m_Header->SourceSize == t_SourceSize;
+		}
+
+		/** True if this was cooked from a file with this size and modified time, which is enough to skip hashing it */
+		inline bool IsCookedFromTime(uint64 t_SourceSize, uint64 t_SourceModifiedTime) const
+		{
+			return m_Header && t_SourceModifiedTime != 0 && m_Header->SourceModifiedTime == t_SourceModifiedTime && m_Header->SourceSize == t_SourceSize;
+		}
+
+		/** True if this was cooked with the same import settings, changing them makes it stale */
+		inline bool IsCookedWith(uint64 t_SettingsHash) const
+		{
+			return m_Header && m_Header->SettingsHash == t_SettingsHash;
+		}
+
+		inline const CookedMeshHeader& GetHeader() const { return *m_Header; }
+
+		inline const Vertex* GetVerts() const { return m_Verts; }
+		inline uint32 GetVertexCount() const { return m_Header ? m_Header->NumVerts : 0; }
+
+		inline const uint32* GetIndices() const { return m_Indices; }
+		inline uint32 GetIndexCount() const { return m_Header ? m_Header->NumIndices : 0; }
+
+		inline const MeshLod* GetLods() const { return m_Lods; }
+		inline uint32 GetLodCount() const { return m_Header ? m_Header->NumLods : 0; }
+
+		inline const Meshlet* GetMeshlets() const { return m_Meshlets; }
+		inline uint32 GetMeshletCount() const { return m_Header ? m_Header->NumMeshlets : 0; }
+
+		inline glm::vec3 GetBoundsCenter() const { return glm::vec3(m_Header->BoundsCenter[0], m_Header->BoundsCenter[1], m_Header->BoundsCenter[2]); }
+		inline float GetBoundsRadius() const { return m_Header->BoundsRadius; }
+
+		/**
+		 * Build the contents of a cooked mesh file
+		 *
+		 * @param t_SourceHash	HashBytes64 of the file the mesh was imported from
+		 * @param t_SourceSize	Size of the file the mesh was imported from
+		 * @param t_SettingsHash	Hash of the import settings, see Model::GetImportSettingsHash
+		 * @param t_SourceModifiedTime	Modified time of the source file, 0 if it isn't known
+		 */
+		static std::vector<char> Cook(
+			const Vertex* t_Verts, uint32 t_NumVerts,
+			const uint32* t_Indices, uint32 t_NumIndices,
+			const MeshLod* t_Lods, uint32 t_NumLods,
+			const Meshlet* t_Meshlets, uint32 t_NumMeshlets,
+			const glm::vec3& t_BoundsCenter, float t_BoundsRadius,
+			uint64 t_SourceHash, uint64 t_SourceSize, uint64 t_SettingsHash, uint64 t_SourceModifiedTime);
+
+		/**
+		 * Write a cooked mesh to disk. It is written to a temporary file first and then renamed
+		 * over the old one, so nobody can map a half written file.
+		 */
+		static bool Write(const std::string& t_Path, const std::vector<char>& t_Cooked);
+
+	private:
+
+		AssetData m_Data;
+
+		const CookedMeshHeader* m_Header = nullptr;
+		const Vertex* m_Verts = nullptr;
+		const uint32* m_Indices = nullptr;
+		const MeshLod* m_Lods = nullptr;
+		const Meshlet* m_Meshlets = nullptr;
+	};
+}   // namespace Fling
@@ -9,7 +9,6 @@ namespace Fling
 	class FrameBuffer;	
 	struct MeshRenderer;
 	class Swapchain;
-	class FirstPersonCamera;
 
 	class DebugSubpass : public Subpass
 	{
@@ -19,14 +18,16 @@ namespace Fling
 			const Swapchain* t_Swap,
 			entt::registry& t_reg,
 			VkRenderPass t_GlobalRenderPass,
-			FirstPersonCamera* t_Cam,
 			std::shared_ptr<Fling::Shader> t_Vert,
 			std::shared_ptr<Fling::Shader> t_Frag
 		);
 
 		virtual ~DebugSubpass();
 
-		void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime) override;
+		/** Creates descriptor sets for any new debug meshes before they are extracted */
+		void PrepareFrame(entt::registry& t_SimReg, const RenderWorld& t_World, float DeltaTime) override;
+
+		void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, const RenderWorld& t_World, float DeltaTime) override;
 
 		void CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg) override;
 
@@ -44,12 +45,14 @@ namespace Fling
 
 		VkRenderPass m_GlobalRenderPass = VK_NULL_HANDLE;
 
-		const FirstPersonCamera* m_Camera;
-
-		struct DebugUBO
+		struct alignas(16) DebugUBO
 		{
 			glm::mat4 Projection;
 			glm::mat4 Model;
+
+			/** Turn packed positions back into model space, the same as OffscreenUBO */
+			alignas(16) glm::vec4 PositionOffset;
+			alignas(16) glm::vec4 PositionScale;
 		} m_Ubo;
 
 		VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
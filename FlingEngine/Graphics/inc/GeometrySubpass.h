@@ -16,7 +16,6 @@ namespace Fling
 	class GraphicsPipeline;
 	class Model;
 	class Buffer;
-	class FirstPersonCamera;
 
 	/**
 	* Settings for the max directional lights and max point lights.
@@ -66,7 +65,6 @@ namespace Fling
 			const Swapchain* t_Swap,
 			entt::registry& t_reg,
 			VkRenderPass t_GlobalRenderPass,
-			FirstPersonCamera* t_Cam,
 			FrameBuffer* t_OffscreenDep,
 			std::shared_ptr<Fling::Shader> t_Vert,
 			std::shared_ptr<Fling::Shader> t_Frag
@@ -74,7 +72,7 @@ namespace Fling
 
 		virtual ~GeometrySubpass();
 
-		void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime) override;
+		void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, const RenderWorld& t_World, float DeltaTime) override;
 
 		void CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg) override;
 
@@ -89,7 +87,7 @@ namespace Fling
 
 		void OnPointLightAdded(entt::entity t_Ent, entt::registry& t_Reg, PointLight& t_Light);
 
-		void UpdateLightingUBO(entt::registry& t_Reg, uint32 t_ActiveFrame);
+		void UpdateLightingUBO(const RenderWorld& t_World, uint32 t_ActiveFrame);
 
 		// Global render pass for frame buffer writes
 		std::shared_ptr<Model> m_QuadModel;
@@ -97,8 +95,6 @@ namespace Fling
 		VkRenderPass m_GlobalRenderPass = VK_NULL_HANDLE;
 		VkDescriptorPool m_DescPool = VK_NULL_HANDLE;
 
-		const FirstPersonCamera* m_Camera;
-
 		/** The offscreen frame buffer that has the G Buffer attachments */
 		FrameBuffer* m_OffscreenFrameBuf = nullptr;
 
@@ -32,8 +32,13 @@ namespace Fling
 
         void CreateBuffer(VkDevice t_Device, VkPhysicalDevice t_PhysicalDevice, VkDeviceSize t_Size, VkBufferUsageFlags t_Usage, VkMemoryPropertyFlags t_Properties, VkBuffer& t_Buffer, VkDeviceMemory& t_BuffMemory);
 
+        /**
+        * Allocate and begin a command buffer from the transient command pool. This is safe to
+        * call from any thread, but the calling thread has the pool locked until it calls EndSingleTimeCommands
+        */
         VkCommandBuffer BeginSingleTimeCommands();
         
+        /** Submit a command buffer from BeginSingleTimeCommands, wait for it to finish and free it */
         void EndSingleTimeCommands(VkCommandBuffer t_CommandBuffer);
 
         void CreateVkImage(
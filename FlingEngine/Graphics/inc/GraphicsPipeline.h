@@ -64,6 +64,8 @@ namespace Fling
 
         VkDescriptorSetLayout m_DescriptorSetLayout;
         VkPipelineVertexInputStateCreateInfo m_VertexInputStateCreateInfo = {};
+        /** Which vertex struct the vertex shader reads, has to match the models that are drawn with it */
+        VertexLayout m_VertexLayout = VertexLayout::Full;
         VkPipelineInputAssemblyStateCreateInfo m_InputAssemblyState = {};
         VkPipelineRasterizationStateCreateInfo m_RasterizationState = {};
         std::vector<VkPipelineColorBlendAttachmentState> m_ColorBlendAttachmentStates;
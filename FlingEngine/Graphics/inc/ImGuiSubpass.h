@@ -9,6 +9,7 @@ namespace Fling
 	class Swapchain;
 	class BaseEditor;
 	class FlingWindow;
+	struct ImGuiDrawSnapshot;
 
 	class ImGuiSubpass : public Subpass
 	{
@@ -26,7 +27,10 @@ namespace Fling
 
 		virtual ~ImGuiSubpass();
 
-		void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime) override;
+		/** Builds the editor UI from the game registry and copies the draw lists for the given render world */
+		void PrepareFrame(entt::registry& t_SimReg, const RenderWorld& t_World, float DeltaTime) override;
+
+		void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, const RenderWorld& t_World, float DeltaTime) override;
 
 		void CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg) override;
 
@@ -42,9 +46,9 @@ namespace Fling
 
 		void PrepareResources();
 
-		void BuildCommandBuffer(VkCommandBuffer t_commandBuffer);
+		void BuildCommandBuffer(VkCommandBuffer t_commandBuffer, const ImGuiDrawSnapshot& t_DrawData);
 
-		void UpdateUniforms();
+		void UpdateUniforms(const ImGuiDrawSnapshot& t_DrawData);
 
 		struct PushConstBlock
 		{
@@ -73,6 +77,9 @@ namespace Fling
 		/** Instance of the editor that we will get what commands to build from */
 		std::shared_ptr<Fling::BaseEditor> m_Editor;
 
+		/** Copied ImGui draw data, one for each render world so the main thread can build the next frame's UI while this one is drawn */
+		std::vector<ImGuiDrawSnapshot> m_Snapshots;
+
 		int32 m_vertexCount = 0;
 		int32 m_indexCount = 0;
 
@@ -34,5 +34,6 @@ namespace Fling
 		}
 
 		FORCEINLINE void SetPos(const glm::vec4& t_Pos) { Pos = t_Pos; }
+		FORCEINLINE const glm::vec4& GetPos() const { return Pos; }
 	};
 }	// namespace Fling
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingMath.h"
+#include "MeshSimplifier.h"
+
+namespace Fling
+{
+	/**
+	 * Picks which LOD of a model to draw from how big its error would be on screen. A LOD's
+	 * MeshLod::Error is projected with the camera from the closest point of the model's bounding
+	 * sphere, and the coarsest LOD that stays under a pixel threshold is drawn.
+	 *
+	 * A model sitting right at the threshold would flip between two LODs every frame, so the LOD
+	 * only gets coarser once the error is Hysteresis below the threshold, and only gets finer once
+	 * the error of the current one is Hysteresis above it.
+	 */
+	namespace LodSelection
+	{
+		/** Most error in pixels that a LOD can have on screen */
+		constexpr float DefaultErrorThreshold = 1.0f;
+
+		/** How far past the threshold, as a fraction of it, the error has to go before the LOD changes */
+		constexpr float DefaultHysteresis = 0.25f;
+
+		/**
+		 * How many pixels tall something one unit tall is at a distance of one unit
+		 *
+		 * @param t_Projection		Perspective projection, before it is flipped for Vulkan
+		 * @param t_ViewportHeight	Height of the render target in pixels
+		 */
+		float GetProjectionScale(const glm::mat4& t_Projection, float t_ViewportHeight);
+
+		/**
+		 * What to multiply a model space error by to get the error in pixels
+		 *
+		 * @param t_Bounds			World space bounding sphere, xyz is the center and w is the radius
+		 * @param t_ModelRadius		Radius of the model's bounds in model space, to tell how much it is scaled by
+		 * @param t_CameraPos		World space camera position
+		 * @param t_ProjectionScale	From GetProjectionScale
+		 */
+		float GetErrorScale(const glm::vec4& t_Bounds, float t_ModelRadius, const glm::vec3& t_CameraPos, float t_ProjectionScale);
+
+		/**
+		 * Pick a LOD to draw
+		 *
+		 * @param t_Lods			The model's LODs, with errors that get bigger
+		 * @param t_ErrorScale		From GetErrorScale
+		 * @param t_Threshold		Most error in pixels
+		 * @param t_CurrentLod		The LOD that was drawn last frame
+		 * @return Index into t_Lods
+		 */
+		uint32 SelectLod(
+			const MeshLod* t_Lods,
+			uint32 t_LodCount,
+			float t_ErrorScale,
+			float t_Threshold,
+			uint32 t_CurrentLod,
+			float t_Hysteresis = DefaultHysteresis);
+	}
+}   // namespace Fling
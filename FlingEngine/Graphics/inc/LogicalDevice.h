@@ -2,6 +2,8 @@
 
 #include "FlingVulkan.h"
 
+#include <mutex>
+
 namespace Fling
 {
 	class PhysicalDevice;
@@ -33,6 +35,11 @@ namespace Fling
 
 		void WaitForIdle();
 
+		/**
+		 * Vulkan queues need to be externally synchronized. Hold this lock around any
+		 * vkQueueSubmit, vkQueueWaitIdle or vkQueuePresentKHR on this device's queues.
+		 */
+		std::mutex& GetQueueMutex() const { return m_QueueMutex; }
 
     private:
 
@@ -56,6 +63,9 @@ namespace Fling
 		uint32 m_ComputeFamily = 0;
 		uint32 m_TransferFamily = 0;
 
+		/** @see GetQueueMutex */
+		mutable std::mutex m_QueueMutex;
+
 		/**
 		 * Get what queue Indecies/families this device should use
 		 */
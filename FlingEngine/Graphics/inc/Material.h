@@ -3,6 +3,7 @@
 #include "Shader.h"
 #include "Texture.h"
 #include "JsonFile.h"
+#include "ResourceFuture.h"
 #include "ShaderPrograms/ShaderProgram.h"
 
 namespace Fling
@@ -12,10 +13,10 @@ namespace Fling
     */
     struct PBRTextures
     {
-        Texture* m_AlbedoTexture        = nullptr;
-        Texture* m_NormalTexture        = nullptr;
-        Texture* m_RoughnessTexture    = nullptr;
-        Texture* m_MetalTexture        = nullptr;
+        std::shared_ptr<Texture> m_AlbedoTexture;
+        std::shared_ptr<Texture> m_NormalTexture;
+        std::shared_ptr<Texture> m_RoughnessTexture;
+        std::shared_ptr<Texture> m_MetalTexture;
     };
 
     /**
@@ -40,6 +41,9 @@ namespace Fling
 
         explicit Material(Guid t_ID);
 
+        /** Only read the material file, textures are streamed in with their own async loads */
+        Material(Guid t_ID, AsyncLoad_t);
+
         const PBRTextures& GetPBRTextures() const { return m_Textures; }
 
 		Material::Type GetType() const { return m_Type; }
@@ -48,10 +52,38 @@ namespace Fling
 
 		static const std::string& GetStringFromType(const Material::Type);
 
+        /**
+         * Materials don't have much memory of their own, but they keep their textures loaded.
+         * Evicting an unused material lets its textures be evicted too.
+         */
+        bool CanBeEvicted() const override { return true; }
+
+    protected:
+
+        bool FinalizeAsyncLoad() override;
+
     private:
 
+        /** Number of textures in PBRTextures */
+        static constexpr uint32 NumTextureSlots = 4;
+
         void LoadMaterial();
 
+        /**
+         * Read the pipeline type and texture paths out of the JSON data
+         * @return True if this material has textures to load
+         */
+        bool ReadMaterialData();
+
+        /** Where each texture path gets loaded into */
+        std::shared_ptr<Texture>* GetTextureSlot(uint32 t_Index);
+
+        /** Texture paths in the same order as GetTextureSlot */
+        std::string m_TexturePaths[NumTextureSlots];
+
+        /** Textures that are still loading when this material was loaded asynchronously */
+        std::vector<ResourceFuture<Texture>> m_PendingTextures;
+
         // Textures that this material uses
         PBRTextures m_Textures = {};
         
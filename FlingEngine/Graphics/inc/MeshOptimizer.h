@@ -0,0 +1,56 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "Vertex.h"
+
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * Import time passes that make a mesh cheaper for the GPU to draw without changing what it looks like.
+	 * Model runs them in order: WeldVertices, then OptimizeVertexCache, then OptimizeVertexFetch.
+	 */
+	namespace MeshOptimizer
+	{
+		/** Size of the post transform cache that the optimizer and the stats assume */
+		constexpr uint32 DefaultCacheSize = 32;
+
+		/** How well an index buffer uses the post transform vertex cache */
+		struct VertexCacheStats
+		{
+			/** Vertices transformed per triangle. 3 is no reuse at all, 0.5 is the best a big grid can do */
+			float ACMR = 0.0f;
+
+			/** Vertices transformed per vertex in the mesh. 1 is perfect */
+			float ATVR = 0.0f;
+		};
+
+		/**
+		 * Merge vertices that are exactly the same and point the indices at the one that is kept.
+		 * Vertices keep the order they were first seen in.
+		 *
+		 * @return Number of vertices left
+		 */
+		uint32 WeldVertices(std::vector<Vertex>& t_Verts, std::vector<uint32>& t_Indices);
+
+		/**
+		 * Reorder triangles so that vertices are reused while they are still in the post transform
+		 * cache, with Tom Forsyth's linear speed greedy algorithm. Every triangle keeps its winding.
+		 *
+		 * @see https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+		 */
+		void OptimizeVertexCache(uint32* t_Indices, size_t t_NumIndices, uint32 t_NumVerts);
+
+		/**
+		 * Reorder vertices into the order the index buffer first uses them, so that vertex fetches
+		 * walk through memory instead of jumping around it. Vertices that no triangle uses are dropped.
+		 *
+		 * @return Number of vertices left
+		 */
+		uint32 OptimizeVertexFetch(std::vector<Vertex>& t_Verts, std::vector<uint32>& t_Indices);
+
+		/** Simulate a FIFO post transform cache of t_CacheSize vertices */
+		VertexCacheStats AnalyzeVertexCache(const uint32* t_Indices, size_t t_NumIndices, uint32 t_NumVerts, uint32 t_CacheSize = DefaultCacheSize);
+	}
+}   // namespace Fling
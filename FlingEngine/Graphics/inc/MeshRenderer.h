@@ -4,8 +4,10 @@
 #include "Material.h"
 #include "Model.h"
 #include "Buffer.h"
+#include "ResourceManager.h"
 
 #include <entt/entity/registry.hpp>
+#include <type_traits>
 
 namespace Fling
 {
@@ -19,28 +21,63 @@ namespace Fling
 
 		MeshRenderer(const std::string& t_MeshPath, const std::string& t_MaterialPath);
 
+		/**
+		* Stream the model and material in without stalling the frame. The mesh isn't drawn until
+		* its model is ready and it uses the default material until its own material is ready.
+		* The default material picks which subpass draws it, so t_MaterialPath should be a default (PBR) material.
+		*/
+		MeshRenderer(const std::string& t_MeshPath, const std::string& t_MaterialPath, AsyncLoad_t);
+
 		/**
 		* Create a mesh renderer with the given material and model.
 		* If the material is null than it will load the default material
 		*/
-		MeshRenderer(Model* t_Model, Material* t_Mat = nullptr);
+		MeshRenderer(const std::shared_ptr<Model>& t_Model, const std::shared_ptr<Material>& t_Mat = nullptr);
 
-		// Cleanup is handled by the rendering systems
+		// Cleanup is handled by the rendering systems and ReleaseHandles
 		~MeshRenderer() = default;
 
-		/** Pointer to the actual model  */
-		Model* m_Model = nullptr;
+		/**
+		* The model and material. Each handle owns a reference that keeps the resource from being
+		* evicted while this mesh renderer is around. Mesh renderers are plain values, so copying
+		* one hands the same references to the copy. Only one of them should end up in a registry.
+		*/
+		ResourceHandle<Model> m_Model;
 
-		/** Pointer to the material that this mesh renderer uses */
-		Material* m_Material = nullptr;
+		ResourceHandle<Material> m_Material;
+
+		/** The material that is drawn with. The default material until m_Material has streamed in */
+		ResourceHandle<Material> m_ActiveMaterial;
 
 		/** We need a uniform buffer per-swap chain image */
 		Buffer* m_UniformBuffer = nullptr;
 
 		VkDescriptorSet m_DescriptorSet  = VK_NULL_HANDLE;
 
+		/** The model to draw, nullptr if there isn't one or it is still loading */
+		inline Model* GetModel() const { return ResourceManager::Resolve(m_Model); }
+
+		/** The material to draw with, see m_ActiveMaterial */
+		inline Material* GetMaterial() const { return ResourceManager::Resolve(m_ActiveMaterial); }
+
+		/**
+		* Start drawing with m_Material once it has streamed in.
+		* Called by the renderer on the main thread before each frame is extracted.
+		*
+		* @return True if the material changed and any descriptor sets need to be rebuilt
+		*/
+		bool UpdatePendingLoads();
+
+		inline bool HasPendingLoads() const { return m_ActiveMaterial != m_Material || (m_Model.IsValid() && !GetModel()); }
+
 		void Release();
 
+		/** Give back the model and material handles, called when the component is destroyed */
+		void ReleaseHandles();
+
+		/** Release the handles of every mesh renderer that is destroyed in this registry */
+		static void ConnectToRegistry(entt::registry& t_Reg);
+
 		bool operator==(const MeshRenderer& other) const;
 		bool operator!=(const MeshRenderer& other) const;
 
@@ -49,5 +86,14 @@ namespace Fling
 		void LoadModelFromPath(const std::string& t_MeshPath);
 
 		void LoadMaterialFromPath(const std::string& t_MatPath);
+
+	private:
+
+		/** Take ownership of a material handle and start drawing with it as soon as it is safe to */
+		void SetMaterial(ResourceHandle<Material> t_Material);
+
+		static void OnDestroyed(entt::entity t_Ent, entt::registry& t_Reg);
 	};
+
+	static_assert(std::is_trivially_copyable<MeshRenderer>::value, "MeshRenderer needs to stay trivially copyable so that the registry can memcpy it");
 }	// namespace Fling
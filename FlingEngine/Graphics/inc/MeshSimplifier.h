@@ -0,0 +1,70 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "Vertex.h"
+
+#include <vector>
+
+namespace Fling
+{
+	/** One level of detail of a mesh, a range of its index buffer. Written straight into cooked meshes */
+	struct MeshLod
+	{
+		uint32 FirstIndex = 0;
+		uint32 IndexCount = 0;
+
+		/**
+		 * Roughly how far in model space this LOD's surface is from the full detail one. Project it
+		 * to the screen to decide when the LOD is good enough. 0 for LOD 0.
+		 */
+		float Error = 0.0f;
+	};
+
+	static_assert(sizeof(MeshLod) == 12, "MeshLod is written straight to disk, don't change its size");
+
+	/**
+	 * Makes lower detail versions of a mesh by collapsing edges, cheapest first, with quadric error
+	 * metrics (Garland and Heckbert). Every collapse moves a vertex onto one of its neighbours, so
+	 * the simplified index buffers still use the original vertex buffer and every LOD can share it.
+	 *
+	 * Collapses also pay for how much they bend the normals, texture coordinates and colors, with
+	 * attribute quadrics (Hoppe), so flat evenly mapped areas go before detailed ones. Vertices on
+	 * attribute seams (where vertices with the same position have different attributes) never move,
+	 * so the seams don't crack. Vertices on open boundaries only slide along the boundary, and extra
+	 * planes along it keep it from shrinking. Duplicate triangles are left out of the simplified LODs.
+	 *
+	 * @see https://www.cs.cmu.edu/~garland/Papers/quadrics.pdf
+	 * @see https://hhoppe.com/newqem.pdf
+	 */
+	namespace MeshSimplifier
+	{
+		constexpr uint32 DefaultMaxLods = 4;
+
+		/** How many of the triangles of one LOD the next one aims to keep */
+		constexpr float DefaultLodReduction = 0.5f;
+
+		/**
+		 * Simplify a mesh down to at most t_TargetIndexCount indices, or as close as it can get
+		 *
+		 * @param t_Out		The simplified indices
+		 * @return The error of the simplified mesh, the same as MeshLod::Error
+		 */
+		float Simplify(const std::vector<Vertex>& t_Verts, const uint32* t_Indices, size_t t_NumIndices, size_t t_TargetIndexCount, std::vector<uint32>& t_Out);
+
+		/**
+		 * Build a chain of LODs that each have about t_Reduction of the triangles of the one before.
+		 * Stops early once the mesh can't be simplified any more. Every LOD after the first is
+		 * optimized for the vertex cache.
+		 *
+		 * @param t_Indices		The full detail mesh going in, every LOD back to back coming out
+		 * @param t_OutLods		Where each LOD is in t_Indices, starting with the full detail mesh
+		 * @param t_MaxLods		Most LODs to make, including the full detail one
+		 */
+		void BuildLodChain(
+			const std::vector<Vertex>& t_Verts,
+			std::vector<uint32>& t_Indices,
+			std::vector<MeshLod>& t_OutLods,
+			uint32 t_MaxLods = DefaultMaxLods,
+			float t_Reduction = DefaultLodReduction);
+	}
+}   // namespace Fling
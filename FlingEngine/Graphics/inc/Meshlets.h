@@ -0,0 +1,104 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingMath.h"
+#include "Vertex.h"
+
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * A small cluster of a mesh's triangles that can be culled on its own. Meshlets are runs of
+	 * triangles that are next to each other in the index buffer. Written straight into cooked meshes.
+	 */
+	struct Meshlet
+	{
+		uint32 FirstIndex = 0;
+		uint32 IndexCount = 0;
+
+		/** Number of different vertices the triangles use */
+		uint32 VertexCount = 0;
+
+		/** Model space bounding sphere */
+		glm::vec3 Center { 0.0f };
+		float Radius = 0.0f;
+
+		/**
+		 * Cone that every triangle's normal is inside of. If the camera sees the apex at more than the
+		 * cutoff along the axis, every triangle faces away from it. A cutoff of 1 never culls.
+		 */
+		glm::vec3 ConeApex { 0.0f };
+		glm::vec3 ConeAxis { 0.0f };
+		float ConeCutoff = 1.0f;
+	};
+
+	static_assert(sizeof(Meshlet) == 56, "Meshlet is written straight to disk, don't change its size");
+
+	/**
+	 * Splits meshes into meshlets at import, and culls them against the camera on the CPU so big meshes
+	 * only draw the clusters that can be seen. Meshlets are grown one triangle at a time from their
+	 * neighbours, preferring ones that add the fewest vertices and then the ones that face the same way,
+	 * so they come out compact with narrow normal cones. The triangles are then put in meshlet order so
+	 * every meshlet is one range of the index buffer.
+	 */
+	namespace Meshlets
+	{
+		/** Sizes that suit mesh shaders too, 124 triangles leaves room for a header in 128 */
+		constexpr uint32 DefaultMaxVertices = 64;
+		constexpr uint32 DefaultMaxTriangles = 124;
+
+		/** A range of an index buffer to draw */
+		struct DrawRange
+		{
+			uint32 FirstIndex = 0;
+			uint32 IndexCount = 0;
+		};
+
+		/**
+		 * Split a range of an index buffer into meshlets, reordering the triangles in it to match
+		 *
+		 * @param t_Indices		The whole index buffer, meshlet FirstIndex values count from the start of it
+		 */
+		void Build(
+			const std::vector<Vertex>& t_Verts,
+			uint32* t_Indices,
+			uint32 t_FirstIndex,
+			uint32 t_IndexCount,
+			std::vector<Meshlet>& t_Out,
+			uint32 t_MaxVertices = DefaultMaxVertices,
+			uint32 t_MaxTriangles = DefaultMaxTriangles);
+
+		/** Where the camera is and what it can see, in the space of one model */
+		struct CullParams
+		{
+			/** Frustum planes facing in, normalized so they give distances in model space */
+			glm::vec4 Planes[6];
+
+			glm::vec3 CameraPos { 0.0f };
+
+			/** Off when the model is mirrored or squashed, which bends the normal cones */
+			bool bConeCulling = true;
+		};
+
+		/**
+		 * Put the camera in a model's space. The planes come from the combined matrix (Gribb and Hartmann),
+		 * and the near plane is the OpenGL one, which is the same or further back for Vulkan depth.
+		 *
+		 * @param t_ViewProjection	Projection * View, before the projection is flipped for Vulkan
+		 * @param t_World			The model's world matrix
+		 */
+		CullParams MakeCullParams(const glm::mat4& t_ViewProjection, const glm::mat4& t_World, const glm::vec3& t_CameraPos);
+
+		/** False if the meshlet is outside the frustum or every triangle in it faces away from the camera */
+		bool IsVisible(const Meshlet& t_Meshlet, const CullParams& t_Params);
+
+		/**
+		 * Cull meshlets and merge the ones that are left into as few ranges as possible
+		 *
+		 * @param t_OutRanges	Cleared first
+		 * @return Number of meshlets that are visible
+		 */
+		uint32 Cull(const Meshlet* t_Meshlets, uint32 t_Count, const CullParams& t_Params, std::vector<DrawRange>& t_OutRanges);
+	}
+}   // namespace Fling
@@ -3,6 +3,9 @@
 #include "Resource.h"
 
 #include "Buffer.h"
+#include "CookedMesh.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
 #include "Vertex.h"
 
 namespace Fling
@@ -11,6 +14,17 @@ namespace Fling
 	 * A model represents a 3D model (.obj files for now) with vertices
 	 * 			and indecies. A model has a vertex and index buffer and can be 
 	 * 			bound to a command buffer.
+	 *
+	 * Models are loaded from the cooked .flmesh next to their source file when there is an up to date
+	 * one. Otherwise the source is imported and, with CookMeshes on, cooked for next time.
+	 *
+	 * Imported models get a chain of MeshLods. Every LOD is a range of the one index buffer and they
+	 * all use the same vertex buffer, so switching LOD is just drawing a different range.
+	 * The full detail mesh is also split into Meshlets, so the parts of it that can't be seen can be culled.
+	 *
+	 * With CompactVertices on the vertex buffer holds PackedVertex instead, see VertexPacking.
+	 *
+	 * @see Fling::CookedMesh
 	 */
     class Model : public Resource
     {
@@ -27,6 +41,9 @@ namespace Fling
 		 */
 		Model(Guid t_ID);
 
+		/** Only parse the model file, the GPU buffers are created in FinalizeAsyncLoad */
+		Model(Guid t_ID, AsyncLoad_t);
+
 		/**
 		 * @param	t_ID The GUID that represents a unique name for this model. It's up to the user to ensure uniqueness
 		 */
@@ -38,29 +55,108 @@ namespace Fling
 		FORCEINLINE Buffer* GetIndexBuffer() const { return m_IndexBuffer; }
 
 		FORCEINLINE const std::vector<Vertex>& GetVerts() const { return m_Verts; }
+		/** The indices of every LOD, back to back */
 		FORCEINLINE const std::vector<uint32>& GetIndices() const { return m_Indices; }
 
-		FORCEINLINE uint32 GetIndexCount() const { return static_cast<uint32>(m_Indices.size()); }
+		/** Number of indices in the full detail mesh */
+		FORCEINLINE uint32 GetIndexCount() const { return m_Lods.empty() ? static_cast<uint32>(m_Indices.size()) : m_Lods[0].IndexCount; }
 		FORCEINLINE uint32 GetVertexCount() const { return static_cast<uint32>(m_Verts.size()); }
 
-		constexpr static VkIndexType GetIndexType() { return VK_INDEX_TYPE_UINT32; }
+		/** 16 bit when the model has few enough vertices, the CPU copy of the indices is always 32 bit */
+		FORCEINLINE VkIndexType GetIndexType() const { return m_IndexType; }
+
+		/** What the vertex buffer holds, the CPU copy of the vertices is always Vertex */
+		FORCEINLINE VertexLayout GetVertexLayout() const { return m_VertexLayout; }
+
+		/** What packed positions are scaled by and then offset by to get back to model space */
+		FORCEINLINE const glm::vec3& GetPositionOffset() const { return m_PositionOffset; }
+		FORCEINLINE const glm::vec3& GetPositionScale() const { return m_PositionScale; }
+
+		/** Number of levels of detail, including the full detail mesh */
+		FORCEINLINE uint32 GetLodCount() const { return static_cast<uint32>(m_Lods.size()); }
+
+		/** LOD 0 is the full detail mesh, every one after it has fewer triangles and a bigger error */
+		FORCEINLINE const MeshLod& GetLod(uint32 t_Lod) const { return m_Lods[t_Lod]; }
+
+		/** Meshlets of the full detail mesh, in index buffer order. Empty for models made in code */
+		FORCEINLINE const std::vector<Meshlet>& GetMeshlets() const { return m_Meshlets; }
+		FORCEINLINE uint32 GetMeshletCount() const { return static_cast<uint32>(m_Meshlets.size()); }
+
+		/** Center of a sphere in model space that contains every vertex */
+		FORCEINLINE const glm::vec3& GetBoundsCenter() const { return m_BoundsCenter; }
+		FORCEINLINE float GetBoundsRadius() const { return m_BoundsRadius; }
+
+		/** The GPU vertex and index buffers, plus the CPU copies of the vertices and indices */
+		ResourceMemoryUsage GetMemoryUsage() const override;
+
+		/** Models that were made in code can't be loaded again, so only ones loaded from a file can be evicted */
+		bool CanBeEvicted() const override { return m_bLoadedFromFile; }
+
+	protected:
+
+		bool FinalizeAsyncLoad() override;
 
 	private:
 
+		/** Upload the vertices and indices, straight from the cooked mesh file if that is where they came from */
 		void CreateBuffers();
 
 		static void CalculateVertexTangents(Vertex* verts, uint32 numVerts, uint32* indices, uint32 numIndices);
 
+		/** Fit a bounding sphere around the vertices, centered on their bounding box */
+		void CalculateBounds();
+
 		std::vector<Vertex> m_Verts;
 		std::vector<uint32> m_Indices;
+		std::vector<MeshLod> m_Lods;
+		std::vector<Meshlet> m_Meshlets;
 
 		Buffer* m_VertexBuffer = nullptr;
 		Buffer* m_IndexBuffer = nullptr;
 
+		VkIndexType m_IndexType = VK_INDEX_TYPE_UINT32;
+		VertexLayout m_VertexLayout = VertexLayout::Full;
+		glm::vec3 m_PositionOffset { 0.0f };
+		glm::vec3 m_PositionScale { 1.0f };
+
+		glm::vec3 m_BoundsCenter { 0.0f };
+		float m_BoundsRadius = 0.0f;
+
+		bool m_bLoadedFromFile = false;
+
+		/** The mapped cooked mesh file that this was loaded from, until the GPU buffers are made */
+		CookedMesh m_Cooked;
+
+		/**
+		 * Load this model from its cooked mesh, or import it if that is missing or stale
+		 * @return False if the file could not be loaded
+		 */
+		bool LoadModel();
+
+		/** Take the vertices, indices, LODs, meshlets and bounds from m_Cooked */
+		void LoadCooked();
+
 		/**
-		 * Load this model from Tiny Obj loader
+		 * Import the source file of this model
+		 * @return False if the file could not be parsed
 		 */
-		void LoadModel();
+		bool ImportModel(const AssetData& t_Source);
+
+		/**
+		 * Read the source file of this model, if it hasn't been read already, and hash it
+		 * @param t_SourceHash	Hash of the source, left alone if it is known already
+		 * @return False if the file could not be read
+		 */
+		bool ReadSource(AssetData& t_Source, uint64& t_SourceHash) const;
+
+		/** Write the imported mesh out to the cooked mesh file */
+		void CookModel(const std::string& t_CookedPath, uint64 t_SourceHash, uint64 t_SourceSize, uint64 t_SourceModifiedTime) const;
+
+		/** How many LODs to import models with, from the MeshLods setting */
+		static uint32 GetMaxLods();
+
+		/** Hash of the settings that change what ImportModel makes, cooked meshes with a different one are stale */
+		static uint64 GetImportSettingsHash();
 
     };
 }   // namespace Fling
\ No newline at end of file
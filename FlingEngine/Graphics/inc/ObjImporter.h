@@ -0,0 +1,58 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "Vertex.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Fling
+{
+	class VirtualArena;
+
+	/**
+	 * Wavefront OBJ importer that parses a file in parallel on the job system. The text is split into
+	 * line aligned chunks and every chunk is parsed on its own, in three passes:
+	 *
+	 *  1. Count the positions, normals, texture coordinates and triangle corners in each chunk
+	 *  2. Parse each chunk straight into its slice of the shared arrays, found from the counts
+	 *  3. Build a Vertex for every triangle corner
+	 *
+	 * Nothing has to be merged at the end, and nothing grows while it is being parsed. Numbers are
+	 * read with hand rolled from_chars style parsers that don't look at the locale or allocate.
+	 *
+	 * The output matches what tinyobjloader gave Model: one vertex per triangle corner in file order
+	 * with a white color, polygons fanned into triangles, and indices 0, 1, 2... Materials, groups,
+	 * lines and points are skipped. Parallel on any thread, including the resource loading threads.
+	 */
+	namespace ObjImporter
+	{
+		/** Roughly how many bytes of the file each job parses */
+		constexpr size_t DefaultChunkSize = 256 * 1024;
+
+		/**
+		 * Import an OBJ file that is already in memory. The vertices and indices are written straight
+		 * into the output vectors, everything else is parsed into the scratch arena
+		 *
+		 * @param t_Text			Contents of the file
+		 * @param t_OutError		Why the import failed
+		 * @param t_ScratchArena	Arena for the temporary arrays, rewound before returning. A small one is made if null
+		 * @return False if the file is malformed, i.e. a face uses a vertex that doesn't exist
+		 */
+		bool Import(
+			std::string_view t_Text,
+			std::vector<Vertex>& t_OutVerts,
+			std::vector<uint32>& t_OutIndices,
+			std::string& t_OutError,
+			size_t t_ChunkSize = DefaultChunkSize,
+			VirtualArena* t_ScratchArena = nullptr);
+
+		/**
+		 * Parse a decimal float like "-1.25e-3" from the start of [t_Begin, t_End), skipping spaces and tabs first
+		 *
+		 * @return Where the number ended, or nullptr if there isn't one
+		 */
+		const char* ParseFloat(const char* t_Begin, const char* t_End, float& t_Out);
+	}
+}   // namespace Fling
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Subpass.h"
+#include "Meshlets.h"
 
 namespace Fling
 {
@@ -8,8 +9,8 @@ namespace Fling
 	class LogicalDevice;
 	class FrameBuffer;	
 	struct MeshRenderer;
+	class Model;
 	class Swapchain;
-	class FirstPersonCamera;
 
 	/** UBO for mesh data */
 	struct alignas(16) OffscreenUBO
@@ -18,6 +19,10 @@ namespace Fling
 		glm::mat4 Model;
 		glm::mat4 View;
 		glm::vec3 ObjPos;
+
+		/** Turn packed positions back into model space, see VertexPacking. Unused by the full vertex shader */
+		alignas(16) glm::vec4 PositionOffset;
+		alignas(16) glm::vec4 PositionScale;
 	};
 
 	// Uses the MRT shaders (mulitple render targets)
@@ -28,7 +33,6 @@ namespace Fling
 			const LogicalDevice* t_Dev,
 			const Swapchain* t_Swap,
 			entt::registry& t_reg,
-			FirstPersonCamera* t_Cam,
 			std::shared_ptr<Fling::Shader> t_Vert,
 			std::shared_ptr<Fling::Shader> t_Frag
 		);
@@ -37,15 +41,18 @@ namespace Fling
 
 		FrameBuffer* GetOffscreenFrameBuffer() const { return m_OffscreenFrameBuf; }
 
-		void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveSwapImage, entt::registry& t_reg, float DeltaTime) override final;
+		/** Swaps in any streamed in materials and frees descriptor sets that the GPU is done with */
+		void PrepareFrame(entt::registry& t_SimReg, const RenderWorld& t_World, float DeltaTime) override final;
+
+		void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveSwapImage, const RenderWorld& t_World, float DeltaTime) override final;
 
 		void PrepareAttachments() override final;
 
 		void CreateGraphicsPipeline() override final;
 
 		void GatherPresentDependencies(
-			std::vector<CommandBuffer*>& t_CmdBuffs,
-			std::vector<VkSemaphore>& t_Deps,
+			ScratchVector<CommandBuffer*>& t_CmdBuffs,
+			ScratchVector<VkSemaphore>& t_Deps,
 			uint32 t_ActiveFrameIndex,
 			uint32 t_CurrentFrameInFlight) override final;
 
@@ -63,6 +70,12 @@ namespace Fling
 
 		void BuildOffscreenCommandBuffer(entt::registry& t_reg, uint32 t_ActiveFrameInFlight);
 
+		/**
+		 * Pick the LOD to draw an entity's model with from how big it is on screen, and remember it for next frame
+		 * @see LodSelection
+		 */
+		uint32 SelectLod(entt::entity t_Ent, const Model& t_Model, const glm::vec4& t_Bounds, const glm::vec3& t_CameraPos, float t_ProjectionScale);
+
 		// We need an offscreen semaphore for each possible frame in flight because the swap chain
 		// presentation will depend on this command buffer being complete
 		std::vector<VkSemaphore> m_OffscreenSemaphores;
@@ -74,8 +87,37 @@ namespace Fling
 
 		FrameBuffer* m_OffscreenFrameBuf = nullptr;
 
-		const FirstPersonCamera* m_Camera;
-
 		VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+
+		/** A descriptor set that was replaced, but may still be used by a frame in flight */
+		struct RetiredDescriptorSet
+		{
+			VkDescriptorSet Set = VK_NULL_HANDLE;
+			uint64 FreeOnFrame = 0;
+		};
+
+		std::vector<RetiredDescriptorSet> m_RetiredDescriptorSets;
+
+		/** Number of times PrepareFrame has been called */
+		uint64 m_FrameCount = 0;
+
+		/** The LOD an entity was drawn with last frame */
+		struct EntityLod
+		{
+			entt::entity Entity = entt::null;
+			uint8 Lod = 0;
+		};
+
+		/** Indexed by entity id without the version. Only touched while drawing */
+		std::vector<EntityLod> m_EntityLods;
+
+		/** Most error in pixels a LOD can have, from LodErrorPixels with the LodBias applied */
+		float m_LodErrorThreshold = 1.0f;
+
+		/** Cull the meshlets of models drawn at full detail, from ClusterCulling */
+		bool m_bClusterCulling = true;
+
+		/** The ranges of the index buffer that survived cluster culling, reused for every draw */
+		std::vector<Meshlets::DrawRange> m_VisibleRanges;
 	};
 }   // namespace Fling
\ No newline at end of file
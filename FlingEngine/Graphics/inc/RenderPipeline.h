@@ -11,6 +11,7 @@ namespace Fling
 	class Swapchain;
 	class FrameBuffer;
 	struct MeshRenderer;
+	class RenderWorld;
 
 	/**
 	* A render pipeline encapsulates the functionality of a
@@ -22,12 +23,15 @@ namespace Fling
 		RenderPipeline(entt::registry& t_Reg, LogicalDevice* t_dev, Swapchain* t_Swap, std::vector<std::unique_ptr<Subpass>>& t_Subpasses);
 		~RenderPipeline();
 
-		void Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, uint32 t_ActiveFrameInFlight, entt::registry& t_Reg, float DeltaTime);
+		/** Let every subpass read from the game registry before the frame is drawn. @see Subpass::PrepareFrame */
+		void PrepareFrame(entt::registry& t_SimReg, const RenderWorld& t_World, float DeltaTime);
+
+		void Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, uint32 t_ActiveFrameInFlight, const RenderWorld& t_World, float DeltaTime);
 
 		/** Given a frame index, get any semaphores that the swap chain command buffer needs to wait for */
-		void GatherPresentDependencies(std::vector<CommandBuffer*>& t_CmdBuffs, std::vector<VkSemaphore>& t_Deps, uint32 t_ActiveFrameIndex, uint32 t_CurrentFrameInFlight);
+		void GatherPresentDependencies(ScratchVector<CommandBuffer*>& t_CmdBuffs, ScratchVector<VkSemaphore>& t_Deps, uint32 t_ActiveFrameIndex, uint32 t_CurrentFrameInFlight);
 
-		void GatherPresentBuffers(std::vector<CommandBuffer*>& t_CmdBuffs, uint32 t_ActiveFrameIndex);
+		void GatherPresentBuffers(ScratchVector<CommandBuffer*>& t_CmdBuffs, uint32 t_ActiveFrameIndex);
 
 		/** Clean up any allocated VK resources that may have been set in a sub pass and need the registry */
 		void CleanUp(entt::registry& t_reg);
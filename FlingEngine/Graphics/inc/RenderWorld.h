@@ -0,0 +1,198 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingMath.h"
+#include "FlingVulkan.h"
+#include "NonCopyable.hpp"
+#include "Lighting/PointLight.hpp"
+#include "Lighting/DirectionalLight.hpp"
+
+#include <entt/entity/registry.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace Fling
+{
+	class Camera;
+	class Model;
+	class Material;
+	class Buffer;
+	struct Transform;
+
+	/** The parts of a camera that the renderer needs, copied out when a frame is extracted */
+	struct RenderCamera
+	{
+		glm::mat4 View { 1.0f };
+		glm::mat4 Projection { 1.0f };
+		glm::vec3 Position { 0.0f };
+		float Gamma = 2.2f;
+		float Exposure = 4.5f;
+
+		void CopyFrom(const Camera& t_Cam);
+	};
+
+	/** Per frame values that are not tied to an entity */
+	struct RenderFrameInfo
+	{
+		RenderCamera Camera;
+
+		/** How far between the previous and current simulation step transforms were extracted at */
+		float InterpolationAlpha = 1.0f;
+
+		float DeltaTime = 0.0f;
+	};
+
+	/** Which subpass draws a mesh, picked from the material tag on its entity */
+	enum class MeshDrawList : uint8
+	{
+		Default,
+		Debug,
+		Count
+	};
+
+	/**
+	 * Every mesh in one draw list as parallel arrays (structure of arrays).
+	 * Draws are sorted by material, then mesh, then front to back, so draws that share buffers are next to each other.
+	 * @see DrawSorting::PackDraws
+	 */
+	struct MeshDraws
+	{
+		std::vector<glm::mat4> WorldMatrices;
+
+		/** World space bounding spheres, xyz is the center and w is the radius */
+		std::vector<glm::vec4> Bounds;
+
+		/** Index into RenderWorld::GetMeshes */
+		std::vector<uint32> MeshIds;
+
+		/** Index into RenderWorld::GetMaterials */
+		std::vector<uint32> MaterialIds;
+
+		/** The entity each draw came from, for subpasses that keep state for an entity across frames */
+		std::vector<entt::entity> Entities;
+
+		/** Per mesh renderer GPU resources that the subpass writes and binds, the descriptor sets are never null */
+		std::vector<Buffer*> UniformBuffers;
+		std::vector<VkDescriptorSet> DescriptorSets;
+
+		inline size_t Size() const { return MeshIds.size(); }
+		inline bool Empty() const { return MeshIds.empty(); }
+
+		void Resize(size_t t_Count);
+		void Clear();
+	};
+
+	/** A draw that has been found but not sorted or packed yet. Only plain data, so it can be packed without a GPU */
+	struct DrawInput
+	{
+		const Transform* Trans = nullptr;
+
+		/** Model space bounding sphere of the mesh */
+		glm::vec3 BoundsCenter { 0.0f };
+		float BoundsRadius = 0.0f;
+
+		MeshDrawList List = MeshDrawList::Default;
+		uint32 MaterialId = 0;
+		uint32 MeshId = 0;
+		entt::entity Entity = entt::null;
+		Buffer* UniformBuffer = nullptr;
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+	};
+
+	/**
+	 * Sorts draws and packs them into their MeshDraws. The sort key has the pipeline (which is picked by
+	 * the draw list) in the highest bits, then the material, then the mesh, then the depth in front of the camera.
+	 */
+	namespace DrawSorting
+	{
+		constexpr uint32 DepthBits = 24;
+		constexpr uint32 MeshBits = 16;
+		constexpr uint32 MaterialBits = 16;
+		constexpr uint32 PipelineBits = 8;
+
+		/**
+		 * Build the sort key of one draw
+		 *
+		 * @param t_ViewDepth	How far in front of the camera the draw is, anything behind it sorts first
+		 */
+		uint64 MakeSortKey(MeshDrawList t_List, uint32 t_MaterialId, uint32 t_MeshId, float t_ViewDepth);
+
+		/**
+		 * Sort draws and pack each one into the MeshDraws of its list. Every array of a list lines up
+		 * by index. Runs on the job system.
+		 *
+		 * @param t_View		View matrix that the depth of each draw is measured with
+		 * @param t_Alpha		How far between the previous and current transform to draw at
+		 * @param t_OutLists	One MeshDraws for each MeshDrawList
+		 */
+		void PackDraws(const DrawInput* t_Draws, size_t t_Count, const glm::mat4& t_View, float t_Alpha, MeshDraws* t_OutLists);
+	}
+
+	/**
+	 * A flat copy of everything the renderer needs for one frame. Extracting walks the game
+	 * registry once and packs transforms, mesh bindings and lights into sorted arrays, so
+	 * recording draw commands streams through memory and never touches the registry.
+	 *
+	 * When rendering is pipelined the main thread extracts frame N+1 into one world while the
+	 * render thread draws frame N from another. Models, materials and GPU buffers are only
+	 * referenced, they are owned by the resource manager and the game's mesh renderers. The resource
+	 * manager keeps evicted resources alive for a few frames, so a world in flight never points at freed ones.
+	 */
+	class RenderWorld : public NonCopyable
+	{
+	public:
+
+		explicit RenderWorld(uint32 t_Index = 0)
+			: m_Index(t_Index)
+		{}
+
+		~RenderWorld() = default;
+
+		/**
+		 * Throw out the last frame and pack the render data of the game registry.
+		 * Call this from the main thread once the simulation for the frame is done.
+		 *
+		 * @param t_SimReg	The game's registry
+		 * @param t_Info	Camera and timing info for this frame. Transforms are interpolated with its alpha
+		 */
+		void Extract(entt::registry& t_SimReg, const RenderFrameInfo& t_Info);
+
+		inline const RenderFrameInfo& GetInfo() const { return m_Info; }
+
+		inline const MeshDraws& GetDraws(MeshDrawList t_List) const { return m_Draws[static_cast<size_t>(t_List)]; }
+
+		inline const std::vector<Model*>& GetMeshes() const { return m_Meshes; }
+		inline const std::vector<Material*>& GetMaterials() const { return m_Materials; }
+
+		/** Point lights with their position already set from their transform */
+		inline const std::vector<PointLight>& GetPointLights() const { return m_PointLights; }
+		inline const std::vector<DirectionalLight>& GetDirectionalLights() const { return m_DirectionalLights; }
+
+		/**
+		 * Which of the VulkanApp's worlds this is. Subpasses that keep their own per frame
+		 * CPU data can use this to double buffer it along with the world.
+		 */
+		inline uint32 GetIndex() const { return m_Index; }
+
+	private:
+
+		uint32 GetMeshId(Model* t_Model);
+		uint32 GetMaterialId(Material* t_Material);
+
+		uint32 m_Index = 0;
+
+		RenderFrameInfo m_Info;
+
+		MeshDraws m_Draws[static_cast<size_t>(MeshDrawList::Count)];
+
+		std::vector<Model*> m_Meshes;
+		std::vector<Material*> m_Materials;
+
+		/** Lookups from resource to id, kept around so that they don't reallocate every frame */
+		std::unordered_map<Model*, uint32> m_MeshIds;
+		std::unordered_map<Material*, uint32> m_MaterialIds;
+
+		std::vector<PointLight> m_PointLights;
+		std::vector<DirectionalLight> m_DirectionalLights;
+	};
+}   // namespace Fling
@@ -7,8 +7,8 @@
 #include "spirv.h"
 
 #include "Resource.h"
+#include "AssetData.h"
 #include "FlingExports.h"
-#include <fstream>
 #include <vector>
 
 namespace Fling
@@ -112,12 +112,7 @@ namespace Fling
         void ParseReflectionData(const uint32* t_Code, uint32 t_Size);
 
         /** Creates the shader modules  */
-        VkResult CreateShaderModule(std::vector<char>& t_ShaderCode);
-
-        /**
-         * Load the raw shader code in off-disk
-         */
-        static std::vector<char> LoadRawBytes(const std::string& t_FilePath);
+        VkResult CreateShaderModule(const AssetData& t_ShaderCode);
 
         /** The shader module created by this shader */
         VkShaderModule m_Module = VK_NULL_HANDLE;
@@ -2,6 +2,7 @@
 
 #include "Shader.h"
 #include "NonCopyable.hpp"
+#include "FrameAllocator.h"
 
 #include <entt/entity/registry.hpp>
 #include <entt/entity/helper.hpp>
@@ -13,6 +14,7 @@ namespace Fling
 	class FrameBuffer;
 	class Swapchain;
 	class GraphicsPipeline;
+	class RenderWorld;
 
 	/**
 	* A subpass represents one part of a RenderPipeline. Each subpass should
@@ -34,7 +36,22 @@ namespace Fling
 
 		virtual void CreateGraphicsPipeline() = 0;
 
-		virtual void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime) = 0;
+		/**
+		* Called on the main thread once the game has updated, before the frame is extracted and handed to Draw.
+		*			Anything that needs game state that is not in the RenderWorld should be done here
+		*			(i.e. building the editor UI), and anything that needs to be set up on the game's
+		*			components before they are extracted.
+		* 
+		* @param t_SimReg	The game's registry
+		* @param t_World	The world that Draw will get for this frame. Only its index is valid until it is extracted
+		*/
+		virtual void PrepareFrame(entt::registry& t_SimReg, const RenderWorld& t_World, float DeltaTime) {}
+
+		/**
+		* Record the commands for this subpass. This is called from the render thread when
+		*			rendering is pipelined, so everything it needs has to come from the given world.
+		*/
+		virtual void Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, const RenderWorld& t_World, float DeltaTime) = 0;
 
 		/** Cleanup any allocated resources that you may need a registry for */
 		virtual void CleanUp(entt::registry& t_reg) {}
@@ -50,13 +67,13 @@ namespace Fling
 		 * If a subpass has a command buffer that the final swap chain presentation is dependent on,
 		 *			then add it this vector. The Deferred offscreen GBuffer is an example of this
 		 */
-		virtual void GatherPresentDependencies(std::vector<CommandBuffer*>& t_CmdBuffs, std::vector<VkSemaphore>& t_Deps, uint32 t_ActiveFrameIndex, uint32 t_CurrentFrameInFlight) {}
+		virtual void GatherPresentDependencies(ScratchVector<CommandBuffer*>& t_CmdBuffs, ScratchVector<VkSemaphore>& t_Deps, uint32 t_ActiveFrameIndex, uint32 t_CurrentFrameInFlight) {}
 		
 		/**
 		* If a subpass has an additional command buffer to add to the final swap chain draw submission
 		*			but it is not dependent on it, then add it here. ImGUI is an example of this
 		*/
-		virtual void GatherPresentBuffers(std::vector<CommandBuffer*>& t_CmdBuffs, uint32 t_ActiveFrameIndex) {}
+		virtual void GatherPresentBuffers(ScratchVector<CommandBuffer*>& t_CmdBuffs, uint32 t_ActiveFrameIndex) {}
 
 		/** Function that is called when the swap chain is resized. Put any logic that may depend on Swapchain extents */
 		virtual void OnSwapchainResized(entt::registry& t_reg) {}
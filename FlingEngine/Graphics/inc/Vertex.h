@@ -17,7 +17,7 @@ namespace Fling
 
 		bool operator==(const Vertex& other) const 
 		{
-			return Pos == other.Pos && Color == other.Color && TexCoord == other.TexCoord && Tangent == other.Tangent;
+			return Pos == other.Pos && Color == other.Color && TexCoord == other.TexCoord && Tangent == other.Tangent && Normal == other.Normal;
 		}
 
 		/**
@@ -67,6 +67,73 @@ namespace Fling
         }
 
     };
+
+	/** Which vertex struct a vertex buffer holds, and a pipeline reads */
+	enum class VertexLayout : uint8
+	{
+		Full,
+		Packed,
+	};
+
+	/**
+	 * A Vertex squashed down for the GPU, see VertexPacking. The position is unorm16 inside the mesh's
+	 * bounding box, the normal and tangent are octahedral snorm16, the UVs are halfs and the color is unorm8.
+	 * Shaders decode it with the mesh's PositionOffset and PositionScale, see mrt_compact.vert
+	 */
+	struct PackedVertex
+	{
+		/** w is unused, three component 16 bit formats aren't widely supported */
+		uint16 Pos[4] = {};
+		uint8 Color[4] = {};
+		int16 Tangent[2] = {};
+		int16 Normal[2] = {};
+		uint16 TexCoord[2] = {};
+
+		static VkVertexInputBindingDescription GetBindingDescription()
+		{
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(PackedVertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		/** Same locations as Vertex::GetAttributeDescriptions */
+		static std::array<VkVertexInputAttributeDescription, 5> GetAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions = {};
+
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+			attributeDescriptions[0].offset = offsetof(PackedVertex, Pos);
+
+			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].location = 1;
+			attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+			attributeDescriptions[1].offset = offsetof(PackedVertex, Color);
+
+			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[2].offset = offsetof(PackedVertex, Tangent);
+
+			attributeDescriptions[3].binding = 0;
+			attributeDescriptions[3].location = 3;
+			attributeDescriptions[3].format = VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[3].offset = offsetof(PackedVertex, Normal);
+
+			attributeDescriptions[4].binding = 0;
+			attributeDescriptions[4].location = 4;
+			attributeDescriptions[4].format = VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[4].offset = offsetof(PackedVertex, TexCoord);
+
+			return attributeDescriptions;
+		}
+	};
+
+	static_assert(sizeof(PackedVertex) == 24, "PackedVertex should stay 24 bytes, update the shaders if it changes");
 }   // namespace Fling
 
 // Hash function for a vertex so that we can put thing std::maps and what not
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingMath.h"
+#include "Vertex.h"
+
+namespace Fling
+{
+	/**
+	 * Turns Vertex into PackedVertex for the GPU, which is less than half the size. Positions are stored
+	 * relative to the mesh's bounding box so 16 bits cover the whole mesh, and the shader scales them back
+	 * with the mesh's PositionOffset and PositionScale. Normals and tangents use an octahedral encoding,
+	 * which spreads the precision evenly over the sphere instead of wasting it on the corners of a cube.
+	 *
+	 * Models keep their full Vertex on the CPU, only the vertex buffer is packed.
+	 */
+	namespace VertexPacking
+	{
+		/** Meshes with at most this many vertices get 16 bit indices */
+		constexpr uint32 MaxVertsFor16BitIndices = 65536;
+
+		/** The offscreen vertex shader that decodes PackedVertex, built from mrt_compact.vert by CMake */
+		constexpr const char* CompactShaderPath = "Shaders/Deferred/mrt_compact_vert.spv";
+
+		/**
+		 * True if vertex buffers and the mesh pipeline should use PackedVertex, from CompactVertices.
+		 * False if CompactShaderPath is missing. Only read once so that models loaded later agree with
+		 * the pipelines made at startup
+		 */
+		bool UseCompactVertices();
+
+		/** Encode a unit vector as two snorm16 values */
+		void OctEncode(const glm::vec3& t_Dir, int16 t_Out[2]);
+
+		/** Decode the same way the shaders do */
+		glm::vec3 OctDecode(const int16 t_Encoded[2]);
+
+		/**
+		 * Work out what the shader scales and offsets positions by, from the bounding box of the vertices
+		 * Position = Offset + Unorm * Scale
+		 */
+		void GetPositionTransform(const Vertex* t_Verts, uint32 t_Count, glm::vec3& t_OutOffset, glm::vec3& t_OutScale);
+
+		void Pack(const Vertex* t_Verts, uint32 t_Count, const glm::vec3& t_PositionOffset, const glm::vec3& t_PositionScale, PackedVertex* t_Out);
+
+		/** Decode a packed vertex on the CPU the same way mrt_compact.vert does */
+		Vertex Unpack(const PackedVertex& t_Packed, const glm::vec3& t_PositionOffset, const glm::vec3& t_PositionScale);
+
+		/** Copy indices into 16 bit ones, they have to be less than MaxVertsFor16BitIndices */
+		void PackIndices16(const uint32* t_Indices, size_t t_Count, uint16* t_Out);
+	}
+}   // namespace Fling
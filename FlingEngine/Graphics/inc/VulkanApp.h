@@ -3,10 +3,14 @@
 #include "FlingTypes.h"
 #include "FlingVulkan.h"
 #include "Singleton.hpp"
+#include "RenderWorld.h"
 
 #include <entt/entity/registry.hpp>
 #include <vector>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace Fling
 {
@@ -35,11 +39,18 @@ namespace Fling
 	/**
 	* Core rendering functionality of the Fling Engine. Controls what Render pipelines
 	*			are available
+	*
+	* When "PipelinedRendering" is set, command recording and submission happen on a render
+	* thread. The main thread extracts what the renderer needs into a RenderWorld at the
+	* end of every frame and hands it off, so it can simulate frame N+1 while frame N is drawn.
 	*/
     class VulkanApp : public Singleton<VulkanApp>
     {
     public:
 
+		/** Number of render worlds the main and render thread swap between when rendering is pipelined */
+		static constexpr uint32 NumRenderWorlds = 2;
+
 		void Init(PipelineFlags t_Conf, entt::registry& t_Reg, std::shared_ptr<Fling::BaseEditor> t_Editor);
 		void Shutdown(entt::registry& t_Reg);
 
@@ -51,14 +62,30 @@ namespace Fling
         ~VulkanApp() = default;
 
 		/**
-		* Updates all rendering buffers and sends commands to draw a frame
+		* Call at the very start of a frame, before anything is allocated from the frame allocator.
+		* When rendering is pipelined this waits for the render thread to be at most one frame behind
+		* and handles any swap chain resizing while it is idle.
+		*/
+		void BeginFrame(entt::registry& t_Reg);
+
+		/**
+		* Updates all rendering buffers and sends commands to draw a frame. When rendering is
+		* pipelined this only extracts the frame state and hands it off to the render thread.
 		*/
 		void Update(float DeltaTime, entt::registry& t_Reg);
 
+		/** Block until the render thread has drawn every frame that was handed to it */
+		void FlushRenderThread();
+
+		inline bool IsPipelined() const { return m_PipelinedRendering; }
+
 		inline FlingWindow* GetCurrentWindow() const { return m_CurrentWindow; }
 		inline LogicalDevice* GetLogicalDevice() const { return m_LogicalDevice; }
 		inline PhysicalDevice* GetPhysicalDevice() const { return m_PhysicalDevice; }
 		inline const VkCommandPool GetCommandPool() const { return m_CommandPool; }
+
+		/** Command pool for short lived command buffers. @see GraphicsHelpers::BeginSingleTimeCommands */
+		inline const VkCommandPool GetTransientCommandPool() const { return m_TransientCommandPool; }
 		inline FirstPersonCamera* GetCamera() const { return m_Camera; }
 		inline VkRenderPass GetGlobalRenderPass() const { return m_RenderPass; }
 
@@ -90,6 +117,17 @@ namespace Fling
 
 		void RecreateFrameResourcesForResize(entt::registry& t_Reg);
 
+		/**
+		* Acquire a swap chain image, record every render pipeline and present it.
+		*
+		* @param t_World	The extracted render data to draw
+		* @return True if the swap chain is out of date and needs to be recreated
+		*/
+		bool RenderFrame(const RenderWorld& t_World, float DeltaTime);
+
+		/** Draws frames as the main thread hands them off until the app shuts down */
+		void RenderThreadLoop();
+
 		/** Returns the current extents needed to render based on the physical device and surface */
 		VkExtent2D ChooseSwapExtent();
 
@@ -129,7 +167,7 @@ namespace Fling
 		* Flag that when set to true, means that there is a pending resize of a window
 		* so we must recreate the necessary swap chain/frame buffer elements
 		*/
-		uint8 bNeedsResizing : 1;
+		std::atomic<bool> bNeedsResizing { false };
 
 		// Stages that the swap chain needs to wait on in order to present
 		VkPipelineStageFlags m_WaitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
@@ -152,11 +190,38 @@ namespace Fling
 		// Command Buffer pool
 		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
 
+		/** Separate from m_CommandPool so that other threads can make one off command buffers while the render thread records */
+		VkCommandPool m_TransientCommandPool = VK_NULL_HANDLE;
+
 		std::vector<RenderPipeline*> m_RenderPipelines;
 
 		/** The Vulkan app will specify the current camera and be limited to one for now */
 		FirstPersonCamera* m_Camera = nullptr;
 
+		// Pipelined rendering ------------------------------------------------------------------------
+		bool m_PipelinedRendering = false;
+
+		/** Frame N is extracted into m_RenderWorlds[N % NumRenderWorlds]. Only the first is used when not pipelined */
+		static_assert(NumRenderWorlds == 2, "Update the render world initializers");
+		RenderWorld m_RenderWorlds[NumRenderWorlds] = { RenderWorld(0), RenderWorld(1) };
+
+		std::thread m_RenderThread;
+
+		/** Guards the frame counters and the stop flag */
+		std::mutex m_RenderThreadMutex;
+		std::condition_variable m_RenderThreadCondition;
+
+		/** Number of frames the main thread has handed off */
+		uint64 m_FramesSubmitted = 0;
+
+		/** Number of frames the render thread has finished */
+		uint64 m_FramesRendered = 0;
+
+		bool m_StopRenderThread = false;
+
+		/** Set by the render thread when presenting says the swap chain needs to be recreated */
+		std::atomic<bool> m_SwapchainOutOfDate { false };
+
 		// #TODO VMA Allocator
     };
 }   // namespace Fling
\ No newline at end of file
@@ -4,9 +4,40 @@
 #include "VulkanApp.h"	// #TODO Pass in the devices by arg and not using this singleton
 #include "LogicalDevice.h"
 #include "PhyscialDevice.h"
+#include "ConcurrentPoolAllocator.hpp"
 
 namespace Fling
 {
+	namespace
+	{
+		/** Intentionally leaked so that buffers which are released during static destruction are still safe */
+		ConcurrentPoolAllocator<Buffer>& GetBufferPool()
+		{
+			static ConcurrentPoolAllocator<Buffer>* Pool = new ConcurrentPoolAllocator<Buffer>();
+			return *Pool;
+		}
+	}
+
+	void* Buffer::operator new(size_t t_Size)
+	{
+		// Anything bigger than a buffer won't fit in the pool
+		if (t_Size != sizeof(Buffer))
+		{
+			return ::operator new(t_Size);
+		}
+		return GetBufferPool().Allocate();
+	}
+
+	void Buffer::operator delete(void* t_Ptr, size_t t_Size)
+	{
+		if (t_Size != sizeof(Buffer))
+		{
+			::operator delete(t_Ptr);
+			return;
+		}
+		GetBufferPool().Free(t_Ptr);
+	}
+
     Buffer::Buffer(const VkDeviceSize& size, const VkBufferUsageFlags& t_Usage, const VkMemoryPropertyFlags& t_Properties, const void* t_Data)
 		: m_Size(size)
 		, m_Buffer(VK_NULL_HANDLE)
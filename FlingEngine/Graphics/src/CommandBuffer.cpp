@@ -3,9 +3,39 @@
 #include "LogicalDevice.h"
 #include "GraphicsHelpers.h"
 #include "FrameBuffer.h"
+#include "ConcurrentPoolAllocator.hpp"
 
 namespace Fling
 {
+	namespace
+	{
+		/** Intentionally leaked so that command buffers which are released during static destruction are still safe */
+		ConcurrentPoolAllocator<CommandBuffer>& GetCommandBufferPool()
+		{
+			static ConcurrentPoolAllocator<CommandBuffer>* Pool = new ConcurrentPoolAllocator<CommandBuffer>();
+			return *Pool;
+		}
+	}
+
+	void* CommandBuffer::operator new(size_t t_Size)
+	{
+		if (t_Size != sizeof(CommandBuffer))
+		{
+			return ::operator new(t_Size);
+		}
+		return GetCommandBufferPool().Allocate();
+	}
+
+	void CommandBuffer::operator delete(void* t_Ptr, size_t t_Size)
+	{
+		if (t_Size != sizeof(CommandBuffer))
+		{
+			::operator delete(t_Ptr);
+			return;
+		}
+		GetCommandBufferPool().Free(t_Ptr);
+	}
+
 	CommandBuffer::CommandBuffer(const LogicalDevice* t_Device, VkCommandPool t_CmdPool)
 		: m_Device(t_Device)
 		, m_Pool(t_CmdPool)
@@ -79,14 +109,14 @@ namespace Fling
 		vkCmdBindPipeline(GetHandle(), t_BindPoint, t_Pipeline);
 	}
 
-	void CommandBuffer::SetViewport(uint32 first_viewport, const std::vector<VkViewport>& viewports)
+	void CommandBuffer::SetViewport(uint32 first_viewport, std::initializer_list<VkViewport> viewports)
 	{
-		vkCmdSetViewport(GetHandle(), first_viewport, to_u32(viewports.size()), viewports.data());
+		vkCmdSetViewport(GetHandle(), first_viewport, to_u32(viewports.size()), viewports.begin());
 	}
 
-	void CommandBuffer::SetScissor(uint32 first_scissor, const std::vector<VkRect2D>& scissors)
+	void CommandBuffer::SetScissor(uint32 first_scissor, std::initializer_list<VkRect2D> scissors)
 	{
-		vkCmdSetScissor(GetHandle(), first_scissor, to_u32(scissors.size()), scissors.data());
+		vkCmdSetScissor(GetHandle(), first_scissor, to_u32(scissors.size()), scissors.begin());
 	}
 
 	void CommandBuffer::EndRenderPass()
@@ -0,0 +1,206 @@
+#include "pch.h"
+#include "CookedMesh.h"
+#include "Hash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Fling
+{
+	namespace
+	{
+		inline uint64 AlignUp(uint64 t_Value, uint64 t_Alignment)
+		{
+			return (t_Value + t_Alignment - 1) & ~(t_Alignment - 1);
+		}
+
+		uint64 HashMeshData(const void* t_Verts, uint64 t_VertsSize, const void* t_Indices, uint64 t_IndicesSize, const void* t_Lods, uint64 t_LodsSize, const void* t_Meshlets, uint64 t_MeshletsSize)
+		{
+			const uint64 VertsHash = HashBytes64(t_Verts, static_cast<size_t>(t_VertsSize));
+			const uint64 IndicesHash = HashBytes64(t_Indices, static_cast<size_t>(t_IndicesSize), VertsHash);
+			const uint64 LodsHash = HashBytes64(t_Lods, static_cast<size_t>(t_LodsSize), IndicesHash);
+			return HashBytes64(t_Meshlets, static_cast<size_t>(t_MeshletsSize), LodsHash);
+		}
+	}
+
+	std::string CookedMesh::GetCookedPath(const std::string& t_SourcePath)
+	{
+		const size_t Dot = t_SourcePath.find_last_of('.');
+		const size_t Slash = t_SourcePath.find_last_of('/');
+		if (Dot == std::string::npos || (Slash != std::string::npos && Dot < Slash))
+		{
+			return t_SourcePath + Extension;
+		}
+		return t_SourcePath.substr(0, Dot) + Extension;
+	}
+
+	bool CookedMesh::Load(AssetData&& t_Data, bool t_bVerify)
+	{
+		Reset();
+
+		const uint64 FileSize = t_Data.GetSize();
+		const char* Base = t_Data.GetData();
+		if (!t_Data.IsValid() || FileSize < sizeof(CookedMeshHeader))
+		{
+			return false;
+		}
+
+		const CookedMeshHeader* Header = reinterpret_cast<const CookedMeshHeader*>(Base);
+		if (Header->Magic != Magic || Header->Version != Version || Header->VertexStride != sizeof(Vertex) || Header->IndexStride != sizeof(uint32))
+		{
+			return false;
+		}
+
+		const uint64 VertsSize = static_cast<uint64>(Header->NumVerts) * sizeof(Vertex);
+		const uint64 IndicesSize = static_cast<uint64>(Header->NumIndices) * sizeof(uint32);
+		const bool bValidVerts = Header->VertexOffset % alignof(Vertex) == 0 && Header->VertexOffset <= FileSize && VertsSize <= FileSize - Header->VertexOffset;
+		const uint64 LodsSize = static_cast<uint64>(Header->NumLods) * sizeof(MeshLod);
+		const bool bValidIndices = Header->IndexOffset % alignof(uint32) == 0 && Header->IndexOffset <= FileSize && IndicesSize <= FileSize - Header->IndexOffset;
+		const bool bValidLods = Header->NumLods > 0 && Header->LodOffset % alignof(MeshLod) == 0 && Header->LodOffset <= FileSize && LodsSize <= FileSize - Header->LodOffset;
+		const uint64 MeshletsSize = static_cast<uint64>(Header->NumMeshlets) * sizeof(Meshlet);
+		const bool bValidMeshlets = Header->MeshletOffset % alignof(Meshlet) == 0 && Header->MeshletOffset <= FileSize && MeshletsSize <= FileSize - Header->MeshletOffset;
+		if (!bValidVerts || !bValidIndices || !bValidLods || !bValidMeshlets || Header->NumIndices % 3 != 0)
+		{
+			F_LOG_WARN("Cooked mesh has a corrupt header");
+			return false;
+		}
+
+		const MeshLod* Lods = reinterpret_cast<const MeshLod*>(Base + Header->LodOffset);
+		for (uint32 i = 0; i < Header->NumLods; ++i)
+		{
+			if (Lods[i].FirstIndex > Header->NumIndices || Lods[i].IndexCount > Header->NumIndices - Lods[i].FirstIndex)
+			{
+				F_LOG_WARN("Cooked mesh has a corrupt LOD table");
+				return false;
+			}
+		}
+
+		const Meshlet* Meshlets = reinterpret_cast<const Meshlet*>(Base + Header->MeshletOffset);
+		for (uint32 i = 0; i < Header->NumMeshlets; ++i)
+		{
+			if (Meshlets[i].FirstIndex > Header->NumIndices || Meshlets[i].IndexCount > Header->NumIndices - Meshlets[i].FirstIndex)
+			{
+				F_LOG_WARN("Cooked mesh has corrupt meshlets");
+				return false;
+			}
+		}
+
+		const char* Verts = Base + Header->VertexOffset;
+		const char* Indices = Base + Header->IndexOffset;
+		if (t_bVerify && HashMeshData(Verts, VertsSize, Indices, IndicesSize, Lods, LodsSize, Meshlets, MeshletsSize) != Header->Checksum)
+		{
+			F_LOG_WARN("Cooked mesh failed its checksum");
+			return false;
+		}
+
+		m_Data = std::move(t_Data);
+		m_Header = Header;
+		m_Verts = reinterpret_cast<const Vertex*>(Verts);
+		m_Indices = reinterpret_cast<const uint32*>(Indices);
+		m_Lods = Lods;
+		m_Meshlets = Meshlets;
+		return true;
+	}
+
+	void CookedMesh::Reset()
+	{
+		m_Data = AssetData();
+		m_Header = nullptr;
+		m_Verts = nullptr;
+		m_Indices = nullptr;
+		m_Lods = nullptr;
+		m_Meshlets = nullptr;
+	}
+
+	std::vector<char> CookedMesh::Cook(
+		const Vertex* t_Verts, uint32 t_NumVerts,
+		const uint32* t_Indices, uint32 t_NumIndices,
+		const MeshLod* t_Lods, uint32 t_NumLods,
+		const Meshlet* t_Meshlets, uint32 t_NumMeshlets,
+		const glm::vec3& t_BoundsCenter, float t_BoundsRadius,
+		uint64 t_SourceHash, uint64 t_SourceSize, uint64 t_SettingsHash, uint64 t_SourceModifiedTime)
+	{
+		const uint64 VertsSize = static_cast<uint64>(t_NumVerts) * sizeof(Vertex);
+		const uint64 IndicesSize = static_cast<uint64>(t_NumIndices) * sizeof(uint32);
+		const uint64 LodsSize = static_cast<uint64>(t_NumLods) * sizeof(MeshLod);
+		const uint64 MeshletsSize = static_cast<uint64>(t_NumMeshlets) * sizeof(Meshlet);
+
+		CookedMeshHeader Header;
+		Header.Magic = Magic;
+		Header.Version = Version;
+		Header.VertexStride = sizeof(Vertex);
+		Header.IndexStride = sizeof(uint32);
+		Header.NumVerts = t_NumVerts;
+		Header.NumIndices = t_NumIndices;
+		Header.SourceHash = t_SourceHash;
+		Header.SourceSize = t_SourceSize;
+		Header.SettingsHash = t_SettingsHash;
+		Header.SourceModifiedTime = t_SourceModifiedTime;
+		Header.BoundsCenter[0] = t_BoundsCenter.x;
+		Header.BoundsCenter[1] = t_BoundsCenter.y;
+		Header.BoundsCenter[2] = t_BoundsCenter.z;
+		Header.BoundsRadius = t_BoundsRadius;
+		Header.VertexOffset = AlignUp(sizeof(CookedMeshHeader), DataAlignment);
+		Header.IndexOffset = AlignUp(Header.VertexOffset + VertsSize, DataAlignment);
+		Header.NumLods = t_NumLods;
+		Header.LodOffset = AlignUp(Header.IndexOffset + IndicesSize, DataAlignment);
+		Header.NumMeshlets = t_NumMeshlets;
+		Header.MeshletOffset = AlignUp(Header.LodOffset + LodsSize, DataAlignment);
+		Header.Checksum = HashMeshData(t_Verts, VertsSize, t_Indices, IndicesSize, t_Lods, LodsSize, t_Meshlets, MeshletsSize);
+
+		// Zero filled, so the padding is always the same and cooking the same mesh twice gives the same file
+		std::vector<char> Cooked(static_cast<size_t>(Header.MeshletOffset + MeshletsSize), 0);
+		std::memcpy(Cooked.data(), &Header, sizeof(Header));
+		if (VertsSize)
+		{
+			std::memcpy(Cooked.data() + Header.VertexOffset, t_Verts, static_cast<size_t>(VertsSize));
+		}
+		if (IndicesSize)
+		{
+			std::memcpy(Cooked.data() + Header.IndexOffset, t_Indices, static_cast<size_t>(IndicesSize));
+		}
+		if (LodsSize)
+		{
+			std::memcpy(Cooked.data() + Header.LodOffset, t_Lods, static_cast<size_t>(LodsSize));
+		}
+		if (MeshletsSize)
+		{
+			std::memcpy(Cooked.data() + Header.MeshletOffset, t_Meshlets, static_cast<size_t>(MeshletsSize));
+		}
+		return Cooked;
+	}
+
+	bool CookedMesh::Write(const std::string& t_Path, const std::vector<char>& t_Cooked)
+	{
+		const std::string TempPath = t_Path + ".tmp";
+		{
+			std::ofstream Out(TempPath, std::ios::binary | std::ios::trunc);
+			if (!Out.is_open())
+			{
+				F_LOG_ERROR("Failed to write cooked mesh {}", t_Path);
+				return false;
+			}
+
+			Out.write(t_Cooked.data(), static_cast<std::streamsize>(t_Cooked.size()));
+			if (!Out.good())
+			{
+				F_LOG_ERROR("Failed to write cooked mesh {}", t_Path);
+				Out.close();
+				std::remove(TempPath.c_str());
+				return false;
+			}
+		}
+
+		std::error_code Error;
+		std::filesystem::rename(TempPath, t_Path, Error);
+		if (Error)
+		{
+			F_LOG_ERROR("Failed to write cooked mesh {}: {}", t_Path, Error.message());
+			std::remove(TempPath.c_str());
+			return false;
+		}
+		return true;
+	}
+}   // namespace Fling
@@ -8,8 +8,10 @@
 #include "MeshRenderer.h"
 #include "SwapChain.h"
 #include "UniformBufferObject.h"
-#include "FirstPersonCamera.h"
+#include "RenderWorld.h"
 #include "FlingVulkan.h"
+#include "Profiler.h"
+#include "VertexPacking.h"
 
 #define FRAME_BUF_DIM 2048
 
@@ -20,12 +22,10 @@ namespace Fling
 		const Swapchain* t_Swap,
 		entt::registry& t_reg,
 		VkRenderPass t_GlobalRenderPass,
-		FirstPersonCamera* t_Cam,
 		std::shared_ptr<Fling::Shader> t_Vert,
 		std::shared_ptr<Fling::Shader> t_Frag)
 		: Subpass(t_Dev, t_Swap, t_Vert, t_Frag)
 		, m_GlobalRenderPass(t_GlobalRenderPass)
-		, m_Camera(t_Cam)
 	{
 		t_reg.on_construct<MeshRenderer>().connect<&DebugSubpass::OnMeshRendererAdded>(*this);
 
@@ -37,45 +37,61 @@ namespace Fling
 		
 	}
 
-	void DebugSubpass::Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime)
+	void DebugSubpass::PrepareFrame(entt::registry& t_SimReg, const RenderWorld& t_World, float DeltaTime)
 	{
-		// For every mesh bind it's model and descriptor set info.
-		// View instead of owning group so assign<Transform>() references stay valid.
-		auto RenderView = t_reg.view<Transform, MeshRenderer, entt::tag<"Debug"_hs>>();
+		// If the mesh has no descriptor sets, then build them
+		// #TODO Investigate a better way to do this, probably by just moving the 
+		// descriptors off of the mesh
+		t_SimReg.view<MeshRenderer, entt::tag<"Debug"_hs>>().less([&](MeshRenderer& t_MeshRend)
+		{
+			// Debug materials don't have textures, so swapping the material doesn't touch the descriptor set
+			if (t_MeshRend.HasPendingLoads())
+			{
+				t_MeshRend.UpdatePendingLoads();
+			}
+
+			if (t_MeshRend.GetModel() && t_MeshRend.m_DescriptorSet == VK_NULL_HANDLE)
+			{
+				CreateMeshDescriptorSet(t_MeshRend);
+			}
+		});
+	}
+
+	void DebugSubpass::Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, const RenderWorld& t_World, float DeltaTime)
+	{
+		FLING_PROFILE_SCOPE("DebugSubpass::Draw");
+
+		const MeshDraws& Draws = t_World.GetDraws(MeshDrawList::Debug);
+		const std::vector<Model*>& Meshes = t_World.GetMeshes();
 
 		// Invert the project value to match the proper coordinate space compared to OpenGL
-		m_Ubo.Projection = m_Camera->GetProjectionMatrix();
+		m_Ubo.Projection = t_World.GetInfo().Camera.Projection;
 		m_Ubo.Projection[1][1] *= -1.0f;
 		VkDeviceSize offsets[1] = { 0 };
 
-		RenderView.less([&](entt::entity ent, Transform& t_trans, MeshRenderer& t_MeshRend)
+		vkCmdBindPipeline(t_CmdBuf.GetHandle(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->GetPipeline());
+
+		// For every mesh bind it's model and descriptor set info
+		uint32 BoundMeshId = UINT32_MAX;
+		for (size_t i = 0; i < Draws.Size(); ++i)
 		{
-			Fling::Model* Model = t_MeshRend.m_Model;
-			if (!Model)
-			{
-				return;
-			}
+			const uint32 MeshId = Draws.MeshIds[i];
+			const Fling::Model* Model = Meshes[MeshId];
+			assert(Model->GetVertexLayout() == m_GraphicsPipeline->m_VertexLayout);
 
 			// Update the UBO
-			Transform::CalculateWorldMatrix(t_trans);
-			m_Ubo.Model = t_trans.GetWorldMatrix();
+			m_Ubo.Model = Draws.WorldMatrices[i];
+			m_Ubo.PositionOffset = glm::vec4(Model->GetPositionOffset(), 0.0f);
+			m_Ubo.PositionScale = glm::vec4(Model->GetPositionScale(), 0.0f);
 
 			// Memcpy to the buffer
-			Buffer* buf = t_MeshRend.m_UniformBuffer;
+			Buffer* buf = Draws.UniformBuffers[i];
 			memcpy(
 				buf->m_MappedMem,
 				&m_Ubo,
 				buf->GetSize()
 			);
 
-			// If the mesh has no descriptor sets, then build them
-			// #TODO Investigate a better way to do this, probably by just moving the 
-			// descriptors off of the mesh
-			if (t_MeshRend.m_DescriptorSet == VK_NULL_HANDLE)
-			{
-				CreateMeshDescriptorSet(t_MeshRend);
-			}
-
 			// Bind the descriptor set for rendering a mesh using the dynamic offset
 			vkCmdBindDescriptorSets(
 				t_CmdBuf.GetHandle(),
@@ -83,18 +99,21 @@ namespace Fling
 				m_GraphicsPipeline->GetPipelineLayout(),
 				0,
 				1,
-				&t_MeshRend.m_DescriptorSet,
+				&Draws.DescriptorSets[i],
 				0,
 				nullptr);
 
-			vkCmdBindPipeline(t_CmdBuf.GetHandle(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->GetPipeline());
+			if (MeshId != BoundMeshId)
+			{
+				VkBuffer vertexBuffers[1] = { Model->GetVertexBuffer()->GetVkBuffer() };
+				vkCmdBindVertexBuffers(t_CmdBuf.GetHandle(), 0, 1, vertexBuffers, offsets);
+				vkCmdBindIndexBuffer(t_CmdBuf.GetHandle(), Model->GetIndexBuffer()->GetVkBuffer(), 0, Model->GetIndexType());
+				BoundMeshId = MeshId;
+			}
 
-			VkBuffer vertexBuffers[1] = { Model->GetVertexBuffer()->GetVkBuffer() };
 			// Render the mesh
-			vkCmdBindVertexBuffers(t_CmdBuf.GetHandle(), 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(t_CmdBuf.GetHandle(), Model->GetIndexBuffer()->GetVkBuffer(), 0, Model->GetIndexType());
 			vkCmdDrawIndexed(t_CmdBuf.GetHandle(), Model->GetIndexCount(), 1, 0, 0, 0);
-		});
+		}
 	}
 
 	void DebugSubpass::CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg)
@@ -119,7 +138,7 @@ namespace Fling
 			VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device->GetVkDevice(), &allocInfo, &t_MeshRend.m_DescriptorSet));
 		}
 
-		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
+		ScratchVector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
 			// 0: UBO
 			Initializers::WriteDescriptorSetUniform(
@@ -164,6 +183,9 @@ namespace Fling
 				VK_FRONT_FACE_COUNTER_CLOCKWISE
 			);
 
+		// Models share their vertex buffers with the offscreen pass, so read them the same way it does
+		m_GraphicsPipeline->m_VertexLayout = VertexPacking::UseCompactVertices() ? VertexLayout::Packed : VertexLayout::Full;
+
 		// Create it otherwise with defaults
 		m_GraphicsPipeline->CreateGraphicsPipeline(m_GlobalRenderPass, nullptr);
 	}
@@ -180,7 +202,8 @@ namespace Fling
 	void DebugSubpass::OnMeshRendererAdded(entt::entity t_Ent, entt::registry& t_Reg, MeshRenderer& t_MeshRend)
 	{
 		// If this mesh renderer material is set to DEBUG, then do this
-		if (t_MeshRend.m_Material && t_MeshRend.m_Material->GetType() != Material::Type::Debug)
+		const Material* Mat = t_MeshRend.GetMaterial();
+		if (Mat && Mat->GetType() != Material::Type::Debug)
 		{
 			return;
 		}
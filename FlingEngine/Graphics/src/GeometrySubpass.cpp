@@ -10,9 +10,10 @@
 #include "Model.h"
 #include "Buffer.h"
 #include "OffscreenSubpass.h"
-#include "FirstPersonCamera.h"
+#include "RenderWorld.h"
 #include "Components/Transform.h"
 #include "VulkanApp.h"
+#include "Profiler.h"
 
 namespace Fling
 {
@@ -21,13 +22,11 @@ namespace Fling
 		const Swapchain* t_Swap,
 		entt::registry& t_reg,
 		VkRenderPass t_GlobalRenderPass,
-		FirstPersonCamera* t_Cam,
 		FrameBuffer* t_OffscreenDep,
 		std::shared_ptr<Fling::Shader> t_Vert,
 		std::shared_ptr<Fling::Shader> t_Frag)
 		: Subpass(t_Dev, t_Swap, t_Vert, t_Frag)
 		, m_GlobalRenderPass(t_GlobalRenderPass)
-		, m_Camera(t_Cam)
 		, m_OffscreenFrameBuf(t_OffscreenDep)
 	{
 		assert(m_GlobalRenderPass != VK_NULL_HANDLE);
@@ -92,17 +91,20 @@ namespace Fling
 		// Clean up any allocated descriptor sets
 	}
 
-	void GeometrySubpass::Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime)
+	void GeometrySubpass::Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, const RenderWorld& t_World, float DeltaTime)
 	{
-		UpdateLightingUBO(t_reg, t_ActiveFrameInFlight);
+		FLING_PROFILE_SCOPE("GeometrySubpass::Draw");
+
+		UpdateLightingUBO(t_World, t_ActiveFrameInFlight);
 
 		// Update camera UBO's		
 		{
-			m_CamInfoUBO.Projection = m_Camera->GetProjectionMatrix();
-			m_CamInfoUBO.ModelView = m_Camera->GetViewMatrix();
-			m_CamInfoUBO.CamPos = glm::vec4(m_Camera->GetPosition(), 1.0f);
-			m_CamInfoUBO.Gamma = m_Camera->GetGamma();
-			m_CamInfoUBO.Exposure = m_Camera->GetExposure();
+			const RenderCamera& Cam = t_World.GetInfo().Camera;
+			m_CamInfoUBO.Projection = Cam.Projection;
+			m_CamInfoUBO.ModelView = Cam.View;
+			m_CamInfoUBO.CamPos = glm::vec4(Cam.Position, 1.0f);
+			m_CamInfoUBO.Gamma = Cam.Gamma;
+			m_CamInfoUBO.Exposure = Cam.Exposure;
 
 			memcpy(m_CameraUboBuffers[t_ActiveFrameInFlight]->m_MappedMem, &m_CamInfoUBO, sizeof(m_CamInfoUBO));
 		}
@@ -188,7 +190,7 @@ namespace Fling
 					m_OffscreenFrameBuf->GetAttachmentAtIndex(4)->GetViewHandle(),
 					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-			std::vector<VkWriteDescriptorSet> writeDescriptorSets =
+			ScratchVector<VkWriteDescriptorSet> writeDescriptorSets =
 			{
 				// 1 : Position sampler
 				Initializers::WriteDescriptorSet(
@@ -310,43 +312,22 @@ namespace Fling
 #endif	// FLING_DEBUG
 	}
 
-	void GeometrySubpass::UpdateLightingUBO(entt::registry& t_Reg, uint32 t_ActiveFrame)
+	void GeometrySubpass::UpdateLightingUBO(const RenderWorld& t_World, uint32 t_ActiveFrame)
 	{
-		auto PointLightView = t_Reg.view<PointLight, Transform>();
-		auto DirectionalLightView = t_Reg.view<DirectionalLight>();
-
-		uint32 CurLightCount = 0;
 		// Directional Lights ----------------
-		for (auto entity : DirectionalLightView)
-		{
-			if (CurLightCount < DeferredLightSettings::MaxDirectionalLights)
-			{
-				DirectionalLight& Light = DirectionalLightView.get(entity);
-				// Copy the dir light info to the buffer
-				memcpy((m_LightingUBO.DirLightBuffer + (CurLightCount++)), &Light, sizeof(DirectionalLight));
-			}
-		}
-
-		m_LightingUBO.DirLightCount = CurLightCount;
-
-		CurLightCount = 0;
+		const std::vector<DirectionalLight>& DirLights = t_World.GetDirectionalLights();
+		const uint32 DirLightCount = std::min(static_cast<uint32>(DirLights.size()), DeferredLightSettings::MaxDirectionalLights);
+		memcpy(m_LightingUBO.DirLightBuffer, DirLights.data(), sizeof(DirectionalLight) * DirLightCount);
+		m_LightingUBO.DirLightCount = DirLightCount;
 
 		// Point lights ---------------------
-		for (auto entity : PointLightView)
-		{
-			if (CurLightCount < DeferredLightSettings::MaxPointLights)
-			{
-				PointLight& Light = PointLightView.get<PointLight>(entity);
-				Transform& Trans = PointLightView.get<Transform>(entity);
-
-				Light.SetPos(glm::vec4(Trans.GetPos(), 1.0f));
-				// Copy the point light info to the buffer
-				memcpy((m_LightingUBO.PointLightBuffer + (CurLightCount++)), &Light, sizeof(PointLight));
-			}
-		}
+		// The light positions were already set from their transforms when the world was extracted
+		const std::vector<PointLight>& PointLights = t_World.GetPointLights();
+		const uint32 PointLightCount = std::min(static_cast<uint32>(PointLights.size()), DeferredLightSettings::MaxPointLights);
+		memcpy(m_LightingUBO.PointLightBuffer, PointLights.data(), sizeof(PointLight) * PointLightCount);
+		m_LightingUBO.PointLightCount = PointLightCount;
 
 		// Memcpy to the buffer
-		m_LightingUBO.PointLightCount = CurLightCount;
 		
 		memcpy(
 			m_LightingUboBuffers[t_ActiveFrame]->m_MappedMem,
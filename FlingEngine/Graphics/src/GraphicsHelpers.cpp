@@ -4,10 +4,21 @@
 #include "LogicalDevice.h"
 #include "PhyscialDevice.h"
 
+#include <mutex>
+
 namespace Fling
 {
     namespace GraphicsHelpers
     {
+        namespace
+        {
+            /**
+             * Guards the transient command pool. Held from BeginSingleTimeCommands until the
+             * matching EndSingleTimeCommands, recursive because some helpers nest them
+             */
+            std::recursive_mutex g_SingleTimeCommandMutex;
+        }
+
         uint32 FindMemoryType(VkPhysicalDevice t_PhysicalDevice, uint32 t_Filter, VkMemoryPropertyFlags t_Props)
         {
             // #TODO Move this to the Physical device abstraction once we create it
@@ -67,7 +78,10 @@ namespace Fling
 			LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
 			assert(Dev);
             VkDevice Device = Dev->GetVkDevice();
-            const VkCommandPool& CommandPool = VulkanApp::Get().GetCommandPool();
+
+            // Released in EndSingleTimeCommands
+            g_SingleTimeCommandMutex.lock();
+            const VkCommandPool CommandPool = VulkanApp::Get().GetTransientCommandPool();
 
             VkCommandBufferAllocateInfo allocInfo = {};
             allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -91,7 +105,7 @@ namespace Fling
 			LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
 			assert(Dev);
             VkDevice Device = Dev->GetVkDevice();
-            VkCommandPool CmdPool = VulkanApp::Get().GetCommandPool();
+            VkCommandPool CmdPool = VulkanApp::Get().GetTransientCommandPool();
             VkQueue GraphicsQueue = Dev->GetGraphicsQueue();
 
             vkEndCommandBuffer(t_CommandBuffer);
@@ -101,10 +115,15 @@ namespace Fling
             submitInfo.commandBufferCount = 1;
             submitInfo.pCommandBuffers = &t_CommandBuffer;
 
-            vkQueueSubmit(GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-            vkQueueWaitIdle(GraphicsQueue);
+            {
+                // The render thread may be submitting a frame at the same time
+                std::lock_guard<std::mutex> QueueLock(Dev->GetQueueMutex());
+                vkQueueSubmit(GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+                vkQueueWaitIdle(GraphicsQueue);
+            }
 
             vkFreeCommandBuffers(Device, CmdPool, 1, &t_CommandBuffer);
+            g_SingleTimeCommandMutex.unlock();
         }
 
         void CreateVkImage(
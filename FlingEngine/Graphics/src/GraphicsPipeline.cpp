@@ -115,8 +115,9 @@ namespace Fling
         }
 
         // Vertex Input 
-        VkVertexInputBindingDescription BindingDescription = Vertex::GetBindingDescription();
-        std::array<VkVertexInputAttributeDescription, 5> AttributeDescriptions = Vertex::GetAttributeDescriptions();
+        const bool bPackedVerts = m_VertexLayout == VertexLayout::Packed;
+        VkVertexInputBindingDescription BindingDescription = bPackedVerts ? PackedVertex::GetBindingDescription() : Vertex::GetBindingDescription();
+        std::array<VkVertexInputAttributeDescription, 5> AttributeDescriptions = bPackedVerts ? PackedVertex::GetAttributeDescriptions() : Vertex::GetAttributeDescriptions();
 
         m_VertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         m_VertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
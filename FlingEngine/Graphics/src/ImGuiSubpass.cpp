@@ -11,12 +11,34 @@
 #include "FirstPersonCamera.h"
 #include "FlingVulkan.h"
 #include "BaseEditor.h"
+#include "VulkanApp.h"
+#include "Profiler.h"
 
 #include <imgui.h>
 #include <algorithm>
 
 namespace Fling
 {
+	/**
+	 * A copy of ImGui's draw data. ImGui's own draw data is only valid until the next NewFrame,
+	 * which the main thread can get to before the render thread is done with it.
+	 */
+	struct ImGuiDrawSnapshot
+	{
+		struct DrawCmd
+		{
+			ImVec4 ClipRect;
+			uint32 ElemCount = 0;
+			uint32 IndexOffset = 0;
+			int32 VertexOffset = 0;
+		};
+
+		std::vector<ImDrawVert> Vertices;
+		std::vector<ImDrawIdx> Indices;
+		std::vector<DrawCmd> Commands;
+		ImVec2 DisplaySize;
+	};
+
 	ImGuiSubpass::ImGuiSubpass(
 		const LogicalDevice* t_Dev,
 		const Swapchain* t_Swap,
@@ -49,6 +71,9 @@ namespace Fling
 		PrepImGuiStyleSettings();
 
 		PrepareAttachments();
+
+		// Sized up front so that the render thread never reads a snapshot while it is being moved
+		m_Snapshots.resize(VulkanApp::NumRenderWorlds);
 	}
 
 	ImGuiSubpass::~ImGuiSubpass()
@@ -68,33 +93,74 @@ namespace Fling
 		vkDestroyDescriptorSetLayout(logicalDevice, m_descriptorSetLayout, nullptr);
 	}
 
-	void ImGuiSubpass::Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime)
+	void ImGuiSubpass::PrepareFrame(entt::registry& t_SimReg, const RenderWorld& t_World, float DeltaTime)
 	{
+		FLING_PROFILE_SCOPE("ImGuiSubpass::PrepareFrame");
+
 		ImGui::NewFrame();
 
 		if (m_Editor)
 		{
-			m_Editor->Draw(t_reg, DeltaTime);
+			m_Editor->Draw(t_SimReg, DeltaTime);
 		}
 
 		ImGui::Render();
 
-		UpdateUniforms();
+		// Reuse the last snapshot for this world so that we aren't reallocating every frame
+		assert(t_World.GetIndex() < m_Snapshots.size());
+		ImGuiDrawSnapshot* Snapshot = &m_Snapshots[t_World.GetIndex()];
+
+		Snapshot->Vertices.clear();
+		Snapshot->Indices.clear();
+		Snapshot->Commands.clear();
+		Snapshot->DisplaySize = ImGui::GetIO().DisplaySize;
+
+		ImDrawData* imDrawData = ImGui::GetDrawData();
+		uint32 IndexOffset = 0;
+		for (int32 i = 0; i < imDrawData->CmdListsCount; ++i)
+		{
+			const ImDrawList* cmd_list = imDrawData->CmdLists[i];
+			const int32 VertexOffset = static_cast<int32>(Snapshot->Vertices.size());
+
+			Snapshot->Vertices.insert(Snapshot->Vertices.end(), cmd_list->VtxBuffer.begin(), cmd_list->VtxBuffer.end());
+			Snapshot->Indices.insert(Snapshot->Indices.end(), cmd_list->IdxBuffer.begin(), cmd_list->IdxBuffer.end());
+
+			for (int32 j = 0; j < cmd_list->CmdBuffer.Size; ++j)
+			{
+				const ImDrawCmd& pcmd = cmd_list->CmdBuffer[j];
+				Snapshot->Commands.push_back({ pcmd.ClipRect, pcmd.ElemCount, IndexOffset, VertexOffset });
+				IndexOffset += pcmd.ElemCount;
+			}
+		}
+	}
+
+	void ImGuiSubpass::Draw(CommandBuffer& t_CmdBuf, uint32 t_ActiveFrameInFlight, const RenderWorld& t_World, float DeltaTime)
+	{
+		FLING_PROFILE_SCOPE("ImGuiSubpass::Draw");
+
+		// Empty until PrepareFrame has run for this world
+		const ImGuiDrawSnapshot& Snapshot = m_Snapshots[t_World.GetIndex()];
+		if (Snapshot.Commands.empty())
+		{
+			return;
+		}
 
-		BuildCommandBuffer(t_CmdBuf.GetHandle());
+		UpdateUniforms(Snapshot);
+
+		BuildCommandBuffer(t_CmdBuf.GetHandle(), Snapshot);
 	}
 
-	void ImGuiSubpass::BuildCommandBuffer(VkCommandBuffer t_commandBuffer)
+	void ImGuiSubpass::BuildCommandBuffer(VkCommandBuffer t_commandBuffer, const ImGuiDrawSnapshot& t_DrawData)
 	{
-		ImGuiIO& io = ImGui::GetIO();
+		const ImVec2& DisplaySize = t_DrawData.DisplaySize;
 
 
 		vkCmdBindDescriptorSets(t_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_descriptorSet, 0, nullptr);
 		vkCmdBindPipeline(t_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeLine);
 
 		//for minimizing screen 
-		float displayWidth = ImGui::GetIO().DisplaySize.x ? ImGui::GetIO().DisplaySize.x : .0001f;
-		float displayHeight = ImGui::GetIO().DisplaySize.y ? ImGui::GetIO().DisplaySize.y : .0001f;
+		float displayWidth = DisplaySize.x ? DisplaySize.x : .0001f;
+		float displayHeight = DisplaySize.y ? DisplaySize.y : .0001f;
 
 		VkViewport viewport = Initializers::Viewport(
 			displayWidth,
@@ -104,7 +170,7 @@ namespace Fling
 		vkCmdSetViewport(t_commandBuffer, 0, 1, &viewport);
 
 		//UI scale and translate via push constants
-		pushConstBlock.scale = glm::vec2(2.0f / io.DisplaySize.x, 2.0f / io.DisplaySize.y);
+		pushConstBlock.scale = glm::vec2(2.0f / DisplaySize.x, 2.0f / DisplaySize.y);
 		pushConstBlock.translate = glm::vec2(-1.0f);
 		vkCmdPushConstants(
 			t_commandBuffer,
@@ -115,11 +181,7 @@ namespace Fling
 			&pushConstBlock);
 
 		//Render commands 
-		ImDrawData* imDrawData = ImGui::GetDrawData();
-		uint32 vertexOffset = 0;
-		uint32 indexOffset = 0;
-
-		if (imDrawData->CmdListsCount > 0)
+		if (!t_DrawData.Commands.empty())
 		{
 			VkDeviceSize offsets[1] = { 0 };
 			vkCmdBindVertexBuffers(
@@ -135,23 +197,15 @@ namespace Fling
 				0,
 				VK_INDEX_TYPE_UINT16);
 
-			for (int32 i = 0; i < imDrawData->CmdListsCount; ++i)
+			for (const ImGuiDrawSnapshot::DrawCmd& pcmd : t_DrawData.Commands)
 			{
-				const ImDrawList* cmd_list = imDrawData->CmdLists[i];
-				for (int32 j = 0; j < cmd_list->CmdBuffer.Size; ++j)
-				{
-					const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[j];
-					VkRect2D scissorRect;
-					scissorRect.offset.x = std::max((int32)(pcmd->ClipRect.x), 0);
-					scissorRect.offset.y = std::max((int32)(pcmd->ClipRect.y), 0);
-					scissorRect.extent.width = (int32)(pcmd->ClipRect.z - pcmd->ClipRect.x);
-					scissorRect.extent.height = (int32)(pcmd->ClipRect.w - pcmd->ClipRect.y);
-					vkCmdSetScissor(t_commandBuffer, 0, 1, &scissorRect);
-					vkCmdDrawIndexed(t_commandBuffer, pcmd->ElemCount, 1, indexOffset, vertexOffset, 0);
-					indexOffset += pcmd->ElemCount;
-				}
-
-				vertexOffset += cmd_list->VtxBuffer.Size;
+				VkRect2D scissorRect;
+				scissorRect.offset.x = std::max((int32)(pcmd.ClipRect.x), 0);
+				scissorRect.offset.y = std::max((int32)(pcmd.ClipRect.y), 0);
+				scissorRect.extent.width = (int32)(pcmd.ClipRect.z - pcmd.ClipRect.x);
+				scissorRect.extent.height = (int32)(pcmd.ClipRect.w - pcmd.ClipRect.y);
+				vkCmdSetScissor(t_commandBuffer, 0, 1, &scissorRect);
+				vkCmdDrawIndexed(t_commandBuffer, pcmd.ElemCount, 1, pcmd.IndexOffset, pcmd.VertexOffset, 0);
 			}
 		}
 	}
@@ -439,12 +493,13 @@ namespace Fling
 		m_vertexBuffer = std::make_unique<Buffer>();
 	}
 	
-	void ImGuiSubpass::UpdateUniforms()
+	void ImGuiSubpass::UpdateUniforms(const ImGuiDrawSnapshot& t_DrawData)
 	{
-		ImDrawData* imDrawData = ImGui::GetDrawData();
+		const int32 TotalVtxCount = static_cast<int32>(t_DrawData.Vertices.size());
+		const int32 TotalIdxCount = static_cast<int32>(t_DrawData.Indices.size());
 
-		VkDeviceSize vertexBufferSize = imDrawData->TotalVtxCount * sizeof(ImDrawVert);
-		VkDeviceSize indexBufferSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
+		VkDeviceSize vertexBufferSize = TotalVtxCount * sizeof(ImDrawVert);
+		VkDeviceSize indexBufferSize = TotalIdxCount * sizeof(ImDrawIdx);
 
 		if ((vertexBufferSize == 0) || (indexBufferSize == 0)) 
 		{
@@ -452,37 +507,30 @@ namespace Fling
 		}
 
 		if ((m_vertexBuffer->GetVkBuffer() == VK_NULL_HANDLE) ||
-			(m_vertexCount != imDrawData->TotalVtxCount))
+			(m_vertexCount != TotalVtxCount))
 		{
 			m_vertexBuffer->UnmapMemory();
 			m_vertexBuffer->Release();
 
 			m_vertexBuffer->CreateBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
-			m_vertexCount = imDrawData->TotalVtxCount;
+			m_vertexCount = TotalVtxCount;
 			m_vertexBuffer->MapMemory();
 		}
 
 		if ((m_indexBuffer->GetVkBuffer() == VK_NULL_HANDLE) ||
-			(m_indexCount < imDrawData->TotalIdxCount))
+			(m_indexCount < TotalIdxCount))
 		{
 			m_indexBuffer->UnmapMemory();
 			m_indexBuffer->Release();
 
 			m_indexBuffer->CreateBuffer(indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
-			m_indexCount = imDrawData->TotalIdxCount;
+			m_indexCount = TotalIdxCount;
 			m_indexBuffer->MapMemory();
 		}
 
-		ImDrawVert* vtxDst = (ImDrawVert*)m_vertexBuffer->m_MappedMem;
-		ImDrawIdx* idxDst = (ImDrawIdx*)m_indexBuffer->m_MappedMem;
-
-		for (int n = 0; n < imDrawData->CmdListsCount; ++n) {
-			const ImDrawList* cmd_list = imDrawData->CmdLists[n];
-			memcpy(vtxDst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
-			memcpy(idxDst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-			vtxDst += cmd_list->VtxBuffer.Size;
-			idxDst += cmd_list->IdxBuffer.Size;
-		}
+		// The snapshot already has every draw list packed together
+		memcpy(m_vertexBuffer->m_MappedMem, t_DrawData.Vertices.data(), vertexBufferSize);
+		memcpy(m_indexBuffer->m_MappedMem, t_DrawData.Indices.data(), indexBufferSize);
 
 		m_vertexBuffer->Flush(VK_WHOLE_SIZE, 0);
 		m_indexBuffer->Flush(VK_WHOLE_SIZE, 0);
@@ -0,0 +1,63 @@
+#include "pch.h"
+#include "LodSelection.h"
+
+namespace Fling
+{
+	namespace LodSelection
+	{
+		namespace
+		{
+			/** Cameras inside a model's bounds are treated as being this close to it, so the scale stays finite */
+			constexpr float MinDistance = 1e-3f;
+
+			/** The coarsest LOD with at most t_MaxError pixels of error, or 0 if there isn't one */
+			uint32 FindCoarsest(const MeshLod* t_Lods, uint32 t_LodCount, float t_ErrorScale, float t_MaxError)
+			{
+				uint32 Lod = 0;
+				while (Lod + 1 < t_LodCount && t_Lods[Lod + 1].Error * t_ErrorScale <= t_MaxError)
+				{
+					++Lod;
+				}
+				return Lod;
+			}
+		}
+
+		float GetProjectionScale(const glm::mat4& t_Projection, float t_ViewportHeight)
+		{
+			// [1][1] is 1 / tan(fov / 2), and the viewport covers -1 to 1 of that
+			return std::abs(t_Projection[1][1]) * t_ViewportHeight * 0.5f;
+		}
+
+		float GetErrorScale(const glm::vec4& t_Bounds, float t_ModelRadius, const glm::vec3& t_CameraPos, float t_ProjectionScale)
+		{
+			const float Radius = t_Bounds.w;
+			const float ModelScale = t_ModelRadius > 0.0f ? Radius / t_ModelRadius : 1.0f;
+			const float Distance = std::max(glm::length(glm::vec3(t_Bounds) - t_CameraPos) - Radius, MinDistance);
+			return ModelScale * t_ProjectionScale / Distance;
+		}
+
+		uint32 SelectLod(const MeshLod* t_Lods, uint32 t_LodCount, float t_ErrorScale, float t_Threshold, uint32 t_CurrentLod, float t_Hysteresis)
+		{
+			if (t_LodCount <= 1)
+			{
+				return 0;
+			}
+
+			const uint32 Current = std::min(t_CurrentLod, t_LodCount - 1);
+
+			// Only go coarser once it is well under the threshold
+			const uint32 Coarser = FindCoarsest(t_Lods, t_LodCount, t_ErrorScale, t_Threshold * (1.0f - t_Hysteresis));
+			if (Coarser > Current)
+			{
+				return Coarser;
+			}
+
+			// And only go finer once the current one is well over it
+			if (t_Lods[Current].Error * t_ErrorScale <= t_Threshold * (1.0f + t_Hysteresis))
+			{
+				return Current;
+			}
+			return FindCoarsest(t_Lods, t_LodCount, t_ErrorScale, t_Threshold);
+		}
+	}
+}   // namespace Fling
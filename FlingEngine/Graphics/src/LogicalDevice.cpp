@@ -131,6 +131,8 @@ namespace Fling
 
 	void LogicalDevice::WaitForIdle()
 	{
+		// Waiting on the device counts as using every queue on it
+		std::lock_guard<std::mutex> Lock(m_QueueMutex);
 		vkDeviceWaitIdle(m_Device);
 	}
 
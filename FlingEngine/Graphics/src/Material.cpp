@@ -29,7 +29,65 @@ namespace Fling
         LoadMaterial();
     }
 
+    Material::Material(Guid t_ID, AsyncLoad_t)
+        : JsonFile(t_ID)
+    {
+        // Only default materials have textures, anything else failed to read
+        if (!ReadMaterialData() && m_Type == Material::Type::Default)
+        {
+            throw std::runtime_error("Failed to read material");
+        }
+    }
+
     void Material::LoadMaterial()
+    {
+        if (!ReadMaterialData())
+        {
+            return;
+        }
+
+        for (uint32 i = 0; i < NumTextureSlots; ++i)
+        {
+            *GetTextureSlot(i) = Texture::Create(HS(m_TexturePaths[i].c_str()));
+        }
+    }
+
+    bool Material::FinalizeAsyncLoad()
+    {
+        if (m_Type != Material::Type::Default)
+        {
+            return true;
+        }
+
+        // Kick off the texture loads the first time through
+        if (m_PendingTextures.empty())
+        {
+            for (uint32 i = 0; i < NumTextureSlots; ++i)
+            {
+                m_PendingTextures.emplace_back(ResourceManager::LoadResourceAsync<Texture>(HS(m_TexturePaths[i].c_str())));
+            }
+        }
+
+        for (const ResourceFuture<Texture>& Pending : m_PendingTextures)
+        {
+            if (!Pending.IsDone())
+            {
+                return false;
+            }
+        }
+
+        for (uint32 i = 0; i < NumTextureSlots; ++i)
+        {
+            // Fall back to a normal load so that failures are handled the same way either way
+            std::shared_ptr<Texture> Loaded = m_PendingTextures[i].Get();
+            *GetTextureSlot(i) = Loaded ? Loaded : Texture::Create(HS(m_TexturePaths[i].c_str()));
+        }
+
+        m_PendingTextures.clear();
+        return true;
+    }
+
+    bool Material::ReadMaterialData()
     {
         try
         {
@@ -39,31 +97,35 @@ namespace Fling
 
 			if (m_Type != Material::Type::Default)
 			{
-				return;
+				return false;
 			}
 
-            // Load Textures -------------
-            // Albedo
-            const std::string AlbedoPath = m_JsonData.GetString("albedo");
-            m_Textures.m_AlbedoTexture = Texture::Create(HS(AlbedoPath.c_str())).get();
-
-            // Normal
-            const std::string NormalPath = m_JsonData.GetString("normal");
-            m_Textures.m_NormalTexture = Texture::Create(HS(NormalPath.c_str())).get();
-
-            // Metal
-            const std::string MetalPath = m_JsonData.GetString("metal");
-            m_Textures.m_MetalTexture = Texture::Create(HS(MetalPath.c_str())).get();
-
-            // Rough
-            const std::string RoughPath = m_JsonData.GetString("rough");
-            m_Textures.m_RoughnessTexture = Texture::Create(HS(RoughPath.c_str())).get();
+            // Textures -------------
+            m_TexturePaths[0] = m_JsonData.GetString("albedo");
+            m_TexturePaths[1] = m_JsonData.GetString("normal");
+            m_TexturePaths[2] = m_JsonData.GetString("metal");
+            m_TexturePaths[3] = m_JsonData.GetString("rough");
+            return true;
         }
         catch (std::exception& e)
         {
             F_LOG_ERROR("Failed to load material file {} : {}", GetFilepathReleativeToAssets(), e.what());
             FLING_BREAK();
         }
+        return false;
+    }
+
+    std::shared_ptr<Texture>* Material::GetTextureSlot(uint32 t_Index)
+    {
+        std::shared_ptr<Texture>* Slots[NumTextureSlots] =
+        {
+            &m_Textures.m_AlbedoTexture,
+            &m_Textures.m_NormalTexture,
+            &m_Textures.m_MetalTexture,
+            &m_Textures.m_RoughnessTexture
+        };
+        assert(t_Index < NumTextureSlots);
+        return Slots[t_Index];
     }
 
 	Material::Type Material::GetTypeFromStr(const std::string& t_Str)
@@ -0,0 +1,273 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <limits>
+
+namespace Fling
+{
+	namespace MeshOptimizer
+	{
+		namespace
+		{
+			constexpr uint32 InvalidIndex = std::numeric_limits<uint32>::max();
+
+			/** Tuning from Forsyth's paper */
+			constexpr float CacheDecayPower = 1.5f;
+			constexpr float LastTriScore = 0.75f;
+			constexpr float ValenceBoostScale = 2.0f;
+			constexpr float ValenceBoostPower = 0.5f;
+
+			/**
+			 * How much we want to use a vertex next. Ones that were just used or are near the front
+			 * of the cache score high, and so do ones with only a few triangles left so that they
+			 * get finished off instead of leaving lonely triangles for later.
+			 */
+			float ForsythVertexScore(int32 t_CachePos, uint32 t_RemainingTris)
+			{
+				if (t_RemainingTris == 0)
+				{
+					return -1.0f;
+				}
+
+				float Score = 0.0f;
+				if (t_CachePos >= 0)
+				{
+					if (t_CachePos < 3)
+					{
+						// Used by the last triangle, which has to be scored the same whichever order it went in
+						Score = LastTriScore;
+					}
+					else
+					{
+						const float Scaler = 1.0f / static_cast<float>(DefaultCacheSize - 3);
+						Score = std::pow(1.0f - static_cast<float>(t_CachePos - 3) * Scaler, CacheDecayPower);
+					}
+				}
+
+				Score += ValenceBoostScale * std::pow(static_cast<float>(t_RemainingTris), -ValenceBoostPower);
+				return Score;
+			}
+		}
+
+		uint32 WeldVertices(std::vector<Vertex>& t_Verts, std::vector<uint32>& t_Indices)
+		{
+			std::unordered_map<Vertex, uint32> Unique;
+			Unique.reserve(t_Verts.size());
+
+			std::vector<Vertex> Welded;
+			Welded.reserve(t_Verts.size());
+
+			std::vector<uint32> Remap(t_Verts.size());
+			for (size_t i = 0; i < t_Verts.size(); ++i)
+			{
+				const auto Inserted = Unique.try_emplace(t_Verts[i], static_cast<uint32>(Welded.size()));
+				if (Inserted.second)
+				{
+					Welded.push_back(t_Verts[i]);
+				}
+				Remap[i] = Inserted.first->second;
+			}
+
+			for (uint32& Index : t_Indices)
+			{
+				Index = Remap[Index];
+			}
+
+			t_Verts.swap(Welded);
+			return static_cast<uint32>(t_Verts.size());
+		}
+
+		void OptimizeVertexCache(uint32* t_Indices, size_t t_NumIndices, uint32 t_NumVerts)
+		{
+			const size_t NumTris = t_NumIndices / 3;
+			if (NumTris == 0)
+			{
+				return;
+			}
+
+			// The triangles that use each vertex. Triangles that have been drawn are swapped to the
+			// back of their vertex's range, so the first RemainingTris of it are the ones left
+			std::vector<uint32> RemainingTris(t_NumVerts, 0);
+			for (size_t i = 0; i < NumTris * 3; ++i)
+			{
+				++RemainingTris[t_Indices[i]];
+			}
+
+			std::vector<uint32> TriOffsets(t_NumVerts + 1, 0);
+			for (uint32 v = 0; v < t_NumVerts; ++v)
+			{
+				TriOffsets[v + 1] = TriOffsets[v] + RemainingTris[v];
+			}
+
+			std::vector<uint32> VertTris(NumTris * 3);
+			{
+				std::vector<uint32> Cursor(TriOffsets.begin(), TriOffsets.end() - 1);
+				for (size_t i = 0; i < NumTris * 3; ++i)
+				{
+					VertTris[Cursor[t_Indices[i]]++] = static_cast<uint32>(i / 3);
+				}
+			}
+
+			std::vector<int32> CachePos(t_NumVerts, -1);
+			std::vector<float> VertScores(t_NumVerts);
+			for (uint32 v = 0; v < t_NumVerts; ++v)
+			{
+				VertScores[v] = ForsythVertexScore(-1, RemainingTris[v]);
+			}
+
+			std::vector<float> TriScores(NumTris);
+			std::vector<bool> TriDrawn(NumTris, false);
+			uint32 BestTri = 0;
+			for (uint32 t = 0; t < NumTris; ++t)
+			{
+				const uint32* Tri = t_Indices + static_cast<size_t>(t) * 3;
+				TriScores[t] = VertScores[Tri[0]] + VertScores[Tri[1]] + VertScores[Tri[2]];
+				if (TriScores[t] > TriScores[BestTri])
+				{
+					BestTri = t;
+				}
+			}
+
+			std::vector<uint32> Output;
+			Output.reserve(NumTris * 3);
+
+			// Most recently used first. Has room for the 3 vertices that a triangle pushes past the end
+			uint32 Cache[DefaultCacheSize + 3];
+			uint32 CacheCount = 0;
+			uint32 ScanCursor = 0;
+
+			while (Output.size() < NumTris * 3)
+			{
+				if (BestTri == InvalidIndex)
+				{
+					// Nothing in the cache has triangles left, start again from the next one that hasn't been drawn
+					while (TriDrawn[ScanCursor])
+					{
+						++ScanCursor;
+					}
+					BestTri = ScanCursor;
+				}
+
+				const uint32* Drawn = t_Indices + static_cast<size_t>(BestTri) * 3;
+				const uint32 TriVerts[3] = { Drawn[0], Drawn[1], Drawn[2] };
+				TriDrawn[BestTri] = true;
+
+				uint32 NewCache[DefaultCacheSize + 3];
+				uint32 NewCount = 0;
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					const uint32 Vert = TriVerts[k];
+					Output.push_back(Vert);
+
+					// Degenerate triangles use the same vertex more than once, but it's only in their list once per use
+					uint32* Tris = VertTris.data() + TriOffsets[Vert];
+					for (uint32 i = 0; i < RemainingTris[Vert]; ++i)
+					{
+						if (Tris[i] == BestTri)
+						{
+							std::swap(Tris[i], Tris[RemainingTris[Vert] - 1]);
+							--RemainingTris[Vert];
+							break;
+						}
+					}
+
+					if (std::find(NewCache, NewCache + NewCount, Vert) == NewCache + NewCount)
+					{
+						NewCache[NewCount++] = Vert;
+					}
+				}
+
+				for (uint32 i = 0; i < CacheCount; ++i)
+				{
+					if (Cache[i] != TriVerts[0] && Cache[i] != TriVerts[1] && Cache[i] != TriVerts[2])
+					{
+						NewCache[NewCount++] = Cache[i];
+					}
+				}
+
+				// Everything that moved gets scored again, including the ones that just fell out
+				for (uint32 i = 0; i < NewCount; ++i)
+				{
+					const uint32 Vert = NewCache[i];
+					CachePos[Vert] = i < DefaultCacheSize ? static_cast<int32>(i) : -1;
+					VertScores[Vert] = ForsythVertexScore(CachePos[Vert], RemainingTris[Vert]);
+				}
+
+				CacheCount = std::min(NewCount, DefaultCacheSize);
+				std::copy(NewCache, NewCache + CacheCount, Cache);
+
+				// The next triangle is the best one that uses something in the cache
+				BestTri = InvalidIndex;
+				float BestScore = -1.0f;
+				for (uint32 i = 0; i < NewCount; ++i)
+				{
+					const uint32 Vert = NewCache[i];
+					const uint32* Tris = VertTris.data() + TriOffsets[Vert];
+					for (uint32 j = 0; j < RemainingTris[Vert]; ++j)
+					{
+						const uint32 Tri = Tris[j];
+						const uint32* Verts = t_Indices + static_cast<size_t>(Tri) * 3;
+						TriScores[Tri] = VertScores[Verts[0]] + VertScores[Verts[1]] + VertScores[Verts[2]];
+						if (TriScores[Tri] > BestScore)
+						{
+							BestScore = TriScores[Tri];
+							BestTri = Tri;
+						}
+					}
+				}
+			}
+
+			std::copy(Output.begin(), Output.end(), t_Indices);
+		}
+
+		uint32 OptimizeVertexFetch(std::vector<Vertex>& t_Verts, std::vector<uint32>& t_Indices)
+		{
+			std::vector<uint32> Remap(t_Verts.size(), InvalidIndex);
+
+			std::vector<Vertex> Reordered;
+			Reordered.reserve(t_Verts.size());
+
+			for (uint32& Index : t_Indices)
+			{
+				if (Remap[Index] == InvalidIndex)
+				{
+					Remap[Index] = static_cast<uint32>(Reordered.size());
+					Reordered.push_back(t_Verts[Index]);
+				}
+				Index = Remap[Index];
+			}
+
+			t_Verts.swap(Reordered);
+			return static_cast<uint32>(t_Verts.size());
+		}
+
+		VertexCacheStats AnalyzeVertexCache(const uint32* t_Indices, size_t t_NumIndices, uint32 t_NumVerts, uint32 t_CacheSize)
+		{
+			VertexCacheStats Stats;
+			const size_t NumTris = t_NumIndices / 3;
+			if (NumTris == 0 || t_NumVerts == 0)
+			{
+				return Stats;
+			}
+
+			// A vertex is still in a FIFO cache if fewer than t_CacheSize misses have happened since it went in
+			std::vector<uint32> InsertedAt(t_NumVerts, 0);
+			uint32 Misses = 0;
+			uint32 Clock = t_CacheSize + 1;
+			for (size_t i = 0; i < NumTris * 3; ++i)
+			{
+				const uint32 Vert = t_Indices[i];
+				if (Clock - InsertedAt[Vert] > t_CacheSize)
+				{
+					InsertedAt[Vert] = Clock++;
+					++Misses;
+				}
+			}
+
+			Stats.ACMR = static_cast<float>(Misses) / static_cast<float>(NumTris);
+			Stats.ATVR = static_cast<float>(Misses) / static_cast<float>(t_NumVerts);
+			return Stats;
+		}
+	}
+}   // namespace Fling
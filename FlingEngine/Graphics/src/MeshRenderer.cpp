@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "MeshRenderer.h"
 
+#include "ResourceManager.h"
+
 #include <entt/entity/helper.hpp>
 
 namespace Fling
@@ -17,22 +19,91 @@ namespace Fling
 		LoadMaterialFromPath(t_MaterialPath);
 	}
 
-	MeshRenderer::MeshRenderer(Model* t_Model, Material* t_Mat /** = nullptr */)
-		:m_Model(t_Model)
-		, m_Material(t_Mat)
+	MeshRenderer::MeshRenderer(const std::string& t_MeshPath, const std::string& t_MaterialPath, AsyncLoad_t)
+	{
+		m_Model = ResourceManager::LoadResourceHandleAsync<Model>(Guid{ t_MeshPath.c_str() });
+		m_Material = ResourceManager::LoadResourceHandleAsync<Material>(Guid{ t_MaterialPath.c_str() });
+
+		// Either of these might have already been loaded
+		if (ResourceManager::Resolve(m_Material))
+		{
+			m_ActiveMaterial = m_Material;
+			ResourceManager::AddHandleRef(m_ActiveMaterial);
+		}
+		else
+		{
+			m_ActiveMaterial = ResourceManager::AcquireHandle(Material::GetDefaultMat());
+		}
+	}
+
+	MeshRenderer::MeshRenderer(const std::shared_ptr<Model>& t_Model, const std::shared_ptr<Material>& t_Mat /** = nullptr */)
 	{
-		if (!m_Material)
+		m_Model = ResourceManager::AcquireHandle(t_Model);
+		if (t_Mat)
+		{
+			SetMaterial(ResourceManager::AcquireHandle(t_Mat));
+		}
+		else
 		{
 			LoadMaterialFromPath("Materials/Default.mat");
 		}
 	}
 
+	bool MeshRenderer::UpdatePendingLoads()
+	{
+		if (m_ActiveMaterial == m_Material)
+		{
+			return false;
+		}
+
+		Material* Loaded = ResourceManager::Resolve(m_Material);
+		if (!Loaded)
+		{
+			// Still streaming in, or it failed to load and we stick with the placeholder
+			return false;
+		}
+
+		Material* Active = GetMaterial();
+		if (Active && Loaded->GetType() != Active->GetType())
+		{
+			// Switching types would mean moving to another subpass, so stick with the placeholder
+			F_LOG_WARN("Material {} isn't the same type as its placeholder and won't be used", Loaded->GetGuidString());
+			ResourceManager::ReleaseHandle(m_Material);
+			m_Material = m_ActiveMaterial;
+			ResourceManager::AddHandleRef(m_Material);
+			return false;
+		}
+
+		// Let go of the placeholder after the frames in flight are done with it, the eviction delay covers that
+		ResourceManager::ReleaseHandle(m_ActiveMaterial);
+		m_ActiveMaterial = m_Material;
+		ResourceManager::AddHandleRef(m_ActiveMaterial);
+		return true;
+	}
+
 	void MeshRenderer::Release()
 	{
 		delete m_UniformBuffer;
 		m_UniformBuffer = nullptr;
 	}
 
+	void MeshRenderer::ReleaseHandles()
+	{
+		ResourceManager::ReleaseHandle(m_Model);
+		ResourceManager::ReleaseHandle(m_Material);
+		ResourceManager::ReleaseHandle(m_ActiveMaterial);
+	}
+
+	void MeshRenderer::ConnectToRegistry(entt::registry& t_Reg)
+	{
+		t_Reg.on_destroy<MeshRenderer>().connect<&MeshRenderer::OnDestroyed>();
+	}
+
+	void MeshRenderer::OnDestroyed(entt::entity t_Ent, entt::registry& t_Reg)
+	{
+		t_Reg.get<MeshRenderer>(t_Ent).ReleaseHandles();
+	}
+
 	bool MeshRenderer::operator==(const MeshRenderer& other) const
 	{
 		return m_Model == other.m_Model && m_Material == other.m_Material;
@@ -45,15 +116,34 @@ namespace Fling
 
 	void MeshRenderer::LoadModelFromPath(const std::string& t_MeshPath)
 	{
-		// Load the model
-		m_Model = Model::Create(Guid{ t_MeshPath.c_str() }).get();
-		assert(m_Model);
+		ResourceHandle<Model> Loaded = ResourceManager::LoadResourceHandle<Model>(Guid{ t_MeshPath.c_str() });
+		assert(ResourceManager::Resolve(Loaded));
+
+		// Acquire the new one first so that loading the same model again doesn't unload it in between
+		ResourceManager::ReleaseHandle(m_Model);
+		m_Model = Loaded;
 	}
 
 	void MeshRenderer::LoadMaterialFromPath(const std::string& t_MatPath)
 	{
-		m_Material = Material::Create(Guid{ t_MatPath.c_str() }).get();
-		assert(m_Material);
+		ResourceHandle<Material> Loaded = ResourceManager::LoadResourceHandle<Material>(Guid{ t_MatPath.c_str() });
+		assert(ResourceManager::Resolve(Loaded));
+		SetMaterial(Loaded);
+	}
+
+	void MeshRenderer::SetMaterial(ResourceHandle<Material> t_Material)
+	{
+		ResourceManager::ReleaseHandle(m_Material);
+		m_Material = t_Material;
+
+		// Draw with it right away if this renderer hasn't been picked up by a subpass yet,
+		// otherwise UpdatePendingLoads swaps it in and rebuilds the descriptor sets
+		if (m_DescriptorSet == VK_NULL_HANDLE)
+		{
+			ResourceManager::ReleaseHandle(m_ActiveMaterial);
+			m_ActiveMaterial = m_Material;
+			ResourceManager::AddHandleRef(m_ActiveMaterial);
+		}
 	}
 
 	void MeshRenderer::Serialize(JsonArchive& Ar)
@@ -63,8 +153,9 @@ namespace Fling
 
 		if (Ar.IsSaving())
 		{
-			meshPath = m_Model ? m_Model->GetGuidString() : "";
-			materialPath = m_Material ? m_Material->GetGuidString() : "";
+			// The paths are kept with the handles, so this works while they are still streaming in
+			meshPath = ResourceManager::GetHandlePath(m_Model);
+			materialPath = ResourceManager::GetHandlePath(m_Material);
 		}
 
 		Ar << MakeNVP("mesh", meshPath);
@@ -0,0 +1,682 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <set>
+
+namespace Fling
+{
+	namespace MeshSimplifier
+	{
+		namespace
+		{
+			/** Boundary planes count this much more than surface planes, so boundaries hold their shape */
+			constexpr double BorderWeight = 10.0;
+
+			/**
+			 * How much attribute error counts against position error, as a fraction of the mesh's radius.
+			 * Being a whole unit off in a normal or texture coordinate costs as much as being this far
+			 * off the surface.
+			 */
+			constexpr double AttributeWeight = 0.05;
+
+			/** The normal, texture coordinate and color, which is everything in a Vertex that gets interpolated */
+			constexpr uint32 AttributeCount = 8;
+
+			/** LODs that don't get rid of at least this much of the last one aren't worth keeping */
+			constexpr float MinLodReduction = 0.9f;
+
+			/** Meshes smaller than this aren't worth simplifying */
+			constexpr size_t MinLodIndexCount = 3 * 8;
+
+			inline void GetAttributes(const Vertex& t_Vert, float* t_Out)
+			{
+				t_Out[0] = t_Vert.Normal.x; t_Out[1] = t_Vert.Normal.y; t_Out[2] = t_Vert.Normal.z;
+				t_Out[3] = t_Vert.TexCoord.x; t_Out[4] = t_Vert.TexCoord.y;
+				t_Out[5] = t_Vert.Color.x; t_Out[6] = t_Vert.Color.y; t_Out[7] = t_Vert.Color.z;
+			}
+
+			/**
+			 * Symmetric 4x4 matrix that measures the summed squared distance to a set of planes, stored
+			 * as its 10 unique terms. Weight is how many planes went in, to turn that into an average.
+			 */
+			struct Quadric
+			{
+				double A2 = 0.0, AB = 0.0, AC = 0.0, AD = 0.0;
+				double B2 = 0.0, BC = 0.0, BD = 0.0;
+				double C2 = 0.0, CD = 0.0;
+				double D2 = 0.0;
+				double Weight = 0.0;
+
+				/** Add (dot(t_Normal, p) + t_Distance)^2, without touching the weight */
+				void AddPlane(const glm::dvec3& t_Normal, double t_Distance, double t_Weight)
+				{
+					const double A = t_Normal.x;
+					const double B = t_Normal.y;
+					const double C = t_Normal.z;
+					const double D = t_Distance;
+					A2 += t_Weight * A * A; AB += t_Weight * A * B; AC += t_Weight * A * C; AD += t_Weight * A * D;
+					B2 += t_Weight * B * B; BC += t_Weight * B * C; BD += t_Weight * B * D;
+					C2 += t_Weight * C * C; CD += t_Weight * C * D;
+					D2 += t_Weight * D * D;
+				}
+
+				Quadric& operator+=(const Quadric& t_Other)
+				{
+					A2 += t_Other.A2; AB += t_Other.AB; AC += t_Other.AC; AD += t_Other.AD;
+					B2 += t_Other.B2; BC += t_Other.BC; BD += t_Other.BD;
+					C2 += t_Other.C2; CD += t_Other.CD;
+					D2 += t_Other.D2;
+					Weight += t_Other.Weight;
+					return *this;
+				}
+
+				double Evaluate(const glm::dvec3& t_Pos) const
+				{
+					const double X = t_Pos.x;
+					const double Y = t_Pos.y;
+					const double Z = t_Pos.z;
+					return
+						A2 * X * X + 2.0 * AB * X * Y + 2.0 * AC * X * Z + 2.0 * AD * X +
+						B2 * Y * Y + 2.0 * BC * Y * Z + 2.0 * BD * Y +
+						C2 * Z * Z + 2.0 * CD * Z +
+						D2;
+				}
+			};
+
+			/**
+			 * Measures how far a vertex's attributes are from what the triangles it has taken over would
+			 * interpolate at its position (Hoppe, "New quadric metric for simplifying meshes with
+			 * appearance attributes"). Every triangle adds the gradient G and offset D of each attribute
+			 * over it, and the error for attribute value S at position P is the sum of (G.P + D - S)^2.
+			 * Attributes that change linearly across a flat area cost nothing to collapse.
+			 */
+			struct AttributeQuadric
+			{
+				/** The (G.P + D)^2 terms */
+				Quadric Pos;
+
+				/** The sums of G and D for each attribute, for the -2S(G.P + D) terms */
+				double Gradients[AttributeCount][4] = {};
+
+				void AddTriangle(const glm::dvec3& t_P0, const glm::dvec3& t_P1, const glm::dvec3& t_P2, const float* t_S0, const float* t_S1, const float* t_S2)
+				{
+					const glm::dvec3 Edge1 = t_P1 - t_P0;
+					const glm::dvec3 Edge2 = t_P2 - t_P0;
+					const glm::dvec3 Normal = glm::cross(Edge1, Edge2);
+					const double LengthSq = glm::dot(Normal, Normal);
+					if (LengthSq <= 0.0)
+					{
+						return;
+					}
+
+					// The gradient that lies in the triangle and matches the attribute at all 3 corners
+					const glm::dvec3 Along1 = glm::cross(Edge2, Normal) / LengthSq;
+					const glm::dvec3 Along2 = glm::cross(Normal, Edge1) / LengthSq;
+					for (uint32 k = 0; k < AttributeCount; ++k)
+					{
+						const glm::dvec3 Gradient = Along1 * static_cast<double>(t_S1[k] - t_S0[k]) + Along2 * static_cast<double>(t_S2[k] - t_S0[k]);
+						const double Offset = t_S0[k] - glm::dot(Gradient, t_P0);
+						Pos.AddPlane(Gradient, Offset, 1.0);
+						Gradients[k][0] += Gradient.x;
+						Gradients[k][1] += Gradient.y;
+						Gradients[k][2] += Gradient.z;
+						Gradients[k][3] += Offset;
+					}
+					Pos.Weight += 1.0;
+				}
+
+				AttributeQuadric& operator+=(const AttributeQuadric& t_Other)
+				{
+					Pos += t_Other.Pos;
+					for (uint32 k = 0; k < AttributeCount; ++k)
+					{
+						for (uint32 i = 0; i < 4; ++i)
+						{
+							Gradients[k][i] += t_Other.Gradients[k][i];
+						}
+					}
+					return *this;
+				}
+
+				double Evaluate(const glm::dvec3& t_Pos, const float* t_Attributes) const
+				{
+					double Error = Pos.Evaluate(t_Pos);
+					for (uint32 k = 0; k < AttributeCount; ++k)
+					{
+						const double S = t_Attributes[k];
+						const double Predicted = Gradients[k][0] * t_Pos.x + Gradients[k][1] * t_Pos.y + Gradients[k][2] * t_Pos.z + Gradients[k][3];
+						Error += Pos.Weight * S * S - 2.0 * S * Predicted;
+					}
+					return Error;
+				}
+			};
+
+			/** Average error of a quadric, rounding can take the sum a hair below zero */
+			inline double Normalize(double t_Error, double t_Weight)
+			{
+				return t_Weight > 0.0 ? std::max(t_Error / t_Weight, 0.0) : 0.0;
+			}
+
+			enum VertexFlags : uint8
+			{
+				/** Has the same position as another vertex with different attributes */
+				Vertex_Seam = 1 << 0,
+
+				/** On an edge that only one triangle uses */
+				Vertex_Border = 1 << 1,
+
+				/** On an edge that more than two triangles use, or otherwise can't move */
+				Vertex_Locked = 1 << 2
+			};
+
+			inline uint64 EdgeKey(uint32 t_A, uint32 t_B)
+			{
+				return t_A < t_B ? (static_cast<uint64>(t_A) << 32) | t_B : (static_cast<uint64>(t_B) << 32) | t_A;
+			}
+
+			/** Collapsing vertex From onto vertex To */
+			struct Collapse
+			{
+				double Cost = 0.0;
+				uint32 From = 0;
+				uint32 To = 0;
+
+				bool operator>(const Collapse& t_Other) const { return Cost > t_Other.Cost; }
+			};
+
+			/**
+			 * Edge collapse state for one mesh. Triangles that collapse are marked dead rather than
+			 * removed, and adjacency lists are allowed to hold dead triangles, which are skipped.
+			 */
+			class Simplifier
+			{
+			public:
+
+				Simplifier(const std::vector<Vertex>& t_Verts, const uint32* t_Indices, size_t t_NumIndices);
+
+				/** Collapse edges until there are at most t_TargetIndexCount indices, or nothing else can go */
+				void CollapseTo(size_t t_TargetIndexCount);
+
+				inline size_t GetIndexCount() const { return m_LiveTris * 3; }
+
+				/** Furthest any collapse so far moved the surface, in model space. Attributes don't count */
+				inline float GetError() const { return static_cast<float>(std::sqrt(m_MaxPosError)); }
+
+				/** Add the triangles that are left to the end of t_Out, in their original order */
+				void AppendIndices(std::vector<uint32>& t_Out) const;
+
+			private:
+
+				/**
+				 * How much a collapse costs, false if it would break the mesh
+				 *
+				 * @param t_OutPosError		Squared distance the collapse moves the surface, without the attribute and boundary weights
+				 */
+				bool EvaluateCollapse(uint32 t_From, uint32 t_To, double& t_OutCost, double& t_OutPosError) const;
+
+				void PerformCollapse(uint32 t_From, uint32 t_To);
+
+				/** Queue up collapses of a vertex onto each of its neighbours, and the other way too if t_bBothWays */
+				void QueueEdges(uint32 t_Vert, bool t_bBothWays);
+
+				inline bool IsTriAlive(uint32 t_Tri) const { return !m_TriDead[t_Tri]; }
+
+				inline bool TriHasGroup(uint32 t_Tri, uint32 t_Group) const
+				{
+					const uint32* Tri = &m_Tris[t_Tri * 3];
+					return m_Group[Tri[0]] == t_Group || m_Group[Tri[1]] == t_Group || m_Group[Tri[2]] == t_Group;
+				}
+
+				const std::vector<Vertex>& m_Verts;
+
+				std::vector<uint32> m_Tris;
+				std::vector<bool> m_TriDead;
+				size_t m_LiveTris = 0;
+
+				/** Vertices with the same position are in the same group, and share a quadric */
+				std::vector<uint32> m_Group;
+				std::vector<Quadric> m_Quadrics;
+
+				/** Planes along open boundaries for each group, unweighted. Kept apart so they can be weighted up for the cost only */
+				std::vector<Quadric> m_BorderQuadrics;
+
+				/** Attributes belong to each vertex, not the group */
+				std::vector<AttributeQuadric> m_Attributes;
+
+				std::vector<uint8> m_Flags;
+				std::vector<bool> m_VertDead;
+				std::vector<std::vector<uint32>> m_VertTris;
+
+				std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_Queue;
+				std::vector<uint32> m_Neighbours;
+
+				double m_AttributeScaleSq = 0.0;
+				double m_MaxPosError = 0.0;
+			};
+
+			Simplifier::Simplifier(const std::vector<Vertex>& t_Verts, const uint32* t_Indices, size_t t_NumIndices)
+				: m_Verts(t_Verts)
+			{
+				const uint32 NumVerts = static_cast<uint32>(t_Verts.size());
+
+				// Group up vertices by position
+				m_Group.resize(NumVerts);
+				std::vector<uint32> GroupSizes;
+				{
+					std::unordered_map<glm::vec3, uint32> Groups;
+					Groups.reserve(NumVerts);
+					for (uint32 v = 0; v < NumVerts; ++v)
+					{
+						const auto Inserted = Groups.try_emplace(t_Verts[v].Pos, static_cast<uint32>(GroupSizes.size()));
+						if (Inserted.second)
+						{
+							GroupSizes.push_back(0);
+						}
+						m_Group[v] = Inserted.first->second;
+						++GroupSizes[m_Group[v]];
+					}
+				}
+
+				// Leave out triangles that are squashed flat or drawn twice, which some models have two
+				// copies of every triangle in. They would make every edge look like it has four sides
+				{
+					std::set<std::array<uint32, 3>> Seen;
+					m_Tris.reserve(t_NumIndices);
+					for (size_t i = 0; i + 2 < t_NumIndices; i += 3)
+					{
+						const uint32* Tri = t_Indices + i;
+						if (m_Group[Tri[0]] == m_Group[Tri[1]] || m_Group[Tri[1]] == m_Group[Tri[2]] || m_Group[Tri[2]] == m_Group[Tri[0]])
+						{
+							continue;
+						}
+
+						// Rotate the smallest index to the front so the same triangle always looks the same
+						const uint32 First = Tri[0] < Tri[1] ? (Tri[0] < Tri[2] ? 0 : 2) : (Tri[1] < Tri[2] ? 1 : 2);
+						if (Seen.insert({ Tri[First], Tri[(First + 1) % 3], Tri[(First + 2) % 3] }).second)
+						{
+							m_Tris.insert(m_Tris.end(), Tri, Tri + 3);
+						}
+					}
+				}
+
+				const uint32 NumTris = static_cast<uint32>(m_Tris.size() / 3);
+				m_TriDead.assign(NumTris, false);
+				m_LiveTris = NumTris;
+
+				m_Flags.assign(NumVerts, 0);
+				m_VertDead.assign(NumVerts, false);
+				m_VertTris.resize(NumVerts);
+				m_Quadrics.resize(GroupSizes.size());
+				m_BorderQuadrics.resize(GroupSizes.size());
+				m_Attributes.resize(NumVerts);
+
+				glm::vec3 Min(std::numeric_limits<float>::max());
+				glm::vec3 Max(-std::numeric_limits<float>::max());
+
+				// Count how many triangles use each edge, by position so that seams don't look like boundaries
+				std::unordered_map<uint64, uint32> EdgeUses;
+				EdgeUses.reserve(m_Tris.size());
+				for (uint32 t = 0; t < NumTris; ++t)
+				{
+					const uint32* Tri = &m_Tris[t * 3];
+					for (uint32 k = 0; k < 3; ++k)
+					{
+						m_VertTris[Tri[k]].push_back(t);
+						Min = glm::min(Min, t_Verts[Tri[k]].Pos);
+						Max = glm::max(Max, t_Verts[Tri[k]].Pos);
+						++EdgeUses[EdgeKey(m_Group[Tri[k]], m_Group[Tri[(k + 1) % 3]])];
+					}
+				}
+
+				const double Radius = glm::length(Max - Min) * 0.5;
+				m_AttributeScaleSq = (AttributeWeight * Radius) * (AttributeWeight * Radius);
+
+				for (uint32 v = 0; v < NumVerts; ++v)
+				{
+					if (GroupSizes[m_Group[v]] > 1)
+					{
+						m_Flags[v] |= Vertex_Seam;
+					}
+				}
+
+				std::vector<uint8> GroupFlags(GroupSizes.size(), 0);
+				for (uint32 t = 0; t < NumTris; ++t)
+				{
+					const uint32* Tri = &m_Tris[t * 3];
+					const glm::dvec3 P0(t_Verts[Tri[0]].Pos);
+					const glm::dvec3 P1(t_Verts[Tri[1]].Pos);
+					const glm::dvec3 P2(t_Verts[Tri[2]].Pos);
+					const glm::dvec3 Cross = glm::cross(P1 - P0, P2 - P0);
+					const double Length = glm::length(Cross);
+					if (Length <= 0.0)
+					{
+						continue;
+					}
+
+					const glm::dvec3 Normal = Cross / Length;
+					Quadric Plane;
+					Plane.AddPlane(Normal, -glm::dot(Normal, P0), 1.0);
+					Plane.Weight = 1.0;
+
+					float Attributes[3][AttributeCount];
+					AttributeQuadric Attribute;
+					for (uint32 k = 0; k < 3; ++k)
+					{
+						GetAttributes(t_Verts[Tri[k]], Attributes[k]);
+					}
+					Attribute.AddTriangle(P0, P1, P2, Attributes[0], Attributes[1], Attributes[2]);
+
+					for (uint32 k = 0; k < 3; ++k)
+					{
+						m_Quadrics[m_Group[Tri[k]]] += Plane;
+						m_Attributes[Tri[k]] += Attribute;
+					}
+
+					for (uint32 k = 0; k < 3; ++k)
+					{
+						const uint32 A = Tri[k];
+						const uint32 B = Tri[(k + 1) % 3];
+						const uint32 Uses = EdgeUses[EdgeKey(m_Group[A], m_Group[B])];
+						if (Uses == 1)
+						{
+							// A plane through the boundary edge, at right angles to the surface. It doesn't add to the
+							// weight, so that it isn't averaged away by the surface planes. See BorderWeight
+							const glm::dvec3 EdgeStart(t_Verts[A].Pos);
+							const glm::dvec3 BorderCross = glm::cross(glm::dvec3(t_Verts[B].Pos) - EdgeStart, Normal);
+							const double BorderLength = glm::length(BorderCross);
+							if (BorderLength > 0.0)
+							{
+								const glm::dvec3 BorderNormal = BorderCross / BorderLength;
+								Quadric Border;
+								Border.AddPlane(BorderNormal, -glm::dot(BorderNormal, EdgeStart), 1.0);
+								m_BorderQuadrics[m_Group[A]] += Border;
+								m_BorderQuadrics[m_Group[B]] += Border;
+							}
+							GroupFlags[m_Group[A]] |= Vertex_Border;
+							GroupFlags[m_Group[B]] |= Vertex_Border;
+						}
+						else if (Uses > 2)
+						{
+							GroupFlags[m_Group[A]] |= Vertex_Locked;
+							GroupFlags[m_Group[B]] |= Vertex_Locked;
+						}
+					}
+				}
+
+				for (uint32 v = 0; v < NumVerts; ++v)
+				{
+					m_Flags[v] |= GroupFlags[m_Group[v]];
+				}
+
+				for (uint32 v = 0; v < NumVerts; ++v)
+				{
+					if (!m_VertTris[v].empty())
+					{
+						QueueEdges(v, false);
+					}
+				}
+			}
+
+			bool Simplifier::EvaluateCollapse(uint32 t_From, uint32 t_To, double& t_OutCost, double& t_OutPosError) const
+			{
+				if (t_From == t_To || m_VertDead[t_From] || m_VertDead[t_To] || (m_Flags[t_From] & (Vertex_Seam | Vertex_Locked)))
+				{
+					return false;
+				}
+
+				const uint32 ToGroup = m_Group[t_To];
+				const glm::vec3& FromPos = m_Verts[t_From].Pos;
+				const glm::vec3& ToPos = m_Verts[t_To].Pos;
+
+				uint32 SharedTris = 0;
+				for (uint32 t : m_VertTris[t_From])
+				{
+					if (!IsTriAlive(t))
+					{
+						continue;
+					}
+
+					const uint32* Tri = &m_Tris[t * 3];
+					if (TriHasGroup(t, ToGroup))
+					{
+						// The triangles on the edge have to agree on which vertex is on the other end,
+						// otherwise the edge runs along a seam and the attributes would be wrong on one side
+						if (Tri[0] != t_To && Tri[1] != t_To && Tri[2] != t_To)
+						{
+							return false;
+						}
+						++SharedTris;
+						continue;
+					}
+
+					// Moving this triangle's corner mustn't flip it over or squash it flat
+					glm::vec3 Corners[3] = { m_Verts[Tri[0]].Pos, m_Verts[Tri[1]].Pos, m_Verts[Tri[2]].Pos };
+					const glm::vec3 Before = glm::cross(Corners[1] - Corners[0], Corners[2] - Corners[0]);
+					for (glm::vec3& Corner : Corners)
+					{
+						if (Corner == FromPos)
+						{
+							Corner = ToPos;
+						}
+					}
+					const glm::vec3 After = glm::cross(Corners[1] - Corners[0], Corners[2] - Corners[0]);
+					if (glm::dot(Before, After) <= 0.0f)
+					{
+						return false;
+					}
+				}
+
+				// Not an edge any more
+				if (SharedTris == 0)
+				{
+					return false;
+				}
+
+				// Boundary vertices can only slide along the boundary
+				if ((m_Flags[t_From] & Vertex_Border) && SharedTris != 1)
+				{
+					return false;
+				}
+
+				// Quadrics are linear, so evaluating them one at a time is the same as merging them first
+				const Quadric& FromQuadric = m_Quadrics[m_Group[t_From]];
+				const Quadric& ToQuadric = m_Quadrics[ToGroup];
+				const Quadric& FromBorder = m_BorderQuadrics[m_Group[t_From]];
+				const Quadric& ToBorder = m_BorderQuadrics[ToGroup];
+				const AttributeQuadric& FromAttributes = m_Attributes[t_From];
+				const AttributeQuadric& ToAttributes = m_Attributes[t_To];
+
+				float Attributes[AttributeCount];
+				GetAttributes(m_Verts[t_To], Attributes);
+
+				const glm::dvec3 NewPos(ToPos);
+				const double SurfaceError = FromQuadric.Evaluate(NewPos) + ToQuadric.Evaluate(NewPos);
+				const double BorderError = FromBorder.Evaluate(NewPos) + ToBorder.Evaluate(NewPos);
+				const double PosWeight = FromQuadric.Weight + ToQuadric.Weight;
+				const double AttributeError = Normalize(
+					FromAttributes.Evaluate(NewPos, Attributes) + ToAttributes.Evaluate(NewPos, Attributes),
+					FromAttributes.Pos.Weight + ToAttributes.Pos.Weight);
+
+				t_OutPosError = Normalize(SurfaceError + BorderError, PosWeight);
+				t_OutCost = Normalize(SurfaceError + BorderError * BorderWeight, PosWeight) + AttributeError * m_AttributeScaleSq;
+				return true;
+			}
+
+			void Simplifier::PerformCollapse(uint32 t_From, uint32 t_To)
+			{
+				const uint32 ToGroup = m_Group[t_To];
+				for (uint32 t : m_VertTris[t_From])
+				{
+					if (!IsTriAlive(t))
+					{
+						continue;
+					}
+
+					if (TriHasGroup(t, ToGroup))
+					{
+						m_TriDead[t] = true;
+						--m_LiveTris;
+						continue;
+					}
+
+					uint32* Tri = &m_Tris[t * 3];
+					for (uint32 k = 0; k < 3; ++k)
+					{
+						if (Tri[k] == t_From)
+						{
+							Tri[k] = t_To;
+						}
+					}
+					m_VertTris[t_To].push_back(t);
+				}
+
+				m_Quadrics[ToGroup] += m_Quadrics[m_Group[t_From]];
+				m_BorderQuadrics[ToGroup] += m_BorderQuadrics[m_Group[t_From]];
+				m_Attributes[t_To] += m_Attributes[t_From];
+				m_VertDead[t_From] = true;
+				m_VertTris[t_From].clear();
+
+				// Keep the adjacency list from filling up with dead triangles
+				std::vector<uint32>& ToTris = m_VertTris[t_To];
+				ToTris.erase(std::remove_if(ToTris.begin(), ToTris.end(), [this](uint32 t_Tri) { return !IsTriAlive(t_Tri); }), ToTris.end());
+
+				QueueEdges(t_To, true);
+			}
+
+			void Simplifier::QueueEdges(uint32 t_Vert, bool t_bBothWays)
+			{
+				m_Neighbours.clear();
+				for (uint32 t : m_VertTris[t_Vert])
+				{
+					if (!IsTriAlive(t))
+					{
+						continue;
+					}
+
+					const uint32* Tri = &m_Tris[t * 3];
+					for (uint32 k = 0; k < 3; ++k)
+					{
+						if (Tri[k] != t_Vert && std::find(m_Neighbours.begin(), m_Neighbours.end(), Tri[k]) == m_Neighbours.end())
+						{
+							m_Neighbours.push_back(Tri[k]);
+						}
+					}
+				}
+
+				double PosError = 0.0;
+				for (uint32 Other : m_Neighbours)
+				{
+					Collapse Candidate;
+					if (EvaluateCollapse(t_Vert, Other, Candidate.Cost, PosError))
+					{
+						Candidate.From = t_Vert;
+						Candidate.To = Other;
+						m_Queue.push(Candidate);
+					}
+					if (t_bBothWays && EvaluateCollapse(Other, t_Vert, Candidate.Cost, PosError))
+					{
+						Candidate.From = Other;
+						Candidate.To = t_Vert;
+						m_Queue.push(Candidate);
+					}
+				}
+			}
+
+			void Simplifier::CollapseTo(size_t t_TargetIndexCount)
+			{
+				while (GetIndexCount() > t_TargetIndexCount && !m_Queue.empty())
+				{
+					const Collapse Next = m_Queue.top();
+					m_Queue.pop();
+
+					// Costs in the queue go out of date as the mesh changes, so check it again
+					double Cost = 0.0;
+					double PosError = 0.0;
+					if (!EvaluateCollapse(Next.From, Next.To, Cost, PosError))
+					{
+						continue;
+					}
+
+					if (Cost > Next.Cost * (1.0 + 1e-6) + 1e-12)
+					{
+						Collapse Updated = Next;
+						Updated.Cost = Cost;
+						m_Queue.push(Updated);
+						continue;
+					}
+
+					m_MaxPosError = std::max(m_MaxPosError, PosError);
+					PerformCollapse(Next.From, Next.To);
+				}
+			}
+
+			void Simplifier::AppendIndices(std::vector<uint32>& t_Out) const
+			{
+				t_Out.reserve(t_Out.size() + GetIndexCount());
+				for (uint32 t = 0; t < m_TriDead.size(); ++t)
+				{
+					if (IsTriAlive(t))
+					{
+						t_Out.insert(t_Out.end(), m_Tris.begin() + t * 3, m_Tris.begin() + t * 3 + 3);
+					}
+				}
+			}
+		}
+
+		float Simplify(const std::vector<Vertex>& t_Verts, const uint32* t_Indices, size_t t_NumIndices, size_t t_TargetIndexCount, std::vector<uint32>& t_Out)
+		{
+			t_Out.clear();
+			Simplifier Simp(t_Verts, t_Indices, t_NumIndices);
+			Simp.CollapseTo(t_TargetIndexCount);
+			Simp.AppendIndices(t_Out);
+			return Simp.GetError();
+		}
+
+		void BuildLodChain(const std::vector<Vertex>& t_Verts, std::vector<uint32>& t_Indices, std::vector<MeshLod>& t_OutLods, uint32 t_MaxLods, float t_Reduction)
+		{
+			t_OutLods.clear();
+
+			MeshLod FullDetail;
+			FullDetail.IndexCount = static_cast<uint32>(t_Indices.size());
+			t_OutLods.push_back(FullDetail);
+
+			if (t_MaxLods <= 1 || t_Indices.size() < MinLodIndexCount)
+			{
+				return;
+			}
+
+			// One run of the simplifier, taking a snapshot every time it gets to the next target
+			Simplifier Simp(t_Verts, t_Indices.data(), t_Indices.size());
+			while (t_OutLods.size() < t_MaxLods)
+			{
+				const MeshLod& Previous = t_OutLods.back();
+				const size_t Target = static_cast<size_t>(static_cast<float>(Previous.IndexCount / 3) * t_Reduction) * 3;
+				if (Target < MinLodIndexCount)
+				{
+					break;
+				}
+
+				Simp.CollapseTo(Target);
+				const size_t Count = Simp.GetIndexCount();
+				if (Count == 0 || static_cast<float>(Count) > static_cast<float>(Previous.IndexCount) * MinLodReduction)
+				{
+					break;
+				}
+
+				MeshLod Lod;
+				Lod.FirstIndex = static_cast<uint32>(t_Indices.size());
+				Lod.IndexCount = static_cast<uint32>(Count);
+				Lod.Error = Simp.GetError();
+				Simp.AppendIndices(t_Indices);
+				MeshOptimizer::OptimizeVertexCache(t_Indices.data() + Lod.FirstIndex, Lod.IndexCount, static_cast<uint32>(t_Verts.size()));
+				t_OutLods.push_back(Lod);
+			}
+		}
+	}
+}   // namespace Fling
@@ -0,0 +1,393 @@
+#include "pch.h"
+#include "Meshlets.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Fling
+{
+	namespace Meshlets
+	{
+		namespace
+		{
+			/** Normal cones wider than this (cos of the half angle) can hardly ever be culled, so don't try */
+			constexpr float MinConeCos = 0.1f;
+
+			/** How different the scale of each axis can be before the normal cones can't be trusted */
+			constexpr float UniformScaleTolerance = 0.01f;
+
+			/** Fill in the bounds and normal cone of a meshlet from its triangles */
+			void ComputeBounds(const std::vector<Vertex>& t_Verts, const uint32* t_Indices, Meshlet& t_Meshlet)
+			{
+				const uint32* Begin = t_Indices + t_Meshlet.FirstIndex;
+				const uint32* End = Begin + t_Meshlet.IndexCount;
+
+				glm::vec3 Min(std::numeric_limits<float>::max());
+				glm::vec3 Max(-std::numeric_limits<float>::max());
+				for (const uint32* Index = Begin; Index != End; ++Index)
+				{
+					Min = glm::min(Min, t_Verts[*Index].Pos);
+					Max = glm::max(Max, t_Verts[*Index].Pos);
+				}
+
+				t_Meshlet.Center = (Min + Max) * 0.5f;
+				float RadiusSq = 0.0f;
+				for (const uint32* Index = Begin; Index != End; ++Index)
+				{
+					const glm::vec3 Offset = t_Verts[*Index].Pos - t_Meshlet.Center;
+					RadiusSq = std::max(RadiusSq, glm::dot(Offset, Offset));
+				}
+				t_Meshlet.Radius = std::sqrt(RadiusSq);
+
+				// The cone goes down the average normal, and is as wide as the normal that is furthest from it
+				glm::vec3 NormalSum(0.0f);
+				for (const uint32* Tri = Begin; Tri != End; Tri += 3)
+				{
+					const glm::vec3& P0 = t_Verts[Tri[0]].Pos;
+					const glm::vec3 Cross = glm::cross(t_Verts[Tri[1]].Pos - P0, t_Verts[Tri[2]].Pos - P0);
+					const float Length = glm::length(Cross);
+					if (Length > 0.0f)
+					{
+						NormalSum += Cross / Length;
+					}
+				}
+
+				t_Meshlet.ConeApex = t_Meshlet.Center;
+				t_Meshlet.ConeAxis = glm::vec3(0.0f);
+				t_Meshlet.ConeCutoff = 1.0f;
+
+				const float SumLength = glm::length(NormalSum);
+				if (SumLength <= 0.0f)
+				{
+					return;
+				}
+
+				const glm::vec3 Axis = NormalSum / SumLength;
+				float MinCos = 1.0f;
+				for (const uint32* Tri = Begin; Tri != End; Tri += 3)
+				{
+					const glm::vec3& P0 = t_Verts[Tri[0]].Pos;
+					const glm::vec3 Cross = glm::cross(t_Verts[Tri[1]].Pos - P0, t_Verts[Tri[2]].Pos - P0);
+					const float Length = glm::length(Cross);
+					if (Length > 0.0f)
+					{
+						MinCos = std::min(MinCos, glm::dot(Cross / Length, Axis));
+					}
+				}
+
+				t_Meshlet.ConeAxis = Axis;
+				if (MinCos <= MinConeCos)
+				{
+					return;
+				}
+
+				// Move the apex back along the axis until it is behind the plane of every triangle, so
+				// that anything looking at the apex from outside the cone is behind all of them
+				float MaxT = 0.0f;
+				for (const uint32* Tri = Begin; Tri != End; Tri += 3)
+				{
+					const glm::vec3& P0 = t_Verts[Tri[0]].Pos;
+					const glm::vec3 Cross = glm::cross(t_Verts[Tri[1]].Pos - P0, t_Verts[Tri[2]].Pos - P0);
+					const float Length = glm::length(Cross);
+					if (Length > 0.0f)
+					{
+						const glm::vec3 Normal = Cross / Length;
+						const float T = glm::dot(t_Meshlet.Center - P0, Normal) / glm::dot(Normal, Axis);
+						MaxT = std::max(MaxT, T);
+					}
+				}
+
+				t_Meshlet.ConeApex = t_Meshlet.Center - Axis * MaxT;
+				t_Meshlet.ConeCutoff = std::sqrt(1.0f - MinCos * MinCos);
+			}
+		}
+
+		void Build(const std::vector<Vertex>& t_Verts, uint32* t_Indices, uint32 t_FirstIndex, uint32 t_IndexCount, std::vector<Meshlet>& t_Out, uint32 t_MaxVertices, uint32 t_MaxTriangles)
+		{
+			FLING_PROFILE_SCOPE("Meshlets::Build");
+
+			t_Out.clear();
+			const uint32 NumTris = t_IndexCount / 3;
+			if (NumTris == 0)
+			{
+				return;
+			}
+
+			const uint32* Indices = t_Indices + t_FirstIndex;
+
+			// Triangles are next to each other if they share a position, so flat shaded faces still join up
+			std::vector<uint32> Group(t_Verts.size());
+			uint32 NumGroups = 0;
+			{
+				std::unordered_map<glm::vec3, uint32> Groups;
+				Groups.reserve(t_Verts.size());
+				for (size_t v = 0; v < t_Verts.size(); ++v)
+				{
+					const auto Inserted = Groups.try_emplace(t_Verts[v].Pos, NumGroups);
+					NumGroups += Inserted.second ? 1 : 0;
+					Group[v] = Inserted.first->second;
+				}
+			}
+
+			// The triangles around each position, GroupTris[GroupStart[g]] to GroupTris[GroupStart[g + 1]]
+			std::vector<uint32> GroupStart(NumGroups + 1, 0);
+			for (uint32 i = 0; i < NumTris * 3; ++i)
+			{
+				++GroupStart[Group[Indices[i]] + 1];
+			}
+			for (uint32 g = 0; g < NumGroups; ++g)
+			{
+				GroupStart[g + 1] += GroupStart[g];
+			}
+			std::vector<uint32> GroupTris(NumTris * 3);
+			{
+				std::vector<uint32> Fill(GroupStart.begin(), GroupStart.end() - 1);
+				for (uint32 i = 0; i < NumTris * 3; ++i)
+				{
+					GroupTris[Fill[Group[Indices[i]]]++] = i / 3;
+				}
+			}
+
+			std::vector<glm::vec3> TriNormals(NumTris, glm::vec3(0.0f));
+			for (uint32 t = 0; t < NumTris; ++t)
+			{
+				const glm::vec3& P0 = t_Verts[Indices[t * 3]].Pos;
+				const glm::vec3 Cross = glm::cross(t_Verts[Indices[t * 3 + 1]].Pos - P0, t_Verts[Indices[t * 3 + 2]].Pos - P0);
+				const float Length = glm::length(Cross);
+				if (Length > 0.0f)
+				{
+					TriNormals[t] = Cross / Length;
+				}
+			}
+
+			// Which meshlet last used each vertex, so counting the vertices in one doesn't need a search
+			std::vector<uint32> LastMeshlet(t_Verts.size(), UINT32_MAX);
+			const auto CountNewVerts = [&](uint32 t_Tri, uint32 t_MeshletId)
+			{
+				const uint32* Tri = Indices + t_Tri * 3;
+				uint32 NewVerts = 0;
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					// A triangle can use the same vertex twice, only count it once
+					const bool bRepeat = (k > 0 && Tri[k] == Tri[0]) || (k > 1 && Tri[k] == Tri[1]);
+					NewVerts += (LastMeshlet[Tri[k]] != t_MeshletId && !bRepeat) ? 1 : 0;
+				}
+				return NewVerts;
+			};
+
+			std::vector<uint8> Used(NumTris, 0);
+			std::vector<uint32> Ordered;
+			Ordered.reserve(NumTris * 3);
+
+			// Unused triangles that touch the meshlet being built, and which meshlet each one was last a candidate of
+			std::vector<uint32> Candidates;
+			std::vector<uint32> CandidateOf(NumTris, UINT32_MAX);
+
+			Meshlet Current;
+			Current.FirstIndex = t_FirstIndex;
+			glm::vec3 NormalSum(0.0f);
+			uint32 MeshletId = 0;
+			uint32 NextUnused = 0;
+
+			for (uint32 Added = 0; Added < NumTris; ++Added)
+			{
+				// Grow into the triangle that needs the fewest new vertices, then the one that bends the normals the least
+				const float SumLength = glm::length(NormalSum);
+				const glm::vec3 Axis = SumLength > 0.0f ? NormalSum / SumLength : glm::vec3(0.0f);
+				uint32 Best = UINT32_MAX;
+				uint32 BestNewVerts = 0;
+				float BestSpread = 0.0f;
+				size_t Kept = 0;
+				for (size_t c = 0; c < Candidates.size(); ++c)
+				{
+					const uint32 Tri = Candidates[c];
+					if (Used[Tri])
+					{
+						continue;
+					}
+					Candidates[Kept++] = Tri;
+
+					const uint32 NewVerts = CountNewVerts(Tri, MeshletId);
+					const float Spread = 1.0f - glm::dot(TriNormals[Tri], Axis);
+					if (Current.VertexCount + NewVerts <= t_MaxVertices && (Best == UINT32_MAX || NewVerts < BestNewVerts || (NewVerts == BestNewVerts && Spread < BestSpread)))
+					{
+						Best = Tri;
+						BestNewVerts = NewVerts;
+						BestSpread = Spread;
+					}
+				}
+				Candidates.resize(Kept);
+
+				// Start a new meshlet once this one is full, or nothing next to it fits. Jumping somewhere else on
+				// the mesh would make its bounds and normal cone too big to ever cull
+				if (Current.IndexCount > 0 && (Current.IndexCount / 3 >= t_MaxTriangles || Best == UINT32_MAX))
+				{
+					t_Out.push_back(Current);
+					Current = Meshlet();
+					Current.FirstIndex = t_FirstIndex + static_cast<uint32>(Ordered.size());
+					NormalSum = glm::vec3(0.0f);
+					++MeshletId;
+
+					// Carry on from next to the last one so what is left of the mesh stays in one piece
+					Best = Candidates.empty() ? UINT32_MAX : Candidates.front();
+					Candidates.clear();
+				}
+
+				if (Best == UINT32_MAX)
+				{
+					while (Used[NextUnused])
+					{
+						++NextUnused;
+					}
+					Best = NextUnused;
+				}
+
+				const uint32* Tri = Indices + Best * 3;
+				Current.VertexCount += CountNewVerts(Best, MeshletId);
+				Current.IndexCount += 3;
+				NormalSum += TriNormals[Best];
+				Used[Best] = 1;
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					Ordered.push_back(Tri[k]);
+					LastMeshlet[Tri[k]] = MeshletId;
+
+					const uint32 G = Group[Tri[k]];
+					for (uint32 n = GroupStart[G]; n < GroupStart[G + 1]; ++n)
+					{
+						const uint32 Neighbour = GroupTris[n];
+						if (!Used[Neighbour] && CandidateOf[Neighbour] != MeshletId)
+						{
+							CandidateOf[Neighbour] = MeshletId;
+							Candidates.push_back(Neighbour);
+						}
+					}
+				}
+			}
+			t_Out.push_back(Current);
+
+			std::copy(Ordered.begin(), Ordered.end(), t_Indices + t_FirstIndex);
+
+			// Growing a meshlet doesn't care about the vertex cache, so put each one back in a good order.
+			// They are small enough to give their vertices local ids, which keeps the optimizer cheap
+			std::vector<uint32> LocalId(t_Verts.size(), UINT32_MAX);
+			std::vector<uint32> GlobalId;
+			std::vector<uint32> LocalIndices;
+			for (Meshlet& Cluster : t_Out)
+			{
+				uint32* ClusterIndices = t_Indices + Cluster.FirstIndex;
+				GlobalId.clear();
+				LocalIndices.resize(Cluster.IndexCount);
+				for (uint32 i = 0; i < Cluster.IndexCount; ++i)
+				{
+					uint32& Local = LocalId[ClusterIndices[i]];
+					if (Local == UINT32_MAX)
+					{
+						Local = static_cast<uint32>(GlobalId.size());
+						GlobalId.push_back(ClusterIndices[i]);
+					}
+					LocalIndices[i] = Local;
+				}
+
+				MeshOptimizer::OptimizeVertexCache(LocalIndices.data(), LocalIndices.size(), static_cast<uint32>(GlobalId.size()));
+				for (uint32 i = 0; i < Cluster.IndexCount; ++i)
+				{
+					ClusterIndices[i] = GlobalId[LocalIndices[i]];
+				}
+				for (uint32 Global : GlobalId)
+				{
+					LocalId[Global] = UINT32_MAX;
+				}
+
+				ComputeBounds(t_Verts, t_Indices, Cluster);
+			}
+		}
+
+		CullParams MakeCullParams(const glm::mat4& t_ViewProjection, const glm::mat4& t_World, const glm::vec3& t_CameraPos)
+		{
+			CullParams Params;
+
+			const glm::mat4 Combined = t_ViewProjection * t_World;
+			const auto Row = [&Combined](int t_Row) { return glm::vec4(Combined[0][t_Row], Combined[1][t_Row], Combined[2][t_Row], Combined[3][t_Row]); };
+			const glm::vec4 W = Row(3);
+			Params.Planes[0] = W + Row(0);	// Left
+			Params.Planes[1] = W - Row(0);	// Right
+			Params.Planes[2] = W + Row(1);	// Bottom
+			Params.Planes[3] = W - Row(1);	// Top
+			Params.Planes[4] = W + Row(2);	// Near
+			Params.Planes[5] = W - Row(2);	// Far
+			for (glm::vec4& Plane : Params.Planes)
+			{
+				const float Length = glm::length(glm::vec3(Plane));
+				if (Length > 0.0f)
+				{
+					Plane = Plane * (1.0f / Length);
+				}
+			}
+
+			Params.CameraPos = glm::vec3(glm::inverse(t_World) * glm::vec4(t_CameraPos, 1.0f));
+
+			// The cones are only right if the model keeps its angles and isn't turned inside out
+			const float ScaleX = glm::length(glm::vec3(t_World[0]));
+			const float ScaleY = glm::length(glm::vec3(t_World[1]));
+			const float ScaleZ = glm::length(glm::vec3(t_World[2]));
+			const float MaxScale = std::max(ScaleX, std::max(ScaleY, ScaleZ));
+			const float MinScale = std::min(ScaleX, std::min(ScaleY, ScaleZ));
+			Params.bConeCulling = MaxScale - MinScale <= MaxScale * UniformScaleTolerance && glm::determinant(glm::mat3(t_World)) > 0.0f;
+
+			return Params;
+		}
+
+		bool IsVisible(const Meshlet& t_Meshlet, const CullParams& t_Params)
+		{
+			for (const glm::vec4& Plane : t_Params.Planes)
+			{
+				if (glm::dot(glm::vec3(Plane), t_Meshlet.Center) + Plane.w < -t_Meshlet.Radius)
+				{
+					return false;
+				}
+			}
+
+			if (t_Params.bConeCulling && t_Meshlet.ConeCutoff < 1.0f)
+			{
+				const glm::vec3 ToApex = t_Meshlet.ConeApex - t_Params.CameraPos;
+				const float Distance = glm::length(ToApex);
+				if (Distance > 0.0f && glm::dot(ToApex, t_Meshlet.ConeAxis) >= t_Meshlet.ConeCutoff * Distance)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		uint32 Cull(const Meshlet* t_Meshlets, uint32 t_Count, const CullParams& t_Params, std::vector<DrawRange>& t_OutRanges)
+		{
+			t_OutRanges.clear();
+
+			uint32 Visible = 0;
+			for (uint32 i = 0; i < t_Count; ++i)
+			{
+				const Meshlet& Cluster = t_Meshlets[i];
+				if (!IsVisible(Cluster, t_Params))
+				{
+					continue;
+				}
+
+				++Visible;
+				if (!t_OutRanges.empty() && t_OutRanges.back().FirstIndex + t_OutRanges.back().IndexCount == Cluster.FirstIndex)
+				{
+					t_OutRanges.back().IndexCount += Cluster.IndexCount;
+				}
+				else
+				{
+					t_OutRanges.push_back({ Cluster.FirstIndex, Cluster.IndexCount });
+				}
+			}
+			return Visible;
+		}
+	}
+}   // namespace Fling
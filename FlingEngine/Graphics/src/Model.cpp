@@ -1,9 +1,11 @@
 #include "pch.h"
 #include "Model.h"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
 #include "ResourceManager.h"
+#include "Hash.h"
+#include "MeshOptimizer.h"
+#include "ObjImporter.h"
+#include "VertexPacking.h"
+#include "Misc/CommandLine.h"
 
 namespace Fling
 {
@@ -75,8 +77,28 @@ namespace Fling
 
 	Model::Model(Guid t_ID)
 		: Resource(t_ID)
+		, m_bLoadedFromFile(true)
+	{
+		if (LoadModel())
+		{
+			CreateBuffers();
+		}
+	}
+
+	Model::Model(Guid t_ID, AsyncLoad_t)
+		: Resource(t_ID)
+		, m_bLoadedFromFile(true)
 	{
-		LoadModel();
+		if (!LoadModel())
+		{
+			throw std::runtime_error("Failed to parse model");
+		}
+	}
+
+	bool Model::FinalizeAsyncLoad()
+	{
+		CreateBuffers();
+		return true;
 	}
 
 	Model::Model(Guid t_ID, std::vector<Vertex>& t_Verts, std::vector<uint32> t_Indecies)
@@ -84,94 +106,274 @@ namespace Fling
 	{
 		m_Verts = t_Verts;
 		m_Indices = t_Indecies;
+		m_Lods.resize(1);
+		m_Lods[0].IndexCount = static_cast<uint32>(m_Indices.size());
 
 		CalculateVertexTangents(m_Verts.data(), static_cast<uint32>(m_Verts.size()), m_Indices.data(), static_cast<uint32>(m_Indices.size()));
+		CalculateBounds();
 		CreateBuffers();
 	}
 
 	Model::~Model()
 	{
-		// #TODO Make the buffer allocations from a pool allocator instead of new's and deletes
 		delete m_VertexBuffer;
 		delete m_IndexBuffer;
 	}
 
-	void Model::LoadModel()
+	bool Model::LoadModel()
 	{
-		const std::string FilePath = GetFilepathReleativeToAssets();
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn;
-		std::string err;
+		// The source is only read if the cooked mesh is missing, or its size and modified time don't match
+		VfsFileInfo SourceInfo;
+		const bool bHasSource = ResourceManager::Get().GetFileSystem().GetFileInfo(GetGuidHandle(), GetGuidString(), SourceInfo);
+		const bool bCookMeshes = CommandLine::Get().GetValueAs<bool>("CookMeshes", true);
+		AssetData Source;
+		uint64 SourceHash = SourceInfo.Hash;
+
+		// Shipped builds might only have the cooked mesh, in which case it can't be stale
+		const std::string CookedPath = CookedMesh::GetCookedPath(GetGuidString());
+		AssetData CookedData;
+		if (ResourceManager::Get().ReadAsset(Guid{ CookedPath.c_str() }, CookedPath, CookedData) && m_Cooked.Load(std::move(CookedData)))
+		{
+			if (!bHasSource || (m_Cooked.IsCookedWith(GetImportSettingsHash()) && m_Cooked.IsCookedFromTime(SourceInfo.Size, SourceInfo.ModifiedTime)))
+			{
+				LoadCooked();
+				return true;
+			}
+
+			// The modified time changes without the contents changing (i.e. a fresh checkout), so check the hash.
+			// Archives know the hash of their files already, anything else has to be read
+			const bool bHashKnown = SourceHash != 0;
+			if (m_Cooked.IsCookedWith(GetImportSettingsHash()) && (bHashKnown || ReadSource(Source, SourceHash)) && m_Cooked.IsCookedFrom(SourceHash, SourceInfo.Size))
+			{
+				LoadCooked();
+
+				// Cook it again with the new modified time so the next load doesn't hash the source. The
+				// GPU buffers are made from the CPU copies instead of the cooked file that gets replaced
+				if (bCookMeshes && SourceInfo.ModifiedTime != 0 && Source.IsValid())
+				{
+					m_Cooked.Reset();
+					CookModel(CookedPath, SourceHash, Source.GetSize(), SourceInfo.ModifiedTime);
+				}
+				return true;
+			}
+
+			F_LOG_TRACE("Cooked mesh {} is out of date", CookedPath);
+			m_Cooked.Reset();
+		}
 
-		// Load the model from tiny obj
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, FilePath.c_str()))
+		if (!bHasSource || !ReadSource(Source, SourceHash))
 		{
-			F_LOG_ERROR("Failed to load model: {} {}", warn, err);
-			
-			return;
+			F_LOG_ERROR("Failed to load model: {}", GetGuidString());
+			return false;
 		}
 
-		// Parse all shapes to get the verts and indecies of this object
-		for (const tinyobj::shape_t& shape : shapes)
+		if (!ImportModel(Source))
 		{
-			for (const tinyobj::index_t& index : shape.mesh.indices) 
-			{
-				Vertex vertex = {};
-				vertex.Pos = 
-				{
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2]
-				};
+			return false;
+		}
 
-				vertex.Normal = 
-				{
-					attrib.normals[3 * index.normal_index + 0],
-					attrib.normals[3 * index.normal_index + 1],
-					attrib.normals[3 * index.normal_index + 2]
-				};
+		if (bCookMeshes)
+		{
+			CookModel(CookedPath, SourceHash, Source.GetSize(), SourceInfo.ModifiedTime);
+		}
+		return true;
+	}
 
-				vertex.TexCoord = 
-				{
-					attrib.texcoords[2 * index.texcoord_index + 0],
-					attrib.texcoords[2 * index.texcoord_index + 1]
-				};
+	bool Model::ReadSource(AssetData& t_Source, uint64& t_SourceHash) const
+	{
+		if (t_Source.IsValid())
+		{
+			return true;
+		}
 
-				vertex.Color = { 1.0f, 1.0f, 1.0f };
+		if (!ReadAsset(t_Source))
+		{
+			return false;
+		}
 
-				m_Verts.push_back(vertex);
-				m_Indices.push_back(m_Indices.size());
-			}
+		// Archives already know the hash of what they hold
+		if (t_SourceHash == 0)
+		{
+			t_SourceHash = HashBytes64(t_Source.GetData(), t_Source.GetSize());
 		}
+		return true;
+	}
+
+	void Model::LoadCooked()
+	{
+		// The GPU buffers are uploaded straight from the mapped file, these are just the CPU copies
+		m_Verts.assign(m_Cooked.GetVerts(), m_Cooked.GetVerts() + m_Cooked.GetVertexCount());
+		m_Indices.assign(m_Cooked.GetIndices(), m_Cooked.GetIndices() + m_Cooked.GetIndexCount());
+		m_Lods.assign(m_Cooked.GetLods(), m_Cooked.GetLods() + m_Cooked.GetLodCount());
+		m_Meshlets.assign(m_Cooked.GetMeshlets(), m_Cooked.GetMeshlets() + m_Cooked.GetMeshletCount());
+		m_BoundsCenter = m_Cooked.GetBoundsCenter();
+		m_BoundsRadius = m_Cooked.GetBoundsRadius();
+	}
+
+	void Model::CookModel(const std::string& t_CookedPath, uint64 t_SourceHash, uint64 t_SourceSize, uint64 t_SourceModifiedTime) const
+	{
+		const std::vector<char> Cooked = CookedMesh::Cook(
+			m_Verts.data(), GetVertexCount(),
+			m_Indices.data(), static_cast<uint32>(m_Indices.size()),
+			m_Lods.data(), GetLodCount(),
+			m_Meshlets.data(), GetMeshletCount(),
+			m_BoundsCenter, m_BoundsRadius,
+			t_SourceHash, t_SourceSize, GetImportSettingsHash(), t_SourceModifiedTime);
+
+		if (CookedMesh::Write(FlingPaths::EngineAssetsDir() + "/" + t_CookedPath, Cooked))
+		{
+			ResourceManager::Get().GetFileSystem().RefreshPath(t_CookedPath);
+			F_LOG_TRACE("Cooked mesh {}", t_CookedPath);
+		}
+	}
+
+	uint32 Model::GetMaxLods()
+	{
+		return static_cast<uint32>(std::max(CommandLine::Get().GetValueAs<int32>("MeshLods", static_cast<int32>(MeshSimplifier::DefaultMaxLods)), 1));
+	}
+
+	uint64 Model::GetImportSettingsHash()
+	{
+		const uint32 MaxLods = GetMaxLods();
+		const float LodReduction = MeshSimplifier::DefaultLodReduction;
+		uint64 Hash = HashBytes64(&MaxLods, sizeof(MaxLods));
+		Hash = HashBytes64(&LodReduction, sizeof(LodReduction), Hash);
+		return Hash;
+	}
+
+	bool Model::ImportModel(const AssetData& t_Source)
+	{
+		std::string Error;
+		// Parse straight into the model's own storage, only the temporary arrays use the import arena
+		if (!ObjImporter::Import(t_Source.GetView(), m_Verts, m_Indices, Error, ObjImporter::DefaultChunkSize, &ResourceManager::Get().GetImportArena()))
+		{
+			F_LOG_ERROR("Failed to load model {}: {}", GetGuidString(), Error);
+			return false;
+		}
+
+		// Every OBJ index made its own vertex, so share the ones that are the same. This happens before
+		// the tangents are calculated so that shared vertices get the tangents of every triangle they are in
+		const uint32 ImportedVertCount = GetVertexCount();
+		const MeshOptimizer::VertexCacheStats Before = MeshOptimizer::AnalyzeVertexCache(m_Indices.data(), m_Indices.size(), ImportedVertCount);
+		MeshOptimizer::WeldVertices(m_Verts, m_Indices);
 
 		// Calculate our tangent vectors for this model
 		CalculateVertexTangents(m_Verts.data(), static_cast<uint32>(m_Verts.size()), m_Indices.data(), static_cast<uint32>(m_Indices.size()));
+		CalculateBounds();
 
-		CreateBuffers();
+		MeshOptimizer::OptimizeVertexCache(m_Indices.data(), m_Indices.size(), GetVertexCount());
+
+		// The LODs keep the triangles of the full detail mesh in the same order, and only use its vertices,
+		// so the fetch order that suits the full detail mesh suits them too
+		MeshSimplifier::BuildLodChain(m_Verts, m_Indices, m_Lods, GetMaxLods());
+
+		// Meshlets put the full detail triangles in meshlet order, which keeps neighbours together for the vertex cache too
+		Meshlets::Build(m_Verts, m_Indices.data(), m_Lods[0].FirstIndex, m_Lods[0].IndexCount, m_Meshlets);
+		MeshOptimizer::OptimizeVertexFetch(m_Verts, m_Indices);
+
+		const MeshOptimizer::VertexCacheStats After = MeshOptimizer::AnalyzeVertexCache(m_Indices.data(), GetIndexCount(), GetVertexCount());
+		F_LOG_TRACE("Optimized {}: {} -> {} verts, ACMR {:.3f} -> {:.3f}, ATVR {:.3f}, {} meshlets",
+			GetGuidString(), ImportedVertCount, GetVertexCount(), Before.ACMR, After.ACMR, After.ATVR, GetMeshletCount());
+		for (uint32 i = 1; i < GetLodCount(); ++i)
+		{
+			F_LOG_TRACE("{} LOD {}: {} triangles, error {}", GetGuidString(), i, m_Lods[i].IndexCount / 3, m_Lods[i].Error);
+		}
+
+		return true;
 	}
 
 	void Model::CreateBuffers()
 	{
+		// Cooked meshes are copied into the staging buffers right out of the mapped file
+		const bool bFromCooked = m_Cooked.IsLoaded();
+		const Vertex* SourceVerts = bFromCooked ? m_Cooked.GetVerts() : m_Verts.data();
+		const uint32* SourceIndices = bFromCooked ? m_Cooked.GetIndices() : m_Indices.data();
+		const void* VertData = SourceVerts;
+		const void* IndexData = SourceIndices;
+		VkDeviceSize VertBufferSize = sizeof(Vertex) * m_Verts.size();
+		VkDeviceSize IndexBufferSize = sizeof(uint32) * m_Indices.size();
+
+		// The mesh pipeline decodes packed vertices with this model's position offset and scale
+		std::vector<PackedVertex> PackedVerts;
+		if (VertexPacking::UseCompactVertices())
+		{
+			m_VertexLayout = VertexLayout::Packed;
+			VertexPacking::GetPositionTransform(SourceVerts, GetVertexCount(), m_PositionOffset, m_PositionScale);
+			PackedVerts.resize(m_Verts.size());
+			VertexPacking::Pack(SourceVerts, GetVertexCount(), m_PositionOffset, m_PositionScale, PackedVerts.data());
+			VertData = PackedVerts.data();
+			VertBufferSize = sizeof(PackedVertex) * PackedVerts.size();
+		}
+
+		// Half the index memory and bandwidth for any mesh small enough
+		std::vector<uint16> ShortIndices;
+		if (GetVertexCount() <= VertexPacking::MaxVertsFor16BitIndices)
+		{
+			m_IndexType = VK_INDEX_TYPE_UINT16;
+			ShortIndices.resize(m_Indices.size());
+			VertexPacking::PackIndices16(SourceIndices, m_Indices.size(), ShortIndices.data());
+			IndexData = ShortIndices.data();
+			IndexBufferSize = sizeof(uint16) * ShortIndices.size();
+		}
+
 		// Create vertex buffer
-		VkDeviceSize VertBufferSize = sizeof(m_Verts[0]) * m_Verts.size();
 		// We use a staging buffer to get to a more optimial memory layout for the GPU
-		Buffer VertexStagingBuffer(VertBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Verts.data());
+		Buffer VertexStagingBuffer(VertBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VertData);
 		m_VertexBuffer = new Buffer(VertBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 		Buffer::CopyBuffer(&VertexStagingBuffer, m_VertexBuffer, VertBufferSize);
 
 		// Create Index buffer
-		VkDeviceSize IndexBufferSize = sizeof(m_Indices[0]) * GetIndexCount();
-		Buffer IndexStagingBuffer(IndexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Indices.data());
+		Buffer IndexStagingBuffer(IndexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, IndexData);
 		m_IndexBuffer = new Buffer(IndexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 		Buffer::CopyBuffer(&IndexStagingBuffer, m_IndexBuffer, IndexBufferSize);
+
+		// Done with the file now that it's on the GPU
+		m_Cooked.Reset();
+	}
+
+	ResourceMemoryUsage Model::GetMemoryUsage() const
+	{
+		ResourceMemoryUsage Usage;
+		Usage[ResourceMemoryType::Mesh] =
+			(m_VertexBuffer ? static_cast<uint64>(m_VertexBuffer->GetSize()) : 0) +
+			(m_IndexBuffer ? static_cast<uint64>(m_IndexBuffer->GetSize()) : 0);
+		Usage[ResourceMemoryType::CPU] = m_Verts.capacity() * sizeof(Vertex) + m_Indices.capacity() * sizeof(uint32) +
+			m_Lods.capacity() * sizeof(MeshLod) + m_Meshlets.capacity() * sizeof(Meshlet);
+		return Usage;
+	}
+
+	void Model::CalculateBounds()
+	{
+		if (m_Verts.empty())
+		{
+			m_BoundsCenter = glm::vec3(0.0f);
+			m_BoundsRadius = 0.0f;
+			return;
+		}
+
+		glm::vec3 Min = m_Verts[0].Pos;
+		glm::vec3 Max = m_Verts[0].Pos;
+		for (const Vertex& Vert : m_Verts)
+		{
+			Min = glm::min(Min, Vert.Pos);
+			Max = glm::max(Max, Vert.Pos);
+		}
+
+		m_BoundsCenter = (Min + Max) * 0.5f;
+
+		float RadiusSq = 0.0f;
+		for (const Vertex& Vert : m_Verts)
+		{
+			const glm::vec3 Offset = Vert.Pos - m_BoundsCenter;
+			RadiusSq = std::max(RadiusSq, glm::dot(Offset, Offset));
+		}
+		m_BoundsRadius = std::sqrt(RadiusSq);
 	}
 
 	void Model::CalculateVertexTangents(Vertex* verts, uint32 numVerts, uint32* indices, uint32 numIndices)
 	{
 		// Calculate tangents one whole triangle at a time
-		for ( size_t i = 0; i < numVerts;)
+		for ( size_t i = 0; i + 2 < numIndices;)
 		{
 			// Grab indices and vertices of first triangle
 			uint32 i1 = indices [ i++ ];
@@ -0,0 +1,598 @@
+#include "pch.h"
+#include "ObjImporter.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "VirtualArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
+
+namespace Fling
+{
+	namespace ObjImporter
+	{
+		namespace
+		{
+			/** Triangle corners handed to each job when building vertices */
+			constexpr uint32 CornersPerJob = 16 * 1024;
+
+			/** More digits than this don't fit in the mantissa, and don't change a float anyway */
+			constexpr uint32 MaxSignificantDigits = 19;
+
+			/** Big enough to tell that an index doesn't fit in an int32 */
+			constexpr int64 MaxIndex = static_cast<int64>(std::numeric_limits<int32>::max()) + 1;
+
+			constexpr double Pow10[] =
+			{
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+			};
+
+			/** Where a triangle corner's attributes are in the shared arrays, -1 if it doesn't have one */
+			struct Corner
+			{
+				int32 Pos = -1;
+				int32 Tex = -1;
+				int32 Normal = -1;
+			};
+
+			enum class LineType : uint8
+			{
+				Other,
+				Position,
+				TexCoord,
+				Normal,
+				Face
+			};
+
+			enum Attribute : uint8
+			{
+				Attribute_Position,
+				Attribute_TexCoord,
+				Attribute_Normal,
+				Attribute_Count
+			};
+
+			/** One line aligned piece of the file */
+			struct Chunk
+			{
+				const char* Begin = nullptr;
+				const char* End = nullptr;
+
+				/** How many of each attribute are in this chunk, from the first pass */
+				uint32 Counts[Attribute_Count] = {};
+				uint32 NumCorners = 0;
+
+				/** Where this chunk's data starts in the shared arrays */
+				uint32 Bases[Attribute_Count] = {};
+				uint32 CornerBase = 0;
+
+				/** The first line that couldn't be parsed, if there is one */
+				const char* ErrorLine = nullptr;
+				const char* ErrorReason = nullptr;
+			};
+
+			inline bool IsSpace(char t_Char)
+			{
+				return t_Char == ' ' || t_Char == '\t' || t_Char == '\r';
+			}
+
+			inline bool IsDigit(char t_Char)
+			{
+				return static_cast<unsigned char>(t_Char - '0') < 10;
+			}
+
+			inline const char* SkipSpaces(const char* t_Cursor, const char* t_End)
+			{
+				while (t_Cursor < t_End && IsSpace(*t_Cursor))
+				{
+					++t_Cursor;
+				}
+				return t_Cursor;
+			}
+
+			inline const char* FindLineEnd(const char* t_Cursor, const char* t_End)
+			{
+				const void* NewLine = std::memchr(t_Cursor, '\n', static_cast<size_t>(t_End - t_Cursor));
+				return NewLine ? static_cast<const char*>(NewLine) : t_End;
+			}
+
+			/** Start of the line after the one that ends at t_LineEnd */
+			inline const char* NextLine(const char* t_LineEnd, const char* t_End)
+			{
+				return t_LineEnd < t_End ? t_LineEnd + 1 : t_End;
+			}
+
+			/** Work out what a line holds and move t_Cursor past its keyword */
+			LineType ClassifyLine(const char*& t_Cursor, const char* t_End)
+			{
+				const char* Cursor = SkipSpaces(t_Cursor, t_End);
+				const ptrdiff_t Length = t_End - Cursor;
+				if (Length < 2)
+				{
+					return LineType::Other;
+				}
+
+				LineType Type = LineType::Other;
+				ptrdiff_t KeywordLength = 1;
+				if (Cursor[0] == 'v')
+				{
+					if (IsSpace(Cursor[1]))
+					{
+						Type = LineType::Position;
+					}
+					else if (Length > 2 && IsSpace(Cursor[2]) && (Cursor[1] == 't' || Cursor[1] == 'n'))
+					{
+						Type = Cursor[1] == 't' ? LineType::TexCoord : LineType::Normal;
+						KeywordLength = 2;
+					}
+				}
+				else if (Cursor[0] == 'f' && IsSpace(Cursor[1]))
+				{
+					Type = LineType::Face;
+				}
+
+				t_Cursor = Cursor + KeywordLength;
+				return Type;
+			}
+
+			/** Count the "v/vt/vn" groups on a face line */
+			uint32 CountFaceCorners(const char* t_Cursor, const char* t_End)
+			{
+				uint32 Count = 0;
+				while (true)
+				{
+					t_Cursor = SkipSpaces(t_Cursor, t_End);
+					if (t_Cursor >= t_End || *t_Cursor == '#')
+					{
+						return Count;
+					}
+
+					++Count;
+					while (t_Cursor < t_End && !IsSpace(*t_Cursor))
+					{
+						++t_Cursor;
+					}
+				}
+			}
+
+			const char* ParseInt(const char* t_Cursor, const char* t_End, int64& t_Out)
+			{
+				bool bNegative = false;
+				if (t_Cursor < t_End && (*t_Cursor == '-' || *t_Cursor == '+'))
+				{
+					bNegative = *t_Cursor == '-';
+					++t_Cursor;
+				}
+
+				if (t_Cursor >= t_End || !IsDigit(*t_Cursor))
+				{
+					return nullptr;
+				}
+
+				int64 Value = 0;
+				for (; t_Cursor < t_End && IsDigit(*t_Cursor); ++t_Cursor)
+				{
+					Value = std::min(Value * 10 + (*t_Cursor - '0'), MaxIndex);
+				}
+
+				t_Out = bNegative ? -Value : Value;
+				return t_Cursor;
+			}
+
+			/**
+			 * Turn an OBJ index into an index into the shared array. Positive ones count from 1 at the
+			 * start of the file, negative ones count back from the last one defined before this line.
+			 *
+			 * @param t_NumDefined	How many have been defined before this line
+			 * @return -1 if it is 0 or before the start of the file
+			 */
+			inline int32 ResolveIndex(int64 t_Raw, uint32 t_NumDefined)
+			{
+				const int64 Index = t_Raw > 0 ? t_Raw - 1 : static_cast<int64>(t_NumDefined) + t_Raw;
+				return (t_Raw == 0 || Index < 0 || Index >= MaxIndex - 1) ? -1 : static_cast<int32>(Index);
+			}
+
+			/** Parse one "v", "v/vt", "v//vn" or "v/vt/vn" group */
+			const char* ParseCorner(const char* t_Cursor, const char* t_End, const uint32* t_NumDefined, Corner& t_Out)
+			{
+				int64 Raw[Attribute_Count] = {};
+
+				t_Cursor = ParseInt(t_Cursor, t_End, Raw[Attribute_Position]);
+				if (!t_Cursor)
+				{
+					return nullptr;
+				}
+
+				if (t_Cursor < t_End && *t_Cursor == '/')
+				{
+					++t_Cursor;
+					if (t_Cursor < t_End && *t_Cursor != '/')
+					{
+						t_Cursor = ParseInt(t_Cursor, t_End, Raw[Attribute_TexCoord]);
+						if (!t_Cursor)
+						{
+							return nullptr;
+						}
+					}
+
+					if (t_Cursor < t_End && *t_Cursor == '/')
+					{
+						t_Cursor = ParseInt(t_Cursor + 1, t_End, Raw[Attribute_Normal]);
+						if (!t_Cursor)
+						{
+							return nullptr;
+						}
+					}
+				}
+
+				if (t_Cursor < t_End && !IsSpace(*t_Cursor))
+				{
+					return nullptr;
+				}
+
+				t_Out.Pos = ResolveIndex(Raw[Attribute_Position], t_NumDefined[Attribute_Position]);
+				t_Out.Tex = Raw[Attribute_TexCoord] ? ResolveIndex(Raw[Attribute_TexCoord], t_NumDefined[Attribute_TexCoord]) : -1;
+				t_Out.Normal = Raw[Attribute_Normal] ? ResolveIndex(Raw[Attribute_Normal], t_NumDefined[Attribute_Normal]) : -1;
+				return t_Out.Pos < 0 ? nullptr : t_Cursor;
+			}
+
+			/** First pass, count everything in a chunk so that we know where its data goes */
+			void CountChunk(Chunk& t_Chunk)
+			{
+				for (const char* Line = t_Chunk.Begin; Line < t_Chunk.End;)
+				{
+					const char* LineEnd = FindLineEnd(Line, t_Chunk.End);
+					const char* Cursor = Line;
+
+					switch (ClassifyLine(Cursor, LineEnd))
+					{
+					case LineType::Position: ++t_Chunk.Counts[Attribute_Position]; break;
+					case LineType::TexCoord: ++t_Chunk.Counts[Attribute_TexCoord]; break;
+					case LineType::Normal: ++t_Chunk.Counts[Attribute_Normal]; break;
+					case LineType::Face:
+					{
+						const uint32 NumCorners = CountFaceCorners(Cursor, LineEnd);
+						t_Chunk.NumCorners += NumCorners >= 3 ? (NumCorners - 2) * 3 : 0;
+						break;
+					}
+					default: break;
+					}
+
+					Line = NextLine(LineEnd, t_Chunk.End);
+				}
+			}
+
+			/** The arrays that every chunk parses into, sized from the counts in the scratch arena */
+			struct SharedArrays
+			{
+				glm::vec3* Positions = nullptr;
+				glm::vec2* TexCoords = nullptr;
+				glm::vec3* Normals = nullptr;
+				Corner* Corners = nullptr;
+			};
+
+			/** Second pass, parse a chunk into its slice of the shared arrays */
+			void ParseChunk(Chunk& t_Chunk, SharedArrays& t_Arrays)
+			{
+				uint32 Parsed[Attribute_Count] = {};
+				uint32 NumCorners = 0;
+
+				const auto Fail = [&t_Chunk](const char* t_Line, const char* t_Reason)
+				{
+					t_Chunk.ErrorLine = t_Line;
+					t_Chunk.ErrorReason = t_Reason;
+				};
+
+				for (const char* Line = t_Chunk.Begin; Line < t_Chunk.End;)
+				{
+					const char* LineEnd = FindLineEnd(Line, t_Chunk.End);
+					const char* Cursor = Line;
+
+					switch (ClassifyLine(Cursor, LineEnd))
+					{
+					case LineType::Position:
+					{
+						glm::vec3& Pos = t_Arrays.Positions[t_Chunk.Bases[Attribute_Position] + Parsed[Attribute_Position]++];
+						if (!(Cursor = ParseFloat(Cursor, LineEnd, Pos.x)) || !(Cursor = ParseFloat(Cursor, LineEnd, Pos.y)) || !ParseFloat(Cursor, LineEnd, Pos.z))
+						{
+							return Fail(Line, "bad vertex position");
+						}
+						break;
+					}
+					case LineType::TexCoord:
+					{
+						// The v coordinate is optional
+						glm::vec2& TexCoord = t_Arrays.TexCoords[t_Chunk.Bases[Attribute_TexCoord] + Parsed[Attribute_TexCoord]++];
+						if (!(Cursor = ParseFloat(Cursor, LineEnd, TexCoord.x)))
+						{
+							return Fail(Line, "bad texture coordinate");
+						}
+						if (!ParseFloat(Cursor, LineEnd, TexCoord.y))
+						{
+							TexCoord.y = 0.0f;
+						}
+						break;
+					}
+					case LineType::Normal:
+					{
+						glm::vec3& Normal = t_Arrays.Normals[t_Chunk.Bases[Attribute_Normal] + Parsed[Attribute_Normal]++];
+						if (!(Cursor = ParseFloat(Cursor, LineEnd, Normal.x)) || !(Cursor = ParseFloat(Cursor, LineEnd, Normal.y)) || !ParseFloat(Cursor, LineEnd, Normal.z))
+						{
+							return Fail(Line, "bad vertex normal");
+						}
+						break;
+					}
+					case LineType::Face:
+					{
+						uint32 Defined[Attribute_Count];
+						for (uint32 a = 0; a < Attribute_Count; ++a)
+						{
+							Defined[a] = t_Chunk.Bases[a] + Parsed[a];
+						}
+
+						// Fan the polygon out from its first corner
+						Corner First;
+						Corner Previous;
+						uint32 NumFaceCorners = 0;
+						while (true)
+						{
+							Cursor = SkipSpaces(Cursor, LineEnd);
+							if (Cursor >= LineEnd || *Cursor == '#')
+							{
+								break;
+							}
+
+							Corner Current;
+							if (!(Cursor = ParseCorner(Cursor, LineEnd, Defined, Current)))
+							{
+								return Fail(Line, "bad face");
+							}
+
+							if (NumFaceCorners == 0)
+							{
+								First = Current;
+							}
+							else if (NumFaceCorners >= 2)
+							{
+								Corner* Out = t_Arrays.Corners + t_Chunk.CornerBase + NumCorners;
+								Out[0] = First;
+								Out[1] = Previous;
+								Out[2] = Current;
+								NumCorners += 3;
+							}
+
+							Previous = Current;
+							++NumFaceCorners;
+						}
+						break;
+					}
+					default: break;
+					}
+
+					Line = NextLine(LineEnd, t_Chunk.End);
+				}
+			}
+		}
+
+		const char* ParseFloat(const char* t_Begin, const char* t_End, float& t_Out)
+		{
+			const char* Cursor = SkipSpaces(t_Begin, t_End);
+
+			bool bNegative = false;
+			if (Cursor < t_End && (*Cursor == '-' || *Cursor == '+'))
+			{
+				bNegative = *Cursor == '-';
+				++Cursor;
+			}
+
+			uint64 Mantissa = 0;
+			int32 Exponent = 0;
+			uint32 SignificantDigits = 0;
+			bool bAnyDigits = false;
+
+			for (; Cursor < t_End && IsDigit(*Cursor); ++Cursor)
+			{
+				bAnyDigits = true;
+				if (SignificantDigits < MaxSignificantDigits)
+				{
+					Mantissa = Mantissa * 10 + static_cast<uint64>(*Cursor - '0');
+					SignificantDigits += Mantissa != 0;
+				}
+				else
+				{
+					++Exponent;
+				}
+			}
+
+			if (Cursor < t_End && *Cursor == '.')
+			{
+				for (++Cursor; Cursor < t_End && IsDigit(*Cursor); ++Cursor)
+				{
+					bAnyDigits = true;
+					if (SignificantDigits < MaxSignificantDigits)
+					{
+						Mantissa = Mantissa * 10 + static_cast<uint64>(*Cursor - '0');
+						SignificantDigits += Mantissa != 0;
+						--Exponent;
+					}
+				}
+			}
+
+			if (!bAnyDigits)
+			{
+				return nullptr;
+			}
+
+			// Only take the exponent if there are digits after the 'e'
+			if (Cursor < t_End && (*Cursor == 'e' || *Cursor == 'E'))
+			{
+				const char* ExpCursor = Cursor + 1;
+				bool bNegativeExp = false;
+				if (ExpCursor < t_End && (*ExpCursor == '-' || *ExpCursor == '+'))
+				{
+					bNegativeExp = *ExpCursor == '-';
+					++ExpCursor;
+				}
+
+				if (ExpCursor < t_End && IsDigit(*ExpCursor))
+				{
+					int32 Exp = 0;
+					for (; ExpCursor < t_End && IsDigit(*ExpCursor); ++ExpCursor)
+					{
+						Exp = std::min(Exp * 10 + (*ExpCursor - '0'), 100000);
+					}
+					Exponent += bNegativeExp ? -Exp : Exp;
+					Cursor = ExpCursor;
+				}
+			}
+
+			double Value = static_cast<double>(Mantissa);
+			if (Mantissa != 0 && Exponent != 0)
+			{
+				// Powers of 10 up to 22 are exact in a double, so the common case is a single rounding
+				if (Exponent > 0 && Exponent <= 22)
+				{
+					Value *= Pow10[Exponent];
+				}
+				else if (Exponent < 0 && Exponent >= -22)
+				{
+					Value /= Pow10[-Exponent];
+				}
+				else
+				{
+					Value *= std::pow(10.0, static_cast<double>(Exponent));
+				}
+			}
+
+			t_Out = static_cast<float>(bNegative ? -Value : Value);
+			return Cursor;
+		}
+
+		bool Import(std::string_view t_Text, std::vector<Vertex>& t_OutVerts, std::vector<uint32>& t_OutIndices, std::string& t_OutError, size_t t_ChunkSize, VirtualArena* t_ScratchArena)
+		{
+			FLING_PROFILE_SCOPE("ObjImporter::Import");
+
+			const char* const TextBegin = t_Text.data();
+			const char* const TextEnd = TextBegin + t_Text.size();
+
+			// Split the file up at the first new line after every t_ChunkSize bytes
+			std::vector<Chunk> Chunks;
+			Chunks.reserve(t_Text.size() / std::max<size_t>(t_ChunkSize, 1) + 1);
+			for (const char* Cursor = TextBegin; Cursor < TextEnd;)
+			{
+				Chunk& NewChunk = Chunks.emplace_back();
+				NewChunk.Begin = Cursor;
+
+				const char* SplitAt = static_cast<size_t>(TextEnd - Cursor) > t_ChunkSize ? Cursor + t_ChunkSize : TextEnd;
+				NewChunk.End = NextLine(FindLineEnd(SplitAt, TextEnd), TextEnd);
+				Cursor = NewChunk.End;
+			}
+
+			const uint32 NumChunks = static_cast<uint32>(Chunks.size());
+			JobSystem::Get().ParallelFor(NumChunks, 1, [&Chunks](uint32 t_Begin, uint32 t_End)
+			{
+				for (uint32 i = t_Begin; i < t_End; ++i)
+				{
+					CountChunk(Chunks[i]);
+				}
+			});
+
+			uint32 Totals[Attribute_Count] = {};
+			uint32 TotalCorners = 0;
+			for (Chunk& CurChunk : Chunks)
+			{
+				for (uint32 a = 0; a < Attribute_Count; ++a)
+				{
+					CurChunk.Bases[a] = Totals[a];
+					Totals[a] += CurChunk.Counts[a];
+				}
+				CurChunk.CornerBase = TotalCorners;
+				TotalCorners += CurChunk.NumCorners;
+			}
+
+			// Everything but the vertices and indices is thrown away at the end, so it goes in the scratch arena
+			const size_t ScratchSize =
+				sizeof(glm::vec3) * (Totals[Attribute_Position] + Totals[Attribute_Normal]) +
+				sizeof(glm::vec2) * Totals[Attribute_TexCoord] +
+				sizeof(Corner) * TotalCorners +
+				4 * alignof(std::max_align_t);
+			std::unique_ptr<VirtualArena> OwnedArena;
+			if (t_ScratchArena == nullptr)
+			{
+				OwnedArena = std::make_unique<VirtualArena>(ScratchSize);
+				t_ScratchArena = OwnedArena.get();
+			}
+			VirtualArena::Scope ScratchScope(*t_ScratchArena);
+
+			SharedArrays Arrays;
+			Arrays.Positions = t_ScratchArena->AllocateArray<glm::vec3>(Totals[Attribute_Position]);
+			Arrays.TexCoords = t_ScratchArena->AllocateArray<glm::vec2>(Totals[Attribute_TexCoord]);
+			Arrays.Normals = t_ScratchArena->AllocateArray<glm::vec3>(Totals[Attribute_Normal]);
+			Arrays.Corners = t_ScratchArena->AllocateArray<Corner>(TotalCorners);
+			if (!Arrays.Positions || !Arrays.TexCoords || !Arrays.Normals || !Arrays.Corners)
+			{
+				t_OutError = "the import arena is too small";
+				return false;
+			}
+
+			JobSystem::Get().ParallelFor(NumChunks, 1, [&Chunks, &Arrays](uint32 t_Begin, uint32 t_End)
+			{
+				for (uint32 i = t_Begin; i < t_End; ++i)
+				{
+					ParseChunk(Chunks[i], Arrays);
+				}
+			});
+
+			for (const Chunk& CurChunk : Chunks)
+			{
+				if (CurChunk.ErrorLine)
+				{
+					const size_t LineNumber = std::count(TextBegin, CurChunk.ErrorLine, '\n') + 1;
+					t_OutError = std::string(CurChunk.ErrorReason) + " on line " + std::to_string(LineNumber);
+					return false;
+				}
+			}
+
+			t_OutVerts.resize(TotalCorners);
+			std::atomic<bool> bBadIndex { false };
+			JobSystem::Get().ParallelFor(TotalCorners, CornersPerJob, [&](uint32 t_Begin, uint32 t_End)
+			{
+				for (uint32 i = t_Begin; i < t_End; ++i)
+				{
+					const Corner& Src = Arrays.Corners[i];
+					if (static_cast<uint32>(Src.Pos) >= Totals[Attribute_Position] ||
+						(Src.Tex >= 0 && static_cast<uint32>(Src.Tex) >= Totals[Attribute_TexCoord]) ||
+						(Src.Normal >= 0 && static_cast<uint32>(Src.Normal) >= Totals[Attribute_Normal]))
+					{
+						bBadIndex.store(true, std::memory_order_relaxed);
+						continue;
+					}
+
+					Vertex& Vert = t_OutVerts[i];
+					Vert = {};
+					Vert.Pos = Arrays.Positions[Src.Pos];
+					Vert.Normal = Src.Normal >= 0 ? Arrays.Normals[Src.Normal] : glm::vec3(0.0f);
+					Vert.TexCoord = Src.Tex >= 0 ? Arrays.TexCoords[Src.Tex] : glm::vec2(0.0f);
+					Vert.Color = glm::vec3(1.0f);
+				}
+			});
+
+			if (bBadIndex.load())
+			{
+				t_OutError = "a face uses a vertex that doesn't exist";
+				t_OutVerts.clear();
+				return false;
+			}
+
+			t_OutIndices.resize(TotalCorners);
+			std::iota(t_OutIndices.begin(), t_OutIndices.end(), 0u);
+			return true;
+		}
+	}
+}   // namespace Fling
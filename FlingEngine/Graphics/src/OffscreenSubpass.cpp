@@ -8,20 +8,31 @@
 #include "MeshRenderer.h"
 #include "SwapChain.h"
 #include "UniformBufferObject.h"
-#include "FirstPersonCamera.h"
+#include "RenderWorld.h"
+#include "VulkanApp.h"
 #include "FlingVulkan.h"
+#include "JobSystem.h"
+#include "LodSelection.h"
+#include "Profiler.h"
+#include "Stats.h"
+#include "VertexPacking.h"
+#include "Misc/CommandLine.h"
 
 namespace Fling
 {
+	/** Number of mesh renderers that each job will update the uniform buffers of */
+	static constexpr uint32 UniformUpdateChunkSize = 64;
+
+	/** Models with fewer meshlets than this are drawn whole, culling them would cost more than it saves */
+	static constexpr uint32 MinMeshletsToCull = 8;
+
 	OffscreenSubpass::OffscreenSubpass(
 		const LogicalDevice* t_Dev,
 		const Swapchain* t_Swap,
 		entt::registry& t_reg,
-		FirstPersonCamera* t_Cam,
 		std::shared_ptr<Fling::Shader> t_Vert,
 		std::shared_ptr<Fling::Shader> t_Frag)
 		: Subpass(t_Dev, t_Swap, t_Vert, t_Frag)
-		, m_Camera(t_Cam)
 	{
 		t_reg.on_construct<MeshRenderer>().connect<&OffscreenSubpass::OnMeshRendererAdded>(*this);
 
@@ -40,6 +51,12 @@ namespace Fling
 
 		GraphicsHelpers::CreateCommandPool(&m_CommandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 
+		// Every step of bias doubles how much error is allowed, so meshes drop to coarser LODs closer to the camera
+		const float LodErrorPixels = CommandLine::Get().GetValueAs<float>("LodErrorPixels", LodSelection::DefaultErrorThreshold);
+		const float LodBias = CommandLine::Get().GetValueAs<float>("LodBias", 0.0f);
+		m_LodErrorThreshold = LodErrorPixels * std::exp2(LodBias);
+		m_bClusterCulling = CommandLine::Get().GetValueAs<bool>("ClusterCulling", true);
+
 		// Build offscreen command buffers
 		m_OffscreenCmdBufs.resize(m_SwapChain->GetImageCount());
 		for (size_t i = 0; i < m_OffscreenCmdBufs.size(); ++i)
@@ -74,12 +91,52 @@ namespace Fling
 		m_OffscreenFrameBuf = nullptr;
 	}
 
+	void OffscreenSubpass::PrepareFrame(entt::registry& t_SimReg, const RenderWorld& t_World, float DeltaTime)
+	{
+		++m_FrameCount;
+
+		// Anything that is retired now could be drawn by every frame the renderer still has queued up
+		const uint64 FramesUntilFree = VulkanApp::NumRenderWorlds + VkConfig::MAX_FRAMES_IN_FLIGHT;
+
+		t_SimReg.view<MeshRenderer, entt::tag<"Default"_hs>>().less([&](MeshRenderer& t_MeshRend)
+		{
+			if (!t_MeshRend.HasPendingLoads() || !t_MeshRend.UpdatePendingLoads())
+			{
+				return;
+			}
+
+			// Write the new material to a new set instead of changing one that the GPU might be reading
+			if (t_MeshRend.m_DescriptorSet != VK_NULL_HANDLE)
+			{
+				m_RetiredDescriptorSets.push_back({ t_MeshRend.m_DescriptorSet, m_FrameCount + FramesUntilFree });
+				t_MeshRend.m_DescriptorSet = VK_NULL_HANDLE;
+			}
+			CreateMeshDescriptorSet(t_MeshRend);
+		});
+
+		for (size_t i = 0; i < m_RetiredDescriptorSets.size();)
+		{
+			if (m_RetiredDescriptorSets[i].FreeOnFrame <= m_FrameCount)
+			{
+				vkFreeDescriptorSets(m_Device->GetVkDevice(), m_DescriptorPool, 1, &m_RetiredDescriptorSets[i].Set);
+				m_RetiredDescriptorSets[i] = m_RetiredDescriptorSets.back();
+				m_RetiredDescriptorSets.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
 	void OffscreenSubpass::Draw(
 		CommandBuffer& t_CmdBuf, 
 		uint32 t_ActiveSwapImage, 
-		entt::registry& t_reg, 
+		const RenderWorld& t_World, 
 		float DeltaTime)
 	{
+		FLING_PROFILE_SCOPE("OffscreenSubpass::Draw");
+
 		assert(m_GraphicsPipeline);
 		// Don't use the given command buffer, instead build the OFFSCREEN command buffer
 		CommandBuffer* OffscreenCmdBuf = m_OffscreenCmdBufs[t_ActiveSwapImage];
@@ -109,41 +166,58 @@ namespace Fling
 
 		VkDeviceSize offsets[1] = { 0 };
 
+		const RenderFrameInfo& FrameInfo = t_World.GetInfo();
+
 		OffscreenUBO CurrentUBO = {};
 		// Invert the project value to match the proper coordinate space compared to OpenGL
-		CurrentUBO.Projection = m_Camera->GetProjectionMatrix();
+		CurrentUBO.Projection = FrameInfo.Camera.Projection;
 		CurrentUBO.Projection[1][1] *= -1.0f;
-		CurrentUBO.View = m_Camera->GetViewMatrix();	
+		CurrentUBO.View = FrameInfo.Camera.View;
 
 		// #TODO This is where a lot of the cost of our engine loop comes from
 		// We can improve this by doing some kind of dirty bit tracking to only
 		// update the UBO's on MeshRenders if they have changed
-		//
-		// Use a view, not an owning group. group<Transform>(MeshRenderer, ...) packs
-		// Transform and can swap it out from under assign<Transform>() references.
-		auto RenderView = t_reg.view<Transform, MeshRenderer, entt::tag<"Default"_hs>>();
+		const MeshDraws& Draws = t_World.GetDraws(MeshDrawList::Default);
+		const std::vector<Model*>& Meshes = t_World.GetMeshes();
 
-		RenderView.less([&](entt::entity ent, Transform& t_trans, MeshRenderer& t_MeshRend)
+		// Update the UBO of every mesh across the job system. World matrices were already
+		// calculated when the frame was extracted, and each draw only touches its own buffer
+		JobSystem::Get().ParallelFor(static_cast<uint32>(Draws.Size()), UniformUpdateChunkSize, [&Draws, &Meshes, &CurrentUBO](uint32 t_Begin, uint32 t_End)
 		{
-			Fling::Model* Model = t_MeshRend.m_Model;
-			if (!Model)
+			for (uint32 i = t_Begin; i < t_End; ++i)
 			{
-				return;
+				const Fling::Model* Model = Meshes[Draws.MeshIds[i]];
+				OffscreenUBO MeshUBO = CurrentUBO;
+				MeshUBO.Model = Draws.WorldMatrices[i];
+				MeshUBO.ObjPos = glm::vec3(Draws.WorldMatrices[i][3]);
+				MeshUBO.PositionOffset = glm::vec4(Model->GetPositionOffset(), 0.0f);
+				MeshUBO.PositionScale = glm::vec4(Model->GetPositionScale(), 0.0f);
+
+				// Memcpy to the buffer
+				Buffer* buf = Draws.UniformBuffers[i];
+				memcpy(
+					buf->m_MappedMem, 
+					&MeshUBO,
+					buf->GetSize()
+				);
 			}
+		});
 
-			// UPDATE UNIFORM BUF of the mesh --------
-			
-			Transform::CalculateWorldMatrix(t_trans);
-			CurrentUBO.Model = t_trans.GetWorldMatrix();
-			CurrentUBO.ObjPos = t_trans.GetPos();
-
-			// Memcpy to the buffer
-			Buffer* buf = t_MeshRend.m_UniformBuffer;
-			memcpy(
-				buf->m_MappedMem, 
-				&CurrentUBO,
-				buf->GetSize()
-			);
+		const glm::vec3 CameraPos = FrameInfo.Camera.Position;
+		const float ProjectionScale = LodSelection::GetProjectionScale(FrameInfo.Camera.Projection, viewport.height);
+		const glm::mat4 ViewProjection = FrameInfo.Camera.Projection * FrameInfo.Camera.View;
+		uint64 Triangles = 0;
+		uint64 FullDetailTriangles = 0;
+		uint32 DrawCount = 0;
+
+		// Command buffer recording has to happen on this thread. Draws are sorted by mesh,
+		// so only bind the vertex and index buffers when the mesh changes
+		uint32 BoundMeshId = UINT32_MAX;
+		for (size_t i = 0; i < Draws.Size(); ++i)
+		{
+			const uint32 MeshId = Draws.MeshIds[i];
+			const Fling::Model* Model = Meshes[MeshId];
+			assert(Model->GetVertexLayout() == m_GraphicsPipeline->m_VertexLayout);
 
 			// Bind the descriptor set for rendering a mesh using the dynamic offset
 			vkCmdBindDescriptorSets(
@@ -152,16 +226,43 @@ namespace Fling
 				m_GraphicsPipeline->GetPipelineLayout(),
 				0,
 				1,
-				&t_MeshRend.m_DescriptorSet,
+				&Draws.DescriptorSets[i],
 				0,
 				nullptr);
 
-			VkBuffer vertexBuffers[1] = { Model->GetVertexBuffer()->GetVkBuffer() };
-			// Render the mesh
-			vkCmdBindVertexBuffers(OffscreenCmdBuf->GetHandle(), 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(OffscreenCmdBuf->GetHandle(), Model->GetIndexBuffer()->GetVkBuffer(), 0, Model->GetIndexType());
-			vkCmdDrawIndexed(OffscreenCmdBuf->GetHandle(), Model->GetIndexCount(), 1, 0, 0, 0);
-		});
+			if (MeshId != BoundMeshId)
+			{
+				VkBuffer vertexBuffers[1] = { Model->GetVertexBuffer()->GetVkBuffer() };
+				vkCmdBindVertexBuffers(OffscreenCmdBuf->GetHandle(), 0, 1, vertexBuffers, offsets);
+				vkCmdBindIndexBuffer(OffscreenCmdBuf->GetHandle(), Model->GetIndexBuffer()->GetVkBuffer(), 0, Model->GetIndexType());
+				BoundMeshId = MeshId;
+			}
+
+			FullDetailTriangles += Model->GetIndexCount() / 3;
+
+			// Render the mesh with the range of the index buffer that its LOD uses
+			const uint32 LodIndex = SelectLod(Draws.Entities[i], *Model, Draws.Bounds[i], CameraPos, ProjectionScale);
+			const MeshLod& Lod = Model->GetLod(LodIndex);
+			if (!m_bClusterCulling || LodIndex != 0 || Model->GetMeshletCount() < MinMeshletsToCull)
+			{
+				vkCmdDrawIndexed(OffscreenCmdBuf->GetHandle(), Lod.IndexCount, 1, Lod.FirstIndex, 0, 0);
+				Triangles += Lod.IndexCount / 3;
+				++DrawCount;
+				continue;
+			}
+
+			// Big meshes up close only draw the meshlets that can be seen, merged into as few draws as possible
+			const Meshlets::CullParams CullParams = Meshlets::MakeCullParams(ViewProjection, Draws.WorldMatrices[i], CameraPos);
+			Meshlets::Cull(Model->GetMeshlets().data(), Model->GetMeshletCount(), CullParams, m_VisibleRanges);
+			for (const Meshlets::DrawRange& Range : m_VisibleRanges)
+			{
+				vkCmdDrawIndexed(OffscreenCmdBuf->GetHandle(), Range.IndexCount, 1, Range.FirstIndex, 0, 0);
+				Triangles += Range.IndexCount / 3;
+			}
+			DrawCount += static_cast<uint32>(m_VisibleRanges.size());
+		}
+
+		Stats::Draws::RecordFrame(Triangles, FullDetailTriangles, DrawCount);
 
 		OffscreenCmdBuf->EndRenderPass();
 
@@ -186,12 +287,14 @@ namespace Fling
 		}
 
 		// Ensure that we have a material to try and sample from
-		if (t_MeshRend.m_Material == nullptr)
+		if (t_MeshRend.GetMaterial() == nullptr)
 		{
-			t_MeshRend.m_Material = Material::GetDefaultMat().get();
+			ResourceManager::ReleaseHandle(t_MeshRend.m_ActiveMaterial);
+			t_MeshRend.m_ActiveMaterial = ResourceManager::AcquireHandle(Material::GetDefaultMat());
 		}
+		const Material* Mat = t_MeshRend.GetMaterial();
 		
-		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
+		ScratchVector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
 			// 0: UBO
 			Initializers::WriteDescriptorSetUniform(
@@ -201,22 +304,22 @@ namespace Fling
 			),
 			// 1: Color map 
 			Initializers::WriteDescriptorSetImage(
-				t_MeshRend.m_Material->GetPBRTextures().m_AlbedoTexture,
+				Mat->GetPBRTextures().m_AlbedoTexture.get(),
 				t_MeshRend.m_DescriptorSet,
 				1),
 			// 2: Normal map
 			Initializers::WriteDescriptorSetImage(
-				t_MeshRend.m_Material->GetPBRTextures().m_NormalTexture,
+				Mat->GetPBRTextures().m_NormalTexture.get(),
 				t_MeshRend.m_DescriptorSet,
 				2),
 			// 3: Metal map
 			Initializers::WriteDescriptorSetImage(
-				t_MeshRend.m_Material->GetPBRTextures().m_MetalTexture,
+				Mat->GetPBRTextures().m_MetalTexture.get(),
 				t_MeshRend.m_DescriptorSet,
 				3),
 			// 4: Roughness map
 			Initializers::WriteDescriptorSetImage(
-				t_MeshRend.m_Material->GetPBRTextures().m_RoughnessTexture,
+				Mat->GetPBRTextures().m_RoughnessTexture.get(),
 				t_MeshRend.m_DescriptorSet,
 				4)
 			// Any other PBR textures or other samplers go HERE and you add to the MRT shader
@@ -230,6 +333,32 @@ namespace Fling
 
 	}
 
+	uint32 OffscreenSubpass::SelectLod(entt::entity t_Ent, const Model& t_Model, const glm::vec4& t_Bounds, const glm::vec3& t_CameraPos, float t_ProjectionScale)
+	{
+		if (t_Model.GetLodCount() <= 1)
+		{
+			return 0;
+		}
+
+		const size_t Slot = static_cast<size_t>(entt::registry::entity(t_Ent));
+		if (Slot >= m_EntityLods.size())
+		{
+			m_EntityLods.resize(Slot + 1);
+		}
+
+		// Entity ids get reused, a new entity shouldn't carry on from the LOD of an old one
+		EntityLod& Last = m_EntityLods[Slot];
+		if (Last.Entity != t_Ent)
+		{
+			Last.Entity = t_Ent;
+			Last.Lod = 0;
+		}
+
+		const float ErrorScale = LodSelection::GetErrorScale(t_Bounds, t_Model.GetBoundsRadius(), t_CameraPos, t_ProjectionScale);
+		Last.Lod = static_cast<uint8>(LodSelection::SelectLod(&t_Model.GetLod(0), t_Model.GetLodCount(), ErrorScale, m_LodErrorThreshold, Last.Lod));
+		return Last.Lod;
+	}
+
 	void OffscreenSubpass::PrepareAttachments()
 	{
 		assert(m_OffscreenFrameBuf == nullptr);
@@ -303,6 +432,8 @@ namespace Fling
 		poolInfo.poolSizeCount = static_cast<uint32>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
 		poolInfo.maxSets = to_u32(1000 * m_SwapChain->GetImageViewCount());
+		// Sets are replaced when a streamed in material is swapped in
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
 		if (vkCreateDescriptorPool(m_Device->GetVkDevice(), &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
 		{
@@ -316,6 +447,9 @@ namespace Fling
 		VkRenderPass RenderPass = m_OffscreenFrameBuf->GetRenderPassHandle();
 		assert(RenderPass != VK_NULL_HANDLE);
 
+		// Has to match the vertex shader that VulkanApp loaded for this pass
+		m_GraphicsPipeline->m_VertexLayout = VertexPacking::UseCompactVertices() ? VertexLayout::Packed : VertexLayout::Full;
+
 		m_GraphicsPipeline->m_RasterizationState =
 			Initializers::PipelineRasterizationStateCreateInfo(
 				VK_POLYGON_MODE_FILL,
@@ -360,7 +494,7 @@ namespace Fling
 		m_GraphicsPipeline->CreateGraphicsPipeline(RenderPass, nullptr);
 	}
 
-	void OffscreenSubpass::GatherPresentDependencies(std::vector<CommandBuffer*>& t_CmdBuffs, std::vector<VkSemaphore>& t_Deps, uint32 t_ActiveFrameIndex, uint32 t_CurrentFrameInFlight)
+	void OffscreenSubpass::GatherPresentDependencies(ScratchVector<CommandBuffer*>& t_CmdBuffs, ScratchVector<VkSemaphore>& t_Deps, uint32 t_ActiveFrameIndex, uint32 t_CurrentFrameInFlight)
 	{
 		t_CmdBuffs.emplace_back(m_OffscreenCmdBufs[t_ActiveFrameIndex]);
 		t_Deps.emplace_back(m_OffscreenSemaphores[t_CurrentFrameInFlight]);
@@ -375,6 +509,9 @@ namespace Fling
 			t_Mesh.Release();
 		});
 
+		// Destroying the pool frees these
+		m_RetiredDescriptorSets.clear();
+
 		if (m_DescriptorPool != VK_NULL_HANDLE)
 		{
 			vkDestroyDescriptorPool(m_Device->GetVkDevice(), m_DescriptorPool, nullptr);
@@ -393,7 +530,8 @@ namespace Fling
 
 	void OffscreenSubpass::OnMeshRendererAdded(entt::entity t_Ent, entt::registry& t_Reg, MeshRenderer& t_MeshRend)
 	{
-		if (t_MeshRend.m_Material && t_MeshRend.m_Material->GetType() != Material::Type::Default)
+		const Material* Mat = t_MeshRend.GetMaterial();
+		if (Mat && Mat->GetType() != Material::Type::Default)
 		{
 			return;
 		}
@@ -5,6 +5,7 @@
 #include "SwapChain.h"
 #include "FrameBuffer.h"
 #include "MeshRenderer.h"
+#include "Profiler.h"
 
 namespace Fling
 {
@@ -38,8 +39,18 @@ namespace Fling
 		m_Subpasses.clear();
 	}
 
-	void RenderPipeline::Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, uint32 t_ActiveFrameInFlight, entt::registry& t_Reg, float DeltaTime)
+	void RenderPipeline::PrepareFrame(entt::registry& t_SimReg, const RenderWorld& t_World, float DeltaTime)
 	{
+		for (const auto& subpass : m_Subpasses)
+		{
+			subpass->PrepareFrame(t_SimReg, t_World, DeltaTime);
+		}
+	}
+
+	void RenderPipeline::Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, uint32 t_ActiveFrameInFlight, const RenderWorld& t_World, float DeltaTime)
+	{
+		FLING_PROFILE_SCOPE("RenderPipeline::Draw");
+
 		assert(!m_Subpasses.empty() && "Render pipeline should contain at least one sub-pass");
 
 		for (size_t i = 0; i < m_Subpasses.size(); ++i)
@@ -48,13 +59,13 @@ namespace Fling
 			m_Subpasses[i]->Draw(
 				t_CmdBuf, 
 				t_ActiveFrameInFlight, 
-				t_Reg,
+				t_World,
 				DeltaTime
 			);
 		}
 	}
 
-	void RenderPipeline::GatherPresentDependencies(std::vector<CommandBuffer*>& t_CmdBuffs, std::vector<VkSemaphore>& t_Deps, uint32 t_ActiveFrameIndex, uint32 t_CurrentFrameInFlight)
+	void RenderPipeline::GatherPresentDependencies(ScratchVector<CommandBuffer*>& t_CmdBuffs, ScratchVector<VkSemaphore>& t_Deps, uint32 t_ActiveFrameIndex, uint32 t_CurrentFrameInFlight)
 	{
 		for (const auto& subpass : m_Subpasses)
 		{
@@ -62,7 +73,7 @@ namespace Fling
 		}
 	}
 
-	void RenderPipeline::GatherPresentBuffers(std::vector<CommandBuffer*>& t_CmdBuffs, uint32 t_ActiveFrameIndex)
+	void RenderPipeline::GatherPresentBuffers(ScratchVector<CommandBuffer*>& t_CmdBuffs, uint32 t_ActiveFrameIndex)
 	{
 		for (const auto& subpass : m_Subpasses)
 		{
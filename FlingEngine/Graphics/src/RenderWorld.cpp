@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "RenderWorld.h"
+#include "Camera.h"
+#include "MeshRenderer.h"
+#include "Components/Transform.h"
+#include "FrameAllocator.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <entt/entity/helper.hpp>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace Fling
+{
+	namespace
+	{
+		/** Number of draws each job packs when filling in the draw arrays */
+		static constexpr uint32 PackChunkSize = 128;
+
+		/** Largest amount a matrix scales along any axis */
+		inline float GetMaxScale(const glm::mat4& t_Mat)
+		{
+			return std::sqrt(std::max(std::max(
+				glm::dot(glm::vec3(t_Mat[0]), glm::vec3(t_Mat[0])),
+				glm::dot(glm::vec3(t_Mat[1]), glm::vec3(t_Mat[1]))),
+				glm::dot(glm::vec3(t_Mat[2]), glm::vec3(t_Mat[2]))));
+		}
+
+		/** The highest bits of a depth. Positive floats sort the same as their bits do */
+		inline uint64 QuantizeDepth(float t_Depth)
+		{
+			if (!(t_Depth > 0.0f))
+			{
+				return 0;
+			}
+
+			uint32 Bits = 0;
+			std::memcpy(&Bits, &t_Depth, sizeof(Bits));
+			return Bits >> (32 - DrawSorting::DepthBits);
+		}
+	}
+
+	static_assert(DrawSorting::DepthBits + DrawSorting::MeshBits + DrawSorting::MaterialBits + DrawSorting::PipelineBits <= 64, "Sort key doesn't fit in 64 bits");
+	static_assert(static_cast<uint32>(MeshDrawList::Count) <= (1u << DrawSorting::PipelineBits), "Not enough sort key bits for every draw list");
+
+	void RenderCamera::CopyFrom(const Camera& t_Cam)
+	{
+		View = t_Cam.GetViewMatrix();
+		Projection = t_Cam.GetProjectionMatrix();
+		Position = t_Cam.GetPosition();
+		Gamma = t_Cam.GetGamma();
+		Exposure = t_Cam.GetExposure();
+	}
+
+	void MeshDraws::Resize(size_t t_Count)
+	{
+		WorldMatrices.resize(t_Count);
+		Bounds.resize(t_Count);
+		MeshIds.resize(t_Count);
+		MaterialIds.resize(t_Count);
+		Entities.resize(t_Count);
+		UniformBuffers.resize(t_Count);
+		DescriptorSets.resize(t_Count);
+	}
+
+	void MeshDraws::Clear()
+	{
+		Resize(0);
+	}
+
+	void RenderWorld::Extract(entt::registry& t_SimReg, const RenderFrameInfo& t_Info)
+	{
+		FLING_PROFILE_SCOPE("RenderWorld::Extract");
+
+		m_Info = t_Info;
+
+		m_Meshes.clear();
+		m_Materials.clear();
+		m_MeshIds.clear();
+		m_MaterialIds.clear();
+		m_PointLights.clear();
+		m_DirectionalLights.clear();
+
+		// Find everything that will be drawn and what list it goes in
+		ScratchVector<DrawInput> Pending;
+
+		t_SimReg.view<Transform, MeshRenderer>().each([&](entt::entity t_Ent, const Transform& t_Trans, const MeshRenderer& t_Mesh)
+		{
+			// Not drawn until its model has streamed in
+			Model* Mesh = t_Mesh.GetModel();
+			if (!Mesh)
+			{
+				return;
+			}
+
+			// Descriptor sets are only made in Subpass::PrepareFrame, on the game registry. The render
+			// thread can't make one, it would go on its copy of the mesh renderer and be lost every frame
+			if (t_Mesh.m_DescriptorSet == VK_NULL_HANDLE)
+			{
+				return;
+			}
+
+			DrawInput Draw;
+			if (t_SimReg.has<entt::tag<"Default"_hs>>(t_Ent))
+			{
+				Draw.List = MeshDrawList::Default;
+			}
+			else if (t_SimReg.has<entt::tag<"Debug"_hs>>(t_Ent))
+			{
+				Draw.List = MeshDrawList::Debug;
+			}
+			else
+			{
+				// No subpass has picked this mesh up
+				return;
+			}
+
+			// Everything that needs the model or the mesh renderer is looked up here, so packing only sees plain data
+			Draw.Trans = &t_Trans;
+			Draw.BoundsCenter = Mesh->GetBoundsCenter();
+			Draw.BoundsRadius = Mesh->GetBoundsRadius();
+			Draw.MaterialId = GetMaterialId(t_Mesh.GetMaterial());
+			Draw.MeshId = GetMeshId(Mesh);
+			Draw.Entity = t_Ent;
+			Draw.UniformBuffer = t_Mesh.m_UniformBuffer;
+			Draw.DescriptorSet = t_Mesh.m_DescriptorSet;
+			Pending.push_back(Draw);
+		});
+
+		DrawSorting::PackDraws(Pending.data(), Pending.size(), m_Info.Camera.View, m_Info.InterpolationAlpha, m_Draws);
+
+		// Lights ---------------------
+		t_SimReg.view<PointLight, Transform>().each([&](PointLight& t_Light, const Transform& t_Trans)
+		{
+			m_PointLights.push_back(t_Light);
+			m_PointLights.back().SetPos(glm::vec4(t_Trans.GetPos(), 1.0f));
+		});
+
+		t_SimReg.view<DirectionalLight>().each([&](const DirectionalLight& t_Light)
+		{
+			m_DirectionalLights.push_back(t_Light);
+		});
+	}
+
+	uint32 RenderWorld::GetMeshId(Model* t_Model)
+	{
+		auto Result = m_MeshIds.emplace(t_Model, static_cast<uint32>(m_Meshes.size()));
+		if (Result.second)
+		{
+			m_Meshes.push_back(t_Model);
+		}
+		return Result.first->second;
+	}
+
+	uint32 RenderWorld::GetMaterialId(Material* t_Material)
+	{
+		auto Result = m_MaterialIds.emplace(t_Material, static_cast<uint32>(m_Materials.size()));
+		if (Result.second)
+		{
+			m_Materials.push_back(t_Material);
+		}
+		return Result.first->second;
+	}
+
+	uint64 DrawSorting::MakeSortKey(MeshDrawList t_List, uint32 t_MaterialId, uint32 t_MeshId, float t_ViewDepth)
+	{
+		assert(t_MaterialId < (1u << MaterialBits) && t_MeshId < (1u << MeshBits));
+
+		return (static_cast<uint64>(t_List) << (MaterialBits + MeshBits + DepthBits)) |
+			(static_cast<uint64>(t_MaterialId) << (MeshBits + DepthBits)) |
+			(static_cast<uint64>(t_MeshId) << DepthBits) |
+			QuantizeDepth(t_ViewDepth);
+	}
+
+	void DrawSorting::PackDraws(const DrawInput* t_Draws, size_t t_Count, const glm::mat4& t_View, float t_Alpha, MeshDraws* t_OutLists)
+	{
+		FLING_PROFILE_SCOPE("DrawSorting::PackDraws");
+
+		// The depth needs the world space bounds, so those are worked out before sorting. Every draw
+		// only writes its own slot, so this can be split up
+		ScratchVector<glm::mat4> WorldMatrices(t_Count);
+		ScratchVector<glm::vec4> Bounds(t_Count);
+		ScratchVector<std::pair<uint64, uint32>> Keys(t_Count);
+		JobSystem::Get().ParallelFor(static_cast<uint32>(t_Count), PackChunkSize, [&](uint32 t_Begin, uint32 t_End)
+		{
+			for (uint32 i = t_Begin; i < t_End; ++i)
+			{
+				const DrawInput& Draw = t_Draws[i];
+				const glm::mat4 World = Draw.Trans->GetInterpolatedWorldMatrix(t_Alpha);
+				const glm::vec3 Center = glm::vec3(World * glm::vec4(Draw.BoundsCenter, 1.0f));
+				WorldMatrices[i] = World;
+				Bounds[i] = glm::vec4(Center, Draw.BoundsRadius * GetMaxScale(World));
+
+				// The camera looks down -Z in view space
+				const float ViewDepth = -(t_View * glm::vec4(Center, 1.0f)).z;
+				Keys[i] = { MakeSortKey(Draw.List, Draw.MaterialId, Draw.MeshId, ViewDepth), i };
+			}
+		});
+
+		// Ties go to the draw that was found first so the order doesn't change from frame to frame
+		std::sort(Keys.begin(), Keys.end());
+
+		// The list is in the highest bits, so each list is one run of the sorted draws
+		size_t RunStart = 0;
+		for (size_t ListIndex = 0; ListIndex < static_cast<size_t>(MeshDrawList::Count); ++ListIndex)
+		{
+			size_t RunEnd = RunStart;
+			while (RunEnd < t_Count && static_cast<size_t>(t_Draws[Keys[RunEnd].second].List) == ListIndex)
+			{
+				++RunEnd;
+			}
+
+			MeshDraws& Draws = t_OutLists[ListIndex];
+			Draws.Resize(RunEnd - RunStart);
+
+			JobSystem::Get().ParallelFor(static_cast<uint32>(RunEnd - RunStart), PackChunkSize, [&](uint32 t_Begin, uint32 t_End)
+			{
+				for (uint32 i = t_Begin; i < t_End; ++i)
+				{
+					const uint32 Source = Keys[RunStart + i].second;
+					const DrawInput& Draw = t_Draws[Source];
+					Draws.WorldMatrices[i] = WorldMatrices[Source];
+					Draws.Bounds[i] = Bounds[Source];
+					Draws.MeshIds[i] = Draw.MeshId;
+					Draws.MaterialIds[i] = Draw.MaterialId;
+					Draws.Entities[i] = Draw.Entity;
+					Draws.UniformBuffers[i] = Draw.UniformBuffer;
+					Draws.DescriptorSets[i] = Draw.DescriptorSet;
+				}
+			});
+
+			RunStart = RunEnd;
+		}
+		assert(RunStart == t_Count);
+	}
+}   // namespace Fling
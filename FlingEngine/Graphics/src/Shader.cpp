@@ -26,17 +26,23 @@ namespace Fling
 		, m_Device(t_Dev)
     {
 		assert(m_Device);
-        std::vector<char> RawCode = LoadRawBytes(GetFilepathReleativeToAssets());
-        
+        // The raw code is only needed while the shader module is created
+        AssetData RawCode;
+        if (!ReadAsset(RawCode))
+        {
+            F_LOG_ERROR("Failed to open file: {}", GetFilepathReleativeToAssets());
+        }
+
         if (CreateShaderModule(RawCode) != VK_SUCCESS)
         {
             F_LOG_ERROR("Failed to create shader module for {}", GetFilepathReleativeToAssets());
         }
 
-		assert(RawCode.size() % 4 == 0);
+		assert(RawCode.GetSize() % 4 == 0);
 
-		uint32 size = static_cast<uint32>(RawCode.size() / 4);
-		ParseReflectionData(reinterpret_cast<const uint32*>(RawCode.data()), size);
+		// Asset data is always 16 byte aligned, so the code can be read as words right where it is
+		uint32 size = static_cast<uint32>(RawCode.GetSize() / 4);
+		ParseReflectionData(reinterpret_cast<const uint32*>(RawCode.GetData()), size);
     }
 
     Shader::~Shader()
@@ -44,38 +50,16 @@ namespace Fling
 		Release();
     }
 
-    VkResult Shader::CreateShaderModule(std::vector<char>& t_ShaderCode)
+    VkResult Shader::CreateShaderModule(const AssetData& t_ShaderCode)
     {
         VkShaderModuleCreateInfo CreateInfo = {};
         CreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        CreateInfo.codeSize = t_ShaderCode.size();
-        CreateInfo.pCode = reinterpret_cast<const uint32*>(t_ShaderCode.data());
+        CreateInfo.codeSize = t_ShaderCode.GetSize();
+        CreateInfo.pCode = reinterpret_cast<const uint32*>(t_ShaderCode.GetData());
 
         return vkCreateShaderModule(m_Device->GetVkDevice(), &CreateInfo, nullptr, &m_Module);
     }
 
-    std::vector<char> Shader::LoadRawBytes(const std::string& FilePath)
-    {
-        std::ifstream File(FilePath, std::ios::ate | std::ios::binary);
-        std::vector<char> RawShaderCode;
-        
-        if (!File.is_open())
-        {
-            F_LOG_ERROR("Failed to open file: {}", FilePath);
-        }
-        else
-        {
-            size_t Filesize = static_cast<size_t>(File.tellg());
-            RawShaderCode.resize(Filesize);
-        
-            File.seekg(0);
-            File.read(RawShaderCode.data(), Filesize);
-            File.close();
-        }
-
-        return RawShaderCode;
-    }
-
 	namespace ParseHelpers
 	{
 		static VkShaderStageFlagBits GetShaderStage(SpvExecutionModel executionModel)
@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "VertexPacking.h"
+#include "Misc/CommandLine.h"
+#include "ResourceManager.h"
+
+#include <glm/gtc/packing.hpp>
+
+namespace Fling
+{
+	namespace VertexPacking
+	{
+		namespace
+		{
+			constexpr float MaxUnorm16 = 65535.0f;
+			constexpr float MaxSnorm16 = 32767.0f;
+
+			/** Fold the lower half of the octahedron over onto the upper half */
+			glm::vec2 OctWrap(const glm::vec2& t_V)
+			{
+				return glm::vec2(
+					(1.0f - std::abs(t_V.y)) * (t_V.x >= 0.0f ? 1.0f : -1.0f),
+					(1.0f - std::abs(t_V.x)) * (t_V.y >= 0.0f ? 1.0f : -1.0f));
+			}
+
+			uint16 ToUnorm16(float t_Value)
+			{
+				return static_cast<uint16>(std::round(glm::clamp(t_Value, 0.0f, 1.0f) * MaxUnorm16));
+			}
+
+			int16 ToSnorm16(float t_Value)
+			{
+				return static_cast<int16>(std::round(glm::clamp(t_Value, -1.0f, 1.0f) * MaxSnorm16));
+			}
+
+			/** The way Vulkan reads SNORM formats, -32768 and -32767 are both -1 */
+			float FromSnorm16(int16 t_Value)
+			{
+				return std::max(static_cast<float>(t_Value) / MaxSnorm16, -1.0f);
+			}
+		}
+
+		bool UseCompactVertices()
+		{
+			static const bool bCompact = []()
+			{
+				if (!CommandLine::Get().GetValueAs<bool>("CompactVertices", false))
+				{
+					return false;
+				}
+
+				// The compact shader is compiled by the build, which skips it if glslangValidator wasn't found
+				if (!ResourceManager::Get().GetFileSystem().Exists(CompactShaderPath))
+				{
+					F_LOG_WARN("CompactVertices is on but {} hasn't been built, using full vertices", CompactShaderPath);
+					return false;
+				}
+				return true;
+			}();
+			return bCompact;
+		}
+
+		void OctEncode(const glm::vec3& t_Dir, int16 t_Out[2])
+		{
+			const float Length = std::abs(t_Dir.x) + std::abs(t_Dir.y) + std::abs(t_Dir.z);
+			glm::vec2 Oct = Length > 0.0f ? glm::vec2(t_Dir.x, t_Dir.y) / Length : glm::vec2(0.0f);
+			if (Length > 0.0f && t_Dir.z < 0.0f)
+			{
+				Oct = OctWrap(Oct);
+			}
+
+			t_Out[0] = ToSnorm16(Oct.x);
+			t_Out[1] = ToSnorm16(Oct.y);
+		}
+
+		glm::vec3 OctDecode(const int16 t_Encoded[2])
+		{
+			const glm::vec2 Oct(FromSnorm16(t_Encoded[0]), FromSnorm16(t_Encoded[1]));
+			glm::vec3 Dir(Oct.x, Oct.y, 1.0f - std::abs(Oct.x) - std::abs(Oct.y));
+			if (Dir.z < 0.0f)
+			{
+				const glm::vec2 Unwrapped = OctWrap(Oct);
+				Dir.x = Unwrapped.x;
+				Dir.y = Unwrapped.y;
+			}
+			return glm::normalize(Dir);
+		}
+
+		void GetPositionTransform(const Vertex* t_Verts, uint32 t_Count, glm::vec3& t_OutOffset, glm::vec3& t_OutScale)
+		{
+			if (t_Count == 0)
+			{
+				t_OutOffset = glm::vec3(0.0f);
+				t_OutScale = glm::vec3(1.0f);
+				return;
+			}
+
+			glm::vec3 Min = t_Verts[0].Pos;
+			glm::vec3 Max = t_Verts[0].Pos;
+			for (uint32 i = 1; i < t_Count; ++i)
+			{
+				Min = glm::min(Min, t_Verts[i].Pos);
+				Max = glm::max(Max, t_Verts[i].Pos);
+			}
+
+			t_OutOffset = Min;
+			t_OutScale = Max - Min;
+		}
+
+		void Pack(const Vertex* t_Verts, uint32 t_Count, const glm::vec3& t_PositionOffset, const glm::vec3& t_PositionScale, PackedVertex* t_Out)
+		{
+			// A flat axis has no extent, everything on it packs to 0 and decodes back to the offset
+			glm::vec3 InvScale;
+			for (int Axis = 0; Axis < 3; ++Axis)
+			{
+				InvScale[Axis] = t_PositionScale[Axis] > 0.0f ? 1.0f / t_PositionScale[Axis] : 0.0f;
+			}
+
+			for (uint32 i = 0; i < t_Count; ++i)
+			{
+				const Vertex& Vert = t_Verts[i];
+				PackedVertex& Out = t_Out[i];
+
+				const glm::vec3 Pos = (Vert.Pos - t_PositionOffset) * InvScale;
+				Out.Pos[0] = ToUnorm16(Pos.x);
+				Out.Pos[1] = ToUnorm16(Pos.y);
+				Out.Pos[2] = ToUnorm16(Pos.z);
+				Out.Pos[3] = 0;
+
+				for (int Channel = 0; Channel < 3; ++Channel)
+				{
+					Out.Color[Channel] = static_cast<uint8>(std::round(glm::clamp(Vert.Color[Channel], 0.0f, 1.0f) * 255.0f));
+				}
+				Out.Color[3] = 255;
+
+				OctEncode(Vert.Tangent, Out.Tangent);
+				OctEncode(Vert.Normal, Out.Normal);
+
+				Out.TexCoord[0] = glm::packHalf1x16(Vert.TexCoord.x);
+				Out.TexCoord[1] = glm::packHalf1x16(Vert.TexCoord.y);
+			}
+		}
+
+		Vertex Unpack(const PackedVertex& t_Packed, const glm::vec3& t_PositionOffset, const glm::vec3& t_PositionScale)
+		{
+			Vertex Out = {};
+			const glm::vec3 Unorm(t_Packed.Pos[0], t_Packed.Pos[1], t_Packed.Pos[2]);
+			Out.Pos = t_PositionOffset + (Unorm / MaxUnorm16) * t_PositionScale;
+			Out.Color = glm::vec3(t_Packed.Color[0], t_Packed.Color[1], t_Packed.Color[2]) / 255.0f;
+			Out.Tangent = OctDecode(t_Packed.Tangent);
+			Out.Normal = OctDecode(t_Packed.Normal);
+			Out.TexCoord = glm::vec2(glm::unpackHalf1x16(t_Packed.TexCoord[0]), glm::unpackHalf1x16(t_Packed.TexCoord[1]));
+			return Out;
+		}
+
+		void PackIndices16(const uint32* t_Indices, size_t t_Count, uint16* t_Out)
+		{
+			for (size_t i = 0; i < t_Count; ++i)
+			{
+				assert(t_Indices[i] < MaxVertsFor16BitIndices);
+				t_Out[i] = static_cast<uint16>(t_Indices[i]);
+			}
+		}
+	}
+}   // namespace Fling
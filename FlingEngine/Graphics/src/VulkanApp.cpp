@@ -7,6 +7,8 @@
 #include "DebugSubpass.h"
 
 #include "CommandBuffer.h"
+#include "FrameAllocator.h"
+#include "Profiler.h"
 #include "Instance.h"
 #include "LogicalDevice.h"
 #include "PhyscialDevice.h"
@@ -15,8 +17,11 @@
 #include "FlingConfig.h"
 #include "FirstPersonCamera.h"
 #include "GraphicsHelpers.h"
+#include "MeshRenderer.h"
 #include "DepthBuffer.h"
+#include "VertexPacking.h"
 #include "BaseEditor.h"
+#include "Misc/CommandLine.h"
 
 namespace Fling
 {
@@ -28,8 +33,18 @@ namespace Fling
 
 		// #TODO Build VMA allocator
 
+		// Mesh renderers are trivially copyable, so their resource handles are given back here instead of in a destructor
+		MeshRenderer::ConnectToRegistry(t_Reg);
+
 		BuildRenderPipelines(t_Conf, t_Reg, t_Editor);
 
+		m_PipelinedRendering = CommandLine::Get().GetValueAs<bool>("PipelinedRendering", false);
+		if (m_PipelinedRendering)
+		{
+			F_LOG_TRACE("Pipelined rendering: Enabled");
+			m_RenderThread = std::thread(&VulkanApp::RenderThreadLoop, this);
+		}
+
 		// Set the window icon for this application
 		if (m_CurrentWindow)
 		{
@@ -62,6 +77,7 @@ namespace Fling
 		assert(m_SwapChain);
 
 		GraphicsHelpers::CreateCommandPool(&m_CommandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+		GraphicsHelpers::CreateCommandPool(&m_TransientCommandPool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
 
 		CreateFrameSyncResources();
 
@@ -309,9 +325,10 @@ namespace Fling
 
 			// Offscreen pipeline ------
 			// These shaders have vertex input and fill in the buffers that the final pass uses
-			std::shared_ptr<Fling::Shader> OffscreenVert = Shader::Create(HS("Shaders/Deferred/mrt_vert.spv"), m_LogicalDevice);
+			const Guid OffscreenVertPath = VertexPacking::UseCompactVertices() ? HS(VertexPacking::CompactShaderPath) : HS("Shaders/Deferred/mrt_vert.spv");
+			std::shared_ptr<Fling::Shader> OffscreenVert = Shader::Create(OffscreenVertPath, m_LogicalDevice);
 			std::shared_ptr<Fling::Shader> OffscreenFrag = Shader::Create(HS("Shaders/Deferred/mrt_frag.spv"), m_LogicalDevice);
-			Subpasses.emplace_back(std::make_unique<OffscreenSubpass>(m_LogicalDevice, m_SwapChain, t_Reg, m_Camera, OffscreenVert, OffscreenFrag));
+			Subpasses.emplace_back(std::make_unique<OffscreenSubpass>(m_LogicalDevice, m_SwapChain, t_Reg, OffscreenVert, OffscreenFrag));
 
 			// Create geometry pass ------
 			// These shaders do not have any vertex input and do the final processing to the screen
@@ -321,7 +338,7 @@ namespace Fling
 			assert(OffscreenBuf);
 			std::shared_ptr<Fling::Shader> GeomVert = Shader::Create(HS("Shaders/Deferred/deferred_vert.spv"), m_LogicalDevice);
 			std::shared_ptr<Fling::Shader> GeomFrag = Shader::Create(HS("Shaders/Deferred/deferred_frag.spv"), m_LogicalDevice);
-			Subpasses.emplace_back(std::make_unique<GeometrySubpass>(m_LogicalDevice, m_SwapChain, t_Reg, m_RenderPass, m_Camera, OffscreenBuf, GeomVert, GeomFrag));
+			Subpasses.emplace_back(std::make_unique<GeometrySubpass>(m_LogicalDevice, m_SwapChain, t_Reg, m_RenderPass, OffscreenBuf, GeomVert, GeomFrag));
 
 			m_RenderPipelines.emplace_back(
 				new Fling::RenderPipeline(t_Reg, m_LogicalDevice, m_SwapChain, Subpasses)
@@ -346,7 +363,7 @@ namespace Fling
 
 			std::shared_ptr<Fling::Shader> DebugVert = Shader::Create(HS("Shaders/Debug/debug_vert.spv"), m_LogicalDevice);
 			std::shared_ptr<Fling::Shader> DebugFrag = Shader::Create(HS("Shaders/Debug/debug_frag.spv"), m_LogicalDevice);
-			Subpasses.emplace_back(std::make_unique<DebugSubpass>(m_LogicalDevice, m_SwapChain, t_Reg, m_RenderPass, m_Camera, DebugVert, DebugFrag));
+			Subpasses.emplace_back(std::make_unique<DebugSubpass>(m_LogicalDevice, m_SwapChain, t_Reg, m_RenderPass, DebugVert, DebugFrag));
 
 			m_RenderPipelines.emplace_back(
 				new Fling::RenderPipeline(t_Reg, m_LogicalDevice, m_SwapChain, Subpasses)
@@ -373,12 +390,124 @@ namespace Fling
 		}
 	}
 
+	void VulkanApp::BeginFrame(entt::registry& t_Reg)
+	{
+		if (!m_PipelinedRendering)
+		{
+			return;
+		}
+
+		FLING_PROFILE_SCOPE("VulkanApp::BeginFrame");
+
+		{
+			// Let the render thread fall at most one frame behind. Anything older, like the frame state we
+			// are about to extract into or the frame allocator buffer that is about to be reset, is then free
+			std::unique_lock<std::mutex> Lock(m_RenderThreadMutex);
+			m_RenderThreadCondition.wait(Lock, [this]() { return m_FramesRendered + 1 >= m_FramesSubmitted; });
+		}
+
+		// The swap chain can only be recreated on the main thread (it waits on window events) and
+		// while nothing is being drawn with it
+		if (bNeedsResizing || m_SwapchainOutOfDate)
+		{
+			FlushRenderThread();
+			bNeedsResizing = false;
+			m_SwapchainOutOfDate = false;
+			RecreateFrameResourcesForResize(t_Reg);
+		}
+	}
+
 	void VulkanApp::Update(float DeltaTime, entt::registry& t_Reg)
 	{
+		FLING_PROFILE_SCOPE("VulkanApp::Update");
+
 		// Prepare the frame for submission by waiting for the swap chain
 		m_CurrentWindow->Update();
 		m_Camera->Update(DeltaTime);
 
+		RenderFrameInfo FrameInfo = {};
+		FrameInfo.Camera.CopyFrom(*m_Camera);
+		FrameInfo.InterpolationAlpha = Timing::Get().GetInterpolationAlpha();
+		FrameInfo.DeltaTime = DeltaTime;
+
+		// BeginFrame already waited for the render thread to be done with this world
+		RenderWorld& World = m_PipelinedRendering ? m_RenderWorlds[m_FramesSubmitted % NumRenderWorlds] : m_RenderWorlds[0];
+
+		// Subpasses can create any GPU resources that new entities need before they are extracted
+		for (RenderPipeline* Pipeline : m_RenderPipelines)
+		{
+			Pipeline->PrepareFrame(t_Reg, World, DeltaTime);
+		}
+
+		World.Extract(t_Reg, FrameInfo);
+
+		if (!m_PipelinedRendering)
+		{
+			// Check if the swap chain is out of date and needs to be rebuilt
+			if (RenderFrame(World, DeltaTime) || bNeedsResizing)
+			{
+				bNeedsResizing = false;
+				RecreateFrameResourcesForResize(t_Reg);
+			}
+			return;
+		}
+
+		// Hand the frame off to the render thread
+		{
+			std::lock_guard<std::mutex> Lock(m_RenderThreadMutex);
+			++m_FramesSubmitted;
+		}
+		m_RenderThreadCondition.notify_all();
+	}
+
+	void VulkanApp::FlushRenderThread()
+	{
+		if (!m_PipelinedRendering)
+		{
+			return;
+		}
+
+		std::unique_lock<std::mutex> Lock(m_RenderThreadMutex);
+		m_RenderThreadCondition.wait(Lock, [this]() { return m_FramesRendered == m_FramesSubmitted; });
+	}
+
+	void VulkanApp::RenderThreadLoop()
+	{
+		Profiler::Get().SetThreadName("Render Thread");
+
+		uint64 FrameNumber = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> Lock(m_RenderThreadMutex);
+				m_RenderThreadCondition.wait(Lock, [&]() { return m_StopRenderThread || m_FramesSubmitted > FrameNumber; });
+
+				// Draw anything that was already handed off before stopping
+				if (m_FramesSubmitted <= FrameNumber)
+				{
+					break;
+				}
+			}
+
+			const RenderWorld& World = m_RenderWorlds[FrameNumber % NumRenderWorlds];
+			if (RenderFrame(World, World.GetInfo().DeltaTime))
+			{
+				// The main thread will recreate it in BeginFrame
+				m_SwapchainOutOfDate = true;
+			}
+
+			{
+				std::lock_guard<std::mutex> Lock(m_RenderThreadMutex);
+				m_FramesRendered = ++FrameNumber;
+			}
+			m_RenderThreadCondition.notify_all();
+		}
+	}
+
+	bool VulkanApp::RenderFrame(const RenderWorld& t_World, float DeltaTime)
+	{
+		FLING_PROFILE_SCOPE("VulkanApp::RenderFrame");
+
 		// Aquire the active image index
 		VkResult iResult = m_SwapChain->AquireNextImage(m_PresentCompleteSemaphores[CurrentFrameIndex]);
 		uint32  ImageIndex = m_SwapChain->GetActiveImageIndex();
@@ -388,7 +517,7 @@ namespace Fling
 		if (iResult == VK_ERROR_OUT_OF_DATE_KHR)
 		{
 			F_LOG_WARN("Swap chain out of date! ");
-			return;
+			return true;
 		}
 		else if (iResult != VK_SUCCESS && iResult != VK_SUBOPTIMAL_KHR)
 		{
@@ -396,12 +525,13 @@ namespace Fling
 		}
 
 		// Fill this with the render pipelines
-		std::vector<VkSemaphore> SemaphoresToWaitOn = {};
-		std::vector<CommandBuffer*> DependentCmdBufs = {};
+		// These only live for this frame, so keep them in the frame allocator instead of the heap
+		ScratchVector<VkSemaphore> SemaphoresToWaitOn = {};
+		ScratchVector<CommandBuffer*> DependentCmdBufs = {};
 
 		// Vector of command buffers to be sent out with the final swap chain presentation
 		// the swap chain draw buffer is always first
-		std::vector<CommandBuffer*> FinalSubmissionBufs = {};
+		ScratchVector<CommandBuffer*> FinalSubmissionBufs = {};
 		FinalSubmissionBufs.emplace_back(m_DrawCmdBuffers[ImageIndex]);
 
 		//vkResetCommandPool(m_LogicalDevice->GetVkDevice(), m_CommandPool, 0);
@@ -439,7 +569,7 @@ namespace Fling
 			// Build the command buffers of the render pipelines
 			for (RenderPipeline* Pipeline : m_RenderPipelines)
 			{		
-				Pipeline->Draw(*CmdBuf, FrameBuf, ImageIndex, t_Reg, DeltaTime);
+				Pipeline->Draw(*CmdBuf, FrameBuf, ImageIndex, t_World, DeltaTime);
 			}
 
 			CmdBuf->EndRenderPass();
@@ -481,7 +611,8 @@ namespace Fling
 			OffscreenSubmission.signalSemaphoreCount = (uint32)SemaphoresToWaitOn.size();
 
 			// Mark the draw command buffer at this frame for submission
-			std::vector<VkCommandBuffer> submitCommandBuffers = {};
+			ScratchVector<VkCommandBuffer> submitCommandBuffers = {};
+			submitCommandBuffers.reserve(DependentCmdBufs.size());
 			
 			for (CommandBuffer* Buf : DependentCmdBufs)
 			{
@@ -491,6 +622,7 @@ namespace Fling
 			OffscreenSubmission.pCommandBuffers = submitCommandBuffers.data();
 			OffscreenSubmission.commandBufferCount = (uint32)submitCommandBuffers.size();
 			// Signal off screen semaphore when this is completed
+			std::lock_guard<std::mutex> QueueLock(m_LogicalDevice->GetQueueMutex());
 			VK_CHECK_RESULT(vkQueueSubmit(m_LogicalDevice->GetGraphicsQueue(), 1, &OffscreenSubmission, VK_NULL_HANDLE));
 
 			// Wait for dependent semaphores
@@ -505,7 +637,8 @@ namespace Fling
 		}
 		
 		// Collect any addition command buffers that we want to submit, but are not dependent on offscreen
-		std::vector<VkCommandBuffer> submitCommandBuffers = {};
+		ScratchVector<VkCommandBuffer> submitCommandBuffers = {};
+		submitCommandBuffers.reserve(FinalSubmissionBufs.size());
 		for (CommandBuffer* buf : FinalSubmissionBufs)
 		{
 			submitCommandBuffers.emplace_back(buf->GetHandle());
@@ -518,28 +651,34 @@ namespace Fling
 		FinalScreenSubmitInfo.signalSemaphoreCount = 1;
 		FinalScreenSubmitInfo.pSignalSemaphores = &m_RenderFinishedSemaphores[CurrentFrameIndex];
 
-		VK_CHECK_RESULT(vkQueueSubmit(m_LogicalDevice->GetGraphicsQueue(), 1, &FinalScreenSubmitInfo, m_InFlightFences[CurrentFrameIndex]));
+		{
+			std::lock_guard<std::mutex> QueueLock(m_LogicalDevice->GetQueueMutex());
+			VK_CHECK_RESULT(vkQueueSubmit(m_LogicalDevice->GetGraphicsQueue(), 1, &FinalScreenSubmitInfo, m_InFlightFences[CurrentFrameIndex]));
+		}
 		
 		// Finish up the frame by setting the in flight fences to wait -----
 		vkWaitForFences(m_LogicalDevice->GetVkDevice(), 1, &m_InFlightFences[CurrentFrameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
 	
 		// Present the swap chain with the renderer finished semaphore
-		iResult = m_SwapChain->QueuePresent(m_LogicalDevice->GetPresentQueue(), m_RenderFinishedSemaphores[CurrentFrameIndex]);
-		
-		// Check if the swap chain is out of date and needs to be rebuilt
-		if (iResult == VK_ERROR_OUT_OF_DATE_KHR || iResult == VK_SUBOPTIMAL_KHR || bNeedsResizing)
 		{
-			// If result is out of date then signal for resize
-			bNeedsResizing = false;
-			RecreateFrameResourcesForResize(t_Reg);
+			std::lock_guard<std::mutex> QueueLock(m_LogicalDevice->GetQueueMutex());
+			iResult = m_SwapChain->QueuePresent(m_LogicalDevice->GetPresentQueue(), m_RenderFinishedSemaphores[CurrentFrameIndex]);
+		}
+
+		// Update the current in flight frame index!
+		CurrentFrameIndex = (CurrentFrameIndex + 1) % VkConfig::MAX_FRAMES_IN_FLIGHT;
+
+		// If result is out of date then signal for resize
+		if (iResult == VK_ERROR_OUT_OF_DATE_KHR || iResult == VK_SUBOPTIMAL_KHR)
+		{
+			return true;
 		}
 		else if (iResult != VK_SUCCESS)
 		{
 			F_LOG_FATAL("Failed to present swap chain image!");
 		}
 
-		// Update the current in flight frame index!
-		CurrentFrameIndex = (CurrentFrameIndex + 1) % VkConfig::MAX_FRAMES_IN_FLIGHT;
+		return false;
 	}
 	
 	VkExtent2D VulkanApp::ChooseSwapExtent()
@@ -573,6 +712,17 @@ namespace Fling
 	{
 		Singleton<VulkanApp>::Shutdown();
 
+		// Let the render thread finish anything it was handed before tearing down what it draws with
+		if (m_RenderThread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> Lock(m_RenderThreadMutex);
+				m_StopRenderThread = true;
+			}
+			m_RenderThreadCondition.notify_all();
+			m_RenderThread.join();
+		}
+
 		// Wait for the device to be ready before shutting down
 		m_LogicalDevice->WaitForIdle();
 
@@ -626,6 +776,7 @@ namespace Fling
 		m_DrawCmdBuffers.clear();
 
 		vkDestroyCommandPool(m_LogicalDevice->GetVkDevice(), m_CommandPool, nullptr);
+		vkDestroyCommandPool(m_LogicalDevice->GetVkDevice(), m_TransientCommandPool, nullptr);
 
 		// Clean up devices and surface (created in Prepare) --------------
 		delete m_LogicalDevice;
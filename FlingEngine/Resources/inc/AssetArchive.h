@@ -0,0 +1,212 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "AssetData.h"
+#include "MappedFile.h"
+#include "NonCopyable.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Fling
+{
+	/** First thing in an archive file */
+	struct AssetArchiveHeader
+	{
+		uint32 Magic = 0;
+		uint32 Version = 0;
+		uint32 NumEntries = 0;
+
+		/** Number of slots in the table of contents, a power of 2 */
+		uint32 TocCapacity = 0;
+
+		uint64 TocOffset = 0;
+		uint64 StringsOffset = 0;
+		uint64 StringsSize = 0;
+
+		/** Checksum of the table of contents and the paths */
+		uint64 TocChecksum = 0;
+	};
+
+	/** One slot in the table of contents of an archive */
+	struct AssetArchiveEntry
+	{
+		/** Hash of the asset path, the same as its Guid_Handle */
+		uint32 ID = 0;
+
+		/** AssetArchive::EntryFlags */
+		uint32 Flags = 0;
+
+		/** Where the asset path is in the string table, used to tell apart paths with the same hash */
+		uint32 PathOffset = 0;
+		uint32 PathLength = 0;
+
+		/** Where the data starts from the beginning of the archive, always aligned */
+		uint64 Offset = 0;
+
+		/** Size of the data in the archive, which is smaller than Size if it is compressed */
+		uint64 StoredSize = 0;
+
+		uint64 Size = 0;
+
+		/** HashBytes64 of the uncompressed data */
+		uint64 Checksum = 0;
+	};
+
+	static_assert(sizeof(AssetArchiveHeader) == 48, "AssetArchiveHeader is written straight to disk, don't change its size");
+	static_assert(sizeof(AssetArchiveEntry) == 48, "AssetArchiveEntry is written straight to disk, don't change its size");
+	static_assert(sizeof(Guid_Handle) == sizeof(uint32), "Archives store Guid_Handles as 32 bits");
+
+	/**
+	 * A single file that packs together lots of assets, so that a shipped build doesn't have to
+	 * open thousands of little files. The whole archive is memory mapped, and its table of contents
+	 * is an open addressing hash table keyed by Guid_Handle, so finding an asset is one probe
+	 * with no file system calls. Assets that aren't compressed are read in place.
+	 *
+	 * Layout: an AssetArchiveHeader, then the data of every asset (each one aligned), then the
+	 * paths, then the table of contents. Everything is little endian.
+	 * Archives are made with an AssetArchiveBuilder. Once opened, an archive is safe to read from any thread.
+	 */
+	class AssetArchive : public NonCopyable
+	{
+	public:
+
+		static constexpr uint32 Magic = 0x4B504C46;	// "FLPK"
+		static constexpr uint32 Version = 1;
+
+		enum EntryFlags : uint32
+		{
+			Entry_Used = 1 << 0,
+			Entry_Compressed = 1 << 1
+		};
+
+		AssetArchive() = default;
+		virtual ~AssetArchive() = default;
+
+		/**
+		 * Map an archive and check that its header and table of contents are intact
+		 *
+		 * @return False if it couldn't be opened or isn't a valid archive
+		 */
+		bool Open(const std::string& t_Path);
+
+		inline bool IsOpen() const { return m_Header != nullptr; }
+
+		inline const std::string& GetPath() const { return m_Path; }
+
+		inline uint32 GetNumEntries() const { return m_Header ? m_Header->NumEntries : 0; }
+
+		/**
+		 * Find the table of contents entry of an asset
+		 *
+		 * @param t_ID		Guid_Handle of the asset
+		 * @param t_Path	Path of the asset, to make sure it isn't another path with the same hash
+		 * @return The entry, or nullptr if it isn't in this archive
+		 */
+		const AssetArchiveEntry* Find(Guid_Handle t_ID, std::string_view t_Path) const;
+
+		inline bool Contains(Guid_Handle t_ID, std::string_view t_Path) const { return Find(t_ID, t_Path) != nullptr; }
+
+		std::string_view GetEntryPath(const AssetArchiveEntry& t_Entry) const;
+
+		/**
+		 * Read an asset. Uncompressed assets point straight into the archive, compressed ones are
+		 * decompressed into a buffer of their own.
+		 *
+		 * @param t_bVerify		Check the data against the checksum it was packed with
+		 * @return False if the entry is out of bounds, fails to decompress, or fails the checksum
+		 */
+		bool Read(const AssetArchiveEntry& t_Entry, AssetData& t_Out, bool t_bVerify = true) const;
+
+		/** Call a function on every asset in the archive */
+		template<class FUNC>
+		void ForEachEntry(FUNC&& t_Func) const;
+
+	private:
+
+		std::shared_ptr<const MappedFile> m_Mapping;
+
+		const AssetArchiveHeader* m_Header = nullptr;
+		const AssetArchiveEntry* m_Toc = nullptr;
+		const char* m_Strings = nullptr;
+
+		std::string m_Path;
+	};
+
+	/**
+	 * Packs assets into an archive that AssetArchive can read. Everything is held in memory
+	 * until Write is called.
+	 */
+	class AssetArchiveBuilder : public NonCopyable
+	{
+	public:
+
+		/** Entries start on a multiple of this, so that they can be read in place as any basic type */
+		static constexpr uint64 DefaultAlignment = 16;
+
+		/** @param t_Alignment	Power of 2 that every entry is aligned to */
+		explicit AssetArchiveBuilder(uint64 t_Alignment = DefaultAlignment);
+		virtual ~AssetArchiveBuilder() = default;
+
+		/**
+		 * Add an asset from memory. Adding the same path again replaces it.
+		 *
+		 * @param t_Path		Path of the asset relative to the assets directory (its Guid)
+		 * @param t_bCompress	Try to compress it. It is only kept compressed if that saves at least an eighth
+		 * @return False if another path already in the archive has the same hash
+		 */
+		bool AddData(const std::string& t_Path, const void* t_Data, size_t t_Size, bool t_bCompress = true);
+
+		/** Add an asset from a file on disk */
+		bool AddFile(const std::string& t_Path, const std::string& t_SourceFile, bool t_bCompress = true);
+
+		/**
+		 * Add every file under a directory, with paths relative to that directory
+		 *
+		 * @return Number of files that were added
+		 */
+		size_t AddDirectory(const std::string& t_Dir, bool t_bCompress = true);
+
+		inline size_t GetNumEntries() const { return m_Entries.size(); }
+
+		/** Write the archive out. Returns false if the file couldn't be written */
+		bool Write(const std::string& t_OutPath) const;
+
+	private:
+
+		struct PendingEntry
+		{
+			std::string Path;
+			Guid_Handle ID = 0;
+			uint32 Flags = 0;
+			uint64 Size = 0;
+			uint64 Checksum = 0;
+
+			/** The data as it will be written, compressed or not */
+			std::vector<char> Stored;
+		};
+
+		std::vector<PendingEntry> m_Entries;
+
+		uint64 m_Alignment = DefaultAlignment;
+	};
+
+	template<class FUNC>
+	inline void AssetArchive::ForEachEntry(FUNC&& t_Func) const
+	{
+		if (!m_Header)
+		{
+			return;
+		}
+
+		for (uint32 i = 0; i < m_Header->TocCapacity; ++i)
+		{
+			if (m_Toc[i].Flags & Entry_Used)
+			{
+				t_Func(m_Toc[i]);
+			}
+		}
+	}
+}   // namespace Fling
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "MappedFile.h"
+#include "NonCopyable.hpp"
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * The bytes of one asset file. Points straight into a mapped archive, loose file or in-memory file
+	 * when it can, and only holds its own copy when the asset had to be decompressed. The data is at
+	 * least 16 byte aligned and stays valid for as long as this is around, even if the mount point it
+	 * came from is unmounted.
+	 *
+	 * @see VirtualFileSystem::Read
+	 */
+	class AssetData : public NonCopyable
+	{
+		friend class AssetArchive;
+		friend class VirtualFileSystem;
+
+	public:
+
+		AssetData() = default;
+		virtual ~AssetData() = default;
+
+		AssetData(AssetData&&) = default;
+		AssetData& operator=(AssetData&&) = default;
+
+		/** False if the asset couldn't be found or read */
+		inline bool IsValid() const { return m_bValid; }
+
+		inline const char* GetData() const { return m_View.data(); }
+
+		inline size_t GetSize() const { return m_View.size(); }
+
+		inline std::string_view GetView() const { return m_View; }
+
+		/** True if this is a decompressed copy instead of a view of the file */
+		inline bool IsCopy() const { return !m_Storage.empty(); }
+
+	private:
+
+		std::string_view m_View;
+
+		/** Keeps whatever this points into alive, like a mapped archive or an in-memory file */
+		std::shared_ptr<const void> m_Owner;
+
+		/** A loose file on disk */
+		MappedFile m_Mapping;
+
+		/** Decompressed data */
+		std::vector<char> m_Storage;
+
+		bool m_bValid = false;
+	};
+}   // namespace Fling
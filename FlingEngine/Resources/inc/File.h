@@ -1,14 +1,14 @@
 #pragma once
 
 #include "Resource.h"
-
-#include <fstream>
-#include <vector>
+#include "AssetData.h"
 
 namespace Fling
 {
     /**
-     * A file is a basic text file that contains a basic text file
+     * A file is a basic text file that contains a basic text file.
+     * The file is memory mapped rather than read into a buffer, so GetData points right at the OS page cache
+     * (or into the asset archive it was packed in).
      */
     class File : public Resource
     {
@@ -28,19 +28,19 @@ namespace Fling
          * 
          * @return const char* 
          */
-        const char* GetData() const { return m_Characters.data(); }
+        const char* GetData() const { return m_Data.GetData(); }
 
         /**
          * Get the File Length object
          * 
          * @return size_t Length of the file in characters
          */
-        size_t GetFileLength() const { return m_Characters.size(); }
+        size_t GetFileLength() const { return m_Data.GetSize(); }
 
         /**
          * Returns true if this file resource is loaded or not (i.e. has any characters in the file)
          */
-        bool IsLoaded() const { return m_Characters.size() != 0; }
+        bool IsLoaded() const { return m_Data.GetSize() != 0; }
 
     private:
 
@@ -51,7 +51,7 @@ namespace Fling
 
         void LoadFile();
 
-        /** Array of characters that represents this file */
-        std::vector<char> m_Characters;
+        /** The characters of this file, read only */
+        AssetData m_Data;
     };
 }   // namespace Fling
\ No newline at end of file
@@ -62,6 +62,9 @@ namespace Fling
 		bool IsObject() const;
 		bool IsArray() const;
 
+		/** Every string value in this document, however deeply nested. Keys aren't included */
+		void CollectStrings(std::vector<std::string>& t_Out) const;
+
 	private:
 		struct Impl;
 		std::unique_ptr<Impl> m_Impl;
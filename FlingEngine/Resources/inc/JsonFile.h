@@ -23,6 +23,9 @@ namespace Fling
 		 */
 		explicit JsonFile(Guid t_ID);
 
+		/** JSON files don't need anything from the main thread, so this is the same as a normal load */
+		JsonFile(Guid t_ID, AsyncLoad_t);
+
 		virtual ~JsonFile() = default;
 
 		/**
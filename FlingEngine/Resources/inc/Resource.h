@@ -2,9 +2,59 @@
 
 #include "Platform.h"
 #include "FlingTypes.h"
+#include "AssetData.h"
+
+#include <atomic>
 
 namespace Fling
 {
+	/**
+	 * Tag for the constructor that ResourceManager::LoadResourceAsync uses. Constructors that take it
+	 * run on a loading thread, so they should only read and decode files. Anything that needs the GPU
+	 * or other resources goes in FinalizeAsyncLoad instead.
+	 */
+	struct AsyncLoad_t
+	{
+		explicit AsyncLoad_t() = default;
+	};
+	inline constexpr AsyncLoad_t AsyncLoad {};
+
+	/** Kinds of memory that resources use. The ResourceManager keeps a separate budget for each */
+	enum class ResourceMemoryType : uint8
+	{
+		/** GPU images */
+		Texture,
+
+		/** GPU vertex and index buffers */
+		Mesh,
+
+		/** CPU side copies of data, like decoded pixels and vertex arrays */
+		CPU,
+
+		Count
+	};
+
+	/** How many bytes of each kind of memory a resource is using */
+	struct ResourceMemoryUsage
+	{
+		uint64 Bytes[static_cast<size_t>(ResourceMemoryType::Count)] = {};
+
+		inline uint64& operator[](ResourceMemoryType t_Type) { return Bytes[static_cast<size_t>(t_Type)]; }
+		inline uint64 operator[](ResourceMemoryType t_Type) const { return Bytes[static_cast<size_t>(t_Type)]; }
+
+		inline bool IsEmpty() const
+		{
+			for (uint64 Count : Bytes)
+			{
+				if (Count != 0)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+
 	/**
 	* Base class that represents a loaded resource in the engine
 	*/
@@ -41,10 +91,43 @@ namespace Fling
          */
         std::string GetFilepathReleativeToAssets() const;
 
+		/**
+		 * Read the file of this resource, from a mounted archive if it is in one
+		 *
+		 * @see ResourceManager::ReadAsset
+		 */
+		bool ReadAsset(AssetData& t_Out) const;
+
+		/** How much memory this resource is using. Only looked at when it is added to the ResourceManager */
+		virtual ResourceMemoryUsage GetMemoryUsage() const { return {}; }
+
+		/**
+		 * If the ResourceManager can unload this resource once nothing else is using it. Only
+		 * resources that can be loaded again from just their Guid should say yes.
+		 */
+		virtual bool CanBeEvicted() const { return false; }
+
     protected:
 
+		/**
+		 * Second half of an asynchronous load, called on the main thread after the AsyncLoad_t
+		 * constructor has finished. This is the place to create GPU objects.
+		 *
+		 * @return False if this is waiting on something else (i.e. other resources it loaded)
+		 *			and should be called again next frame
+		 */
+		virtual bool FinalizeAsyncLoad() { return true; }
+
         Fling::Guid m_Guid;
 
 		std::string m_HumanReadableName;
+
+	private:
+
+		/** ResourceManager frame that this was last handed out or seen in use, for LRU eviction */
+		std::atomic<uint64> m_LastUsedFrame { 0 };
+
+		/** What GetMemoryUsage said when this was added to the ResourceManager */
+		ResourceMemoryUsage m_ResidentUsage;
 	};
 }	// namespace Fling
\ No newline at end of file
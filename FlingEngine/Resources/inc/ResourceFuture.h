@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Resource.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace Fling
+{
+	/** Where an asynchronous resource load is at */
+	enum class AsyncLoadStatus : uint8
+	{
+		/** Waiting for a loading thread to pick it up */
+		Queued,
+
+		/** Being read and decoded on a loading thread */
+		Loading,
+
+		/** Waiting for the main thread to finish it off (i.e. upload it to the GPU) */
+		Finalizing,
+
+		Ready,
+		Failed
+	};
+
+	/**
+	 * Book keeping for a single asynchronous load. Shared between the ResourceManager and every
+	 * ResourceFuture that is waiting on it, so that loading the same Guid twice only loads it once.
+	 */
+	struct AsyncLoadState
+	{
+		/** Keep the path around, the Guid only points at the string it was made from */
+		std::string Path;
+
+		Guid_Handle ID = 0;
+
+		/** Runs on a loading thread and constructs the resource */
+		std::function<std::shared_ptr<Resource>(const AsyncLoadState&)> Construct;
+
+		/** Set by the loading thread. Only safe to read once the status is Finalizing or later */
+		std::shared_ptr<Resource> Result;
+
+		std::atomic<AsyncLoadStatus> Status { AsyncLoadStatus::Queued };
+	};
+
+	/**
+	 * A handle to a resource that is being loaded by ResourceManager::LoadResourceAsync.
+	 * The resource becomes available on the main thread at the start of a frame, so it is
+	 * safe to poll this every frame and use a placeholder until it is ready.
+	 */
+	template<class T>
+	class ResourceFuture
+	{
+	public:
+
+		ResourceFuture() = default;
+
+		explicit ResourceFuture(std::shared_ptr<AsyncLoadState> t_State)
+			: m_State(std::move(t_State))
+		{}
+
+		/** False for a default constructed future that was never given a load */
+		inline bool IsValid() const { return m_State != nullptr; }
+
+		inline AsyncLoadStatus GetStatus() const
+		{
+			return m_State ? m_State->Status.load(std::memory_order_acquire) : AsyncLoadStatus::Failed;
+		}
+
+		inline bool IsReady() const { return GetStatus() == AsyncLoadStatus::Ready; }
+
+		inline bool HasFailed() const { return GetStatus() == AsyncLoadStatus::Failed; }
+
+		/** True once the load has either finished or failed */
+		inline bool IsDone() const { return IsReady() || HasFailed(); }
+
+		/** The loaded resource, or nullptr if it is not ready yet */
+		std::shared_ptr<T> Get() const
+		{
+			return IsReady() ? std::static_pointer_cast<T>(m_State->Result) : nullptr;
+		}
+
+		/** The loaded resource, or t_Placeholder if it is not ready yet */
+		std::shared_ptr<T> GetOr(const std::shared_ptr<T>& t_Placeholder) const
+		{
+			std::shared_ptr<T> Loaded = Get();
+			return Loaded ? Loaded : t_Placeholder;
+		}
+
+		/** Stop waiting on this load. It keeps going in the background if anyone else wants it */
+		inline void Reset() { m_State.reset(); }
+
+	private:
+
+		std::shared_ptr<AsyncLoadState> m_State;
+	};
+}	// namespace Fling
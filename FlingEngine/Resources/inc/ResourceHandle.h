@@ -0,0 +1,379 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "NonCopyable.hpp"
+#include "ResourceFuture.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * A 32 bit reference to a resource of type T. The low bits are an index into the slot array
+	 * for T and the high bits are the generation that slot was on when the handle was made.
+	 * When the last owner of a slot lets go of it the generation goes up, so any handle that is
+	 * still hanging around resolves to nullptr instead of to whatever uses the slot next. A slot
+	 * that has used up every generation is retired instead of wrapping back around to 1.
+	 *
+	 * Handles are plain values, so components that hold them can be memcpy'd and serialized.
+	 * Create and release them through the ResourceManager.
+	 *
+	 * @see ResourceManager::LoadResourceHandle
+	 * @see ResourceManager::Resolve
+	 */
+	template<class T>
+	class ResourceHandle
+	{
+	public:
+
+		static constexpr uint32 IndexBits = 20;
+		static constexpr uint32 GenerationBits = 32 - IndexBits;
+
+		static constexpr uint32 MaxIndex = (1u << IndexBits) - 1;
+		static constexpr uint32 MaxGeneration = (1u << GenerationBits) - 1;
+
+		/** An invalid handle, generations start at 1 so nothing else is ever 0 */
+		constexpr ResourceHandle() = default;
+
+		constexpr ResourceHandle(uint32 t_Index, uint32 t_Generation)
+			: m_Value((t_Generation << IndexBits) | (t_Index & MaxIndex))
+		{}
+
+		static constexpr ResourceHandle FromValue(uint32 t_Value)
+		{
+			ResourceHandle Handle;
+			Handle.m_Value = t_Value;
+			return Handle;
+		}
+
+		inline constexpr uint32 GetIndex() const { return m_Value & MaxIndex; }
+		inline constexpr uint32 GetGeneration() const { return m_Value >> IndexBits; }
+		inline constexpr uint32 GetValue() const { return m_Value; }
+
+		/** True if this was ever given a resource. It can still be stale, Resolve it to find out */
+		inline constexpr bool IsValid() const { return m_Value != 0; }
+
+		inline constexpr bool operator==(const ResourceHandle& t_Other) const { return m_Value == t_Other.m_Value; }
+		inline constexpr bool operator!=(const ResourceHandle& t_Other) const { return m_Value != t_Other.m_Value; }
+
+	private:
+
+		uint32 m_Value = 0;
+	};
+
+	/** Lets the ResourceManager update and clear the slots of every type without knowing about them */
+	class ResourceSlotArrayBase : public NonCopyable
+	{
+	public:
+
+		virtual ~ResourceSlotArrayBase() = default;
+
+		/** Fill in slots whose asynchronous loads have finished */
+		virtual void UpdatePendingLoads() = 0;
+
+		/** Release every slot, making all of the handles to them stale */
+		virtual void Clear() = 0;
+	};
+
+	/**
+	 * The slots that ResourceHandle<T> indexes into. Each slot is one resource. It is shared by
+	 * every handle to that resource and keeps it loaded (and out of eviction) while anything owns
+	 * a handle to it. Slots live in fixed size chunks that never move, so resolving a handle is
+	 * a couple of array lookups.
+	 *
+	 * Acquire and Release are only called from the main thread. Resolve can be called from any
+	 * thread, but what it returns is only safe to use until the main thread releases the handle.
+	 */
+	template<class T>
+	class ResourceSlotArray : public ResourceSlotArrayBase
+	{
+	public:
+
+		using Handle = ResourceHandle<T>;
+
+		ResourceSlotArray() = default;
+		virtual ~ResourceSlotArray() = default;
+
+		/**
+		 * Add an owner to the slot for this resource, making a new slot if there isn't one.
+		 * A new slot resolves to nullptr until SetResource or SetPending fills it in.
+		 *
+		 * @param t_ID		Guid of the resource
+		 * @param t_Path	Path the Guid was made from, kept so the handle can be saved before it loads
+		 */
+		Handle Acquire(Guid_Handle t_ID, const std::string& t_Path);
+
+		/** Add another owner to a handle that is still live. Does nothing for a stale handle */
+		void AddRef(Handle t_Handle);
+
+		/** Remove an owner. Once there are none the resource can be evicted and the handle goes stale */
+		void Release(Handle t_Handle);
+
+		/** The resource this handle points at, or nullptr if it is stale or still loading */
+		inline T* Resolve(Handle t_Handle) const
+		{
+			const Slot* CurSlot = GetSlot(t_Handle);
+			return CurSlot ? CurSlot->Ptr.load(std::memory_order_acquire) : nullptr;
+		}
+
+		/** The path of the resource, even if it is still loading. Empty for a stale handle */
+		const std::string& GetPath(Handle t_Handle) const;
+
+		/** True if the handle is live and waiting on an asynchronous load */
+		bool IsPending(Handle t_Handle) const;
+
+		/** Point a live slot at a loaded resource */
+		void SetResource(Handle t_Handle, std::shared_ptr<T> t_Resource);
+
+		/** Fill in a live slot once this load is ready */
+		void SetPending(Handle t_Handle, const ResourceFuture<T>& t_Future);
+
+		/** Number of owners of the slot, 0 for a stale handle */
+		uint32 GetNumRefs(Handle t_Handle) const;
+
+		/** Number of slots that are in use */
+		inline size_t GetNumLiveSlots() const { return m_SlotsById.size(); }
+
+		virtual void UpdatePendingLoads() override;
+
+		virtual void Clear() override;
+
+	private:
+
+		static constexpr uint32 ChunkBits = 10;
+		static constexpr uint32 ChunkSize = 1u << ChunkBits;
+		static constexpr uint32 MaxChunks = (Handle::MaxIndex + 1) / ChunkSize;
+
+		/** Doesn't fit in a handle, so no handle ever matches a retired slot */
+		static constexpr uint32 RetiredGeneration = Handle::MaxGeneration + 1;
+
+		struct Slot
+		{
+			/** What handles resolve to. Set at the same time as Owner */
+			std::atomic<T*> Ptr { nullptr };
+
+			/** Bumped every time the slot is released, never 0. RetiredGeneration once it has run out */
+			std::atomic<uint32> Generation { 1 };
+
+			uint32 NumRefs = 0;
+
+			/** The reference that keeps the resource loaded while the slot has owners */
+			std::shared_ptr<T> Owner;
+
+			ResourceFuture<T> Pending;
+
+			std::string Path;
+
+			Guid_Handle ID = 0;
+		};
+
+		/** The slot for a live handle, or nullptr if the handle is stale */
+		inline Slot* GetSlot(Handle t_Handle) const
+		{
+			if (!t_Handle.IsValid() || t_Handle.GetIndex() >= m_NumSlots)
+			{
+				return nullptr;
+			}
+
+			Slot& CurSlot = m_Chunks[t_Handle.GetIndex() >> ChunkBits][t_Handle.GetIndex() & (ChunkSize - 1)];
+			return CurSlot.Generation.load(std::memory_order_acquire) == t_Handle.GetGeneration() ? &CurSlot : nullptr;
+		}
+
+		/** Only a chunk at a time is allocated, the rest stay null until they are needed */
+		std::unique_ptr<Slot[]> m_Chunks[MaxChunks];
+
+		/** Number of slots that have ever been used, only the main thread writes this */
+		std::atomic<uint32> m_NumSlots { 0 };
+
+		std::vector<uint32> m_FreeSlots;
+
+		/** Used slots, so the same resource always gets the same slot */
+		std::unordered_map<Guid_Handle, uint32> m_SlotsById;
+
+		/** Slots that are waiting on an asynchronous load */
+		std::vector<uint32> m_PendingSlots;
+	};
+
+	template<class T>
+	typename ResourceSlotArray<T>::Handle ResourceSlotArray<T>::Acquire(Guid_Handle t_ID, const std::string& t_Path)
+	{
+		auto ExistingIt = m_SlotsById.find(t_ID);
+		if (ExistingIt != m_SlotsById.end())
+		{
+			Slot& CurSlot = m_Chunks[ExistingIt->second >> ChunkBits][ExistingIt->second & (ChunkSize - 1)];
+			++CurSlot.NumRefs;
+			return Handle(ExistingIt->second, CurSlot.Generation.load(std::memory_order_relaxed));
+		}
+
+		uint32 Index = 0;
+		if (!m_FreeSlots.empty())
+		{
+			Index = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			Index = m_NumSlots.load(std::memory_order_relaxed);
+			if (Index > Handle::MaxIndex)
+			{
+				F_LOG_FATAL("Out of resource handle slots!");
+			}
+
+			std::unique_ptr<Slot[]>& Chunk = m_Chunks[Index >> ChunkBits];
+			if (!Chunk)
+			{
+				Chunk = std::make_unique<Slot[]>(ChunkSize);
+			}
+			m_NumSlots.store(Index + 1, std::memory_order_release);
+		}
+
+		Slot& CurSlot = m_Chunks[Index >> ChunkBits][Index & (ChunkSize - 1)];
+		CurSlot.NumRefs = 1;
+		CurSlot.ID = t_ID;
+		CurSlot.Path = t_Path;
+		m_SlotsById.emplace(t_ID, Index);
+
+		return Handle(Index, CurSlot.Generation.load(std::memory_order_relaxed));
+	}
+
+	template<class T>
+	void ResourceSlotArray<T>::AddRef(Handle t_Handle)
+	{
+		if (Slot* CurSlot = GetSlot(t_Handle))
+		{
+			++CurSlot->NumRefs;
+		}
+	}
+
+	template<class T>
+	void ResourceSlotArray<T>::Release(Handle t_Handle)
+	{
+		Slot* CurSlot = GetSlot(t_Handle);
+		if (!CurSlot || --CurSlot->NumRefs > 0)
+		{
+			return;
+		}
+
+		// Stale handles fail the generation check from here on. Wrapping around would make handles
+		// from 4096 uses ago live again, so a slot that has run out of generations is never used again
+		const uint32 NextGeneration = CurSlot->Generation.load(std::memory_order_relaxed) + 1;
+		CurSlot->Generation.store(NextGeneration, std::memory_order_release);
+		CurSlot->Ptr.store(nullptr, std::memory_order_release);
+
+		m_SlotsById.erase(CurSlot->ID);
+		if (NextGeneration != RetiredGeneration)
+		{
+			m_FreeSlots.push_back(t_Handle.GetIndex());
+		}
+
+		// Let go of the resource last, destroying it might release other handles
+		std::shared_ptr<T> Owner = std::move(CurSlot->Owner);
+		CurSlot->Pending.Reset();
+		CurSlot->Path.clear();
+		CurSlot->ID = 0;
+	}
+
+	template<class T>
+	const std::string& ResourceSlotArray<T>::GetPath(Handle t_Handle) const
+	{
+		static const std::string Empty;
+		const Slot* CurSlot = GetSlot(t_Handle);
+		return CurSlot ? CurSlot->Path : Empty;
+	}
+
+	template<class T>
+	bool ResourceSlotArray<T>::IsPending(Handle t_Handle) const
+	{
+		const Slot* CurSlot = GetSlot(t_Handle);
+		return CurSlot && CurSlot->Pending.IsValid();
+	}
+
+	template<class T>
+	void ResourceSlotArray<T>::SetResource(Handle t_Handle, std::shared_ptr<T> t_Resource)
+	{
+		if (Slot* CurSlot = GetSlot(t_Handle))
+		{
+			CurSlot->Pending.Reset();
+			CurSlot->Ptr.store(t_Resource.get(), std::memory_order_release);
+			CurSlot->Owner = std::move(t_Resource);
+		}
+	}
+
+	template<class T>
+	void ResourceSlotArray<T>::SetPending(Handle t_Handle, const ResourceFuture<T>& t_Future)
+	{
+		Slot* CurSlot = GetSlot(t_Handle);
+		if (!CurSlot)
+		{
+			return;
+		}
+
+		if (t_Future.IsReady())
+		{
+			SetResource(t_Handle, t_Future.Get());
+		}
+		else if (!t_Future.HasFailed())
+		{
+			CurSlot->Pending = t_Future;
+			m_PendingSlots.push_back(t_Handle.GetIndex());
+		}
+	}
+
+	template<class T>
+	uint32 ResourceSlotArray<T>::GetNumRefs(Handle t_Handle) const
+	{
+		const Slot* CurSlot = GetSlot(t_Handle);
+		return CurSlot ? CurSlot->NumRefs : 0;
+	}
+
+	template<class T>
+	void ResourceSlotArray<T>::UpdatePendingLoads()
+	{
+		for (size_t i = 0; i < m_PendingSlots.size();)
+		{
+			Slot& CurSlot = m_Chunks[m_PendingSlots[i] >> ChunkBits][m_PendingSlots[i] & (ChunkSize - 1)];
+
+			// Released (or filled in some other way) before the load finished
+			if (CurSlot.Pending.IsValid() && !CurSlot.Pending.IsDone())
+			{
+				++i;
+				continue;
+			}
+
+			if (CurSlot.Pending.IsReady())
+			{
+				std::shared_ptr<T> Loaded = CurSlot.Pending.Get();
+				CurSlot.Ptr.store(Loaded.get(), std::memory_order_release);
+				CurSlot.Owner = std::move(Loaded);
+			}
+			CurSlot.Pending.Reset();
+
+			m_PendingSlots[i] = m_PendingSlots.back();
+			m_PendingSlots.pop_back();
+		}
+	}
+
+	template<class T>
+	void ResourceSlotArray<T>::Clear()
+	{
+		const uint32 NumSlots = m_NumSlots.load(std::memory_order_relaxed);
+		for (uint32 Index = 0; Index < NumSlots; ++Index)
+		{
+			Slot& CurSlot = m_Chunks[Index >> ChunkBits][Index & (ChunkSize - 1)];
+			if (CurSlot.NumRefs == 0)
+			{
+				continue;
+			}
+
+			// Drop every owner at once
+			CurSlot.NumRefs = 1;
+			Release(Handle(Index, CurSlot.Generation.load(std::memory_order_relaxed)));
+		}
+
+		m_PendingSlots.clear();
+	}
+}	// namespace Fling
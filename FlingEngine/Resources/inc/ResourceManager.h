@@ -1,21 +1,70 @@
 #pragma once
 
 #include "Singleton.hpp"
+#include "VirtualFileSystem.h"
 #include "Resource.h"
+#include "ResourceFuture.h"
+#include "ResourceHandle.h"
+#include "ResourceTable.h"
 #include "FlingTypes.h" // Guid
+#include "VirtualArena.h"
+#include "ConcurrentQueue.hpp"
+#include "Profiler.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <vector>
-#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 
 namespace Fling
 {
+	/** Memory use of one ResourceMemoryType */
+	struct ResourceResidency
+	{
+		/** Bytes used by loaded resources, including evicted ones that haven't been freed yet */
+		uint64 CurrentBytes = 0;
+
+		/** Most CurrentBytes has been since Init */
+		uint64 PeakBytes = 0;
+
+		/** 0 if there is no budget */
+		uint64 BudgetBytes = 0;
+	};
+
 	/**
 	 * The resource manager handles loading of files off disk. Every Resource type
 	 * has a Guid. This Guid functions as both the file path (relative to the ASSETS directory)
 	 * as well as a hashed string for easy passing around of information. Each resource is only 
 	 * ever loaded into memory ONCE.
 	 * 
+	 * Loaded resources live in a sharded ResourceTable, so LoadResource, GetResource and IsLoaded
+	 * can be called from any thread. If two different paths hash to the same Guid then loading
+	 * the second one is a fatal error, rename one of the files.
+	 * 
+	 * Every kind of ResourceMemoryType has a budget ("TextureBudgetMB", "MeshBudgetMB" and
+	 * "CPUResourceBudgetMB", 0 for no limit). When one is over, Update unloads the least recently
+	 * used resources that nothing else has a reference to. Evicted resources are kept alive for
+	 * "ResourceEvictionDelayFrames" more frames so that frames in flight can finish with them,
+	 * and are loaded again the next time someone asks for them.
+	 * 
+	 * Resources can also be streamed in with LoadResourceAsync. Files are read and decoded on a
+	 * pool of loading threads ("ResourceLoadThreads", 2 by default), then finished off on the main
+	 * thread in Update, which is where GPU objects get created. Update only spends about
+	 * "ResourceFinalizeBudgetMs" each frame finalizing so that a burst of loads doesn't hitch.
+	 * 
+	 * Components should hold a ResourceHandle instead of a shared_ptr. Handles are 32 bits,
+	 * resolve in constant time, and go stale (resolve to nullptr) once every owner has released them.
+	 * 
+	 * Resources read their files with ReadAsset, which goes through the VirtualFileSystem. Init mounts
+	 * the assets directory, and the archive in "AssetArchive" on top of it, so mounted archives
+	 * are looked in before the loose files.
+	 * 
 	 * @see Fling::Guid
 	 * @see Fling::Guid_Handle
 	 * @see Fling::Resource
@@ -28,12 +77,76 @@ namespace Fling
 
 		virtual void Shutdown() override;
 
+		/** Max number of loads that can be waiting on a loading thread before they back up on the main thread */
+		static constexpr size_t MaxQueuedLoads = 1024;
+
 		template<class T, class ...ARGS>
 		static std::shared_ptr<T> LoadResource(Guid t_ID, ARGS&& ... args)
 		{
 			return ResourceManager::Get().LoadResourceImpl<T>(t_ID, std::forward<ARGS>(args)...);
 		}
 
+		/**
+		 * Start loading a resource in the background. Resource types opt in to this by having a
+		 * constructor that takes (Guid, AsyncLoad_t), and can override Resource::FinalizeAsyncLoad
+		 * to do the rest of their work on the main thread. Unlike LoadResource, only call this from the main thread.
+		 *
+		 * @param t_ID 	Guid of the resource (a path relative to the assets directory)
+		 * @return A future that is ready right away if the resource was already loaded
+		 */
+		template<class T>
+		static ResourceFuture<T> LoadResourceAsync(Guid t_ID)
+		{
+			return ResourceManager::Get().LoadResourceAsyncImpl<T>(t_ID);
+		}
+
+		/**
+		 * Finish off any asynchronous loads that have been read in and make them available,
+		 * then evict resources if anything is over budget. Call this once a frame from the main thread.
+		 */
+		void Update();
+
+		/** Block until every asynchronous load has finished. Handy for loading screens and tests */
+		void FlushAsyncLoads();
+
+		/** Number of asynchronous loads that have not finished yet */
+		inline size_t GetNumPendingLoads() const { return m_PendingLoads.size(); }
+
+		/**
+		 * Load a resource and get a handle to it. The handle owns a reference to the resource
+		 * until it is given back with ReleaseHandle. Only call the handle functions from the main thread.
+		 */
+		template<class T, class ...ARGS>
+		static ResourceHandle<T> LoadResourceHandle(Guid t_ID, ARGS&& ... args);
+
+		/** Like LoadResourceHandle, but the handle resolves to nullptr until the resource has streamed in */
+		template<class T>
+		static ResourceHandle<T> LoadResourceHandleAsync(Guid t_ID);
+
+		/** Get a handle to a resource that is already loaded. Invalid if t_Resource is null */
+		template<class T>
+		static ResourceHandle<T> AcquireHandle(const std::shared_ptr<T>& t_Resource);
+
+		/** Add another owner to a handle, each owner has to call ReleaseHandle */
+		template<class T>
+		static void AddHandleRef(ResourceHandle<T> t_Handle) { GetSlots<T>().AddRef(t_Handle); }
+
+		/** Give back a handle and reset it. Safe to call on invalid and stale handles */
+		template<class T>
+		static void ReleaseHandle(ResourceHandle<T>& t_Handle);
+
+		/** The resource a handle points at, or nullptr if it is stale or still loading. Safe to call from any thread */
+		template<class T>
+		static T* Resolve(ResourceHandle<T> t_Handle) { return GetSlots<T>().Resolve(t_Handle); }
+
+		/** Path of the resource a handle points at, even if it is still loading */
+		template<class T>
+		static const std::string& GetHandlePath(ResourceHandle<T> t_Handle) { return GetSlots<T>().GetPath(t_Handle); }
+
+		/** The slots that handles to resources of type T point into */
+		template<class T>
+		static ResourceSlotArray<T>& GetSlots();
+
 		template <class T>
 		std::shared_ptr<T> GetResourceOfType(Guid_Handle t_ID) const;
 
@@ -45,22 +158,209 @@ namespace Fling
 		 */
 		std::shared_ptr<Resource> GetResource(Guid_Handle t_ID) const;
 
+		/** Get the current and peak memory use of one kind of resource memory */
+		ResourceResidency GetResidency(ResourceMemoryType t_Type) const;
+
+		/**
+		 * Set how much of one kind of memory resources can use before some are evicted
+		 *
+		 * @param t_Bytes	The budget, or 0 for no limit
+		 */
+		void SetBudget(ResourceMemoryType t_Type, uint64 t_Bytes);
+
+		/** Log the current and peak residency of every kind of resource memory */
+		void LogResidency() const;
+
+		/** Number of resources that have been evicted since Init */
+		inline uint64 GetNumEvictions() const { return m_NumEvictions; }
+
+		static const char* GetMemoryTypeName(ResourceMemoryType t_Type);
+
+		/** Priority of the assets directory in the file system */
+		static constexpr int32 LooseFilePriority = 0;
+
+		/** Priority of archives mounted with MountArchive, above the loose files */
+		static constexpr int32 ArchivePriority = 100;
+
+		/**
+		 * Mount an asset archive. Archives that are mounted later are searched first, so patches
+		 * can be mounted on top of the base game.
+		 *
+		 * @return False if the archive couldn't be opened
+		 */
+		bool MountArchive(const std::string& t_Path);
+
+		/** Unmount every archive. Assets that were already read from them stay valid */
+		void UnmountArchives();
+
+		inline size_t GetNumMountedArchives() const { return m_FileSystem.GetNumMounts(VfsMountType::Archive); }
+
+		/**
+		 * Read the bytes of an asset file. Safe to call from any thread.
+		 *
+		 * @param t_ID		Guid_Handle of the asset
+		 * @param t_Path	Path of the asset relative to the assets directory
+		 * @return False if the asset isn't in the file system, or is corrupt
+		 */
+		inline bool ReadAsset(Guid_Handle t_ID, const std::string& t_Path, AssetData& t_Out) const { return m_FileSystem.Read(t_ID, t_Path, t_Out); }
+
+		/** Where every asset file is read from */
+		inline VirtualFileSystem& GetFileSystem() { return m_FileSystem; }
+
 		/**
 		* Check if there is a resource with this ID loaded or not
 		* @return	If the resource ID is loaded or not
 		*/
 		bool IsLoaded(Guid_Handle t_ID) const;
 
+		/**
+		 * Scratch memory for importing resources. Anything allocated from here is freed once
+		 * the resource that is currently being loaded has finished constructing, so only use
+		 * it for temporary data while parsing files. The reserve size can be set with
+		 * "ImportArenaSize" (in bytes) and huge pages disabled with "ImportArenaHugePages=false".
+		 * Every loading thread has its own import arena.
+		 */
+		VirtualArena& GetImportArena();
+
 	private:
 
 		template<class T, class ...ARGS>
 		std::shared_ptr<T> LoadResourceImpl(Guid t_ID, ARGS&& ... args);
 
-		typedef std::map<Fling::Guid_Handle, std::shared_ptr<Resource>>::iterator ResourceMapIt;
-		typedef std::map<Fling::Guid_Handle, std::shared_ptr<Resource>>::const_iterator ResourceMapConstIt;
-        
-		///** Map of currently loaded resources */
-		std::map<Fling::Guid_Handle, std::shared_ptr<Resource>> m_ResourceMap;
+		template<class T>
+		ResourceFuture<T> LoadResourceAsyncImpl(Guid t_ID);
+
+		/** Hand a new load off to the loading threads */
+		void QueueAsyncLoad(const std::shared_ptr<AsyncLoadState>& t_State);
+
+		/** Run the construct step of a load on the calling thread */
+		static void RunAsyncLoad(AsyncLoadState& t_State);
+
+		void LoadThreadLoop();
+
+		std::unique_ptr<VirtualArena> CreateImportArena() const;
+
+		/**
+		 * Get the loaded resource with this Guid, making sure that it really was loaded from the same path
+		 *
+		 * @return The loaded resource, or nullptr if it isn't loaded
+		 * @throws std::runtime_error if a different path with the same hash was loaded
+		 */
+		std::shared_ptr<Resource> FindLoaded(Guid t_ID) const;
+
+		/**
+		 * Add a newly loaded resource to the table
+		 *
+		 * @return The resource to use, which is the one that was already there if another thread beat us to it
+		 * @throws std::runtime_error if a different path with the same hash was loaded
+		 */
+		std::shared_ptr<Resource> AddLoaded(const std::shared_ptr<Resource>& t_Resource);
+
+		/**
+		 * Log both paths and throw. Synchronous loads, asynchronous loads and handles all report
+		 * collisions through here, so two paths with the same hash are always fatal
+		 */
+		[[noreturn]] static void ReportGuidCollision(const std::string& t_Loaded, const std::string& t_New);
+
+		/** Add an owner to the slot for this resource, making sure that it is for the same path */
+		template<class T>
+		static ResourceHandle<T> AcquireSlot(Guid_Handle t_ID, const std::string& t_Path);
+
+		/** Take ownership of a slot array so that Update and Shutdown can get to it */
+		template<class T>
+		T* RegisterSlotArray(std::unique_ptr<T> t_Slots);
+
+		/** A copy of the registered slot arrays, so that more can be registered while going through them */
+		std::vector<ResourceSlotArrayBase*> GetSlotArrays() const;
+
+		/** Mark a resource as used this frame */
+		inline void Touch(Resource& t_Resource) const { t_Resource.m_LastUsedFrame.store(m_FrameIndex.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+		/** Add or remove the memory of a resource from the residency totals */
+		void AddResidency(const ResourceMemoryUsage& t_Usage);
+		void RemoveResidency(const ResourceMemoryUsage& t_Usage);
+
+		/** Unload resources until everything is under budget, called at the end of Update */
+		void EvictOverBudget();
+
+		/** Free evicted resources that no frame in flight could still be using */
+		void FreeEvictedResources(bool t_bFreeAll);
+
+		/** Currently loaded resources */
+		ResourceTable m_Resources;
+
+		std::unique_ptr<VirtualArena> m_ImportArena;
+
+		/** The thread that called Init, it uses m_ImportArena */
+		std::thread::id m_MainThreadId;
+
+		// Budgets and eviction ------------------------------------------------------------------
+
+		static constexpr size_t NumMemoryTypes = static_cast<size_t>(ResourceMemoryType::Count);
+
+		std::atomic<uint64> m_CurrentBytes[NumMemoryTypes] = {};
+		std::atomic<uint64> m_PeakBytes[NumMemoryTypes] = {};
+		uint64 m_BudgetBytes[NumMemoryTypes] = {};
+
+		/** Bytes of resources that have been evicted but not freed yet, only touched on the main thread */
+		uint64 m_EvictedBytes[NumMemoryTypes] = {};
+
+		/** A resource that has been taken out of the table and is waiting to be freed */
+		struct EvictedResource
+		{
+			std::shared_ptr<Resource> Res;
+			uint64 EvictedFrame = 0;
+		};
+
+		/** In the order they were evicted, only touched on the main thread */
+		std::deque<EvictedResource> m_EvictedResources;
+
+		/** Number of frames an evicted resource is kept around for */
+		uint64 m_EvictionDelayFrames = 4;
+
+		/** Incremented every Update, used to find the least recently used resources */
+		std::atomic<uint64> m_FrameIndex { 0 };
+
+		uint64 m_NumEvictions = 0;
+
+		// Handles -------------------------------------------------------------------------------
+
+		/** One for every type that has had a handle, they outlive Shutdown so that Init can be called again */
+		std::vector<std::unique_ptr<ResourceSlotArrayBase>> m_SlotArrays;
+		mutable std::mutex m_SlotArrayMutex;
+
+		// Files ---------------------------------------------------------------------------------
+
+		VirtualFileSystem m_FileSystem;
+
+		// Asynchronous loading ------------------------------------------------------------------
+
+		/** Loads that haven't finished yet, only touched on the main thread */
+		std::unordered_map<Guid_Handle, std::shared_ptr<AsyncLoadState>> m_PendingLoads;
+
+		/** Loads that are waiting for a loading thread */
+		std::unique_ptr<MpmcQueue<AsyncLoadState*, MaxQueuedLoads>> m_LoadRequests;
+
+		/** Loads that a loading thread is done with */
+		std::unique_ptr<MpmcQueue<AsyncLoadState*, MaxQueuedLoads>> m_LoadCompletions;
+
+		/** Loads that didn't fit in m_LoadRequests, only touched on the main thread */
+		std::deque<AsyncLoadState*> m_LoadBacklog;
+
+		/** Loads that are being finalized on the main thread, in the order they finished loading */
+		std::deque<AsyncLoadState*> m_Finalizing;
+
+		std::vector<std::thread> m_LoadThreads;
+
+		/** Loading threads sleep on this while there is nothing to load */
+		std::mutex m_LoadThreadMutex;
+		std::condition_variable m_LoadThreadCondition;
+
+		/** Loading threads check this between loads, and while they wait for room to hand a load back */
+		std::atomic<bool> m_StopLoadThreads { false };
+
+		/** Roughly how long Update can spend finalizing loads each frame, in seconds */
+		float m_FinalizeBudget = 0.004f;
 	};
 
 
@@ -68,18 +368,143 @@ namespace Fling
 	inline std::shared_ptr<T> ResourceManager::LoadResourceImpl(Guid t_ID, ARGS&& ... args)
 	{
 		// If this resource exists already then just return that
-		if (std::shared_ptr<T> Existing = GetResourceOfType<T>(t_ID))
+		if (std::shared_ptr<Resource> Existing = FindLoaded(t_ID))
 		{
-			return Existing;
+			return std::static_pointer_cast<T>(Existing);
 		}
 
+		FLING_PROFILE_SCOPE("ResourceManager::LoadResource");
+
+		// Anything the resource puts in the import arena while it loads is thrown out afterwards
+		VirtualArena::Scope ImportScope(GetImportArena());
+
 		// Create a new resource of type T and return it
 		// Every resource type has an explict CTOR whose first arg has to be an ID
 		std::shared_ptr<Resource> NewResource = std::make_shared<T>(t_ID, std::forward<ARGS>(args)...);
 
-		// Keep track of this resource in the map
-		m_ResourceMap[t_ID] = NewResource;
-		return std::static_pointer_cast<T>( NewResource );
+		// Keep track of this resource. If another thread loaded it at the same time then theirs wins
+		return std::static_pointer_cast<T>( AddLoaded(NewResource) );
+	}
+
+	template<class T>
+	inline ResourceFuture<T> ResourceManager::LoadResourceAsyncImpl(Guid t_ID)
+	{
+		static_assert(std::is_base_of<Resource, T>::value, "Only resources can be loaded asynchronously");
+		static_assert(std::is_constructible<T, Guid, AsyncLoad_t>::value, "Resource needs a (Guid, AsyncLoad_t) constructor to be loaded asynchronously");
+
+		// Already being loaded, wait on the same load
+		auto PendingIt = m_PendingLoads.find(t_ID);
+		if (PendingIt != m_PendingLoads.end())
+		{
+			if (PendingIt->second->Path != t_ID.data())
+			{
+				ReportGuidCollision(PendingIt->second->Path, t_ID.data());
+			}
+			return ResourceFuture<T>(PendingIt->second);
+		}
+
+		std::shared_ptr<AsyncLoadState> State = std::make_shared<AsyncLoadState>();
+		State->ID = t_ID;
+
+		// Already loaded, hand back a future that is ready to go
+		if (std::shared_ptr<Resource> Existing = FindLoaded(t_ID))
+		{
+			State->Result = std::move(Existing);
+			State->Status.store(AsyncLoadStatus::Ready, std::memory_order_release);
+			return ResourceFuture<T>(State);
+		}
+
+		State->Path = t_ID.data();
+		State->Construct = [](const AsyncLoadState& t_State) -> std::shared_ptr<Resource>
+		{
+			return std::make_shared<T>(Guid{ t_State.Path.c_str() }, AsyncLoad);
+		};
+
+		m_PendingLoads.emplace(t_ID, State);
+		QueueAsyncLoad(State);
+		return ResourceFuture<T>(State);
+	}
+
+	template<class T>
+	inline ResourceSlotArray<T>& ResourceManager::GetSlots()
+	{
+		static ResourceSlotArray<T>* Slots = ResourceManager::Get().RegisterSlotArray(std::make_unique<ResourceSlotArray<T>>());
+		return *Slots;
+	}
+
+	template<class T>
+	inline T* ResourceManager::RegisterSlotArray(std::unique_ptr<T> t_Slots)
+	{
+		std::lock_guard<std::mutex> Lock(m_SlotArrayMutex);
+		T* Slots = t_Slots.get();
+		m_SlotArrays.push_back(std::move(t_Slots));
+		return Slots;
+	}
+
+	template<class T>
+	inline ResourceHandle<T> ResourceManager::AcquireSlot(Guid_Handle t_ID, const std::string& t_Path)
+	{
+		ResourceSlotArray<T>& Slots = GetSlots<T>();
+		ResourceHandle<T> Handle = Slots.Acquire(t_ID, t_Path);
+		if (Slots.GetPath(Handle) != t_Path)
+		{
+			const std::string Existing = Slots.GetPath(Handle);
+			Slots.Release(Handle);
+			ReportGuidCollision(Existing, t_Path);
+		}
+		return Handle;
+	}
+
+	template<class T, class ...ARGS>
+	inline ResourceHandle<T> ResourceManager::LoadResourceHandle(Guid t_ID, ARGS&& ... args)
+	{
+		ResourceHandle<T> Handle = AcquireSlot<T>(t_ID, t_ID.data());
+
+		// Loading it right away also covers a slot that is still waiting on an asynchronous load
+		ResourceSlotArray<T>& Slots = GetSlots<T>();
+		if (!Slots.Resolve(Handle))
+		{
+			Slots.SetResource(Handle, LoadResource<T>(t_ID, std::forward<ARGS>(args)...));
+		}
+		return Handle;
+	}
+
+	template<class T>
+	inline ResourceHandle<T> ResourceManager::LoadResourceHandleAsync(Guid t_ID)
+	{
+		ResourceHandle<T> Handle = AcquireSlot<T>(t_ID, t_ID.data());
+
+		ResourceSlotArray<T>& Slots = GetSlots<T>();
+		if (!Slots.Resolve(Handle) && !Slots.IsPending(Handle))
+		{
+			Slots.SetPending(Handle, LoadResourceAsync<T>(t_ID));
+		}
+		return Handle;
+	}
+
+	template<class T>
+	inline ResourceHandle<T> ResourceManager::AcquireHandle(const std::shared_ptr<T>& t_Resource)
+	{
+		if (!t_Resource)
+		{
+			return {};
+		}
+
+		ResourceHandle<T> Handle = AcquireSlot<T>(t_Resource->GetGuidHandle(), t_Resource->GetGuidString());
+
+		ResourceSlotArray<T>& Slots = GetSlots<T>();
+		if (!Slots.Resolve(Handle))
+		{
+			Slots.SetResource(Handle, t_Resource);
+		}
+		return Handle;
+	}
+
+	template<class T>
+	inline void ResourceManager::ReleaseHandle(ResourceHandle<T>& t_Handle)
+	{
+		GetSlots<T>().Release(t_Handle);
+		t_Handle = {};
 	}
 
 	template<class T>
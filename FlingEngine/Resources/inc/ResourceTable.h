@@ -0,0 +1,161 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "Hash.h"
+#include "NonCopyable.hpp"
+
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+namespace Fling
+{
+	class Resource;
+
+	/**
+	 * The set of loaded resources, keyed by the hash of their Guid. Safe to use from any thread.
+	 *
+	 * Resources are split up between NumShards shards by their hash, each with its own
+	 * reader/writer lock, so lookups only ever wait on a thread that is adding to the same shard.
+	 * Each shard is an open addressing (linear probing) hash table. Probing only looks at a
+	 * packed array of keys, the resource pointers are kept off to the side until there is a hit.
+	 *
+	 * Two different paths can hash to the same Guid_Handle. Every entry remembers its path
+	 * through the resource, so Insert can tell a collision apart from the same file being added twice.
+	 */
+	class ResourceTable : public NonCopyable
+	{
+	public:
+
+		/** Must be a power of 2 */
+		static constexpr uint32 NumShards = 16;
+
+		/** What happened when trying to add a resource */
+		enum class InsertResult : uint8
+		{
+			/** The resource is in the table now */
+			Inserted,
+
+			/** A resource with the same path was already there, it was kept */
+			AlreadyExists,
+
+			/** A resource with a different path but the same hash was already there */
+			Collision
+		};
+
+		/**
+		 * @param t_InitialShardCapacity	Number of slots each shard starts with, rounded up to a power of 2
+		 */
+		explicit ResourceTable(uint32 t_InitialShardCapacity = 64);
+
+		~ResourceTable() = default;
+
+		/**
+		 * Add a resource, keyed by its Guid. If there is already something with this key
+		 * then it is left alone.
+		 *
+		 * @param t_Resource		The resource to add
+		 * @param t_OutExisting		Optional, set to whatever is in the table for this key afterwards
+		 */
+		InsertResult Insert(const std::shared_ptr<Resource>& t_Resource, std::shared_ptr<Resource>* t_OutExisting = nullptr);
+
+		/** Get the resource with this key, or nullptr if there isn't one */
+		std::shared_ptr<Resource> Find(Guid_Handle t_ID) const;
+
+		bool Contains(Guid_Handle t_ID) const;
+
+		/**
+		 * Take a resource out of the table
+		 *
+		 * @return True if there was a resource with this key
+		 */
+		bool Remove(Guid_Handle t_ID);
+
+		/**
+		 * Take a resource out of the table, but only if the table holds the only reference to it.
+		 * This is checked while the shard is locked, so no other thread can grab it in the meantime.
+		 *
+		 * @return The removed resource, or nullptr if it isn't in the table or is still being used
+		 */
+		std::shared_ptr<Resource> RemoveIfUnreferenced(Guid_Handle t_ID);
+
+		/** Remove every resource */
+		void Clear();
+
+		/** Number of resources in the table. Only a snapshot if other threads are adding to it */
+		size_t Size() const;
+
+		/**
+		 * Call a function on every resource. Each shard is locked for reading while it is visited,
+		 * so don't add or remove resources from inside of it.
+		 */
+		template<class FUNC>
+		void ForEach(FUNC&& t_Func) const;
+
+	private:
+
+		struct Slot
+		{
+			Guid_Handle Key = 0;
+			bool bUsed = false;
+		};
+
+		/** Padded out to its own cache lines so that locking one shard doesn't slow down its neighbours */
+		struct alignas(64) Shard
+		{
+			mutable std::shared_mutex Mutex;
+
+			std::vector<Slot> Slots;
+
+			/** Parallel to Slots */
+			std::vector<std::shared_ptr<Resource>> Resources;
+
+			uint32 Count = 0;
+		};
+
+		/** Spread the Guid hash out so that similar paths don't pile up in the same shard or slots */
+		static inline uint32 Mix(Guid_Handle t_ID) { return MixHash32(static_cast<uint32>(t_ID)); }
+
+		/** The top bits pick the shard, the bottom bits pick the slot in it */
+		inline Shard& GetShard(uint32 t_Hash) { return m_Shards[t_Hash >> (32 - ShardBits)]; }
+		inline const Shard& GetShard(uint32 t_Hash) const { return m_Shards[t_Hash >> (32 - ShardBits)]; }
+
+		/**
+		 * Find the slot that has this key, or the empty slot where it would go.
+		 * The shard must be locked and have at least one empty slot.
+		 */
+		static size_t Probe(const Shard& t_Shard, Guid_Handle t_ID, uint32 t_Hash);
+
+		/** Double the number of slots in a shard. The shard must be locked for writing */
+		static void Grow(Shard& t_Shard);
+
+		/**
+		 * Empty out a used slot and shift the slots after it back so that no probe runs into the hole
+		 * early (no tombstones). The shard must be locked for writing.
+		 *
+		 * @return The resource that was in the slot
+		 */
+		static std::shared_ptr<Resource> Erase(Shard& t_Shard, size_t t_Index);
+
+		static constexpr uint32 ShardBits = 4;
+		static_assert((1u << ShardBits) == NumShards, "ResourceTable::ShardBits must match NumShards");
+
+		Shard m_Shards[NumShards];
+	};
+
+	template<class FUNC>
+	inline void ResourceTable::ForEach(FUNC&& t_Func) const
+	{
+		for (const Shard& CurShard : m_Shards)
+		{
+			std::shared_lock<std::shared_mutex> Lock(CurShard.Mutex);
+			for (size_t i = 0; i < CurShard.Slots.size(); ++i)
+			{
+				if (CurShard.Slots[i].bUsed)
+				{
+					t_Func(CurShard.Resources[i]);
+				}
+			}
+		}
+	}
+}	// namespace Fling
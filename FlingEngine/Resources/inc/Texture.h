@@ -15,6 +15,10 @@ namespace Fling
 		static std::shared_ptr<Fling::Texture> Create(Guid t_ID);
 
         explicit Texture(Guid t_ID);
+
+        /** Only decode the image, the Vulkan image is created in FinalizeAsyncLoad */
+        Texture(Guid t_ID, AsyncLoad_t);
+
         virtual ~Texture();
 
 		FORCEINLINE uint32 GetWidth() const { return m_Width; }
@@ -46,8 +50,27 @@ namespace Fling
 		*/
 		void Release();
 
+        /** The GPU image with all of its mips, plus the decoded pixels if they are still around */
+        ResourceMemoryUsage GetMemoryUsage() const override;
+
+        bool CanBeEvicted() const override { return true; }
+
+    protected:
+
+        bool FinalizeAsyncLoad() override;
+
     private:
 
+        /**
+         * Read and decode the image file into m_PixelData
+         */
+        void LoadPixelData();
+
+        /**
+         * Create the image, view, and sampler once the pixel data is loaded
+         */
+        void CreateVulkanResources();
+
 		/**
 		* Loads the Vulkan resources needed for this image
 		*/
@@ -76,20 +99,20 @@ namespace Fling
         int32 m_Channels = 0;
 
 		/** The Vulkan image data */
-		VkImage m_vVkImage;
+		VkImage m_vVkImage = VK_NULL_HANDLE;
 
         /** The view of this image for the swap chain */
-        VkImageView m_ImageView;
+        VkImageView m_ImageView = VK_NULL_HANDLE;
 
-		VkSampler m_TextureSampler;
+		VkSampler m_TextureSampler = VK_NULL_HANDLE;
 
 		/** The Vulkan memory resource for this image */
-		VkDeviceMemory m_VkMemory;
+		VkDeviceMemory m_VkMemory = VK_NULL_HANDLE;
 
 		VkDescriptorImageInfo m_ImageInfo{};
         
         /** Pixel data of image **/
-        stbi_uc* m_PixelData;
+        stbi_uc* m_PixelData = nullptr;
 
         VkFormat m_Format = VK_FORMAT_R8G8B8A8_UNORM;
     };
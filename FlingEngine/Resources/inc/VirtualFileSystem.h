@@ -0,0 +1,253 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "AssetArchive.h"
+#include "AssetData.h"
+#include "BatchFileReader.h"
+#include "NonCopyable.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Fling
+{
+	/** Where the files of a mount point come from */
+	enum class VfsMountType : uint8
+	{
+		/** Loose files in a directory on disk */
+		Directory,
+
+		/** A packed AssetArchive */
+		Archive,
+
+		/** Files that only exist in memory, written with WriteMemoryFile */
+		Memory
+	};
+
+	/** What can be known about a file without reading it */
+	struct VfsFileInfo
+	{
+		uint64 Size = 0;
+
+		/** Last write time of a loose file, 0 for files from archives and memory */
+		uint64 ModifiedTime = 0;
+
+		/** HashBytes64 of the file if it is known already (archives store it), otherwise 0 */
+		uint64 Hash = 0;
+	};
+
+	/**
+	 * One tree of asset paths made out of any number of mount points. Every mount point has a
+	 * priority, and when more than one of them has the same path the one with the highest priority
+	 * wins (or the one mounted last if they are the same). This lets the same code read loose files
+	 * while developing, packed archives in a shipped build, and in-memory files on top of both.
+	 *
+	 * Paths are relative to the root of their mount point with forward slashes, the same as a Guid.
+	 * Every mount point is scanned once when it is mounted and the winning file for each path goes
+	 * into an index keyed by Guid_Handle, so finding a file is one hash lookup with no file system calls.
+	 * Files that are added to a directory after it was mounted aren't seen until RefreshPath or Rescan.
+	 *
+	 * Reading is safe from any thread. Mounting and unmounting locks out readers while the index is rebuilt.
+	 *
+	 * @see Fling::AssetData
+	 * @see Fling::AssetArchive
+	 */
+	class VirtualFileSystem : public NonCopyable
+	{
+	public:
+
+		typedef uint32 MountId;
+
+		static constexpr MountId InvalidMount = 0;
+
+		VirtualFileSystem() = default;
+		virtual ~VirtualFileSystem() = default;
+
+		/**
+		 * Mount every file under a directory on disk
+		 *
+		 * @return The new mount point, or InvalidMount if the directory doesn't exist
+		 */
+		MountId MountDirectory(const std::string& t_Dir, int32 t_Priority);
+
+		/**
+		 * Mount an asset archive
+		 *
+		 * @return The new mount point, or InvalidMount if the archive couldn't be opened
+		 */
+		MountId MountArchive(const std::string& t_Path, int32 t_Priority);
+
+		/** Mount an empty in-memory overlay that files can be written to */
+		MountId MountMemory(int32 t_Priority);
+
+		/**
+		 * Add or replace a file in a memory mount. The data is copied.
+		 *
+		 * @return False if t_Mount isn't a memory mount
+		 */
+		bool WriteMemoryFile(MountId t_Mount, const std::string& t_Path, const void* t_Data, size_t t_Size);
+
+		/**
+		 * Unmount a mount point. Files that were already read from it stay valid.
+		 *
+		 * @return False if there is no such mount point
+		 */
+		bool Unmount(MountId t_Mount);
+
+		/** Unmount every mount point of one type */
+		void UnmountAll(VfsMountType t_Type);
+
+		/** Unmount everything */
+		void UnmountAll();
+
+		size_t GetNumMounts(VfsMountType t_Type) const;
+
+		/** Number of paths that can be read */
+		size_t GetNumFiles() const;
+
+		/**
+		 * Read a file from whichever mount point has it with the highest priority
+		 *
+		 * @param t_ID		Guid_Handle of the path
+		 * @param t_Path	Path of the file, to tell apart paths with the same hash
+		 * @return False if no mount point has the file, or it couldn't be read
+		 */
+		bool Read(Guid_Handle t_ID, std::string_view t_Path, AssetData& t_Out) const;
+
+		inline bool Read(const std::string& t_Path, AssetData& t_Out) const { return Read(Guid{ t_Path.c_str() }, t_Path, t_Out); }
+
+		bool Exists(Guid_Handle t_ID, std::string_view t_Path) const;
+
+		inline bool Exists(const std::string& t_Path) const { return Exists(Guid{ t_Path.c_str() }, t_Path); }
+
+		/**
+		 * Get the size of a file, and its modified time or hash if they are known, without reading it
+		 * @return False if no mount point has the file
+		 */
+		bool GetFileInfo(Guid_Handle t_ID, std::string_view t_Path, VfsFileInfo& t_Out) const;
+
+		/** The type of mount point a file would be read from. Only valid if the file exists */
+		VfsMountType GetSourceType(const std::string& t_Path) const;
+
+		/**
+		 * List what is directly inside of a directory, from the index
+		 *
+		 * @param t_Dir			Directory to list, "" for the root
+		 * @param t_OutFiles	Paths of the files in it, sorted
+		 * @param t_OutDirs		Paths of the directories in it, sorted
+		 */
+		void ListDirectory(const std::string& t_Dir, std::vector<std::string>& t_OutFiles, std::vector<std::string>& t_OutDirs) const;
+
+		/** Check the directory mounts for a file that was written or deleted since they were mounted */
+		void RefreshPath(const std::string& t_Path);
+
+		/** Scan every directory mount again and rebuild the index */
+		void Rescan();
+
+		/**
+		 * Read a batch of loose files all at once with a BatchFileReader, so that the next Read of each
+		 * of them doesn't touch the disk. Files that come from archives or memory are skipped, they
+		 * are mapped already. Each prefetched file is handed out by Read once.
+		 *
+		 * @param t_Paths	Paths to read. Ones that don't exist are skipped
+		 * @return Number of files that were prefetched
+		 */
+		size_t Prefetch(const std::vector<std::string>& t_Paths);
+
+		/** Throw out prefetched files that nobody read */
+		void ClearPrefetched();
+
+		inline size_t GetNumPrefetched() const { return m_NumPrefetched.load(std::memory_order_relaxed); }
+
+		/** How Prefetch reads files */
+		void SetReadBackend(FileReadBackend t_Backend);
+
+	private:
+
+		struct Mount
+		{
+			MountId ID = InvalidMount;
+			VfsMountType Type = VfsMountType::Directory;
+			int32 Priority = 0;
+
+			/** Directory or archive path */
+			std::string Root;
+
+			/** Relative paths of the files in a directory mount */
+			std::unordered_set<std::string> LooseFiles;
+
+			std::unique_ptr<AssetArchive> Archive;
+
+			std::unordered_map<std::string, std::shared_ptr<const std::vector<char>>> MemoryFiles;
+		};
+
+		/** The file that wins for one path */
+		struct IndexEntry
+		{
+			std::string Path;
+			const Mount* Source = nullptr;
+			const AssetArchiveEntry* ArchiveEntry = nullptr;
+			std::shared_ptr<const std::vector<char>> MemoryFile;
+		};
+
+		MountId AddMount(std::unique_ptr<Mount> t_Mount);
+
+		/** Only call with the lock held */
+		Mount* FindMount(MountId t_Mount) const;
+
+		/** Find every file in a directory mount */
+		static void ScanDirectory(Mount& t_Mount);
+
+		/** Point the index at the winning file for one path. Only call with the lock held */
+		void ResolvePath(const std::string& t_Path);
+
+		/** Put a file in the index, mounts have to be visited from lowest to highest priority */
+		void AddToIndex(const std::string& t_Path, const Mount& t_Source);
+
+		/** Only call with the lock held */
+		void RebuildIndex();
+
+		/** Hand out a prefetched file if there is one */
+		bool TakePrefetched(Guid_Handle t_ID, std::string_view t_Path, AssetData& t_Out) const;
+
+		/** Drop a prefetched file, i.e. because the file changed */
+		void DropPrefetched(Guid_Handle t_ID);
+
+		/** A loose file that was read ahead of time */
+		struct PrefetchedFile
+		{
+			std::string Path;
+			std::shared_ptr<char> Buffer;
+			uint64 Size = 0;
+		};
+
+		/** Sorted from lowest to highest priority, later mounts after earlier ones with the same priority */
+		std::vector<std::unique_ptr<Mount>> m_Mounts;
+
+		std::unordered_map<Guid_Handle, IndexEntry> m_Index;
+
+		MountId m_NextMountId = 1;
+
+		mutable std::shared_mutex m_Mutex;
+
+		/** Taken from by Read, so it has a lock of its own. Always lock m_Mutex first */
+		mutable std::unordered_map<Guid_Handle, PrefetchedFile> m_Prefetched;
+		mutable std::mutex m_PrefetchMutex;
+		mutable std::atomic<size_t> m_NumPrefetched { 0 };
+
+		FileReadBackend m_ReadBackend = FileReadBackend::Auto;
+
+		/** Made by the first Prefetch and kept, so the io_uring ring is only set up once */
+		std::unique_ptr<BatchFileReader> m_Reader;
+
+		/** The reader can only do one batch at a time. Always lock m_Mutex first */
+		std::mutex m_ReaderMutex;
+	};
+}   // namespace Fling
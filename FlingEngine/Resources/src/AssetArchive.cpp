@@ -0,0 +1,358 @@
+#include "pch.h"
+#include "AssetArchive.h"
+#include "Compression.h"
+#include "Hash.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Fling
+{
+	namespace
+	{
+		inline uint64 AlignUp(uint64 t_Value, uint64 t_Alignment)
+		{
+			return (t_Value + t_Alignment - 1) & ~(t_Alignment - 1);
+		}
+
+		/** Checksum of the parts of the archive that are read on every lookup */
+		uint64 HashToc(const AssetArchiveEntry* t_Toc, uint32 t_Capacity, const char* t_Strings, uint64 t_StringsSize)
+		{
+			const uint64 TocHash = HashBytes64(t_Toc, sizeof(AssetArchiveEntry) * t_Capacity);
+			return HashBytes64(t_Strings, static_cast<size_t>(t_StringsSize), TocHash);
+		}
+	}
+
+	// AssetArchive ----------------------------------------------------------------------------------
+
+	bool AssetArchive::Open(const std::string& t_Path)
+	{
+		m_Header = nullptr;
+		m_Toc = nullptr;
+		m_Strings = nullptr;
+		m_Path = t_Path;
+
+		// Nothing is read until the table of contents is checked, so hint that it is random access
+		std::shared_ptr<MappedFile> Mapping = std::make_shared<MappedFile>(t_Path, MappedFileAccess::Random);
+		if (!Mapping->IsOpen())
+		{
+			F_LOG_ERROR("Failed to open asset archive {}", t_Path);
+			return false;
+		}
+
+		const uint64 FileSize = Mapping->GetSize();
+		const char* Base = Mapping->GetData();
+		if (FileSize < sizeof(AssetArchiveHeader))
+		{
+			F_LOG_ERROR("Asset archive {} is too small to be an archive", t_Path);
+			return false;
+		}
+
+		const AssetArchiveHeader* Header = reinterpret_cast<const AssetArchiveHeader*>(Base);
+		if (Header->Magic != Magic || Header->Version != Version)
+		{
+			F_LOG_ERROR("{} is not a version {} asset archive", t_Path, Version);
+			return false;
+		}
+
+		const uint64 TocSize = static_cast<uint64>(Header->TocCapacity) * sizeof(AssetArchiveEntry);
+		const bool bValidCapacity = Header->TocCapacity != 0 && (Header->TocCapacity & (Header->TocCapacity - 1)) == 0 && Header->NumEntries < Header->TocCapacity;
+		const bool bValidToc = Header->TocOffset % alignof(AssetArchiveEntry) == 0 && Header->TocOffset <= FileSize && TocSize <= FileSize - Header->TocOffset;
+		const bool bValidStrings = Header->StringsOffset <= FileSize && Header->StringsSize <= FileSize - Header->StringsOffset;
+		if (!bValidCapacity || !bValidToc || !bValidStrings)
+		{
+			F_LOG_ERROR("Asset archive {} has a corrupt header", t_Path);
+			return false;
+		}
+
+		const AssetArchiveEntry* Toc = reinterpret_cast<const AssetArchiveEntry*>(Base + Header->TocOffset);
+		const char* Strings = Base + Header->StringsOffset;
+		if (HashToc(Toc, Header->TocCapacity, Strings, Header->StringsSize) != Header->TocChecksum)
+		{
+			F_LOG_ERROR("Asset archive {} has a corrupt table of contents", t_Path);
+			return false;
+		}
+
+		m_Mapping = std::move(Mapping);
+		m_Header = Header;
+		m_Toc = Toc;
+		m_Strings = Strings;
+		return true;
+	}
+
+	const AssetArchiveEntry* AssetArchive::Find(Guid_Handle t_ID, std::string_view t_Path) const
+	{
+		if (!m_Header)
+		{
+			return nullptr;
+		}
+
+		const uint32 Mask = m_Header->TocCapacity - 1;
+		uint32 Index = MixHash32(static_cast<uint32>(t_ID)) & Mask;
+
+		// The table is never full, so this always runs into an empty slot eventually
+		while (m_Toc[Index].Flags & Entry_Used)
+		{
+			const AssetArchiveEntry& Entry = m_Toc[Index];
+			if (Entry.ID == static_cast<uint32>(t_ID) && GetEntryPath(Entry) == t_Path)
+			{
+				return &Entry;
+			}
+			Index = (Index + 1) & Mask;
+		}
+		return nullptr;
+	}
+
+	std::string_view AssetArchive::GetEntryPath(const AssetArchiveEntry& t_Entry) const
+	{
+		if (!m_Header || static_cast<uint64>(t_Entry.PathOffset) + t_Entry.PathLength > m_Header->StringsSize)
+		{
+			return {};
+		}
+		return std::string_view(m_Strings + t_Entry.PathOffset, t_Entry.PathLength);
+	}
+
+	bool AssetArchive::Read(const AssetArchiveEntry& t_Entry, AssetData& t_Out, bool t_bVerify) const
+	{
+		t_Out = AssetData {};
+		if (!m_Header)
+		{
+			return false;
+		}
+
+		const uint64 FileSize = m_Mapping->GetSize();
+		if (t_Entry.Offset > FileSize || t_Entry.StoredSize > FileSize - t_Entry.Offset)
+		{
+			F_LOG_ERROR("Asset {} is out of bounds in archive {}", GetEntryPath(t_Entry), m_Path);
+			return false;
+		}
+
+		const char* Stored = m_Mapping->GetData() + t_Entry.Offset;
+		if (t_Entry.Flags & Entry_Compressed)
+		{
+			t_Out.m_Storage.resize(static_cast<size_t>(t_Entry.Size));
+			if (!Compression::Decompress(Stored, static_cast<size_t>(t_Entry.StoredSize), t_Out.m_Storage.data(), t_Out.m_Storage.size()))
+			{
+				F_LOG_ERROR("Failed to decompress {} from archive {}", GetEntryPath(t_Entry), m_Path);
+				t_Out = AssetData {};
+				return false;
+			}
+			t_Out.m_View = std::string_view(t_Out.m_Storage.data(), t_Out.m_Storage.size());
+		}
+		else
+		{
+			if (t_Entry.StoredSize != t_Entry.Size)
+			{
+				F_LOG_ERROR("Asset {} has the wrong size in archive {}", GetEntryPath(t_Entry), m_Path);
+				return false;
+			}
+			t_Out.m_View = std::string_view(Stored, static_cast<size_t>(t_Entry.Size));
+			t_Out.m_Owner = m_Mapping;
+		}
+
+		if (t_bVerify && HashBytes64(t_Out.m_View.data(), t_Out.m_View.size()) != t_Entry.Checksum)
+		{
+			F_LOG_ERROR("Checksum mismatch for {} in archive {}", GetEntryPath(t_Entry), m_Path);
+			t_Out = AssetData {};
+			return false;
+		}
+
+		t_Out.m_bValid = true;
+		return true;
+	}
+
+	// AssetArchiveBuilder ---------------------------------------------------------------------------
+
+	AssetArchiveBuilder::AssetArchiveBuilder(uint64 t_Alignment)
+		: m_Alignment(t_Alignment)
+	{
+		assert(t_Alignment != 0 && (t_Alignment & (t_Alignment - 1)) == 0);
+	}
+
+	bool AssetArchiveBuilder::AddData(const std::string& t_Path, const void* t_Data, size_t t_Size, bool t_bCompress)
+	{
+		const Guid_Handle ID = Guid{ t_Path.c_str() };
+
+		PendingEntry* Entry = nullptr;
+		for (PendingEntry& Existing : m_Entries)
+		{
+			if (Existing.ID != ID)
+			{
+				continue;
+			}
+
+			if (Existing.Path != t_Path)
+			{
+				F_LOG_ERROR("Guid collision! '{}' and '{}' have the same hash, rename one of them", Existing.Path, t_Path);
+				return false;
+			}
+			Entry = &Existing;
+		}
+
+		if (!Entry)
+		{
+			Entry = &m_Entries.emplace_back();
+		}
+
+		Entry->Path = t_Path;
+		Entry->ID = ID;
+		Entry->Flags = AssetArchive::Entry_Used;
+		Entry->Size = t_Size;
+		Entry->Checksum = HashBytes64(t_Data, t_Size);
+		Entry->Stored.clear();
+
+		if (t_bCompress && t_Size > 0)
+		{
+			Entry->Stored.resize(Compression::GetMaxCompressedSize(t_Size));
+			const size_t CompressedSize = Compression::Compress(t_Data, t_Size, Entry->Stored.data(), Entry->Stored.size());
+
+			// Not worth decompressing if it barely got smaller (i.e. images that are already compressed)
+			if (CompressedSize != 0 && CompressedSize <= t_Size - t_Size / 8)
+			{
+				Entry->Stored.resize(CompressedSize);
+				Entry->Flags |= AssetArchive::Entry_Compressed;
+				return true;
+			}
+		}
+
+		const char* Bytes = static_cast<const char*>(t_Data);
+		Entry->Stored.assign(Bytes, Bytes + t_Size);
+		return true;
+	}
+
+	bool AssetArchiveBuilder::AddFile(const std::string& t_Path, const std::string& t_SourceFile, bool t_bCompress)
+	{
+		MappedFile Source(t_SourceFile, MappedFileAccess::Sequential);
+		if (!Source.IsOpen())
+		{
+			F_LOG_ERROR("Failed to open file: {}", t_SourceFile);
+			return false;
+		}
+		return AddData(t_Path, Source.GetData(), Source.GetSize(), t_bCompress);
+	}
+
+	size_t AssetArchiveBuilder::AddDirectory(const std::string& t_Dir, bool t_bCompress)
+	{
+		namespace fs = std::filesystem;
+
+		std::error_code Error;
+		const fs::path Root(t_Dir);
+
+		size_t NumAdded = 0;
+		for (fs::recursive_directory_iterator It(Root, Error), End; !Error && It != End; It.increment(Error))
+		{
+			if (!It->is_regular_file())
+			{
+				continue;
+			}
+
+			// Guids always use forward slashes
+			const std::string RelativePath = fs::relative(It->path(), Root).generic_string();
+			if (AddFile(RelativePath, It->path().string(), t_bCompress))
+			{
+				++NumAdded;
+			}
+		}
+
+		if (Error)
+		{
+			F_LOG_ERROR("Failed to read directory {}: {}", t_Dir, Error.message());
+		}
+		return NumAdded;
+	}
+
+	bool AssetArchiveBuilder::Write(const std::string& t_OutPath) const
+	{
+		AssetArchiveHeader Header;
+		Header.Magic = AssetArchive::Magic;
+		Header.Version = AssetArchive::Version;
+		Header.NumEntries = static_cast<uint32>(m_Entries.size());
+
+		// Keep the table at most half full so that probes stay short
+		Header.TocCapacity = 2;
+		while (Header.TocCapacity < m_Entries.size() * 2)
+		{
+			Header.TocCapacity <<= 1;
+		}
+
+		std::vector<AssetArchiveEntry> Toc(Header.TocCapacity);
+		std::string Strings;
+
+		// Lay out the data first, then the strings and table of contents after it
+		uint64 Offset = AlignUp(sizeof(AssetArchiveHeader), m_Alignment);
+		std::vector<uint64> DataOffsets;
+		DataOffsets.reserve(m_Entries.size());
+
+		for (const PendingEntry& Pending : m_Entries)
+		{
+			DataOffsets.push_back(Offset);
+
+			AssetArchiveEntry Entry;
+			Entry.ID = static_cast<uint32>(Pending.ID);
+			Entry.Flags = Pending.Flags;
+			Entry.PathOffset = static_cast<uint32>(Strings.size());
+			Entry.PathLength = static_cast<uint32>(Pending.Path.size());
+			Entry.Offset = Offset;
+			Entry.StoredSize = Pending.Stored.size();
+			Entry.Size = Pending.Size;
+			Entry.Checksum = Pending.Checksum;
+
+			uint32 Index = MixHash32(Entry.ID) & (Header.TocCapacity - 1);
+			while (Toc[Index].Flags & AssetArchive::Entry_Used)
+			{
+				Index = (Index + 1) & (Header.TocCapacity - 1);
+			}
+			Toc[Index] = Entry;
+
+			Strings += Pending.Path;
+			Offset = AlignUp(Offset + Pending.Stored.size(), m_Alignment);
+		}
+
+		Header.StringsOffset = Offset;
+		Header.StringsSize = Strings.size();
+		Header.TocOffset = AlignUp(Header.StringsOffset + Header.StringsSize, alignof(AssetArchiveEntry));
+		Header.TocChecksum = HashToc(Toc.data(), Header.TocCapacity, Strings.data(), Strings.size());
+
+		std::ofstream Out(t_OutPath, std::ios::binary | std::ios::trunc);
+		if (!Out.is_open())
+		{
+			F_LOG_ERROR("Failed to write asset archive {}", t_OutPath);
+			return false;
+		}
+
+		uint64 Written = 0;
+		const auto WriteBytes = [&](const void* t_Data, uint64 t_Size)
+		{
+			Out.write(static_cast<const char*>(t_Data), static_cast<std::streamsize>(t_Size));
+			Written += t_Size;
+		};
+		const auto PadTo = [&](uint64 t_Offset)
+		{
+			static const char Zeros[256] = {};
+			while (Written < t_Offset)
+			{
+				WriteBytes(Zeros, std::min<uint64>(sizeof(Zeros), t_Offset - Written));
+			}
+		};
+
+		WriteBytes(&Header, sizeof(Header));
+		for (size_t i = 0; i < m_Entries.size(); ++i)
+		{
+			PadTo(DataOffsets[i]);
+			WriteBytes(m_Entries[i].Stored.data(), m_Entries[i].Stored.size());
+		}
+
+		PadTo(Header.StringsOffset);
+		WriteBytes(Strings.data(), Strings.size());
+		PadTo(Header.TocOffset);
+		WriteBytes(Toc.data(), sizeof(AssetArchiveEntry) * Toc.size());
+
+		if (!Out.good())
+		{
+			F_LOG_ERROR("Failed to write asset archive {}", t_OutPath);
+			return false;
+		}
+		return true;
+	}
+}   // namespace Fling
@@ -17,22 +17,9 @@ namespace Fling
 
     void File::LoadFile()
     {
-        const std::string FilePath = GetFilepathReleativeToAssets();
-        
-        std::ifstream File(FilePath, std::ios::ate | std::ios::binary);
-
-        if (!File.is_open())
-        {
-            F_LOG_ERROR("Failed to open file: {}", FilePath);
-        }
-        else
+        if (!ReadAsset(m_Data))
         {
-            size_t Filesize = (size_t)(File.tellg());
-            m_Characters.resize(Filesize);
-        
-            File.seekg(0);
-            File.read(m_Characters.data(), Filesize);
-            File.close();
+            F_LOG_ERROR("Failed to open file: {}", GetFilepathReleativeToAssets());
         }
     }
 } // namespace Fling
\ No newline at end of file
@@ -37,10 +37,17 @@ namespace Fling
     void HDRImage::LoadVulkanImage()
     {
         const std::string Filepath = GetFilepathReleativeToAssets();
+        AssetData Data;
+        if (!ReadAsset(Data))
+        {
+            F_LOG_ERROR("Failed to open image file: {}", Filepath);
+        }
+
         int Width = 0;
         int Height = 0;
-        m_PixelData = stbi_loadf(
-            Filepath.c_str(),
+        m_PixelData = stbi_loadf_from_memory(
+            reinterpret_cast<const stbi_uc*>(Data.GetData()),
+            static_cast<int>(Data.GetSize()),
             &Width,
             &Height,
             &m_Channels,
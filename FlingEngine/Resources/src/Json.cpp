@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Json.h"
+#include "MappedFile.h"
 
 #include <fstream>
 #include <nlohmann/json.hpp>
@@ -41,7 +42,7 @@ namespace Fling
 		Json result;
 		try
 		{
-			result.m_Impl->data = nlohmann::json::parse(std::string(text));
+			result.m_Impl->data = nlohmann::json::parse(text.begin(), text.end());
 		}
 		catch (const std::exception& e)
 		{
@@ -72,8 +73,9 @@ namespace Fling
 
 	bool Json::LoadFromFile(const std::string& path)
 	{
-		std::ifstream ifs(path);
-		if (!ifs.is_open())
+		// Parse straight out of the page cache instead of through a stream
+		MappedFile Mapping(path, MappedFileAccess::Sequential);
+		if (!Mapping.IsOpen())
 		{
 			F_LOG_ERROR("Failed to load JSON file {}", path);
 			return false;
@@ -81,7 +83,8 @@ namespace Fling
 
 		try
 		{
-			ifs >> m_Impl->data;
+			const std::string_view Text = Mapping.GetView();
+			m_Impl->data = nlohmann::json::parse(Text.begin(), Text.end());
 			return true;
 		}
 		catch (const std::exception& e)
@@ -333,4 +336,26 @@ namespace Fling
 	{
 		return m_Impl->data.is_array();
 	}
+
+	void Json::CollectStrings(std::vector<std::string>& t_Out) const
+	{
+		std::vector<const nlohmann::json*> stack { &m_Impl->data };
+		while (!stack.empty())
+		{
+			const nlohmann::json* node = stack.back();
+			stack.pop_back();
+
+			if (node->is_string())
+			{
+				t_Out.push_back(node->get<std::string>());
+			}
+			else if (node->is_structured())
+			{
+				for (const nlohmann::json& child : *node)
+				{
+					stack.push_back(&child);
+				}
+			}
+		}
+	}
 }	// namespace Fling
@@ -15,6 +15,11 @@ namespace Fling
 		LoadJsonFile();
 	}
 
+	JsonFile::JsonFile(Guid t_ID, AsyncLoad_t)
+		: JsonFile(t_ID)
+	{
+	}
+
 	void JsonFile::Write()
 	{
 		const std::string FilePath = GetFilepathReleativeToAssets();
@@ -26,6 +31,12 @@ namespace Fling
 
 	void JsonFile::LoadJsonFile()
 	{
-		m_JsonData.LoadFromFile(GetFilepathReleativeToAssets());
+		AssetData Data;
+		if (!ReadAsset(Data))
+		{
+			F_LOG_ERROR("Failed to load JSON file {}", GetFilepathReleativeToAssets());
+			return;
+		}
+		m_JsonData = Json::Parse(Data.GetView());
 	}
 }	// namespace Fling
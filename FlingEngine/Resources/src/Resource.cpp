@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Resource.h"
+#include "ResourceManager.h"
 
 namespace Fling
 {
@@ -7,4 +8,9 @@ namespace Fling
     {
         return (FlingPaths::EngineAssetsDir() + "/" + GetGuidString());
     }
+
+    bool Resource::ReadAsset(AssetData& t_Out) const
+    {
+        return ResourceManager::Get().ReadAsset(GetGuidHandle(), GetGuidString(), t_Out);
+    }
 }
\ No newline at end of file
@@ -1,8 +1,29 @@
 #include "pch.h"
 #include "ResourceManager.h"
+#include "Misc/CommandLine.h"
+
+#include <algorithm>
+#include <chrono>
 
 namespace Fling
 {
+	/** Default amount of address space to reserve for the import arena */
+	static constexpr int64 DefaultImportArenaSize = int64(4) * 1024 * 1024 * 1024;
+
+	/** Default number of threads that read and decode asynchronous loads */
+	static constexpr int32 DefaultLoadThreadCount = 2;
+
+	/**
+	 * Default number of frames to keep evicted resources around for. Covers both render worlds
+	 * of the pipelined renderer and the GPU's frames in flight.
+	 */
+	static constexpr int32 DefaultEvictionDelayFrames = 4;
+
+	static constexpr uint64 BytesPerMB = 1024 * 1024;
+
+	/** Import arena of a loading thread, the main thread uses the resource manager's */
+	static thread_local VirtualArena* tl_ImportArena = nullptr;
+
 	void ResourceManager::Init()
 	{
 		// Ensure "Current Directory" (relative path) is always the .exe's folder
@@ -21,28 +42,556 @@ namespace Fling
 
 		char currentDir[1024] = {};
 		FlingPaths::GetCurrentWorkingDir(currentDir, 1024);
+
+		m_ImportArena = CreateImportArena();
+		m_MainThreadId = std::this_thread::get_id();
+
+		// Memory budgets
+		m_BudgetBytes[static_cast<size_t>(ResourceMemoryType::Texture)] = static_cast<uint64>(CommandLine::Get().GetValueAs<int64>("TextureBudgetMB", 0)) * BytesPerMB;
+		m_BudgetBytes[static_cast<size_t>(ResourceMemoryType::Mesh)] = static_cast<uint64>(CommandLine::Get().GetValueAs<int64>("MeshBudgetMB", 0)) * BytesPerMB;
+		m_BudgetBytes[static_cast<size_t>(ResourceMemoryType::CPU)] = static_cast<uint64>(CommandLine::Get().GetValueAs<int64>("CPUResourceBudgetMB", 0)) * BytesPerMB;
+		m_EvictionDelayFrames = static_cast<uint64>(std::max(CommandLine::Get().GetValueAs<int32>("ResourceEvictionDelayFrames", DefaultEvictionDelayFrames), 0));
+
+		for (size_t i = 0; i < NumMemoryTypes; ++i)
+		{
+			m_CurrentBytes[i] = 0;
+			m_PeakBytes[i] = 0;
+			m_EvictedBytes[i] = 0;
+		}
+		m_FrameIndex = 0;
+		m_NumEvictions = 0;
+
+		// Start up the loading threads
+		m_FinalizeBudget = CommandLine::Get().GetValueAs<float>("ResourceFinalizeBudgetMs", 4.0f) / 1000.0f;
+		m_LoadRequests = std::make_unique<MpmcQueue<AsyncLoadState*, MaxQueuedLoads>>();
+		m_LoadCompletions = std::make_unique<MpmcQueue<AsyncLoadState*, MaxQueuedLoads>>();
+		m_StopLoadThreads = false;
+
+		m_FileSystem.SetReadBackend(ParseFileReadBackend(CommandLine::Get().GetValueAs<std::string>("FileReadBackend", "Auto")));
+		m_FileSystem.MountDirectory(FlingPaths::EngineAssetsDir(), LooseFilePriority);
+
+		const std::string ArchivePath = CommandLine::Get().GetValueAs<std::string>("AssetArchive", "");
+		if (!ArchivePath.empty())
+		{
+			MountArchive(ArchivePath);
+		}
+
+		const int32 NumLoadThreads = CommandLine::Get().GetValueAs<int32>("ResourceLoadThreads", DefaultLoadThreadCount);
+		for (int32 i = 0; i < NumLoadThreads; ++i)
+		{
+			m_LoadThreads.emplace_back(&ResourceManager::LoadThreadLoop, this);
+		}
 	}
 
 	void ResourceManager::Shutdown()
 	{
+		// Stop the loading threads before anything they might be using goes away. They drop whatever
+		// is left in the request queue instead of loading it, and nothing is waiting on the completions
+		{
+			std::lock_guard<std::mutex> Lock(m_LoadThreadMutex);
+			m_StopLoadThreads = true;
+		}
+		m_LoadThreadCondition.notify_all();
+
+		for (std::thread& Thread : m_LoadThreads)
+		{
+			Thread.join();
+		}
+		m_LoadThreads.clear();
+
+		// Anything that was still in flight is thrown out
+		for (auto& Pending : m_PendingLoads)
+		{
+			Pending.second->Result.reset();
+			Pending.second->Status.store(AsyncLoadStatus::Failed, std::memory_order_release);
+		}
+		m_PendingLoads.clear();
+		m_LoadBacklog.clear();
+		m_Finalizing.clear();
+		m_LoadRequests.reset();
+		m_LoadCompletions.reset();
+
+		// Every handle goes stale, this lets go of the references they were holding
+		for (ResourceSlotArrayBase* Slots : GetSlotArrays())
+		{
+			Slots->Clear();
+		}
+
 		// Unload all assets BB
 		// This will remove all owning references to the shared_ptr's
-		m_ResourceMap.clear();
+		FreeEvictedResources(true);
+		m_Resources.Clear();
+		for (std::atomic<uint64>& Bytes : m_CurrentBytes)
+		{
+			Bytes = 0;
+		}
+
+		m_FileSystem.UnmountAll();
+		m_ImportArena.reset();
 	}
 
-	std::shared_ptr<Resource> ResourceManager::GetResource(Guid_Handle t_ID) const
+	bool ResourceManager::MountArchive(const std::string& t_Path)
+	{
+		return m_FileSystem.MountArchive(t_Path, ArchivePriority) != VirtualFileSystem::InvalidMount;
+	}
+
+	void ResourceManager::UnmountArchives()
+	{
+		m_FileSystem.UnmountAll(VfsMountType::Archive);
+	}
+
+	std::unique_ptr<VirtualArena> ResourceManager::CreateImportArena() const
+	{
+		// Reserve plenty of room for importing big levels and meshes, it only costs address space
+		const int64 ImportArenaSize = CommandLine::Get().GetValueAs<int64>("ImportArenaSize", DefaultImportArenaSize);
+		const bool bImportHugePages = CommandLine::Get().GetValueAs<bool>("ImportArenaHugePages", true);
+		return std::make_unique<VirtualArena>(static_cast<size_t>(ImportArenaSize), bImportHugePages);
+	}
+
+	VirtualArena& ResourceManager::GetImportArena()
+	{
+		if (tl_ImportArena)
+		{
+			return *tl_ImportArena;
+		}
+
+		if (std::this_thread::get_id() == m_MainThreadId)
+		{
+			assert(m_ImportArena);
+			return *m_ImportArena;
+		}
+
+		// Any other thread that loads something gets its own arena the first time it does
+		thread_local std::unique_ptr<VirtualArena> ThreadArena;
+		ThreadArena = CreateImportArena();
+		tl_ImportArena = ThreadArena.get();
+		return *tl_ImportArena;
+	}
+
+	std::shared_ptr<Resource> ResourceManager::FindLoaded(Guid t_ID) const
+	{
+		std::shared_ptr<Resource> Existing = m_Resources.Find(t_ID);
+		if (Existing)
+		{
+			if (Existing->GetGuidString() != t_ID.data())
+			{
+				ReportGuidCollision(Existing->GetGuidString(), t_ID.data());
+			}
+			Touch(*Existing);
+		}
+		return Existing;
+	}
+
+	std::shared_ptr<Resource> ResourceManager::AddLoaded(const std::shared_ptr<Resource>& t_Resource)
+	{
+		// Nobody else can see this resource yet, so it is safe to set up before it goes in the table
+		t_Resource->m_ResidentUsage = t_Resource->GetMemoryUsage();
+		Touch(*t_Resource);
+
+		std::shared_ptr<Resource> Stored;
+		switch (m_Resources.Insert(t_Resource, &Stored))
+		{
+		case ResourceTable::InsertResult::Inserted:
+			AddResidency(t_Resource->m_ResidentUsage);
+			break;
+		case ResourceTable::InsertResult::AlreadyExists:
+			Touch(*Stored);
+			break;
+		case ResourceTable::InsertResult::Collision:
+			ReportGuidCollision(Stored->GetGuidString(), t_Resource->GetGuidString());
+		}
+		return Stored;
+	}
+
+	void ResourceManager::ReportGuidCollision(const std::string& t_Loaded, const std::string& t_New)
+	{
+		F_LOG_ERROR("Guid collision! '{}' and '{}' have the same hash, rename one of them", t_Loaded, t_New);
+		F_LOG_FATAL("Guid collision between two resource paths");
+	}
+
+	void ResourceManager::QueueAsyncLoad(const std::shared_ptr<AsyncLoadState>& t_State)
+	{
+		// Without any loading threads just do the load right now, it still gets finalized in Update
+		if (m_LoadThreads.empty())
+		{
+			RunAsyncLoad(*t_State);
+			m_Finalizing.push_back(t_State.get());
+			return;
+		}
+
+		// Keep the order loads were asked for if some are already backed up
+		if (!m_LoadBacklog.empty() || !m_LoadRequests->TryPush(t_State.get()))
+		{
+			m_LoadBacklog.push_back(t_State.get());
+			return;
+		}
+
+		// Take the lock so that a thread that is about to go to sleep can't miss this
+		{
+			std::lock_guard<std::mutex> Lock(m_LoadThreadMutex);
+		}
+		m_LoadThreadCondition.notify_one();
+	}
+
+	void ResourceManager::RunAsyncLoad(AsyncLoadState& t_State)
+	{
+		FLING_PROFILE_SCOPE("ResourceManager::RunAsyncLoad");
+
+		t_State.Status.store(AsyncLoadStatus::Loading, std::memory_order_release);
+
+		// Anything the resource puts in the import arena while it loads is thrown out afterwards
+		VirtualArena::Scope ImportScope(ResourceManager::Get().GetImportArena());
+
+		try
+		{
+			t_State.Result = t_State.Construct(t_State);
+		}
+		catch (std::exception& e)
+		{
+			F_LOG_ERROR("Failed to load {} : {}", t_State.Path, e.what());
+			t_State.Result.reset();
+		}
+	}
+
+	void ResourceManager::LoadThreadLoop()
 	{
-		ResourceMapConstIt It = m_ResourceMap.find(t_ID);
-		if (It != m_ResourceMap.end())
+		Profiler::Get().SetThreadName("Resource Loading");
+
+		// Every loading thread gets its own scratch memory so that they never have to share it
+		std::unique_ptr<VirtualArena> ImportArena = CreateImportArena();
+		tl_ImportArena = ImportArena.get();
+
+		while (!m_StopLoadThreads.load(std::memory_order_acquire))
 		{
-			return It->second;
+			AsyncLoadState* State = nullptr;
+			if (!m_LoadRequests->TryPop(State))
+			{
+				std::unique_lock<std::mutex> Lock(m_LoadThreadMutex);
+				m_LoadThreadCondition.wait(Lock, [this]() { return m_StopLoadThreads || !m_LoadRequests->Empty(); });
+				if (m_StopLoadThreads)
+				{
+					break;
+				}
+				continue;
+			}
+
+			RunAsyncLoad(*State);
+
+			// The main thread empties this every frame, so it won't be full for long. When shutting down
+			// the main thread stops emptying it, and fails every load that hasn't been handed back
+			while (!m_LoadCompletions->TryPush(State))
+			{
+				if (m_StopLoadThreads.load(std::memory_order_acquire))
+				{
+					break;
+				}
+				std::this_thread::yield();
+			}
 		}
 
-		return nullptr;
+		tl_ImportArena = nullptr;
+	}
+
+	void ResourceManager::Update()
+	{
+		FLING_PROFILE_SCOPE("ResourceManager::Update");
+
+		m_FrameIndex.fetch_add(1, std::memory_order_relaxed);
+
+		// Move any backed up loads over now that the loading threads have made some room
+		bool bQueuedLoads = false;
+		while (!m_LoadBacklog.empty() && m_LoadRequests->TryPush(m_LoadBacklog.front()))
+		{
+			m_LoadBacklog.pop_front();
+			bQueuedLoads = true;
+		}
+		if (bQueuedLoads)
+		{
+			{
+				std::lock_guard<std::mutex> Lock(m_LoadThreadMutex);
+			}
+			m_LoadThreadCondition.notify_all();
+		}
+
+		AsyncLoadState* Loaded = nullptr;
+		while (m_LoadCompletions && m_LoadCompletions->TryPop(Loaded))
+		{
+			m_Finalizing.push_back(Loaded);
+		}
+
+		// Finish loads in the order they came in until we are out of time for this frame.
+		// Only look at each load once, some might go to the back of the line to wait on others
+		const auto StartTime = std::chrono::steady_clock::now();
+		for (size_t NumToVisit = m_Finalizing.size(); NumToVisit > 0 && !m_Finalizing.empty(); --NumToVisit)
+		{
+			AsyncLoadState* State = m_Finalizing.front();
+			m_Finalizing.pop_front();
+
+			if (State->Result)
+			{
+				// Someone loaded this synchronously in the meantime, use that one so there is only one copy
+				if (std::shared_ptr<Resource> Existing = m_Resources.Find(State->ID))
+				{
+					if (Existing->GetGuidString() != State->Path)
+					{
+						ReportGuidCollision(Existing->GetGuidString(), State->Path);
+					}
+					State->Result = std::move(Existing);
+				}
+				else
+				{
+					State->Status.store(AsyncLoadStatus::Finalizing, std::memory_order_release);
+
+					// This can start other loads, so don't hang on to anything from the pending list over it
+					if (!State->Result->FinalizeAsyncLoad())
+					{
+						// Still waiting on something, try again next frame
+						m_Finalizing.push_back(State);
+						continue;
+					}
+					State->Result = AddLoaded(State->Result);
+				}
+			}
+
+			// Keep the state alive until we are done with it, the pending list might be the last owner
+			auto PendingIt = m_PendingLoads.find(State->ID);
+			assert(PendingIt != m_PendingLoads.end());
+			std::shared_ptr<AsyncLoadState> Owner = std::move(PendingIt->second);
+			m_PendingLoads.erase(PendingIt);
+
+			State->Status.store(State->Result ? AsyncLoadStatus::Ready : AsyncLoadStatus::Failed, std::memory_order_release);
+
+			const std::chrono::duration<float> Elapsed = std::chrono::steady_clock::now() - StartTime;
+			if (Elapsed.count() >= m_FinalizeBudget)
+			{
+				break;
+			}
+		}
+
+		// Point handles at anything that just finished loading
+		for (ResourceSlotArrayBase* Slots : GetSlotArrays())
+		{
+			Slots->UpdatePendingLoads();
+		}
+
+		FreeEvictedResources(false);
+		EvictOverBudget();
+	}
+
+	std::vector<ResourceSlotArrayBase*> ResourceManager::GetSlotArrays() const
+	{
+		std::lock_guard<std::mutex> Lock(m_SlotArrayMutex);
+		std::vector<ResourceSlotArrayBase*> SlotArrays;
+		SlotArrays.reserve(m_SlotArrays.size());
+		for (const std::unique_ptr<ResourceSlotArrayBase>& Slots : m_SlotArrays)
+		{
+			SlotArrays.push_back(Slots.get());
+		}
+		return SlotArrays;
+	}
+
+	void ResourceManager::AddResidency(const ResourceMemoryUsage& t_Usage)
+	{
+		for (size_t i = 0; i < NumMemoryTypes; ++i)
+		{
+			if (t_Usage.Bytes[i] == 0)
+			{
+				continue;
+			}
+
+			const uint64 Current = m_CurrentBytes[i].fetch_add(t_Usage.Bytes[i], std::memory_order_relaxed) + t_Usage.Bytes[i];
+			uint64 Peak = m_PeakBytes[i].load(std::memory_order_relaxed);
+			while (Current > Peak && !m_PeakBytes[i].compare_exchange_weak(Peak, Current, std::memory_order_relaxed))
+			{
+			}
+		}
+	}
+
+	void ResourceManager::RemoveResidency(const ResourceMemoryUsage& t_Usage)
+	{
+		for (size_t i = 0; i < NumMemoryTypes; ++i)
+		{
+			m_CurrentBytes[i].fetch_sub(t_Usage.Bytes[i], std::memory_order_relaxed);
+		}
+	}
+
+	void ResourceManager::EvictOverBudget()
+	{
+		bool bHasBudget = false;
+		for (uint64 Budget : m_BudgetBytes)
+		{
+			bHasBudget |= Budget != 0;
+		}
+		if (!bHasBudget)
+		{
+			return;
+		}
+
+		FLING_PROFILE_SCOPE("ResourceManager::EvictOverBudget");
+
+		// Evicted resources are still in memory, but they are already on their way out
+		bool bOverBudget[NumMemoryTypes] = {};
+		const auto UpdateOverBudget = [&]()
+		{
+			bool bAnyOver = false;
+			for (size_t i = 0; i < NumMemoryTypes; ++i)
+			{
+				const uint64 Resident = m_CurrentBytes[i].load(std::memory_order_relaxed) - m_EvictedBytes[i];
+				bOverBudget[i] = m_BudgetBytes[i] != 0 && Resident > m_BudgetBytes[i];
+				bAnyOver |= bOverBudget[i];
+			}
+			return bAnyOver;
+		};
+		const bool bAnyOverBudget = UpdateOverBudget();
+
+		// Anything that is being held onto is in use right now. Only the table is holding onto the rest,
+		// so those are what we can evict
+		struct Candidate
+		{
+			Resource* Res = nullptr;
+			uint64 LastUsed = 0;
+		};
+		std::vector<Candidate> Candidates;
+
+		m_Resources.ForEach([&](const std::shared_ptr<Resource>& t_Res)
+		{
+			if (t_Res.use_count() > 1)
+			{
+				Touch(*t_Res);
+			}
+			else if (bAnyOverBudget && t_Res->CanBeEvicted())
+			{
+				Candidates.push_back({ t_Res.get(), t_Res->m_LastUsedFrame.load(std::memory_order_relaxed) });
+			}
+		});
+
+		if (!bAnyOverBudget)
+		{
+			return;
+		}
+
+		std::sort(Candidates.begin(), Candidates.end(), [](const Candidate& A, const Candidate& B)
+		{
+			return A.LastUsed < B.LastUsed;
+		});
+
+		for (const Candidate& Cur : Candidates)
+		{
+			// Resources without any memory of their own (i.e. materials) can only be holding onto
+			// others, so get rid of those too
+			const ResourceMemoryUsage& Usage = Cur.Res->m_ResidentUsage;
+			bool bHelps = Usage.IsEmpty();
+			for (size_t i = 0; i < NumMemoryTypes; ++i)
+			{
+				bHelps |= bOverBudget[i] && Usage.Bytes[i] != 0;
+			}
+			if (!bHelps)
+			{
+				continue;
+			}
+
+			// Another thread might have grabbed it since we looked
+			std::shared_ptr<Resource> Evicted = m_Resources.RemoveIfUnreferenced(Cur.Res->GetGuidHandle());
+			if (!Evicted)
+			{
+				continue;
+			}
+
+			for (size_t i = 0; i < NumMemoryTypes; ++i)
+			{
+				m_EvictedBytes[i] += Usage.Bytes[i];
+			}
+			m_EvictedResources.push_back({ std::move(Evicted), m_FrameIndex.load(std::memory_order_relaxed) });
+			++m_NumEvictions;
+
+			if (!UpdateOverBudget())
+			{
+				break;
+			}
+		}
+	}
+
+	void ResourceManager::FreeEvictedResources(bool t_bFreeAll)
+	{
+		const uint64 Frame = m_FrameIndex.load(std::memory_order_relaxed);
+		while (!m_EvictedResources.empty() && (t_bFreeAll || m_EvictedResources.front().EvictedFrame + m_EvictionDelayFrames <= Frame))
+		{
+			// Move it out first, freeing it can let go of other resources
+			std::shared_ptr<Resource> Res = std::move(m_EvictedResources.front().Res);
+			m_EvictedResources.pop_front();
+
+			const ResourceMemoryUsage& Usage = Res->m_ResidentUsage;
+			for (size_t i = 0; i < NumMemoryTypes; ++i)
+			{
+				m_EvictedBytes[i] -= Usage.Bytes[i];
+			}
+			RemoveResidency(Usage);
+		}
+	}
+
+	ResourceResidency ResourceManager::GetResidency(ResourceMemoryType t_Type) const
+	{
+		const size_t Index = static_cast<size_t>(t_Type);
+
+		ResourceResidency Residency = {};
+		Residency.CurrentBytes = m_CurrentBytes[Index].load(std::memory_order_relaxed);
+		Residency.PeakBytes = m_PeakBytes[Index].load(std::memory_order_relaxed);
+		Residency.BudgetBytes = m_BudgetBytes[Index];
+		return Residency;
+	}
+
+	void ResourceManager::SetBudget(ResourceMemoryType t_Type, uint64 t_Bytes)
+	{
+		m_BudgetBytes[static_cast<size_t>(t_Type)] = t_Bytes;
+	}
+
+	void ResourceManager::LogResidency() const
+	{
+		for (size_t i = 0; i < NumMemoryTypes; ++i)
+		{
+			const ResourceMemoryType Type = static_cast<ResourceMemoryType>(i);
+			const ResourceResidency Residency = GetResidency(Type);
+			F_LOG_TRACE("{} resources: {:.2f} MB resident, {:.2f} MB peak, {:.0f} MB budget",
+				GetMemoryTypeName(Type),
+				static_cast<double>(Residency.CurrentBytes) / BytesPerMB,
+				static_cast<double>(Residency.PeakBytes) / BytesPerMB,
+				static_cast<double>(Residency.BudgetBytes) / BytesPerMB);
+		}
+		F_LOG_TRACE("Resources evicted: {}", m_NumEvictions);
+	}
+
+	const char* ResourceManager::GetMemoryTypeName(ResourceMemoryType t_Type)
+	{
+		switch (t_Type)
+		{
+		case ResourceMemoryType::Texture:	return "Texture";
+		case ResourceMemoryType::Mesh:		return "Mesh";
+		case ResourceMemoryType::CPU:		return "CPU";
+		default:							return "Unknown";
+		}
+	}
+
+	void ResourceManager::FlushAsyncLoads()
+	{
+		while (!m_PendingLoads.empty())
+		{
+			Update();
+			std::this_thread::yield();
+		}
+	}
+
+	std::shared_ptr<Resource> ResourceManager::GetResource(Guid_Handle t_ID) const
+	{
+		std::shared_ptr<Resource> Res = m_Resources.Find(t_ID);
+		if (Res)
+		{
+			Touch(*Res);
+		}
+		return Res;
 	}
 
 	bool ResourceManager::IsLoaded(Guid_Handle t_ID) const
 	{
-        return (m_ResourceMap.find(t_ID) != m_ResourceMap.end());
+		return m_Resources.Contains(t_ID);
 	}
 }	// namespace Fling
\ No newline at end of file
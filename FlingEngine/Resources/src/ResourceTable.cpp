@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "ResourceTable.h"
+#include "Resource.h"
+
+namespace Fling
+{
+	ResourceTable::ResourceTable(uint32 t_InitialShardCapacity)
+	{
+		// Always keep at least one slot empty so that probing stops
+		uint32 Capacity = 2;
+		while (Capacity < t_InitialShardCapacity)
+		{
+			Capacity <<= 1;
+		}
+
+		for (Shard& CurShard : m_Shards)
+		{
+			CurShard.Slots.resize(Capacity);
+			CurShard.Resources.resize(Capacity);
+		}
+	}
+
+	size_t ResourceTable::Probe(const Shard& t_Shard, Guid_Handle t_ID, uint32 t_Hash)
+	{
+		const size_t Mask = t_Shard.Slots.size() - 1;
+		size_t Index = t_Hash & Mask;
+		while (t_Shard.Slots[Index].bUsed && t_Shard.Slots[Index].Key != t_ID)
+		{
+			Index = (Index + 1) & Mask;
+		}
+		return Index;
+	}
+
+	void ResourceTable::Grow(Shard& t_Shard)
+	{
+		std::vector<Slot> OldSlots = std::move(t_Shard.Slots);
+		std::vector<std::shared_ptr<Resource>> OldResources = std::move(t_Shard.Resources);
+
+		t_Shard.Slots.clear();
+		t_Shard.Slots.resize(OldSlots.size() * 2);
+		t_Shard.Resources.clear();
+		t_Shard.Resources.resize(OldSlots.size() * 2);
+
+		for (size_t i = 0; i < OldSlots.size(); ++i)
+		{
+			if (OldSlots[i].bUsed)
+			{
+				const size_t Index = Probe(t_Shard, OldSlots[i].Key, Mix(OldSlots[i].Key));
+				t_Shard.Slots[Index] = OldSlots[i];
+				t_Shard.Resources[Index] = std::move(OldResources[i]);
+			}
+		}
+	}
+
+	ResourceTable::InsertResult ResourceTable::Insert(const std::shared_ptr<Resource>& t_Resource, std::shared_ptr<Resource>* t_OutExisting)
+	{
+		assert(t_Resource);
+
+		const Guid_Handle ID = t_Resource->GetGuidHandle();
+		const uint32 Hash = Mix(ID);
+		Shard& CurShard = GetShard(Hash);
+
+		std::unique_lock<std::shared_mutex> Lock(CurShard.Mutex);
+
+		size_t Index = Probe(CurShard, ID, Hash);
+		if (CurShard.Slots[Index].bUsed)
+		{
+			const std::shared_ptr<Resource>& Existing = CurShard.Resources[Index];
+			if (t_OutExisting)
+			{
+				*t_OutExisting = Existing;
+			}
+			return Existing->GetGuidString() == t_Resource->GetGuidString() ? InsertResult::AlreadyExists : InsertResult::Collision;
+		}
+
+		// Keep the load factor under 3/4 so that probes stay short
+		if ((CurShard.Count + 1) * 4 > CurShard.Slots.size() * 3)
+		{
+			Grow(CurShard);
+			Index = Probe(CurShard, ID, Hash);
+		}
+
+		CurShard.Slots[Index].Key = ID;
+		CurShard.Slots[Index].bUsed = true;
+		CurShard.Resources[Index] = t_Resource;
+		++CurShard.Count;
+
+		if (t_OutExisting)
+		{
+			*t_OutExisting = t_Resource;
+		}
+		return InsertResult::Inserted;
+	}
+
+	std::shared_ptr<Resource> ResourceTable::Find(Guid_Handle t_ID) const
+	{
+		const uint32 Hash = Mix(t_ID);
+		const Shard& CurShard = GetShard(Hash);
+
+		std::shared_lock<std::shared_mutex> Lock(CurShard.Mutex);
+
+		const size_t Index = Probe(CurShard, t_ID, Hash);
+		return CurShard.Slots[Index].bUsed ? CurShard.Resources[Index] : nullptr;
+	}
+
+	bool ResourceTable::Contains(Guid_Handle t_ID) const
+	{
+		const uint32 Hash = Mix(t_ID);
+		const Shard& CurShard = GetShard(Hash);
+
+		std::shared_lock<std::shared_mutex> Lock(CurShard.Mutex);
+
+		return CurShard.Slots[Probe(CurShard, t_ID, Hash)].bUsed;
+	}
+
+	std::shared_ptr<Resource> ResourceTable::Erase(Shard& t_Shard, size_t t_Index)
+	{
+		std::shared_ptr<Resource> Removed = std::move(t_Shard.Resources[t_Index]);
+		t_Shard.Slots[t_Index].bUsed = false;
+		--t_Shard.Count;
+
+		const size_t Mask = t_Shard.Slots.size() - 1;
+		size_t Hole = t_Index;
+		size_t Index = (Hole + 1) & Mask;
+		while (t_Shard.Slots[Index].bUsed)
+		{
+			const size_t Home = Mix(t_Shard.Slots[Index].Key) & Mask;
+
+			// Only move it if its home slot is not between the hole and where it is now
+			const bool bCanMove = ((Index - Home) & Mask) >= ((Index - Hole) & Mask);
+			if (bCanMove)
+			{
+				t_Shard.Slots[Hole] = t_Shard.Slots[Index];
+				t_Shard.Resources[Hole] = std::move(t_Shard.Resources[Index]);
+				t_Shard.Slots[Index].bUsed = false;
+				Hole = Index;
+			}
+			Index = (Index + 1) & Mask;
+		}
+
+		return Removed;
+	}
+
+	bool ResourceTable::Remove(Guid_Handle t_ID)
+	{
+		const uint32 Hash = Mix(t_ID);
+		Shard& CurShard = GetShard(Hash);
+
+		// Hang on to it so that the resource isn't destroyed while we have the lock
+		std::shared_ptr<Resource> Removed;
+		{
+			std::unique_lock<std::shared_mutex> Lock(CurShard.Mutex);
+
+			const size_t Index = Probe(CurShard, t_ID, Hash);
+			if (!CurShard.Slots[Index].bUsed)
+			{
+				return false;
+			}
+			Removed = Erase(CurShard, Index);
+		}
+
+		return true;
+	}
+
+	std::shared_ptr<Resource> ResourceTable::RemoveIfUnreferenced(Guid_Handle t_ID)
+	{
+		const uint32 Hash = Mix(t_ID);
+		Shard& CurShard = GetShard(Hash);
+
+		std::unique_lock<std::shared_mutex> Lock(CurShard.Mutex);
+
+		// New references can only come from the table while we hold the lock, so this count can't go up
+		const size_t Index = Probe(CurShard, t_ID, Hash);
+		if (!CurShard.Slots[Index].bUsed || CurShard.Resources[Index].use_count() != 1)
+		{
+			return nullptr;
+		}
+		return Erase(CurShard, Index);
+	}
+
+	void ResourceTable::Clear()
+	{
+		for (Shard& CurShard : m_Shards)
+		{
+			// Move the resources out first, they might load or unload other resources when they are destroyed
+			std::vector<std::shared_ptr<Resource>> Removed;
+			{
+				std::unique_lock<std::shared_mutex> Lock(CurShard.Mutex);
+				Removed.swap(CurShard.Resources);
+				CurShard.Resources.resize(CurShard.Slots.size());
+				for (Slot& CurSlot : CurShard.Slots)
+				{
+					CurSlot = Slot {};
+				}
+				CurShard.Count = 0;
+			}
+		}
+	}
+
+	size_t ResourceTable::Size() const
+	{
+		size_t Total = 0;
+		for (const Shard& CurShard : m_Shards)
+		{
+			std::shared_lock<std::shared_mutex> Lock(CurShard.Mutex);
+			Total += CurShard.Count;
+		}
+		return Total;
+	}
+}	// namespace Fling
@@ -23,6 +23,29 @@ namespace Fling
 
 	Texture::Texture(Guid t_ID)
         : Resource(t_ID)
+    {
+        LoadPixelData();
+        CreateVulkanResources();
+	}
+
+	Texture::Texture(Guid t_ID, AsyncLoad_t)
+        : Resource(t_ID)
+    {
+        LoadPixelData();
+
+        if (!m_PixelData)
+        {
+            throw std::runtime_error("Failed to decode image");
+        }
+	}
+
+    bool Texture::FinalizeAsyncLoad()
+    {
+        CreateVulkanResources();
+        return true;
+    }
+
+    void Texture::CreateVulkanResources()
     {
         LoadVulkanImage();
 
@@ -34,17 +57,47 @@ namespace Fling
 		m_ImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		m_ImageInfo.imageView = m_ImageView;
 		m_ImageInfo.sampler = m_TextureSampler;
-	}
+    }
 
-    void Texture::LoadVulkanImage()
+    ResourceMemoryUsage Texture::GetMemoryUsage() const
+    {
+        ResourceMemoryUsage Usage;
+
+        if (m_vVkImage != VK_NULL_HANDLE)
+        {
+            uint64 ImageBytes = 0;
+            for (uint32 Mip = 0; Mip < m_MipLevels; ++Mip)
+            {
+                ImageBytes += uint64(std::max(m_Width >> Mip, 1u)) * uint64(std::max(m_Height >> Mip, 1u)) * 4;
+            }
+            Usage[ResourceMemoryType::Texture] = ImageBytes;
+        }
+
+        if (m_PixelData)
+        {
+            Usage[ResourceMemoryType::CPU] = GetImageSize();
+        }
+
+        return Usage;
+    }
+
+    void Texture::LoadPixelData()
     {
         const std::string Filepath = GetFilepathReleativeToAssets();
 
-        // Load the image from STB
+        // Decode the image with STB straight out of the mapped file
+        AssetData Data;
+        if (!ReadAsset(Data))
+        {
+            F_LOG_ERROR("Failed to open image file: {}", Filepath);
+            return;
+        }
+
         int Width = 0;
         int Height = 0;
-        m_PixelData = stbi_load(
-            Filepath.c_str(),
+        m_PixelData = stbi_load_from_memory(
+            reinterpret_cast<const stbi_uc*>(Data.GetData()),
+            static_cast<int>(Data.GetSize()),
             &Width,
             &Height,
             &m_Channels,
@@ -59,7 +112,10 @@ namespace Fling
         {
             F_LOG_ERROR("Failed to load image file: {}", Filepath);
         }
+    }
 
+    void Texture::LoadVulkanImage()
+    {
         GraphicsHelpers::CreateVkImage(
 			VulkanApp::Get().GetLogicalDevice()->GetVkDevice(),
             m_Width,
@@ -273,6 +329,7 @@ namespace Fling
     {
         // We don't need this stbi pixel data any more
         stbi_image_free(m_PixelData);
+        m_PixelData = nullptr;
         
 		LogicalDevice* LogDevice = VulkanApp::Get().GetLogicalDevice();
 		assert(LogDevice);
@@ -0,0 +1,518 @@
+#include "pch.h"
+#include "VirtualFileSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <set>
+
+namespace Fling
+{
+	VirtualFileSystem::MountId VirtualFileSystem::MountDirectory(const std::string& t_Dir, int32 t_Priority)
+	{
+		std::error_code Error;
+		if (!std::filesystem::is_directory(t_Dir, Error))
+		{
+			F_LOG_ERROR("Failed to mount directory {}, it doesn't exist", t_Dir);
+			return InvalidMount;
+		}
+
+		std::unique_ptr<Mount> NewMount = std::make_unique<Mount>();
+		NewMount->Type = VfsMountType::Directory;
+		NewMount->Priority = t_Priority;
+		NewMount->Root = t_Dir;
+		ScanDirectory(*NewMount);
+
+		F_LOG_TRACE("Mounted directory {} with {} files", t_Dir, NewMount->LooseFiles.size());
+		return AddMount(std::move(NewMount));
+	}
+
+	VirtualFileSystem::MountId VirtualFileSystem::MountArchive(const std::string& t_Path, int32 t_Priority)
+	{
+		std::unique_ptr<AssetArchive> Archive = std::make_unique<AssetArchive>();
+		if (!Archive->Open(t_Path))
+		{
+			return InvalidMount;
+		}
+
+		std::unique_ptr<Mount> NewMount = std::make_unique<Mount>();
+		NewMount->Type = VfsMountType::Archive;
+		NewMount->Priority = t_Priority;
+		NewMount->Root = t_Path;
+		NewMount->Archive = std::move(Archive);
+
+		F_LOG_TRACE("Mounted asset archive {} with {} assets", t_Path, NewMount->Archive->GetNumEntries());
+		return AddMount(std::move(NewMount));
+	}
+
+	VirtualFileSystem::MountId VirtualFileSystem::MountMemory(int32 t_Priority)
+	{
+		std::unique_ptr<Mount> NewMount = std::make_unique<Mount>();
+		NewMount->Type = VfsMountType::Memory;
+		NewMount->Priority = t_Priority;
+		return AddMount(std::move(NewMount));
+	}
+
+	bool VirtualFileSystem::WriteMemoryFile(MountId t_Mount, const std::string& t_Path, const void* t_Data, size_t t_Size)
+	{
+		const char* Bytes = static_cast<const char*>(t_Data);
+		std::shared_ptr<const std::vector<char>> File = std::make_shared<const std::vector<char>>(Bytes, Bytes + t_Size);
+
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+		Mount* Target = FindMount(t_Mount);
+		if (!Target || Target->Type != VfsMountType::Memory)
+		{
+			F_LOG_ERROR("Failed to write {}, mount point {} isn't a memory mount", t_Path, t_Mount);
+			return false;
+		}
+
+		// Readers that already have the old file keep it alive
+		Target->MemoryFiles[t_Path] = std::move(File);
+		ResolvePath(t_Path);
+		return true;
+	}
+
+	bool VirtualFileSystem::Unmount(MountId t_Mount)
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+		auto It = std::find_if(m_Mounts.begin(), m_Mounts.end(), [t_Mount](const std::unique_ptr<Mount>& t_Other) { return t_Other->ID == t_Mount; });
+		if (It == m_Mounts.end())
+		{
+			return false;
+		}
+
+		m_Mounts.erase(It);
+		RebuildIndex();
+		return true;
+	}
+
+	void VirtualFileSystem::UnmountAll(VfsMountType t_Type)
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+		m_Mounts.erase(
+			std::remove_if(m_Mounts.begin(), m_Mounts.end(), [t_Type](const std::unique_ptr<Mount>& t_Mount) { return t_Mount->Type == t_Type; }),
+			m_Mounts.end());
+		RebuildIndex();
+	}
+
+	void VirtualFileSystem::UnmountAll()
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+		m_Mounts.clear();
+		m_Index.clear();
+		ClearPrefetched();
+	}
+
+	size_t VirtualFileSystem::GetNumMounts(VfsMountType t_Type) const
+	{
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+		return static_cast<size_t>(std::count_if(m_Mounts.begin(), m_Mounts.end(), [t_Type](const std::unique_ptr<Mount>& t_Mount) { return t_Mount->Type == t_Type; }));
+	}
+
+	size_t VirtualFileSystem::GetNumFiles() const
+	{
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+		return m_Index.size();
+	}
+
+	bool VirtualFileSystem::Read(Guid_Handle t_ID, std::string_view t_Path, AssetData& t_Out) const
+	{
+		FLING_PROFILE_SCOPE("VirtualFileSystem::Read");
+
+		t_Out = AssetData {};
+
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+		auto It = m_Index.find(t_ID);
+		if (It == m_Index.end() || It->second.Path != t_Path)
+		{
+			return false;
+		}
+
+		const IndexEntry& Entry = It->second;
+		switch (Entry.Source->Type)
+		{
+		case VfsMountType::Directory:
+			if (m_NumPrefetched.load(std::memory_order_relaxed) != 0 && TakePrefetched(t_ID, t_Path, t_Out))
+			{
+				return true;
+			}
+
+			if (!t_Out.m_Mapping.Open(Entry.Source->Root + "/" + Entry.Path, MappedFileAccess::Sequential))
+			{
+				return false;
+			}
+			t_Out.m_View = t_Out.m_Mapping.GetView();
+			break;
+
+		case VfsMountType::Archive:
+			return Entry.Source->Archive->Read(*Entry.ArchiveEntry, t_Out);
+
+		case VfsMountType::Memory:
+			t_Out.m_View = std::string_view(Entry.MemoryFile->data(), Entry.MemoryFile->size());
+			t_Out.m_Owner = Entry.MemoryFile;
+			break;
+		}
+
+		t_Out.m_bValid = true;
+		return true;
+	}
+
+	bool VirtualFileSystem::Exists(Guid_Handle t_ID, std::string_view t_Path) const
+	{
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+		auto It = m_Index.find(t_ID);
+		return It != m_Index.end() && It->second.Path == t_Path;
+	}
+
+	bool VirtualFileSystem::GetFileInfo(Guid_Handle t_ID, std::string_view t_Path, VfsFileInfo& t_Out) const
+	{
+		t_Out = VfsFileInfo {};
+
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+		auto It = m_Index.find(t_ID);
+		if (It == m_Index.end() || It->second.Path != t_Path)
+		{
+			return false;
+		}
+
+		const IndexEntry& Entry = It->second;
+		switch (Entry.Source->Type)
+		{
+		case VfsMountType::Directory:
+		{
+			const std::string FullPath = Entry.Source->Root + "/" + Entry.Path;
+			std::error_code Error;
+			const std::uintmax_t Size = std::filesystem::file_size(FullPath, Error);
+			if (Error)
+			{
+				return false;
+			}
+			const std::filesystem::file_time_type Time = std::filesystem::last_write_time(FullPath, Error);
+			t_Out.Size = static_cast<uint64>(Size);
+			t_Out.ModifiedTime = Error ? 0 : static_cast<uint64>(Time.time_since_epoch().count());
+			break;
+		}
+
+		case VfsMountType::Archive:
+			t_Out.Size = Entry.ArchiveEntry->Size;
+			t_Out.Hash = Entry.ArchiveEntry->Checksum;
+			break;
+
+		case VfsMountType::Memory:
+			t_Out.Size = Entry.MemoryFile->size();
+			break;
+		}
+		return true;
+	}
+
+	VfsMountType VirtualFileSystem::GetSourceType(const std::string& t_Path) const
+	{
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+		auto It = m_Index.find(Guid{ t_Path.c_str() });
+		assert(It != m_Index.end() && It->second.Path == t_Path);
+		return It->second.Source->Type;
+	}
+
+	void VirtualFileSystem::ListDirectory(const std::string& t_Dir, std::vector<std::string>& t_OutFiles, std::vector<std::string>& t_OutDirs) const
+	{
+		t_OutFiles.clear();
+		t_OutDirs.clear();
+
+		const std::string Prefix = (t_Dir.empty() || t_Dir.back() == '/') ? t_Dir : t_Dir + "/";
+		std::set<std::string> Dirs;
+
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+		for (const auto& Pair : m_Index)
+		{
+			const std::string& Path = Pair.second.Path;
+			if (Path.compare(0, Prefix.size(), Prefix) != 0)
+			{
+				continue;
+			}
+
+			const size_t Slash = Path.find('/', Prefix.size());
+			if (Slash == std::string::npos)
+			{
+				t_OutFiles.push_back(Path);
+			}
+			else
+			{
+				Dirs.insert(Path.substr(0, Slash));
+			}
+		}
+
+		std::sort(t_OutFiles.begin(), t_OutFiles.end());
+		t_OutDirs.assign(Dirs.begin(), Dirs.end());
+	}
+
+	void VirtualFileSystem::RefreshPath(const std::string& t_Path)
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+		for (const std::unique_ptr<Mount>& DirMount : m_Mounts)
+		{
+			if (DirMount->Type != VfsMountType::Directory)
+			{
+				continue;
+			}
+
+			std::error_code Error;
+			if (std::filesystem::is_regular_file(DirMount->Root + "/" + t_Path, Error))
+			{
+				DirMount->LooseFiles.insert(t_Path);
+			}
+			else
+			{
+				DirMount->LooseFiles.erase(t_Path);
+			}
+		}
+		DropPrefetched(Guid{ t_Path.c_str() });
+		ResolvePath(t_Path);
+	}
+
+	void VirtualFileSystem::Rescan()
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+		for (const std::unique_ptr<Mount>& DirMount : m_Mounts)
+		{
+			if (DirMount->Type == VfsMountType::Directory)
+			{
+				ScanDirectory(*DirMount);
+			}
+		}
+		RebuildIndex();
+	}
+
+	size_t VirtualFileSystem::Prefetch(const std::vector<std::string>& t_Paths)
+	{
+		FLING_PROFILE_SCOPE("VirtualFileSystem::Prefetch");
+
+		std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+		std::lock_guard<std::mutex> ReaderLock(m_ReaderMutex);
+		if (!m_Reader)
+		{
+			m_Reader = std::make_unique<BatchFileReader>(m_ReadBackend);
+		}
+
+		BatchFileReader& Reader = *m_Reader;
+		Reader.Clear();
+		std::vector<const IndexEntry*> Entries;
+		for (const std::string& Path : t_Paths)
+		{
+			auto It = m_Index.find(Guid{ Path.c_str() });
+			if (It == m_Index.end() || It->second.Path != Path || It->second.Source->Type != VfsMountType::Directory)
+			{
+				continue;
+			}
+
+			if (std::find(Entries.begin(), Entries.end(), &It->second) == Entries.end())
+			{
+				Entries.push_back(&It->second);
+				Reader.Add(It->second.Source->Root + "/" + Path);
+			}
+		}
+
+		if (Entries.empty())
+		{
+			return 0;
+		}
+
+		Reader.ReadAll();
+
+		size_t NumPrefetched = 0;
+		std::lock_guard<std::mutex> PrefetchLock(m_PrefetchMutex);
+		for (size_t i = 0; i < Entries.size(); ++i)
+		{
+			const BatchFileReader::Result& Result = Reader.GetResult(i);
+			if (!Result.bSuccess)
+			{
+				continue;
+			}
+
+			PrefetchedFile& File = m_Prefetched[Guid{ Entries[i]->Path.c_str() }];
+			File.Path = Entries[i]->Path;
+			File.Buffer = Reader.TakeBuffer(i);
+			File.Size = Result.Size;
+			++NumPrefetched;
+		}
+		m_NumPrefetched.store(m_Prefetched.size(), std::memory_order_relaxed);
+
+		Reader.Clear();
+
+		F_LOG_TRACE("Prefetched {} files with {}", NumPrefetched, GetFileReadBackendName(Reader.GetBackend()));
+		return NumPrefetched;
+	}
+
+	void VirtualFileSystem::SetReadBackend(FileReadBackend t_Backend)
+	{
+		std::lock_guard<std::mutex> ReaderLock(m_ReaderMutex);
+		if (t_Backend != m_ReadBackend)
+		{
+			m_ReadBackend = t_Backend;
+			m_Reader.reset();
+		}
+	}
+
+	void VirtualFileSystem::ClearPrefetched()
+	{
+		std::lock_guard<std::mutex> PrefetchLock(m_PrefetchMutex);
+		m_Prefetched.clear();
+		m_NumPrefetched.store(0, std::memory_order_relaxed);
+	}
+
+	bool VirtualFileSystem::TakePrefetched(Guid_Handle t_ID, std::string_view t_Path, AssetData& t_Out) const
+	{
+		std::lock_guard<std::mutex> PrefetchLock(m_PrefetchMutex);
+		auto It = m_Prefetched.find(t_ID);
+		if (It == m_Prefetched.end() || It->second.Path != t_Path)
+		{
+			return false;
+		}
+
+		t_Out.m_View = std::string_view(It->second.Buffer.get(), static_cast<size_t>(It->second.Size));
+		t_Out.m_Owner = std::move(It->second.Buffer);
+		t_Out.m_bValid = true;
+
+		m_Prefetched.erase(It);
+		m_NumPrefetched.store(m_Prefetched.size(), std::memory_order_relaxed);
+		return true;
+	}
+
+	void VirtualFileSystem::DropPrefetched(Guid_Handle t_ID)
+	{
+		std::lock_guard<std::mutex> PrefetchLock(m_PrefetchMutex);
+		m_Prefetched.erase(t_ID);
+		m_NumPrefetched.store(m_Prefetched.size(), std::memory_order_relaxed);
+	}
+
+	VirtualFileSystem::MountId VirtualFileSystem::AddMount(std::unique_ptr<Mount> t_Mount)
+	{
+		std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+		t_Mount->ID = m_NextMountId++;
+		const MountId ID = t_Mount->ID;
+
+		// After everything with the same priority, so that the newest mount wins ties
+		auto It = std::upper_bound(m_Mounts.begin(), m_Mounts.end(), t_Mount->Priority,
+			[](int32 t_Priority, const std::unique_ptr<Mount>& t_Other) { return t_Priority < t_Other->Priority; });
+		m_Mounts.insert(It, std::move(t_Mount));
+
+		RebuildIndex();
+		return ID;
+	}
+
+	VirtualFileSystem::Mount* VirtualFileSystem::FindMount(MountId t_Mount) const
+	{
+		for (const std::unique_ptr<Mount>& Existing : m_Mounts)
+		{
+			if (Existing->ID == t_Mount)
+			{
+				return Existing.get();
+			}
+		}
+		return nullptr;
+	}
+
+	void VirtualFileSystem::ScanDirectory(Mount& t_Mount)
+	{
+		namespace fs = std::filesystem;
+
+		t_Mount.LooseFiles.clear();
+
+		std::error_code Error;
+		const fs::path Root(t_Mount.Root);
+		for (fs::recursive_directory_iterator It(Root, Error), End; !Error && It != End; It.increment(Error))
+		{
+			if (It->is_regular_file())
+			{
+				// Guids always use forward slashes
+				t_Mount.LooseFiles.insert(fs::relative(It->path(), Root).generic_string());
+			}
+		}
+
+		if (Error)
+		{
+			F_LOG_ERROR("Failed to scan directory {}: {}", t_Mount.Root, Error.message());
+		}
+	}
+
+	void VirtualFileSystem::ResolvePath(const std::string& t_Path)
+	{
+		auto It = m_Index.find(Guid{ t_Path.c_str() });
+		if (It != m_Index.end() && It->second.Path == t_Path)
+		{
+			m_Index.erase(It);
+		}
+
+		for (const std::unique_ptr<Mount>& Source : m_Mounts)
+		{
+			const bool bHasFile =
+				(Source->Type == VfsMountType::Directory && Source->LooseFiles.count(t_Path)) ||
+				(Source->Type == VfsMountType::Archive && Source->Archive->Contains(Guid{ t_Path.c_str() }, t_Path)) ||
+				(Source->Type == VfsMountType::Memory && Source->MemoryFiles.count(t_Path));
+
+			if (bHasFile)
+			{
+				AddToIndex(t_Path, *Source);
+			}
+		}
+	}
+
+	void VirtualFileSystem::AddToIndex(const std::string& t_Path, const Mount& t_Source)
+	{
+		const Guid_Handle ID = Guid{ t_Path.c_str() };
+		IndexEntry& Entry = m_Index[ID];
+		if (Entry.Source && Entry.Path != t_Path)
+		{
+			F_LOG_ERROR("Guid collision! '{}' and '{}' have the same hash, rename one of them", Entry.Path, t_Path);
+			return;
+		}
+
+		Entry.Path = t_Path;
+		Entry.Source = &t_Source;
+		Entry.ArchiveEntry = nullptr;
+		Entry.MemoryFile.reset();
+
+		if (t_Source.Type == VfsMountType::Archive)
+		{
+			Entry.ArchiveEntry = t_Source.Archive->Find(ID, t_Path);
+		}
+		else if (t_Source.Type == VfsMountType::Memory)
+		{
+			Entry.MemoryFile = t_Source.MemoryFiles.at(t_Path);
+		}
+	}
+
+	void VirtualFileSystem::RebuildIndex()
+	{
+		// Anything that was prefetched might come from somewhere else now
+		ClearPrefetched();
+		m_Index.clear();
+
+		// Lowest priority first, so that higher priority files replace them
+		for (const std::unique_ptr<Mount>& Source : m_Mounts)
+		{
+			switch (Source->Type)
+			{
+			case VfsMountType::Directory:
+				for (const std::string& Path : Source->LooseFiles)
+				{
+					AddToIndex(Path, *Source);
+				}
+				break;
+
+			case VfsMountType::Archive:
+				Source->Archive->ForEachEntry([&](const AssetArchiveEntry& t_Entry)
+				{
+					AddToIndex(std::string(Source->Archive->GetEntryPath(t_Entry)), *Source);
+				});
+				break;
+
+			case VfsMountType::Memory:
+				for (const auto& Pair : Source->MemoryFiles)
+				{
+					AddToIndex(Pair.first, *Source);
+				}
+				break;
+			}
+		}
+	}
+}   // namespace Fling
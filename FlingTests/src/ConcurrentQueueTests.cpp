@@ -0,0 +1,312 @@
+#include <catch2/catch_all.hpp>
+
+#include "pch.h"
+#include "ConcurrentQueue.hpp"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Fling;
+
+TEST_CASE("SPSC Queue", "[jobs]")
+{
+	SECTION("Pops in FIFO order")
+	{
+		SpscQueue<int, 4> Queue;
+		int Item = -1;
+		REQUIRE_FALSE(Queue.TryPop(Item));
+		REQUIRE(Queue.Empty());
+
+		REQUIRE(Queue.TryPush(1));
+		REQUIRE(Queue.TryPush(2));
+		REQUIRE(Queue.Size() == 2);
+
+		REQUIRE(Queue.TryPop(Item));
+		REQUIRE(Item == 1);
+		REQUIRE(Queue.TryPop(Item));
+		REQUIRE(Item == 2);
+		REQUIRE_FALSE(Queue.TryPop(Item));
+	}
+
+	SECTION("Push fails when full")
+	{
+		SpscQueue<int, 4> Queue;
+		for (int i = 0; i < 4; ++i)
+		{
+			REQUIRE(Queue.TryPush(i));
+		}
+		REQUIRE_FALSE(Queue.TryPush(4));
+
+		// Popping makes room again, and the queue keeps wrapping around
+		int Item = -1;
+		for (int i = 4; i < 64; ++i)
+		{
+			REQUIRE(Queue.TryPop(Item));
+			REQUIRE(Item == i - 4);
+			REQUIRE(Queue.TryPush(i));
+		}
+		REQUIRE(Queue.Size() == 4);
+	}
+
+	SECTION("Move only types")
+	{
+		SpscQueue<std::unique_ptr<int>, 2> Queue;
+		REQUIRE(Queue.TryPush(std::make_unique<int>(7)));
+
+		std::unique_ptr<int> Item;
+		REQUIRE(Queue.TryPop(Item));
+		REQUIRE(*Item == 7);
+	}
+
+	SECTION("Producer and consumer threads")
+	{
+		constexpr uint64 NumItems = 100000;
+		auto Queue = std::make_unique<SpscQueue<uint64, 256>>();
+
+		std::thread Producer([&Queue]()
+		{
+			for (uint64 i = 1; i <= NumItems; ++i)
+			{
+				while (!Queue->TryPush(i))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		// Items have to come out in the same order they went in
+		uint64 Expected = 1;
+		bool bInOrder = true;
+		while (Expected <= NumItems)
+		{
+			uint64 Item = 0;
+			if (Queue->TryPop(Item))
+			{
+				bInOrder &= (Item == Expected);
+				++Expected;
+			}
+		}
+
+		Producer.join();
+		REQUIRE(bInOrder);
+		REQUIRE(Queue->Empty());
+	}
+}
+
+TEST_CASE("MPMC Queue", "[jobs]")
+{
+	SECTION("Pops in FIFO order")
+	{
+		MpmcQueue<int, 4> Queue;
+		int Item = -1;
+		REQUIRE_FALSE(Queue.TryPop(Item));
+
+		REQUIRE(Queue.TryPush(1));
+		REQUIRE(Queue.TryPush(2));
+		REQUIRE(Queue.Size() == 2);
+
+		REQUIRE(Queue.TryPop(Item));
+		REQUIRE(Item == 1);
+		REQUIRE(Queue.TryPop(Item));
+		REQUIRE(Item == 2);
+		REQUIRE_FALSE(Queue.TryPop(Item));
+		REQUIRE(Queue.Empty());
+	}
+
+	SECTION("Push fails when full")
+	{
+		MpmcQueue<int, 4> Queue;
+		for (int i = 0; i < 4; ++i)
+		{
+			REQUIRE(Queue.TryPush(i));
+		}
+		REQUIRE_FALSE(Queue.TryPush(4));
+
+		int Item = -1;
+		for (int i = 4; i < 64; ++i)
+		{
+			REQUIRE(Queue.TryPop(Item));
+			REQUIRE(Item == i - 4);
+			REQUIRE(Queue.TryPush(i));
+		}
+		REQUIRE(Queue.Size() == 4);
+	}
+
+	SECTION("Many producers and consumers")
+	{
+		constexpr uint32 NumProducers = 4;
+		constexpr uint32 NumConsumers = 4;
+		constexpr uint64 ItemsPerProducer = 25000;
+		auto Queue = std::make_unique<MpmcQueue<uint64, 1024>>();
+
+		std::atomic<uint64> Sum { 0 };
+		std::atomic<uint64> Popped { 0 };
+		std::vector<std::thread> Threads;
+
+		for (uint32 p = 0; p < NumProducers; ++p)
+		{
+			Threads.emplace_back([&Queue]()
+			{
+				for (uint64 i = 1; i <= ItemsPerProducer; ++i)
+				{
+					while (!Queue->TryPush(i))
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		for (uint32 c = 0; c < NumConsumers; ++c)
+		{
+			Threads.emplace_back([&]()
+			{
+				while (Popped.load() < NumProducers * ItemsPerProducer)
+				{
+					uint64 Item = 0;
+					if (Queue->TryPop(Item))
+					{
+						Sum.fetch_add(Item);
+						Popped.fetch_add(1);
+					}
+					else
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+
+		// Every item was popped exactly once
+		REQUIRE(Popped.load() == NumProducers * ItemsPerProducer);
+		REQUIRE(Sum.load() == NumProducers * (ItemsPerProducer * (ItemsPerProducer + 1) / 2));
+		REQUIRE(Queue->Empty());
+	}
+}
+
+namespace
+{
+	/** What the queues replace, used as a baseline for the benchmarks */
+	template<typename T>
+	class MutexQueue
+	{
+	public:
+		bool TryPush(T t_Item)
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_Items.push_back(t_Item);
+			return true;
+		}
+
+		bool TryPop(T& t_OutItem)
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			if (m_Items.empty())
+			{
+				return false;
+			}
+			t_OutItem = m_Items.front();
+			m_Items.pop_front();
+			return true;
+		}
+
+	private:
+		std::mutex m_Mutex;
+		std::deque<T> m_Items;
+	};
+
+	/** Push t_NumItems from t_NumProducers threads while t_NumConsumers threads pop them */
+	template<typename T_Queue>
+	uint64 RunQueueBenchmark(T_Queue& t_Queue, uint32 t_NumProducers, uint32 t_NumConsumers, uint64 t_NumItems)
+	{
+		std::atomic<uint64> Popped { 0 };
+		std::atomic<uint64> Sum { 0 };
+		std::vector<std::thread> Threads;
+
+		for (uint32 p = 0; p < t_NumProducers; ++p)
+		{
+			Threads.emplace_back([&]()
+			{
+				for (uint64 i = 0; i < t_NumItems / t_NumProducers; ++i)
+				{
+					while (!t_Queue.TryPush(i))
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		for (uint32 c = 0; c < t_NumConsumers; ++c)
+		{
+			Threads.emplace_back([&]()
+			{
+				uint64 LocalSum = 0;
+				uint64 Item = 0;
+				while (Popped.load(std::memory_order_relaxed) < t_NumItems)
+				{
+					if (t_Queue.TryPop(Item))
+					{
+						LocalSum += Item;
+						Popped.fetch_add(1, std::memory_order_relaxed);
+					}
+					else
+					{
+						std::this_thread::yield();
+					}
+				}
+				Sum.fetch_add(LocalSum);
+			});
+		}
+
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+		return Sum.load();
+	}
+}
+
+TEST_CASE("Concurrent Queue Benchmarks", "[jobs][!benchmark]")
+{
+	constexpr uint64 NumItems = 1 << 16;
+
+	BENCHMARK("SPSC queue, 1 producer 1 consumer")
+	{
+		auto Queue = std::make_unique<SpscQueue<uint64, 1024>>();
+		return RunQueueBenchmark(*Queue, 1, 1, NumItems);
+	};
+
+	BENCHMARK("MPMC queue, 1 producer 1 consumer")
+	{
+		auto Queue = std::make_unique<MpmcQueue<uint64, 1024>>();
+		return RunQueueBenchmark(*Queue, 1, 1, NumItems);
+	};
+
+	BENCHMARK("Mutex queue, 1 producer 1 consumer")
+	{
+		MutexQueue<uint64> Queue;
+		return RunQueueBenchmark(Queue, 1, 1, NumItems);
+	};
+
+	BENCHMARK("MPMC queue, 4 producers 4 consumers")
+	{
+		auto Queue = std::make_unique<MpmcQueue<uint64, 1024>>();
+		return RunQueueBenchmark(*Queue, 4, 4, NumItems);
+	};
+
+	BENCHMARK("Mutex queue, 4 producers 4 consumers")
+	{
+		MutexQueue<uint64> Queue;
+		return RunQueueBenchmark(Queue, 4, 4, NumItems);
+	};
+}
@@ -0,0 +1,216 @@
+#include <catch2/catch_all.hpp>
+
+#include "pch.h"
+#include "JobSystem.h"
+#include "WorkStealingQueue.hpp"
+#include "Misc/CommandLine.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Fling;
+
+TEST_CASE("Work Stealing Queue", "[jobs]")
+{
+	int Items[4] = { 0, 1, 2, 3 };
+
+	SECTION("Owner pops in LIFO order")
+	{
+		WorkStealingQueue<int*, 4> Queue;
+		REQUIRE(Queue.Pop() == nullptr);
+
+		REQUIRE(Queue.Push(&Items[0]));
+		REQUIRE(Queue.Push(&Items[1]));
+		REQUIRE(Queue.Size() == 2);
+
+		REQUIRE(Queue.Pop() == &Items[1]);
+		REQUIRE(Queue.Pop() == &Items[0]);
+		REQUIRE(Queue.Pop() == nullptr);
+	}
+
+	SECTION("Thieves steal in FIFO order")
+	{
+		WorkStealingQueue<int*, 4> Queue;
+		REQUIRE(Queue.Steal() == nullptr);
+
+		REQUIRE(Queue.Push(&Items[0]));
+		REQUIRE(Queue.Push(&Items[1]));
+
+		REQUIRE(Queue.Steal() == &Items[0]);
+		REQUIRE(Queue.Pop() == &Items[1]);
+		REQUIRE(Queue.Steal() == nullptr);
+	}
+
+	SECTION("Push fails when full")
+	{
+		WorkStealingQueue<int*, 4> Queue;
+		for (int i = 0; i < 4; ++i)
+		{
+			REQUIRE(Queue.Push(&Items[i]));
+		}
+		REQUIRE_FALSE(Queue.Push(&Items[0]));
+
+		// Stealing makes room again
+		REQUIRE(Queue.Steal() == &Items[0]);
+		REQUIRE(Queue.Push(&Items[0]));
+	}
+}
+
+TEST_CASE("Job System", "[jobs]")
+{
+	Logger::Get().Init();
+
+	SECTION("Parallel for runs inline when not initalized")
+	{
+		uint32 Calls = 0;
+		JobSystem::Get().ParallelFor(100, 10, [&](uint32 t_Begin, uint32 t_End)
+		{
+			REQUIRE(t_Begin == 0);
+			REQUIRE(t_End == 100);
+			++Calls;
+		});
+		REQUIRE(Calls == 1);
+	}
+
+	// Always use a few workers so that stealing is covered no matter how many cores there are
+	REQUIRE(CommandLine::Get().LoadConfigVarsFromString("[ConsoleVariables]\nJobWorkerCount=3\n"));
+
+	JobSystem::Get().Init();
+	REQUIRE(JobSystem::Get().IsRunning());
+	REQUIRE(JobSystem::Get().GetWorkerCount() == 4);
+	REQUIRE(JobSystem::Get().IsWorkerThread());
+
+	SECTION("Counters and waiting")
+	{
+		std::atomic<uint32> Sum { 0 };
+		JobCounter Counter;
+
+		for (uint32 i = 1; i <= 1000; ++i)
+		{
+			JobSystem::Get().Run(JobSystem::Get().CreateJob(&Counter, [&Sum, i]() { Sum.fetch_add(i); }));
+		}
+		JobSystem::Get().Wait(Counter);
+
+		REQUIRE(Counter.IsDone());
+		REQUIRE(Sum.load() == 500500);
+	}
+
+	SECTION("Job slots are not reused while their job is queued")
+	{
+		// More jobs than fit in one thread's pool, all created before any of them are waited on
+		constexpr uint32 NumJobs = static_cast<uint32>(JobSystem::MaxJobsPerThread) * 3;
+		std::vector<std::atomic<uint32>> Runs(NumJobs);
+		JobCounter Counter;
+
+		for (uint32 i = 0; i < NumJobs; ++i)
+		{
+			std::atomic<uint32>* Run = &Runs[i];
+			JobSystem::Get().Run(JobSystem::Get().CreateJob(&Counter, [Run]() { Run->fetch_add(1); }));
+		}
+		JobSystem::Get().Wait(Counter);
+
+		for (const std::atomic<uint32>& Run : Runs)
+		{
+			REQUIRE(Run.load() == 1);
+		}
+	}
+
+	SECTION("Dependencies")
+	{
+		std::atomic<uint32> FirstDone { 0 };
+		std::atomic<bool> SawAllFirst { false };
+		JobCounter First;
+		JobCounter Second;
+
+		for (uint32 i = 0; i < 64; ++i)
+		{
+			JobSystem::Get().Run(JobSystem::Get().CreateJob(&First, [&FirstDone]() { FirstDone.fetch_add(1); }));
+		}
+
+		JobSystem::Get().Run(
+			JobSystem::Get().CreateJob(&Second, [&]() { SawAllFirst.store(FirstDone.load() == 64); }),
+			&First
+		);
+
+		JobSystem::Get().Wait(Second);
+		REQUIRE(SawAllFirst.load());
+	}
+
+	SECTION("Parallel for visits every index once")
+	{
+		std::vector<uint32> Visits(10000, 0);
+		JobSystem::Get().ParallelFor(static_cast<uint32>(Visits.size()), 64, [&](uint32 t_Begin, uint32 t_End)
+		{
+			for (uint32 i = t_Begin; i < t_End; ++i)
+			{
+				++Visits[i];
+			}
+		});
+
+		for (uint32 Count : Visits)
+		{
+			REQUIRE(Count == 1);
+		}
+	}
+
+	SECTION("Parallel for from a thread that isn't a worker")
+	{
+		std::vector<uint32> Visits(10000, 0);
+		std::atomic<bool> bWorkerRanChunk { false };
+		bool bCallerWasWorker = true;
+
+		// Like a resource loading thread, which imports meshes with ParallelFor
+		std::thread Loader([&]()
+		{
+			bCallerWasWorker = JobSystem::Get().IsWorkerThread();
+			JobSystem::Get().ParallelFor(static_cast<uint32>(Visits.size()), 64, [&](uint32 t_Begin, uint32 t_End)
+			{
+				if (JobSystem::Get().IsWorkerThread())
+				{
+					bWorkerRanChunk.store(true);
+				}
+				else
+				{
+					// Hold on to the calling thread so that the workers have to pick up the rest
+					const auto Timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+					while (!bWorkerRanChunk.load() && std::chrono::steady_clock::now() < Timeout)
+					{
+						std::this_thread::yield();
+					}
+				}
+
+				for (uint32 i = t_Begin; i < t_End; ++i)
+				{
+					++Visits[i];
+				}
+			});
+		});
+		Loader.join();
+
+		REQUIRE_FALSE(bCallerWasWorker);
+		REQUIRE(bWorkerRanChunk.load());
+		for (uint32 Count : Visits)
+		{
+			REQUIRE(Count == 1);
+		}
+	}
+
+	SECTION("Parallel for each")
+	{
+		// Anything iterable with a size works, the same as an entt view
+		std::vector<uint32> Entities(500);
+		for (uint32 i = 0; i < Entities.size(); ++i)
+		{
+			Entities[i] = i;
+		}
+
+		std::atomic<uint32> Sum { 0 };
+		JobSystem::Get().ParallelForEach(Entities, 16, [&](uint32 t_Ent) { Sum.fetch_add(t_Ent); });
+		REQUIRE(Sum.load() == (499 * 500) / 2);
+	}
+
+	JobSystem::Get().Shutdown();
+	REQUIRE_FALSE(JobSystem::Get().IsRunning());
+}
@@ -37,6 +37,14 @@ namespace
 		}
 	};
 
+	/** Number of Health components that on_destroy has seen */
+	int g_HealthDestroyed = 0;
+
+	void OnHealthDestroyed(entt::entity, entt::registry&)
+	{
+		++g_HealthDestroyed;
+	}
+
 	void InitLogger()
 	{
 		Fling::Logger::Get().Init();
@@ -248,6 +256,27 @@ TEST_CASE("ComponentTypeRegistry hybrid register and seal", "[json]")
 		REQUIRE(loaded.get<Health>(loadedEntity).Armor == Catch::Approx(3.5f));
 	}
 
+	SECTION("Loading over a component destroys the old one")
+	{
+		REQUIRE(ComponentTypeRegistry::Get().Register<Health>("Health"));
+		ComponentTypeRegistry::Get().Seal();
+
+		// Components like MeshRenderer release what they own in on_destroy, which replace would skip
+		entt::registry reg;
+		reg.on_destroy<Health>().connect<&OnHealthDestroyed>();
+		const entt::entity entity = reg.create();
+		reg.assign<Health>(entity).Amount = 1;
+		g_HealthDestroyed = 0;
+
+		Json in = Json::Object();
+		in.Set("Amount", 7);
+		const ComponentTypeInfo* info = ComponentTypeRegistry::Get().Find("Health");
+		info->load(reg, entity, in);
+
+		REQUIRE(g_HealthDestroyed == 1);
+		REQUIRE(reg.get<Health>(entity).Amount == 7);
+	}
+
 	SECTION("Register after Seal is rejected")
 	{
 		REQUIRE(ComponentTypeRegistry::Get().Register<Health>("Health"));
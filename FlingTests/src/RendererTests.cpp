@@ -3,6 +3,37 @@
 #include <catch2/catch_all.hpp>
 
 #include "pch.h"
+#include "RenderWorld.h"
+#include "MeshRenderer.h"
+#include "Components/Transform.h"
+#include "Lighting/PointLight.hpp"
+#include "Lighting/DirectionalLight.hpp"
+#include "CookedMesh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "LodSelection.h"
+#include "Meshlets.h"
+#include "VertexPacking.h"
+#include "ObjImporter.h"
+#include "VirtualFileSystem.h"
+#include "JobSystem.h"
+#include "Misc/CommandLine.h"
+
+#include <entt/entity/helper.hpp>
+
+// Only used as a baseline for the OBJ importer now, so its implementation lives here
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <tuple>
+#include <thread>
 
 TEST_CASE("Renderer", "[Renderer]")
 {
@@ -10,4 +41,1267 @@ TEST_CASE("Renderer", "[Renderer]")
     {
         REQUIRE(true);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Render World", "[Renderer]")
+{
+    using namespace Fling;
+
+    entt::registry SimReg;
+
+    // Mesh renderers without a model have nothing to draw
+    entt::entity Mesh = SimReg.create();
+    SimReg.assign<Transform>(Mesh).SetPos(glm::vec3(1.0f, 2.0f, 3.0f));
+    SimReg.assign<MeshRenderer>(Mesh);
+    SimReg.assign<entt::tag<"Default"_hs>>(Mesh);
+
+    entt::entity Light = SimReg.create();
+    SimReg.assign<Transform>(Light).SetPos(glm::vec3(4.0f, 5.0f, 6.0f));
+    SimReg.assign<PointLight>(Light).Intensity = 3.0f;
+
+    // Directional lights don't need a transform
+    SimReg.assign<DirectionalLight>(SimReg.create());
+
+    // Not something the renderer uses
+    SimReg.create();
+
+    RenderFrameInfo Info = {};
+    Info.InterpolationAlpha = 0.25f;
+    Info.DeltaTime = 0.5f;
+
+    RenderWorld World(1);
+
+    SECTION("Default world")
+    {
+        REQUIRE(World.GetIndex() == 1);
+        REQUIRE(World.GetInfo().InterpolationAlpha == Catch::Approx(1.0f));
+        REQUIRE(World.GetDraws(MeshDrawList::Default).Empty());
+        REQUIRE(World.GetDraws(MeshDrawList::Debug).Empty());
+        REQUIRE(World.GetPointLights().empty());
+    }
+
+    SECTION("Extract")
+    {
+        World.Extract(SimReg, Info);
+
+        REQUIRE(World.GetDraws(MeshDrawList::Default).Empty());
+        REQUIRE(World.GetDraws(MeshDrawList::Debug).Empty());
+        REQUIRE(World.GetMeshes().empty());
+
+        REQUIRE(World.GetPointLights().size() == 1);
+        const PointLight& Extracted = World.GetPointLights()[0];
+        REQUIRE(Extracted.Intensity == Catch::Approx(3.0f));
+        REQUIRE(Extracted.GetPos().x == Catch::Approx(4.0f));
+        REQUIRE(Extracted.GetPos().y == Catch::Approx(5.0f));
+        REQUIRE(Extracted.GetPos().z == Catch::Approx(6.0f));
+
+        REQUIRE(World.GetDirectionalLights().size() == 1);
+
+        REQUIRE(World.GetInfo().InterpolationAlpha == Catch::Approx(0.25f));
+        REQUIRE(World.GetInfo().DeltaTime == Catch::Approx(0.5f));
+    }
+
+    SECTION("Extracting again replaces the last frame")
+    {
+        World.Extract(SimReg, Info);
+
+        SimReg.destroy(Light);
+        Info.InterpolationAlpha = 0.75f;
+        World.Extract(SimReg, Info);
+
+        REQUIRE(World.GetPointLights().empty());
+        REQUIRE(World.GetDirectionalLights().size() == 1);
+        REQUIRE(World.GetInfo().InterpolationAlpha == Catch::Approx(0.75f));
+
+        // The game registry is left alone
+        REQUIRE(SimReg.view<Transform>().size() == 1);
+    }
+}
+
+TEST_CASE("Draw Sorting", "[Renderer]")
+{
+    using namespace Fling;
+
+    SECTION("Sort keys go pipeline, material, mesh, then depth")
+    {
+        const uint64 Base = DrawSorting::MakeSortKey(MeshDrawList::Default, 1, 1, 10.0f);
+        REQUIRE(Base < DrawSorting::MakeSortKey(MeshDrawList::Debug, 0, 0, 0.0f));
+        REQUIRE(Base < DrawSorting::MakeSortKey(MeshDrawList::Default, 2, 0, 0.0f));
+        REQUIRE(Base < DrawSorting::MakeSortKey(MeshDrawList::Default, 1, 2, 0.0f));
+        REQUIRE(Base < DrawSorting::MakeSortKey(MeshDrawList::Default, 1, 1, 11.0f));
+        REQUIRE(Base > DrawSorting::MakeSortKey(MeshDrawList::Default, 1, 1, 9.0f));
+
+        // Depth keeps its order over a wide range, and things behind the camera come first
+        REQUIRE(DrawSorting::MakeSortKey(MeshDrawList::Default, 0, 0, 0.01f) < DrawSorting::MakeSortKey(MeshDrawList::Default, 0, 0, 0.02f));
+        REQUIRE(DrawSorting::MakeSortKey(MeshDrawList::Default, 0, 0, 5000.0f) < DrawSorting::MakeSortKey(MeshDrawList::Default, 0, 0, 5001.0f));
+        REQUIRE(DrawSorting::MakeSortKey(MeshDrawList::Default, 0, 0, -3.0f) == DrawSorting::MakeSortKey(MeshDrawList::Default, 0, 0, 0.0f));
+        REQUIRE(DrawSorting::MakeSortKey(MeshDrawList::Default, 0, 0, -3.0f) < DrawSorting::MakeSortKey(MeshDrawList::Default, 0, 0, 0.01f));
+    }
+
+    SECTION("Packed arrays line up")
+    {
+        // Each draw is { list, material, mesh, z }. The camera is at the origin looking down -Z
+        struct TestDraw { MeshDrawList List; uint32 Material; uint32 Mesh; float Z; };
+        const std::vector<TestDraw> TestDraws = {
+            { MeshDrawList::Default, 1, 0, -2.0f },
+            { MeshDrawList::Debug, 0, 0, -1.0f },
+            { MeshDrawList::Default, 0, 1, -1.0f },
+            { MeshDrawList::Default, 0, 0, -9.0f },
+            { MeshDrawList::Default, 0, 0, -3.0f },
+            { MeshDrawList::Default, 0, 0, 4.0f },
+        };
+
+        std::vector<Transform> Transforms(TestDraws.size());
+        std::vector<DrawInput> Inputs(TestDraws.size());
+        for (size_t i = 0; i < TestDraws.size(); ++i)
+        {
+            Transforms[i].SetPos(glm::vec3(static_cast<float>(i), 0.0f, TestDraws[i].Z));
+            Transforms[i].SetScale(glm::vec3(2.0f));
+
+            DrawInput& Input = Inputs[i];
+            Input.Trans = &Transforms[i];
+            Input.BoundsCenter = glm::vec3(0.0f, 1.0f, 0.0f);
+            Input.BoundsRadius = 0.5f;
+            Input.List = TestDraws[i].List;
+            Input.MaterialId = TestDraws[i].Material;
+            Input.MeshId = TestDraws[i].Mesh;
+            Input.Entity = static_cast<entt::entity>(i);
+
+            // Never dereferenced, they only have to be told apart
+            Input.UniformBuffer = reinterpret_cast<Buffer*>(static_cast<uintptr_t>(0x1000 + i * 16));
+            Input.DescriptorSet = (VkDescriptorSet)(static_cast<uintptr_t>(0x2000 + i * 16));
+        }
+
+        MeshDraws Lists[static_cast<size_t>(MeshDrawList::Count)];
+        DrawSorting::PackDraws(Inputs.data(), Inputs.size(), glm::mat4(1.0f), 1.0f, Lists);
+
+        const auto GetOrder = [](const MeshDraws& t_Draws)
+        {
+            std::vector<size_t> Order;
+            for (entt::entity Ent : t_Draws.Entities)
+            {
+                Order.push_back(static_cast<size_t>(Ent));
+            }
+            return Order;
+        };
+
+        // Behind the camera, then front to back, then the other mesh, then the other material
+        REQUIRE(GetOrder(Lists[static_cast<size_t>(MeshDrawList::Default)]) == std::vector<size_t>{ 5, 4, 3, 2, 0 });
+        REQUIRE(GetOrder(Lists[static_cast<size_t>(MeshDrawList::Debug)]) == std::vector<size_t>{ 1 });
+
+        for (const MeshDraws& Draws : Lists)
+        {
+            REQUIRE(Draws.WorldMatrices.size() == Draws.Size());
+            REQUIRE(Draws.Bounds.size() == Draws.Size());
+            REQUIRE(Draws.MaterialIds.size() == Draws.Size());
+            REQUIRE(Draws.Entities.size() == Draws.Size());
+            REQUIRE(Draws.UniformBuffers.size() == Draws.Size());
+            REQUIRE(Draws.DescriptorSets.size() == Draws.Size());
+
+            for (size_t i = 0; i < Draws.Size(); ++i)
+            {
+                const size_t Source = static_cast<size_t>(Draws.Entities[i]);
+                const glm::vec3 Pos = Transforms[Source].GetPos();
+                REQUIRE(Draws.MeshIds[i] == Inputs[Source].MeshId);
+                REQUIRE(Draws.MaterialIds[i] == Inputs[Source].MaterialId);
+                REQUIRE(Draws.UniformBuffers[i] == Inputs[Source].UniformBuffer);
+                REQUIRE(Draws.DescriptorSets[i] == Inputs[Source].DescriptorSet);
+                REQUIRE(Draws.WorldMatrices[i][3].x == Catch::Approx(Pos.x));
+                REQUIRE(Draws.WorldMatrices[i][3].z == Catch::Approx(Pos.z));
+
+                // The bounds are moved and scaled with the transform
+                REQUIRE(Draws.Bounds[i].x == Catch::Approx(Pos.x));
+                REQUIRE(Draws.Bounds[i].y == Catch::Approx(2.0f));
+                REQUIRE(Draws.Bounds[i].z == Catch::Approx(Pos.z));
+                REQUIRE(Draws.Bounds[i].w == Catch::Approx(1.0f));
+            }
+        }
+    }
+
+    SECTION("Lots of draws split across the job system")
+    {
+        REQUIRE(CommandLine::Get().LoadConfigVarsFromString("[ConsoleVariables]\nJobWorkerCount=3\n"));
+        JobSystem::Get().Init();
+
+        std::mt19937 Rng(7);
+        const size_t NumDraws = 5000;
+        std::vector<Transform> Transforms(NumDraws);
+        std::vector<DrawInput> Inputs(NumDraws);
+        for (size_t i = 0; i < NumDraws; ++i)
+        {
+            Transforms[i].SetPos(glm::vec3(0.0f, 0.0f, -static_cast<float>(Rng() % 1000)));
+            Inputs[i].Trans = &Transforms[i];
+            Inputs[i].List = (Rng() % 4 == 0) ? MeshDrawList::Debug : MeshDrawList::Default;
+            Inputs[i].MaterialId = Rng() % 8;
+            Inputs[i].MeshId = Rng() % 32;
+            Inputs[i].Entity = static_cast<entt::entity>(i);
+        }
+
+        MeshDraws Lists[static_cast<size_t>(MeshDrawList::Count)];
+        DrawSorting::PackDraws(Inputs.data(), Inputs.size(), glm::mat4(1.0f), 1.0f, Lists);
+        JobSystem::Get().Shutdown();
+
+        size_t Total = 0;
+        for (size_t ListIndex = 0; ListIndex < static_cast<size_t>(MeshDrawList::Count); ++ListIndex)
+        {
+            const MeshDraws& Draws = Lists[ListIndex];
+            Total += Draws.Size();
+            uint64 LastKey = 0;
+            for (size_t i = 0; i < Draws.Size(); ++i)
+            {
+                const DrawInput& Input = Inputs[static_cast<size_t>(Draws.Entities[i])];
+                REQUIRE(static_cast<size_t>(Input.List) == ListIndex);
+                REQUIRE(Draws.MeshIds[i] == Input.MeshId);
+                REQUIRE(Draws.WorldMatrices[i][3].z == Catch::Approx(Input.Trans->GetPos().z));
+
+                const uint64 Key = DrawSorting::MakeSortKey(Input.List, Input.MaterialId, Input.MeshId, -Draws.Bounds[i].z);
+                REQUIRE(Key >= LastKey);
+                LastKey = Key;
+            }
+        }
+        REQUIRE(Total == NumDraws);
+    }
+}
+
+TEST_CASE("Cooked Mesh", "[Renderer]")
+{
+    using namespace Fling;
+
+    std::vector<Vertex> Verts(4);
+    for (size_t i = 0; i < Verts.size(); ++i)
+    {
+        Verts[i].Pos = glm::vec3(static_cast<float>(i), 1.0f, 2.0f);
+        Verts[i].Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+        Verts[i].Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+        Verts[i].TexCoord = glm::vec2(0.5f, static_cast<float>(i));
+    }
+    const std::vector<uint32> Indices = { 0, 1, 2, 2, 3, 0, 0, 1, 2 };
+    const std::vector<MeshLod> Lods = { { 0, 6, 0.0f }, { 6, 3, 0.25f } };
+    std::vector<Meshlet> MeshletTable(2);
+    MeshletTable[0].IndexCount = 3;
+    MeshletTable[0].Radius = 1.0f;
+    MeshletTable[1].FirstIndex = 3;
+    MeshletTable[1].IndexCount = 3;
+    MeshletTable[1].ConeCutoff = 0.5f;
+
+    const std::vector<char> Cooked = CookedMesh::Cook(
+        Verts.data(), static_cast<uint32>(Verts.size()),
+        Indices.data(), static_cast<uint32>(Indices.size()),
+        Lods.data(), static_cast<uint32>(Lods.size()),
+        MeshletTable.data(), static_cast<uint32>(MeshletTable.size()),
+        glm::vec3(1.5f, 1.0f, 2.0f), 1.5f,
+        /* Source hash */ 1234, /* Source size */ 99, /* Settings hash */ 5678, /* Source modified time */ 42);
+
+    // Read it back through the file system, the same as Model does
+    VirtualFileSystem Vfs;
+    const VirtualFileSystem::MountId Mount = Vfs.MountMemory(0);
+    const auto LoadCooked = [&](const std::vector<char>& t_File, CookedMesh& t_Out)
+    {
+        Vfs.WriteMemoryFile(Mount, "Models/Test.flmesh", t_File.data(), t_File.size());
+        AssetData Data;
+        REQUIRE(Vfs.Read("Models/Test.flmesh", Data));
+        return t_Out.Load(std::move(Data));
+    };
+
+    SECTION("Cooked path")
+    {
+        REQUIRE(CookedMesh::GetCookedPath("Models/cube.obj") == "Models/cube.flmesh");
+        REQUIRE(CookedMesh::GetCookedPath("Models/cube") == "Models/cube.flmesh");
+        REQUIRE(CookedMesh::GetCookedPath("Models.v2/cube") == "Models.v2/cube.flmesh");
+    }
+
+    SECTION("Round trip")
+    {
+        CookedMesh Mesh;
+        REQUIRE(LoadCooked(Cooked, Mesh));
+        REQUIRE(Mesh.GetVertexCount() == 4);
+        REQUIRE(Mesh.GetIndexCount() == 9);
+        REQUIRE(Mesh.GetLodCount() == 2);
+        REQUIRE(Mesh.GetLods()[1].FirstIndex == 6);
+        REQUIRE(Mesh.GetLods()[1].IndexCount == 3);
+        REQUIRE(Mesh.GetLods()[1].Error == 0.25f);
+        REQUIRE(Mesh.GetMeshletCount() == 2);
+        REQUIRE(Mesh.GetMeshlets()[1].FirstIndex == 3);
+        REQUIRE(Mesh.GetMeshlets()[1].ConeCutoff == 0.5f);
+        REQUIRE(reinterpret_cast<uintptr_t>(Mesh.GetVerts()) % CookedMesh::DataAlignment == 0);
+        REQUIRE(std::memcmp(Mesh.GetVerts(), Verts.data(), sizeof(Vertex) * Verts.size()) == 0);
+        REQUIRE(std::equal(Indices.begin(), Indices.end(), Mesh.GetIndices()));
+        REQUIRE(Mesh.GetBoundsCenter().x == Catch::Approx(1.5f));
+        REQUIRE(Mesh.GetBoundsRadius() == Catch::Approx(1.5f));
+
+        REQUIRE(Mesh.IsCookedFrom(1234, 99));
+        REQUIRE_FALSE(Mesh.IsCookedFrom(1234, 100));
+        REQUIRE_FALSE(Mesh.IsCookedFrom(4321, 99));
+        REQUIRE(Mesh.IsCookedWith(5678));
+        REQUIRE_FALSE(Mesh.IsCookedWith(8765));
+        REQUIRE(Mesh.IsCookedFromTime(99, 42));
+        REQUIRE_FALSE(Mesh.IsCookedFromTime(99, 43));
+        REQUIRE_FALSE(Mesh.IsCookedFromTime(100, 42));
+
+        Mesh.Reset();
+        REQUIRE_FALSE(Mesh.IsLoaded());
+        REQUIRE(Mesh.GetVertexCount() == 0);
+    }
+
+    SECTION("Cooking is deterministic")
+    {
+        const std::vector<char> Again = CookedMesh::Cook(
+            Verts.data(), static_cast<uint32>(Verts.size()),
+            Indices.data(), static_cast<uint32>(Indices.size()),
+            Lods.data(), static_cast<uint32>(Lods.size()),
+            MeshletTable.data(), static_cast<uint32>(MeshletTable.size()),
+            glm::vec3(1.5f, 1.0f, 2.0f), 1.5f, 1234, 99, 5678, 42);
+        REQUIRE(Again == Cooked);
+    }
+
+    SECTION("Bad files are rejected")
+    {
+        CookedMesh Mesh;
+
+        std::vector<char> OldVersion = Cooked;
+        reinterpret_cast<CookedMeshHeader*>(OldVersion.data())->Version = CookedMesh::Version + 1;
+        REQUIRE_FALSE(LoadCooked(OldVersion, Mesh));
+
+        std::vector<char> Corrupt = Cooked;
+        Corrupt.back() ^= 0x7F;
+        REQUIRE_FALSE(LoadCooked(Corrupt, Mesh));
+
+        // A LOD that runs off the end of the index buffer
+        std::vector<MeshLod> BadLods = Lods;
+        BadLods[1].IndexCount = 6;
+        const std::vector<char> BadLodTable = CookedMesh::Cook(
+            Verts.data(), static_cast<uint32>(Verts.size()),
+            Indices.data(), static_cast<uint32>(Indices.size()),
+            BadLods.data(), static_cast<uint32>(BadLods.size()),
+            MeshletTable.data(), static_cast<uint32>(MeshletTable.size()),
+            glm::vec3(1.5f, 1.0f, 2.0f), 1.5f, 1234, 99, 5678, 42);
+        REQUIRE_FALSE(LoadCooked(BadLodTable, Mesh));
+
+        // And a meshlet that does
+        std::vector<Meshlet> BadMeshlets = MeshletTable;
+        BadMeshlets[1].FirstIndex = 8;
+        const std::vector<char> BadMeshletTable = CookedMesh::Cook(
+            Verts.data(), static_cast<uint32>(Verts.size()),
+            Indices.data(), static_cast<uint32>(Indices.size()),
+            Lods.data(), static_cast<uint32>(Lods.size()),
+            BadMeshlets.data(), static_cast<uint32>(BadMeshlets.size()),
+            glm::vec3(1.5f, 1.0f, 2.0f), 1.5f, 1234, 99, 5678, 42);
+        REQUIRE_FALSE(LoadCooked(BadMeshletTable, Mesh));
+
+        std::vector<char> Truncated(Cooked.begin(), Cooked.end() - 4);
+        REQUIRE_FALSE(LoadCooked(Truncated, Mesh));
+
+        REQUIRE_FALSE(LoadCooked(std::vector<char>(16, 0), Mesh));
+        REQUIRE_FALSE(Mesh.IsLoaded());
+    }
+
+    SECTION("Written to disk")
+    {
+        const std::string Path = "CookedMeshTest.flmesh";
+        REQUIRE(CookedMesh::Write(Path, Cooked));
+
+        std::ifstream File(Path, std::ios::binary);
+        const std::vector<char> OnDisk((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+        File.close();
+        REQUIRE(OnDisk == Cooked);
+        REQUIRE_FALSE(std::filesystem::exists(Path + ".tmp"));
+
+        std::filesystem::remove(Path);
+    }
+}
+
+TEST_CASE("Mesh Optimizer", "[Renderer]")
+{
+    using namespace Fling;
+
+    // A grid of quads where every triangle has its own copy of its vertices, like an OBJ import
+    constexpr uint32 GridSize = 16;
+    std::vector<Vertex> Verts;
+    std::vector<uint32> Indices;
+    const auto AddVert = [&](uint32 t_X, uint32 t_Y)
+    {
+        Vertex Vert;
+        Vert.Pos = glm::vec3(static_cast<float>(t_X), static_cast<float>(t_Y), 0.0f);
+        Vert.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+        Vert.TexCoord = glm::vec2(static_cast<float>(t_X) / GridSize, static_cast<float>(t_Y) / GridSize);
+        Indices.push_back(static_cast<uint32>(Verts.size()));
+        Verts.push_back(Vert);
+    };
+    for (uint32 y = 0; y < GridSize; ++y)
+    {
+        for (uint32 x = 0; x < GridSize; ++x)
+        {
+            AddVert(x, y); AddVert(x + 1, y); AddVert(x + 1, y + 1);
+            AddVert(x, y); AddVert(x + 1, y + 1); AddVert(x, y + 1);
+        }
+    }
+
+    // Every triangle as its corner positions, starting from its smallest corner so winding is kept
+    const auto GetTriangles = [](const std::vector<Vertex>& t_Verts, const std::vector<uint32>& t_Indices)
+    {
+        std::vector<std::array<float, 9>> Tris;
+        for (size_t i = 0; i + 2 < t_Indices.size(); i += 3)
+        {
+            std::array<glm::vec3, 3> Corners = { t_Verts[t_Indices[i]].Pos, t_Verts[t_Indices[i + 1]].Pos, t_Verts[t_Indices[i + 2]].Pos };
+            const auto Less = [](const glm::vec3& a, const glm::vec3& b) { return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z); };
+            std::rotate(Corners.begin(), std::min_element(Corners.begin(), Corners.end(), Less), Corners.end());
+            Tris.push_back({ Corners[0].x, Corners[0].y, Corners[0].z, Corners[1].x, Corners[1].y, Corners[1].z, Corners[2].x, Corners[2].y, Corners[2].z });
+        }
+        std::sort(Tris.begin(), Tris.end());
+        return Tris;
+    };
+    const auto Original = GetTriangles(Verts, Indices);
+
+    SECTION("No reuse before welding")
+    {
+        const MeshOptimizer::VertexCacheStats Stats = MeshOptimizer::AnalyzeVertexCache(Indices.data(), Indices.size(), static_cast<uint32>(Verts.size()));
+        REQUIRE(Stats.ACMR == Catch::Approx(3.0f));
+        REQUIRE(Stats.ATVR == Catch::Approx(1.0f));
+    }
+
+    SECTION("Welding")
+    {
+        REQUIRE(MeshOptimizer::WeldVertices(Verts, Indices) == (GridSize + 1) * (GridSize + 1));
+        REQUIRE(Indices.size() == GridSize * GridSize * 6);
+        REQUIRE(GetTriangles(Verts, Indices) == Original);
+
+        // Different normals are different vertices
+        std::vector<Vertex> Seam(2, Verts[0]);
+        Seam[1].Normal = glm::vec3(1.0f, 0.0f, 0.0f);
+        std::vector<uint32> SeamIndices = { 0, 1, 0 };
+        REQUIRE(MeshOptimizer::WeldVertices(Seam, SeamIndices) == 2);
+    }
+
+    SECTION("Vertex cache and fetch")
+    {
+        MeshOptimizer::WeldVertices(Verts, Indices);
+
+        // Shuffle the triangles so the cache has something to fix
+        std::vector<std::array<uint32, 3>> Tris;
+        for (size_t i = 0; i < Indices.size(); i += 3)
+        {
+            Tris.push_back({ Indices[i], Indices[i + 1], Indices[i + 2] });
+        }
+        std::shuffle(Tris.begin(), Tris.end(), std::mt19937(1234));
+        for (size_t i = 0; i < Tris.size(); ++i)
+        {
+            std::copy(Tris[i].begin(), Tris[i].end(), Indices.begin() + i * 3);
+        }
+
+        const uint32 NumVerts = static_cast<uint32>(Verts.size());
+        const float Before = MeshOptimizer::AnalyzeVertexCache(Indices.data(), Indices.size(), NumVerts).ACMR;
+        MeshOptimizer::OptimizeVertexCache(Indices.data(), Indices.size(), NumVerts);
+        const float After = MeshOptimizer::AnalyzeVertexCache(Indices.data(), Indices.size(), NumVerts).ACMR;
+
+        REQUIRE(After < Before);
+        REQUIRE(After < 1.0f);
+        REQUIRE(GetTriangles(Verts, Indices) == Original);
+
+        REQUIRE(MeshOptimizer::OptimizeVertexFetch(Verts, Indices) == NumVerts);
+        REQUIRE(GetTriangles(Verts, Indices) == Original);
+
+        // Vertices are in the order they are first used
+        uint32 NextNew = 0;
+        for (uint32 Index : Indices)
+        {
+            REQUIRE(Index <= NextNew);
+            NextNew = std::max(NextNew, Index + 1);
+        }
+
+        // Fetch order doesn't change which vertices are in the cache
+        REQUIRE(MeshOptimizer::AnalyzeVertexCache(Indices.data(), Indices.size(), NumVerts).ACMR == Catch::Approx(After));
+    }
+
+    SECTION("Unused vertices are dropped")
+    {
+        std::vector<uint32> Tri = { 2, 0, 4 };
+        REQUIRE(MeshOptimizer::OptimizeVertexFetch(Verts, Tri) == 3);
+        REQUIRE(Tri == std::vector<uint32>{ 0, 1, 2 });
+    }
+}
+
+TEST_CASE("Mesh Simplifier", "[Renderer]")
+{
+    using namespace Fling;
+
+    // A welded grid of quads, split down the middle into two texture islands so there is a seam
+    constexpr uint32 GridSize = 16;
+    constexpr uint32 SeamX = GridSize / 2;
+    std::vector<Vertex> Verts;
+    std::vector<uint32> Indices;
+    const auto MakeGrid = [&](float t_Bumpiness)
+    {
+        Verts.clear();
+        Indices.clear();
+        std::vector<uint32> Left((GridSize + 1) * (GridSize + 1));
+        std::vector<uint32> Right((GridSize + 1) * (GridSize + 1));
+        for (uint32 y = 0; y <= GridSize; ++y)
+        {
+            for (uint32 x = 0; x <= GridSize; ++x)
+            {
+                Vertex Vert;
+                Vert.Pos = glm::vec3(static_cast<float>(x), static_cast<float>(y), t_Bumpiness * std::sin(x * 0.9f) * std::cos(y * 0.7f));
+                Vert.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                Vert.TexCoord = glm::vec2(static_cast<float>(x) / GridSize, static_cast<float>(y) / GridSize);
+                Left[y * (GridSize + 1) + x] = Right[y * (GridSize + 1) + x] = static_cast<uint32>(Verts.size());
+                Verts.push_back(Vert);
+                if (x == SeamX)
+                {
+                    Vert.TexCoord.x += 1.0f;
+                    Right[y * (GridSize + 1) + x] = static_cast<uint32>(Verts.size());
+                    Verts.push_back(Vert);
+                }
+            }
+        }
+        for (uint32 y = 0; y < GridSize; ++y)
+        {
+            for (uint32 x = 0; x < GridSize; ++x)
+            {
+                const std::vector<uint32>& Ids = x < SeamX ? Left : Right;
+                const uint32 A = Ids[y * (GridSize + 1) + x];
+                const uint32 B = Ids[y * (GridSize + 1) + x + 1];
+                const uint32 C = Ids[(y + 1) * (GridSize + 1) + x + 1];
+                const uint32 D = Ids[(y + 1) * (GridSize + 1) + x];
+                Indices.insert(Indices.end(), { A, B, C, A, C, D });
+            }
+        }
+    };
+
+    const auto GetArea = [&](const uint32* t_Indices, size_t t_Count)
+    {
+        float Area = 0.0f;
+        for (size_t i = 0; i + 2 < t_Count; i += 3)
+        {
+            const glm::vec3& P0 = Verts[t_Indices[i]].Pos;
+            Area += glm::length(glm::cross(Verts[t_Indices[i + 1]].Pos - P0, Verts[t_Indices[i + 2]].Pos - P0)) * 0.5f;
+        }
+        return Area;
+    };
+
+    SECTION("Flat grids keep their outline and seam")
+    {
+        MakeGrid(0.0f);
+        std::vector<uint32> Simplified;
+        const float Error = MeshSimplifier::Simplify(Verts, Indices.data(), Indices.size(), Indices.size() / 8, Simplified);
+
+        // Texture coordinates change evenly across the grid, so taking out vertices doesn't cost anything
+        REQUIRE(Simplified.size() <= Indices.size() / 8);
+        REQUIRE(Error == Catch::Approx(0.0f).margin(1e-3f));
+
+        // Nothing moved off the plane or in from the edges
+        REQUIRE(GetArea(Simplified.data(), Simplified.size()) == Catch::Approx(static_cast<float>(GridSize * GridSize)));
+
+        // Every vertex on the seam is still there, and the texture islands didn't get mixed up
+        for (uint32 v = 0; v < Verts.size(); ++v)
+        {
+            if (Verts[v].Pos.x == static_cast<float>(SeamX))
+            {
+                REQUIRE(std::find(Simplified.begin(), Simplified.end(), v) != Simplified.end());
+            }
+        }
+        for (size_t i = 0; i < Simplified.size(); i += 3)
+        {
+            const bool bRight = Verts[Simplified[i]].TexCoord.x > 0.5f || Verts[Simplified[i + 1]].TexCoord.x > 0.5f || Verts[Simplified[i + 2]].TexCoord.x > 0.5f;
+            const bool bLeft = Verts[Simplified[i]].TexCoord.x < 0.5f || Verts[Simplified[i + 1]].TexCoord.x < 0.5f || Verts[Simplified[i + 2]].TexCoord.x < 0.5f;
+            REQUIRE_FALSE((bLeft && bRight));
+        }
+    }
+
+    SECTION("The error is how far the surface moved")
+    {
+        // Colors that don't change evenly make collapses cost more, but the grid is still flat
+        MakeGrid(0.0f);
+        for (Vertex& Vert : Verts)
+        {
+            const uint32 X = static_cast<uint32>(Vert.Pos.x);
+            const uint32 Y = static_cast<uint32>(Vert.Pos.y);
+            Vert.Color = glm::vec3(static_cast<float>((X * 7 + Y * 3) % 5) / 4.0f, static_cast<float>((X * Y) % 3) / 2.0f, 0.0f);
+        }
+
+        std::vector<uint32> Simplified;
+        float Error = MeshSimplifier::Simplify(Verts, Indices.data(), Indices.size(), Indices.size() / 8, Simplified);
+        REQUIRE(Simplified.size() <= Indices.size() / 8);
+        REQUIRE(Error == Catch::Approx(0.0f).margin(1e-4f));
+
+        // Lifting one vertex off the plane, flattening it back out can't be further off than it was lifted
+        constexpr float Height = 0.5f;
+        for (Vertex& Vert : Verts)
+        {
+            if (Vert.Pos.x == 4.0f && Vert.Pos.y == 8.0f)
+            {
+                Vert.Pos.z = Height;
+            }
+        }
+        Error = MeshSimplifier::Simplify(Verts, Indices.data(), Indices.size(), Indices.size() / 8, Simplified);
+        REQUIRE(Error > 0.0f);
+        REQUIRE(Error <= Height);
+    }
+
+    SECTION("LOD chain")
+    {
+        MakeGrid(1.5f);
+        const size_t FullDetailCount = Indices.size();
+        std::vector<MeshLod> Lods;
+        MeshSimplifier::BuildLodChain(Verts, Indices, Lods, 4, 0.5f);
+
+        REQUIRE(Lods.size() == 4);
+        REQUIRE(Lods[0].FirstIndex == 0);
+        REQUIRE(Lods[0].IndexCount == FullDetailCount);
+        REQUIRE(Lods[0].Error == 0.0f);
+        for (size_t i = 1; i < Lods.size(); ++i)
+        {
+            // Back to back, about half the size of the last one, and worse
+            REQUIRE(Lods[i].FirstIndex == Lods[i - 1].FirstIndex + Lods[i - 1].IndexCount);
+            REQUIRE(Lods[i].IndexCount % 3 == 0);
+            REQUIRE(Lods[i].IndexCount <= Lods[i - 1].IndexCount / 2 + 3);
+            REQUIRE(Lods[i].Error > 0.0f);
+            REQUIRE(Lods[i].Error >= Lods[i - 1].Error);
+        }
+        REQUIRE(Lods.back().FirstIndex + Lods.back().IndexCount == Indices.size());
+        REQUIRE(std::all_of(Indices.begin(), Indices.end(), [&](uint32 t_Index) { return t_Index < Verts.size(); }));
+
+        // Still covers about the same area
+        const float FullArea = GetArea(Indices.data(), FullDetailCount);
+        REQUIRE(GetArea(Indices.data() + Lods.back().FirstIndex, Lods.back().IndexCount) == Catch::Approx(FullArea).epsilon(0.2f));
+    }
+
+    SECTION("Small meshes only have one LOD")
+    {
+        std::vector<Vertex> Tri(3);
+        Tri[1].Pos.x = 1.0f;
+        Tri[2].Pos.y = 1.0f;
+        std::vector<uint32> TriIndices = { 0, 1, 2 };
+        std::vector<MeshLod> Lods;
+        MeshSimplifier::BuildLodChain(Tri, TriIndices, Lods);
+        REQUIRE(Lods.size() == 1);
+        REQUIRE(TriIndices.size() == 3);
+    }
+}
+
+TEST_CASE("LOD Selection", "[Renderer]")
+{
+    using namespace Fling;
+
+    const MeshLod Lods[] = { { 0, 3000, 0.0f }, { 3000, 1500, 0.01f }, { 4500, 750, 0.04f }, { 5250, 375, 0.16f } };
+    constexpr uint32 LodCount = 4;
+    constexpr float Threshold = 1.0f;
+
+    // 90 degree field of view on a 1000 pixel tall screen
+    const float ProjectionScale = LodSelection::GetProjectionScale(glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 1000.0f), 1000.0f);
+    REQUIRE(ProjectionScale == Catch::Approx(500.0f));
+
+    const glm::vec4 Bounds(0.0f, 0.0f, -10.0f, 1.0f);
+    const auto ErrorScaleAt = [&](float t_Distance)
+    {
+        // Distance from the camera to the closest point of the bounds
+        return LodSelection::GetErrorScale(Bounds, 1.0f, glm::vec3(0.0f, 0.0f, -10.0f + t_Distance + 1.0f), ProjectionScale);
+    };
+
+    SECTION("Error scale")
+    {
+        REQUIRE(ErrorScaleAt(10.0f) == Catch::Approx(50.0f));
+
+        // Twice as big in the world is twice the error
+        const float Scaled = LodSelection::GetErrorScale(glm::vec4(0.0f, 0.0f, -10.0f, 2.0f), 1.0f, glm::vec3(0.0f, 0.0f, 2.0f), ProjectionScale);
+        REQUIRE(Scaled == Catch::Approx(100.0f));
+
+        // Inside the bounds is as close as it gets
+        REQUIRE(std::isfinite(LodSelection::GetErrorScale(Bounds, 1.0f, glm::vec3(Bounds), ProjectionScale)));
+    }
+
+    SECTION("Further away is coarser")
+    {
+        uint32 Last = 0;
+        for (float Distance = 1.0f; Distance < 1000.0f; Distance *= 1.5f)
+        {
+            const uint32 Lod = LodSelection::SelectLod(Lods, LodCount, ErrorScaleAt(Distance), Threshold, 0, 0.0f);
+            REQUIRE(Lod >= Last);
+            REQUIRE((Lod == 0 || Lods[Lod].Error * ErrorScaleAt(Distance) <= Threshold));
+            Last = Lod;
+        }
+        REQUIRE(Last == LodCount - 1);
+        REQUIRE(LodSelection::SelectLod(Lods, LodCount, ErrorScaleAt(1.0f), Threshold, 0, 0.0f) == 0);
+    }
+
+    SECTION("Hysteresis")
+    {
+        // LOD 1 is exactly at the threshold 5 units away
+        const float AtThreshold = Threshold / Lods[1].Error;
+        REQUIRE(LodSelection::SelectLod(Lods, LodCount, AtThreshold, Threshold, 0, 0.0f) == 1);
+
+        // Wobbling around the threshold doesn't switch back and forth
+        for (uint32 Current : { 0u, 1u })
+        {
+            REQUIRE(LodSelection::SelectLod(Lods, LodCount, AtThreshold * 0.9f, Threshold, Current) == Current);
+            REQUIRE(LodSelection::SelectLod(Lods, LodCount, AtThreshold * 1.1f, Threshold, Current) == Current);
+        }
+
+        // Going well past it does
+        REQUIRE(LodSelection::SelectLod(Lods, LodCount, AtThreshold * 0.5f, Threshold, 0) == 1);
+        REQUIRE(LodSelection::SelectLod(Lods, LodCount, AtThreshold * 1.5f, Threshold, 1) == 0);
+
+        // Jumps straight to the right LOD instead of one step at a time
+        REQUIRE(LodSelection::SelectLod(Lods, LodCount, 1.0f, Threshold, 0) == 3);
+        REQUIRE(LodSelection::SelectLod(Lods, LodCount, 1000.0f, Threshold, 3) == 0);
+    }
+
+    SECTION("Odd input")
+    {
+        REQUIRE(LodSelection::SelectLod(Lods, 1, 0.0f, Threshold, 0) == 0);
+        REQUIRE(LodSelection::SelectLod(Lods, LodCount, 0.0f, Threshold, 7) == LodCount - 1);
+    }
+}
+
+TEST_CASE("Meshlets", "[Renderer]")
+{
+    using namespace Fling;
+
+    // A welded unit sphere at the origin, with the vertex cache order that imported models get
+    constexpr uint32 Rings = 32;
+    constexpr uint32 Segments = 64;
+    std::vector<Vertex> Verts;
+    std::vector<uint32> Indices;
+    for (uint32 Ring = 0; Ring <= Rings; ++Ring)
+    {
+        const float Theta = 3.14159265f * static_cast<float>(Ring) / Rings;
+        for (uint32 Segment = 0; Segment < Segments; ++Segment)
+        {
+            const float Phi = 6.2831853f * static_cast<float>(Segment) / Segments;
+            Vertex Vert;
+            Vert.Pos = glm::vec3(std::sin(Theta) * std::cos(Phi), std::cos(Theta), std::sin(Theta) * std::sin(Phi));
+            Vert.Normal = Vert.Pos;
+            Verts.push_back(Vert);
+        }
+    }
+    for (uint32 Ring = 0; Ring < Rings; ++Ring)
+    {
+        for (uint32 Segment = 0; Segment < Segments; ++Segment)
+        {
+            const uint32 A = Ring * Segments + Segment;
+            const uint32 B = Ring * Segments + (Segment + 1) % Segments;
+            const uint32 C = A + Segments;
+            const uint32 D = B + Segments;
+            if (Ring > 0)
+            {
+                Indices.insert(Indices.end(), { A, B, C });
+            }
+            if (Ring + 1 < Rings)
+            {
+                Indices.insert(Indices.end(), { B, D, C });
+            }
+        }
+    }
+    MeshOptimizer::OptimizeVertexCache(Indices.data(), Indices.size(), static_cast<uint32>(Verts.size()));
+    const uint32 IndexCount = static_cast<uint32>(Indices.size());
+    const std::vector<uint32> Original = Indices;
+
+    std::vector<Meshlet> Clusters;
+    Meshlets::Build(Verts, Indices.data(), 0, IndexCount, Clusters);
+    REQUIRE(Clusters.size() > 1);
+
+    const auto FaceNormal = [&](uint32 t_FirstIndex)
+    {
+        const glm::vec3& P0 = Verts[Indices[t_FirstIndex]].Pos;
+        return glm::normalize(glm::cross(Verts[Indices[t_FirstIndex + 1]].Pos - P0, Verts[Indices[t_FirstIndex + 2]].Pos - P0));
+    };
+
+    // 90 degree camera 5 units down +Z, looking at the sphere
+    const glm::mat4 Projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+    const glm::vec3 CameraPos(0.0f, 0.0f, 5.0f);
+    const glm::mat4 ViewProjection = Projection * glm::lookAt(CameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    SECTION("Meshlets cover the mesh and stay in their limits")
+    {
+        // The triangles are only moved around
+        const auto SortedTriangles = [](const std::vector<uint32>& t_Indices)
+        {
+            std::vector<std::array<uint32, 3>> Triangles;
+            for (size_t i = 0; i < t_Indices.size(); i += 3)
+            {
+                Triangles.push_back({ t_Indices[i], t_Indices[i + 1], t_Indices[i + 2] });
+            }
+            std::sort(Triangles.begin(), Triangles.end());
+            return Triangles;
+        };
+        REQUIRE(SortedTriangles(Indices) == SortedTriangles(Original));
+
+        uint32 Next = 0;
+        for (const Meshlet& Cluster : Clusters)
+        {
+            REQUIRE(Cluster.FirstIndex == Next);
+            REQUIRE(Cluster.IndexCount % 3 == 0);
+            REQUIRE(Cluster.IndexCount / 3 <= Meshlets::DefaultMaxTriangles);
+            Next += Cluster.IndexCount;
+
+            std::set<uint32> Unique(Indices.begin() + Cluster.FirstIndex, Indices.begin() + Cluster.FirstIndex + Cluster.IndexCount);
+            REQUIRE(Unique.size() == Cluster.VertexCount);
+            REQUIRE(Cluster.VertexCount <= Meshlets::DefaultMaxVertices);
+        }
+        REQUIRE(Next == IndexCount);
+
+        // A range part way into the index buffer keeps its offsets, and nothing outside of it is touched
+        const std::vector<uint32> Before = Indices;
+        std::vector<Meshlet> Offset;
+        Meshlets::Build(Verts, Indices.data(), 300, 600, Offset);
+        REQUIRE(Offset.front().FirstIndex == 300);
+        REQUIRE(Offset.back().FirstIndex + Offset.back().IndexCount == 900);
+        REQUIRE(std::equal(Indices.begin(), Indices.begin() + 300, Before.begin()));
+        REQUIRE(std::equal(Indices.begin() + 900, Indices.end(), Before.begin() + 900));
+    }
+
+    SECTION("Bounds and normal cones hold every triangle")
+    {
+        for (const Meshlet& Cluster : Clusters)
+        {
+            REQUIRE(Cluster.ConeCutoff < 1.0f);
+            const float MinCos = std::sqrt(1.0f - Cluster.ConeCutoff * Cluster.ConeCutoff);
+            for (uint32 i = Cluster.FirstIndex; i < Cluster.FirstIndex + Cluster.IndexCount; i += 3)
+            {
+                for (uint32 k = 0; k < 3; ++k)
+                {
+                    REQUIRE(glm::length(Verts[Indices[i + k]].Pos - Cluster.Center) <= Cluster.Radius + 1e-5f);
+
+                    // The apex is behind every triangle
+                    REQUIRE(glm::dot(Verts[Indices[i + k]].Pos - Cluster.ConeApex, FaceNormal(i)) >= -1e-5f);
+                }
+                REQUIRE(glm::dot(FaceNormal(i), Cluster.ConeAxis) >= MinCos - 1e-4f);
+            }
+        }
+    }
+
+    SECTION("Culling keeps every triangle that faces the camera")
+    {
+        const Meshlets::CullParams Params = Meshlets::MakeCullParams(ViewProjection, glm::mat4(1.0f), CameraPos);
+        REQUIRE(Params.bConeCulling);
+
+        std::vector<Meshlets::DrawRange> Ranges;
+        const uint32 Visible = Meshlets::Cull(Clusters.data(), static_cast<uint32>(Clusters.size()), Params, Ranges);
+        REQUIRE(Visible > 0);
+        REQUIRE(Visible < Clusters.size());
+
+        uint32 Drawn = 0;
+        for (size_t r = 0; r < Ranges.size(); ++r)
+        {
+            Drawn += Ranges[r].IndexCount;
+
+            // Ranges next to each other are merged
+            REQUIRE((r == 0 || Ranges[r - 1].FirstIndex + Ranges[r - 1].IndexCount < Ranges[r].FirstIndex));
+        }
+        REQUIRE(Drawn < IndexCount);
+
+        for (uint32 i = 0; i < IndexCount; i += 3)
+        {
+            if (glm::dot(FaceNormal(i), CameraPos - Verts[Indices[i]].Pos) > 0.0f)
+            {
+                const bool bDrawn = std::any_of(Ranges.begin(), Ranges.end(), [i](const Meshlets::DrawRange& t_Range)
+                {
+                    return i >= t_Range.FirstIndex && i < t_Range.FirstIndex + t_Range.IndexCount;
+                });
+                REQUIRE(bDrawn);
+            }
+        }
+
+        // Without the cones everything is in view, so it is all one draw
+        Meshlets::CullParams NoCones = Params;
+        NoCones.bConeCulling = false;
+        REQUIRE(Meshlets::Cull(Clusters.data(), static_cast<uint32>(Clusters.size()), NoCones, Ranges) == Clusters.size());
+        REQUIRE(Ranges.size() == 1);
+        REQUIRE(Ranges[0].IndexCount == IndexCount);
+    }
+
+    SECTION("Culling outside the frustum")
+    {
+        // Looking away from the sphere
+        const glm::mat4 LookingAway = Projection * glm::lookAt(CameraPos, glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        std::vector<Meshlets::DrawRange> Ranges;
+        REQUIRE(Meshlets::Cull(Clusters.data(), static_cast<uint32>(Clusters.size()), Meshlets::MakeCullParams(LookingAway, glm::mat4(1.0f), CameraPos), Ranges) == 0);
+        REQUIRE(Ranges.empty());
+
+        // Moved far off to the side by its world matrix
+        const glm::mat4 OffToTheSide = glm::translate(glm::mat4(1.0f), glm::vec3(100.0f, 0.0f, 0.0f));
+        REQUIRE(Meshlets::Cull(Clusters.data(), static_cast<uint32>(Clusters.size()), Meshlets::MakeCullParams(ViewProjection, OffToTheSide, CameraPos), Ranges) == 0);
+    }
+
+    SECTION("World matrices")
+    {
+        // Cull params are in model space
+        const glm::mat4 World = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -1.0f)), glm::vec3(2.0f));
+        const Meshlets::CullParams Params = Meshlets::MakeCullParams(ViewProjection, World, CameraPos);
+        REQUIRE(Params.bConeCulling);
+        REQUIRE(Params.CameraPos.z == Catch::Approx(3.0f));
+
+        // Near plane is 0.1 in front of the camera, which is 2.95 units along z in model space
+        REQUIRE(glm::dot(glm::vec3(Params.Planes[4]), glm::vec3(0.0f, 0.0f, 2.95f)) + Params.Planes[4].w == Catch::Approx(0.0f).margin(1e-4));
+
+        // Squashed or mirrored models can't trust their normal cones
+        REQUIRE_FALSE(Meshlets::MakeCullParams(ViewProjection, glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 1.0f)), CameraPos).bConeCulling);
+        REQUIRE_FALSE(Meshlets::MakeCullParams(ViewProjection, glm::scale(glm::mat4(1.0f), glm::vec3(-1.0f, 1.0f, 1.0f)), CameraPos).bConeCulling);
+    }
+
+    SECTION("Small meshes")
+    {
+        std::vector<Meshlet> Small;
+        Meshlets::Build(Verts, Indices.data(), 0, 0, Small);
+        REQUIRE(Small.empty());
+
+        Meshlets::Build(Verts, Indices.data(), 0, 3, Small);
+        REQUIRE(Small.size() == 1);
+        REQUIRE(Small[0].VertexCount == 3);
+
+        // One triangle's cone is its normal, and culls from anywhere behind its plane
+        const Meshlet& Single = Small[0];
+        REQUIRE(Single.ConeCutoff == Catch::Approx(0.0f).margin(1e-3));
+        REQUIRE(glm::dot(Single.ConeAxis, FaceNormal(0)) == Catch::Approx(1.0f));
+
+        Meshlets::CullParams Params = Meshlets::MakeCullParams(ViewProjection, glm::mat4(1.0f), CameraPos);
+        for (glm::vec4& Plane : Params.Planes)
+        {
+            Plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+        Params.CameraPos = Single.Center + FaceNormal(0);
+        REQUIRE(Meshlets::IsVisible(Single, Params));
+        Params.CameraPos = Single.Center - FaceNormal(0);
+        REQUIRE_FALSE(Meshlets::IsVisible(Single, Params));
+    }
+}
+
+TEST_CASE("Vertex Packing", "[Renderer]")
+{
+    using namespace Fling;
+
+    std::mt19937 Rng(1234);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+
+    SECTION("Packed vertices are less than half the size")
+    {
+        REQUIRE(sizeof(PackedVertex) * 2 < sizeof(Vertex));
+        REQUIRE(PackedVertex::GetBindingDescription().stride == sizeof(PackedVertex));
+
+        // Same locations as the full vertex, so only the vertex shader changes
+        const auto Full = Vertex::GetAttributeDescriptions();
+        const auto Packed = PackedVertex::GetAttributeDescriptions();
+        for (size_t i = 0; i < Full.size(); ++i)
+        {
+            REQUIRE(Packed[i].location == Full[i].location);
+        }
+    }
+
+    SECTION("Octahedral directions round trip")
+    {
+        std::vector<glm::vec3> Dirs =
+        {
+            { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+            { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }
+        };
+        for (int i = 0; i < 10000; ++i)
+        {
+            const glm::vec3 Dir(Unit(Rng), Unit(Rng), Unit(Rng));
+            if (glm::dot(Dir, Dir) > 1e-4f)
+            {
+                Dirs.push_back(glm::normalize(Dir));
+            }
+        }
+
+        for (const glm::vec3& Dir : Dirs)
+        {
+            int16 Encoded[2];
+            VertexPacking::OctEncode(Dir, Encoded);
+            const glm::vec3 Decoded = VertexPacking::OctDecode(Encoded);
+
+            // snorm16 is well under a hundredth of a degree off anywhere on the sphere
+            REQUIRE(glm::length(Decoded - Dir) < 1e-4f);
+        }
+    }
+
+    SECTION("Positions are within half a step of the bounds")
+    {
+        std::vector<Vertex> Verts(1000);
+        for (Vertex& Vert : Verts)
+        {
+            // Flat in Z, which has no extent to quantize
+            Vert.Pos = glm::vec3(Unit(Rng) * 4.0f + 1.0f, Unit(Rng) * 0.01f - 3.0f, 2.0f);
+            Vert.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            Vert.Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+        }
+
+        glm::vec3 Offset;
+        glm::vec3 Scale;
+        VertexPacking::GetPositionTransform(Verts.data(), static_cast<uint32>(Verts.size()), Offset, Scale);
+        REQUIRE(Scale.z == 0.0f);
+
+        std::vector<PackedVertex> Packed(Verts.size());
+        VertexPacking::Pack(Verts.data(), static_cast<uint32>(Verts.size()), Offset, Scale, Packed.data());
+
+        const glm::vec3 HalfStep = Scale / (2.0f * 65535.0f);
+        for (size_t i = 0; i < Verts.size(); ++i)
+        {
+            const Vertex Unpacked = VertexPacking::Unpack(Packed[i], Offset, Scale);
+            for (int Axis = 0; Axis < 3; ++Axis)
+            {
+                REQUIRE(std::abs(Unpacked.Pos[Axis] - Verts[i].Pos[Axis]) <= HalfStep[Axis] + 1e-6f);
+            }
+            REQUIRE(Unpacked.Pos.z == 2.0f);
+            REQUIRE(glm::dot(Unpacked.Normal, Verts[i].Normal) == Catch::Approx(1.0f));
+            REQUIRE(glm::dot(Unpacked.Tangent, Verts[i].Tangent) == Catch::Approx(1.0f));
+        }
+    }
+
+    SECTION("UVs and colors")
+    {
+        Vertex Vert;
+        Vert.Color = glm::vec3(1.0f, 0.5f, 0.0f);
+        Vert.TexCoord = glm::vec2(0.3f, 0.99f);
+        Vert.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+
+        PackedVertex Packed;
+        VertexPacking::Pack(&Vert, 1, glm::vec3(0.0f), glm::vec3(1.0f), &Packed);
+        REQUIRE(Packed.Color[0] == 255);
+        REQUIRE(Packed.Color[1] == 128);
+        REQUIRE(Packed.Color[2] == 0);
+        REQUIRE(Packed.Color[3] == 255);
+
+        // Halfs have 11 bits of precision, plenty for UVs of a texture up to 2048 wide
+        const Vertex Unpacked = VertexPacking::Unpack(Packed, glm::vec3(0.0f), glm::vec3(1.0f));
+        REQUIRE(Unpacked.TexCoord.x == Catch::Approx(0.3f).margin(1.0f / 2048.0f));
+        REQUIRE(Unpacked.TexCoord.y == Catch::Approx(0.99f).margin(1.0f / 2048.0f));
+    }
+
+    SECTION("16 bit indices")
+    {
+        const std::vector<uint32> Indices = { 0, 1, 2, 65535, 40000, 7 };
+        std::vector<uint16> Short(Indices.size());
+        VertexPacking::PackIndices16(Indices.data(), Indices.size(), Short.data());
+        REQUIRE(std::equal(Indices.begin(), Indices.end(), Short.begin()));
+    }
+}
+
+namespace
+{
+    const char* const ShippedModels[] =
+    {
+        "Models/cube.obj", "Models/cone.obj", "Models/cylinder.obj", "Models/sphere.obj", "Models/torus.obj",
+        "Models/torusknot.obj", "Models/helix.obj", "Models/RoundedCube.obj", "Models/InvertedSphere.obj"
+    };
+
+    std::string ReadTextFile(const std::string& t_Path)
+    {
+        std::ifstream File(t_Path, std::ios::binary);
+        std::stringstream Contents;
+        Contents << File.rdbuf();
+        return Contents.str();
+    }
+
+    /** What Model::LoadModel used to build from tinyobjloader */
+    bool ImportWithTinyObj(const std::string& t_Path, std::vector<Fling::Vertex>& t_OutVerts)
+    {
+        tinyobj::attrib_t Attrib;
+        std::vector<tinyobj::shape_t> Shapes;
+        std::vector<tinyobj::material_t> Materials;
+        std::string Warn;
+        std::string Err;
+        if (!tinyobj::LoadObj(&Attrib, &Shapes, &Materials, &Warn, &Err, t_Path.c_str()))
+        {
+            return false;
+        }
+
+        t_OutVerts.clear();
+        for (const tinyobj::shape_t& Shape : Shapes)
+        {
+            for (const tinyobj::index_t& Index : Shape.mesh.indices)
+            {
+                Fling::Vertex Vert = {};
+                Vert.Pos = { Attrib.vertices[3 * Index.vertex_index + 0], Attrib.vertices[3 * Index.vertex_index + 1], Attrib.vertices[3 * Index.vertex_index + 2] };
+                Vert.Normal = { Attrib.normals[3 * Index.normal_index + 0], Attrib.normals[3 * Index.normal_index + 1], Attrib.normals[3 * Index.normal_index + 2] };
+                Vert.TexCoord = { Attrib.texcoords[2 * Index.texcoord_index + 0], Attrib.texcoords[2 * Index.texcoord_index + 1] };
+                Vert.Color = { 1.0f, 1.0f, 1.0f };
+                t_OutVerts.push_back(Vert);
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE("OBJ Importer", "[Renderer]")
+{
+    using namespace Fling;
+
+    std::vector<Vertex> Verts;
+    std::vector<uint32> Indices;
+    std::string Error;
+
+    SECTION("Floats")
+    {
+        const auto Parse = [](const std::string& t_Text)
+        {
+            float Value = -999.0f;
+            REQUIRE(ObjImporter::ParseFloat(t_Text.data(), t_Text.data() + t_Text.size(), Value) != nullptr);
+            return Value;
+        };
+
+        REQUIRE(Parse("1") == 1.0f);
+        REQUIRE(Parse("  -0.5") == -0.5f);
+        REQUIRE(Parse("+.25") == 0.25f);
+        REQUIRE(Parse("3.") == 3.0f);
+        REQUIRE(Parse("1.5e3") == 1500.0f);
+        REQUIRE(Parse("-2.5E-2") == Catch::Approx(-0.025f));
+        REQUIRE(Parse("0.100000") == 0.1f);
+        REQUIRE(Parse("123456.789012") == 123456.789012f);
+        REQUIRE(Parse("0.0000000000000000000000000001") == Catch::Approx(1e-28f));
+        REQUIRE(Parse("7e") == 7.0f);
+
+        float Value = 0.0f;
+        const std::string NotANumber = "x1";
+        REQUIRE(ObjImporter::ParseFloat(NotANumber.data(), NotANumber.data() + NotANumber.size(), Value) == nullptr);
+    }
+
+    SECTION("Faces")
+    {
+        const std::string Obj =
+            "# A quad and a triangle\r\n"
+            "o Quad\r\n"
+            "v 0 0 0\r\nv 1 0 0\r\nv 1 1 0\r\nv 0 1 0\r\n"
+            "vt 0 0\r\nvt 1 0\r\nvt 1 1\r\nvt 0 1\r\n"
+            "vn 0 0 1\r\n"
+            "usemtl Default\r\n"
+            "f 1/1/1 2/2/1 3/3/1 4/4/1\r\n"
+            "v 5 5 5\n"
+            "f -1 -4//1 -3 # relative to the last vertex\n"
+            "f 1 2";
+
+        REQUIRE(ObjImporter::Import(Obj, Verts, Indices, Error));
+        REQUIRE(Verts.size() == 9);
+        REQUIRE(Indices == std::vector<uint32>{ 0, 1, 2, 3, 4, 5, 6, 7, 8 });
+
+        // The quad is fanned out from its first corner
+        REQUIRE(Verts[3].Pos == glm::vec3(0.0f));
+        REQUIRE(Verts[4].Pos == glm::vec3(1.0f, 1.0f, 0.0f));
+        REQUIRE(Verts[5].Pos == glm::vec3(0.0f, 1.0f, 0.0f));
+        REQUIRE(Verts[5].TexCoord == glm::vec2(0.0f, 1.0f));
+        REQUIRE(Verts[5].Normal == glm::vec3(0.0f, 0.0f, 1.0f));
+        REQUIRE(Verts[5].Color == glm::vec3(1.0f));
+
+        // Negative indices, and corners without some attributes
+        REQUIRE(Verts[6].Pos == glm::vec3(5.0f));
+        REQUIRE(Verts[6].Normal == glm::vec3(0.0f));
+        REQUIRE(Verts[7].Pos == glm::vec3(1.0f, 0.0f, 0.0f));
+        REQUIRE(Verts[7].Normal == glm::vec3(0.0f, 0.0f, 1.0f));
+        REQUIRE(Verts[7].TexCoord == glm::vec2(0.0f));
+    }
+
+    SECTION("Bad files")
+    {
+        REQUIRE_FALSE(ObjImporter::Import("v 0 0 0\nf 1 2 3\n", Verts, Indices, Error));
+        REQUIRE_FALSE(ObjImporter::Import("v 0 0 0\nv 0 0\nf 1 1 1\n", Verts, Indices, Error));
+        REQUIRE(Error == "bad vertex position on line 2");
+        REQUIRE_FALSE(ObjImporter::Import("v 0 0 0\nf 1 1 0\n", Verts, Indices, Error));
+        REQUIRE_FALSE(ObjImporter::Import("v 0 0 0\nf 1 1 -2\n", Verts, Indices, Error));
+        REQUIRE_FALSE(ObjImporter::Import("v 0 0 0\nf 1 1 1x\n", Verts, Indices, Error));
+
+        REQUIRE(ObjImporter::Import("", Verts, Indices, Error));
+        REQUIRE(Verts.empty());
+    }
+
+    SECTION("Matches tinyobjloader on the shipped models")
+    {
+        // Tiny chunks so that even the small models are split up
+        for (const char* Model : ShippedModels)
+        {
+            const std::string Path = FlingPaths::EngineAssetsDir() + "/" + Model;
+            std::vector<Vertex> Expected;
+            REQUIRE(ImportWithTinyObj(Path, Expected));
+
+            const std::string Text = ReadTextFile(Path);
+            REQUIRE(ObjImporter::Import(Text, Verts, Indices, Error, 1024));
+            REQUIRE(Verts.size() == Expected.size());
+            for (size_t i = 0; i < Verts.size(); ++i)
+            {
+                REQUIRE(Verts[i].Pos == Expected[i].Pos);
+                REQUIRE(Verts[i].Normal == Expected[i].Normal);
+                REQUIRE(Verts[i].TexCoord == Expected[i].TexCoord);
+            }
+        }
+    }
+}
+
+TEST_CASE("OBJ Importer Benchmarks", "[Renderer][!benchmark]")
+{
+    using namespace Fling;
+
+    REQUIRE(CommandLine::Get().LoadConfigVarsFromString("[ConsoleVariables]\nJobWorkerCount=3\n"));
+    JobSystem::Get().Init();
+
+    // Every shipped model in one file, so that there is enough to split up
+    std::string Combined;
+    uint32 VertsSoFar = 0;
+    for (const char* Model : ShippedModels)
+    {
+        // Faces only use positive indices in these files, so make them relative to keep them valid
+        std::vector<Vertex> Verts;
+        std::vector<uint32> Indices;
+        std::string Error;
+        const std::string Text = ReadTextFile(FlingPaths::EngineAssetsDir() + "/" + Model);
+        REQUIRE(ObjImporter::Import(Text, Verts, Indices, Error));
+        for (const Vertex& Vert : Verts)
+        {
+            Combined += "v " + std::to_string(Vert.Pos.x) + " " + std::to_string(Vert.Pos.y) + " " + std::to_string(Vert.Pos.z) + "\n";
+            Combined += "vt " + std::to_string(Vert.TexCoord.x) + " " + std::to_string(Vert.TexCoord.y) + "\n";
+            Combined += "vn " + std::to_string(Vert.Normal.x) + " " + std::to_string(Vert.Normal.y) + " " + std::to_string(Vert.Normal.z) + "\n";
+        }
+        for (size_t i = 0; i + 2 < Verts.size(); i += 3)
+        {
+            Combined += "f";
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const std::string Index = std::to_string(VertsSoFar + i + k + 1);
+                Combined += " " + Index + "/" + Index + "/" + Index;
+            }
+            Combined += "\n";
+        }
+        VertsSoFar += static_cast<uint32>(Verts.size());
+    }
+
+    const std::string CombinedPath = "ObjImporterBenchmark.obj";
+    {
+        std::ofstream File(CombinedPath, std::ios::binary | std::ios::trunc);
+        File << Combined;
+    }
+
+    BENCHMARK("tinyobjloader")
+    {
+        std::vector<Vertex> Verts;
+        ImportWithTinyObj(CombinedPath, Verts);
+        return Verts.size();
+    };
+
+    BENCHMARK("ObjImporter, from a file")
+    {
+        std::vector<Vertex> Verts;
+        std::vector<uint32> Indices;
+        std::string Error;
+        ObjImporter::Import(ReadTextFile(CombinedPath), Verts, Indices, Error);
+        return Verts.size();
+    };
+
+    BENCHMARK("ObjImporter, already in memory")
+    {
+        std::vector<Vertex> Verts;
+        std::vector<uint32> Indices;
+        std::string Error;
+        ObjImporter::Import(Combined, Verts, Indices, Error);
+        return Verts.size();
+    };
+
+    // Models are imported on the resource loading threads, which aren't job system workers
+    BENCHMARK("ObjImporter, on a loading thread")
+    {
+        std::vector<Vertex> Verts;
+        std::vector<uint32> Indices;
+        std::string Error;
+        std::thread Loader([&]() { ObjImporter::Import(Combined, Verts, Indices, Error); });
+        Loader.join();
+        return Verts.size();
+    };
+
+    std::filesystem::remove(CombinedPath);
+    JobSystem::Get().Shutdown();
+}
@@ -6,6 +6,18 @@
 #include "Singleton.hpp"
 #include "FlingConfig.h"
 #include "ResourceManager.h"
+#include "Hash.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 // @see TestConf.ini
 
@@ -57,3 +69,910 @@ TEST_CASE("Engine Config File", "[resource]")
     Logger::Get().Shutdown();
     FlingConfig::Get().Shutdown();
 }
+
+namespace
+{
+    using namespace Fling;
+
+    /** A resource that keeps track of where each half of an asynchronous load ran */
+    class AsyncTestResource : public Resource
+    {
+    public:
+        explicit AsyncTestResource(Guid t_ID)
+            : Resource(t_ID)
+        {}
+
+        AsyncTestResource(Guid t_ID, AsyncLoad_t)
+            : Resource(t_ID)
+            , m_LoadThread(std::this_thread::get_id())
+        {
+            ++NumAsyncLoads;
+            if (GetGuidString().find("Missing") != std::string::npos)
+            {
+                throw std::runtime_error("File not found");
+            }
+        }
+
+        std::thread::id m_LoadThread;
+        std::thread::id m_FinalizeThread;
+
+        /** How many times finalize has to be called before it says it is done */
+        static std::atomic<int> FinalizeCallsNeeded;
+
+        /** How many of these a loading thread has made */
+        static std::atomic<int> NumAsyncLoads;
+        int m_FinalizeCalls = 0;
+
+    protected:
+        bool FinalizeAsyncLoad() override
+        {
+            m_FinalizeThread = std::this_thread::get_id();
+            return ++m_FinalizeCalls >= FinalizeCallsNeeded.load();
+        }
+    };
+
+    std::atomic<int> AsyncTestResource::FinalizeCallsNeeded { 1 };
+    std::atomic<int> AsyncTestResource::NumAsyncLoads { 0 };
+
+    /** A resource that says it uses some CPU memory and can be evicted */
+    class BudgetTestResource : public Resource
+    {
+    public:
+        BudgetTestResource(Guid t_ID, uint64 t_Bytes)
+            : Resource(t_ID)
+            , m_Bytes(t_Bytes)
+        {}
+
+        ResourceMemoryUsage GetMemoryUsage() const override
+        {
+            ResourceMemoryUsage Usage;
+            Usage[ResourceMemoryType::CPU] = m_Bytes;
+            return Usage;
+        }
+
+        bool CanBeEvicted() const override { return true; }
+
+    private:
+        uint64 m_Bytes = 0;
+    };
+}
+
+TEST_CASE("Async Resource Loading", "[resource]")
+{
+    using namespace Fling;
+    Logger::Get().Init();
+    ResourceManager::Get().Init();
+
+    AsyncTestResource::FinalizeCallsNeeded = 1;
+    const std::thread::id MainThread = std::this_thread::get_id();
+
+    SECTION("Loads on a loading thread and finalizes on the main thread")
+    {
+        ResourceFuture<AsyncTestResource> Future = ResourceManager::LoadResourceAsync<AsyncTestResource>("Test/Async_A"_hs);
+        REQUIRE(Future.IsValid());
+
+        // Nothing is ready until the main thread finishes it off
+        REQUIRE_FALSE(Future.IsReady());
+        REQUIRE(Future.Get() == nullptr);
+        REQUIRE_FALSE(ResourceManager::Get().IsLoaded("Test/Async_A"_hs));
+
+        ResourceManager::Get().FlushAsyncLoads();
+
+        REQUIRE(Future.IsReady());
+        std::shared_ptr<AsyncTestResource> Loaded = Future.Get();
+        REQUIRE(Loaded != nullptr);
+        REQUIRE(Loaded->GetGuidString() == "Test/Async_A");
+        REQUIRE(Loaded->m_LoadThread != MainThread);
+        REQUIRE(Loaded->m_FinalizeThread == MainThread);
+        REQUIRE(ResourceManager::Get().GetResourceOfType<AsyncTestResource>("Test/Async_A"_hs) == Loaded);
+        REQUIRE(ResourceManager::Get().GetNumPendingLoads() == 0);
+    }
+
+    SECTION("The same resource is only loaded once")
+    {
+        ResourceFuture<AsyncTestResource> First = ResourceManager::LoadResourceAsync<AsyncTestResource>("Test/Async_B"_hs);
+        ResourceFuture<AsyncTestResource> Second = ResourceManager::LoadResourceAsync<AsyncTestResource>("Test/Async_B"_hs);
+        REQUIRE(ResourceManager::Get().GetNumPendingLoads() == 1);
+
+        ResourceManager::Get().FlushAsyncLoads();
+        REQUIRE(First.Get() == Second.Get());
+
+        // Once it's loaded a new request is ready right away
+        ResourceFuture<AsyncTestResource> Third = ResourceManager::LoadResourceAsync<AsyncTestResource>("Test/Async_B"_hs);
+        REQUIRE(Third.IsReady());
+        REQUIRE(Third.Get() == First.Get());
+    }
+
+    SECTION("Placeholders are used until the resource is ready")
+    {
+        std::shared_ptr<AsyncTestResource> Placeholder = ResourceManager::LoadResource<AsyncTestResource>("Test/Placeholder"_hs);
+        ResourceFuture<AsyncTestResource> Future = ResourceManager::LoadResourceAsync<AsyncTestResource>("Test/Async_C"_hs);
+        REQUIRE(Future.GetOr(Placeholder) == Placeholder);
+
+        ResourceManager::Get().FlushAsyncLoads();
+        REQUIRE(Future.GetOr(Placeholder) != Placeholder);
+    }
+
+    SECTION("Failed loads")
+    {
+        ResourceFuture<AsyncTestResource> Future = ResourceManager::LoadResourceAsync<AsyncTestResource>("Test/Missing"_hs);
+        ResourceManager::Get().FlushAsyncLoads();
+
+        REQUIRE(Future.HasFailed());
+        REQUIRE(Future.IsDone());
+        REQUIRE(Future.Get() == nullptr);
+        REQUIRE_FALSE(ResourceManager::Get().IsLoaded("Test/Missing"_hs));
+    }
+
+    SECTION("Finalizing can wait for more frames")
+    {
+        AsyncTestResource::FinalizeCallsNeeded = 3;
+        ResourceFuture<AsyncTestResource> Future = ResourceManager::LoadResourceAsync<AsyncTestResource>("Test/Async_D"_hs);
+
+        ResourceManager::Get().FlushAsyncLoads();
+        REQUIRE(Future.IsReady());
+        REQUIRE(Future.Get()->m_FinalizeCalls == 3);
+    }
+
+    SECTION("Shutting down with full request and completion queues")
+    {
+        // Enough loads to fill both queues and the backlog, with nothing finishing them
+        const size_t NumLoads = ResourceManager::MaxQueuedLoads * 3;
+        std::vector<std::string> Paths;
+        Paths.reserve(NumLoads);
+        std::vector<ResourceFuture<AsyncTestResource>> Futures;
+        Futures.reserve(NumLoads);
+
+        AsyncTestResource::NumAsyncLoads = 0;
+        for (size_t i = 0; i < NumLoads; ++i)
+        {
+            Paths.emplace_back("Test/Shutdown_" + std::to_string(i));
+            Futures.emplace_back(ResourceManager::LoadResourceAsync<AsyncTestResource>(Guid{ Paths.back().c_str() }));
+        }
+
+        // Wait for the completion queue to fill up, the loading threads are stuck trying to hand back one more
+        const auto Timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (AsyncTestResource::NumAsyncLoads.load() <= static_cast<int>(ResourceManager::MaxQueuedLoads) && std::chrono::steady_clock::now() < Timeout)
+        {
+            std::this_thread::yield();
+        }
+        REQUIRE(AsyncTestResource::NumAsyncLoads.load() > static_cast<int>(ResourceManager::MaxQueuedLoads));
+
+        ResourceManager::Get().Shutdown();
+
+        // Nothing got finalized, and the requests that were never loaded were dropped
+        REQUIRE(AsyncTestResource::NumAsyncLoads.load() < static_cast<int>(NumLoads));
+        for (const ResourceFuture<AsyncTestResource>& Future : Futures)
+        {
+            REQUIRE(Future.HasFailed());
+        }
+
+        // The end of the test shuts it down again
+        ResourceManager::Get().Init();
+    }
+
+    ResourceManager::Get().Shutdown();
+    Logger::Get().Shutdown();
+}
+
+TEST_CASE("Resource Table", "[resource]")
+{
+    using namespace Fling;
+
+    // These two paths have the same 32 bit Guid hash
+    static const char* CollidingPathA = "Collision/999666";
+    static const char* CollidingPathB = "Collision/1332280";
+    REQUIRE(Guid_Handle(Guid{ CollidingPathA }) == Guid_Handle(Guid{ CollidingPathB }));
+
+    SECTION("Insert, find and remove")
+    {
+        ResourceTable Table(4);
+
+        std::vector<std::shared_ptr<Resource>> Resources;
+        for (uint32 i = 0; i < 1000; ++i)
+        {
+            const std::string Path = "Test/Table_" + std::to_string(i);
+            Resources.emplace_back(std::make_shared<AsyncTestResource>(Guid{ Path.c_str() }));
+            REQUIRE(Table.Insert(Resources.back()) == ResourceTable::InsertResult::Inserted);
+        }
+        REQUIRE(Table.Size() == Resources.size());
+
+        // Adding the same path again keeps the first one
+        std::shared_ptr<Resource> Existing;
+        std::shared_ptr<Resource> Duplicate = std::make_shared<AsyncTestResource>(Guid{ "Test/Table_7" });
+        REQUIRE(Table.Insert(Duplicate, &Existing) == ResourceTable::InsertResult::AlreadyExists);
+        REQUIRE(Existing == Resources[7]);
+
+        // Remove every other one, the rest still have to be found past the holes
+        for (size_t i = 0; i < Resources.size(); i += 2)
+        {
+            REQUIRE(Table.Remove(Resources[i]->GetGuidHandle()));
+        }
+        REQUIRE_FALSE(Table.Remove(Resources[0]->GetGuidHandle()));
+        REQUIRE(Table.Size() == Resources.size() / 2);
+
+        for (size_t i = 0; i < Resources.size(); ++i)
+        {
+            const bool bShouldExist = (i % 2) == 1;
+            REQUIRE(Table.Contains(Resources[i]->GetGuidHandle()) == bShouldExist);
+            REQUIRE(Table.Find(Resources[i]->GetGuidHandle()) == (bShouldExist ? Resources[i] : nullptr));
+        }
+
+        size_t NumVisited = 0;
+        Table.ForEach([&](const std::shared_ptr<Resource>&) { ++NumVisited; });
+        REQUIRE(NumVisited == Table.Size());
+
+        Table.Clear();
+        REQUIRE(Table.Size() == 0);
+        REQUIRE(Table.Find(Resources[1]->GetGuidHandle()) == nullptr);
+    }
+
+    SECTION("Hash collisions are detected")
+    {
+        ResourceTable Table;
+        std::shared_ptr<Resource> A = std::make_shared<AsyncTestResource>(Guid{ CollidingPathA });
+        std::shared_ptr<Resource> B = std::make_shared<AsyncTestResource>(Guid{ CollidingPathB });
+
+        std::shared_ptr<Resource> Existing;
+        REQUIRE(Table.Insert(A) == ResourceTable::InsertResult::Inserted);
+        REQUIRE(Table.Insert(B, &Existing) == ResourceTable::InsertResult::Collision);
+        REQUIRE(Existing == A);
+    }
+
+    SECTION("Resource manager refuses colliding paths")
+    {
+        Logger::Get().Init();
+        ResourceManager::Get().Init();
+
+        REQUIRE(ResourceManager::LoadResource<AsyncTestResource>(Guid{ CollidingPathA }) != nullptr);
+        REQUIRE_THROWS(ResourceManager::LoadResource<AsyncTestResource>(Guid{ CollidingPathB }));
+
+        ResourceManager::Get().Shutdown();
+        Logger::Get().Shutdown();
+    }
+
+    SECTION("Loading from many threads at once")
+    {
+        Logger::Get().Init();
+        ResourceManager::Get().Init();
+
+        static constexpr uint32 NumThreads = 4;
+        static constexpr uint32 NumPaths = 64;
+
+        std::vector<std::string> Paths;
+        for (uint32 i = 0; i < NumPaths; ++i)
+        {
+            Paths.emplace_back("Test/Threaded_" + std::to_string(i));
+        }
+
+        // Every thread loads every path, they should all end up with the same resources
+        std::vector<std::vector<std::shared_ptr<AsyncTestResource>>> Loaded(NumThreads);
+        std::vector<std::thread> Threads;
+        for (uint32 t = 0; t < NumThreads; ++t)
+        {
+            Threads.emplace_back([&, t]()
+            {
+                for (uint32 i = 0; i < NumPaths; ++i)
+                {
+                    Loaded[t].push_back(ResourceManager::LoadResource<AsyncTestResource>(Guid{ Paths[(i + t * 7) % NumPaths].c_str() }));
+                }
+            });
+        }
+        for (std::thread& Thread : Threads)
+        {
+            Thread.join();
+        }
+
+        for (uint32 i = 0; i < NumPaths; ++i)
+        {
+            std::shared_ptr<Resource> Res = ResourceManager::Get().GetResource(Guid{ Paths[i].c_str() });
+            REQUIRE(Res != nullptr);
+            for (uint32 t = 0; t < NumThreads; ++t)
+            {
+                REQUIRE(Loaded[t][(i + NumPaths - (t * 7) % NumPaths) % NumPaths] == Res);
+            }
+        }
+
+        ResourceManager::Get().Shutdown();
+        Logger::Get().Shutdown();
+    }
+}
+
+TEST_CASE("Resource Budgets", "[resource]")
+{
+    using namespace Fling;
+    Logger::Get().Init();
+    ResourceManager::Get().Init();
+
+    ResourceManager& Manager = ResourceManager::Get();
+
+    // Load one resource per frame so that they have a clear least recently used order
+    Manager.SetBudget(ResourceMemoryType::CPU, 3000);
+    ResourceManager::LoadResource<BudgetTestResource>("Test/Budget_A"_hs, 1000);
+    Manager.Update();
+    std::shared_ptr<BudgetTestResource> B = ResourceManager::LoadResource<BudgetTestResource>("Test/Budget_B"_hs, 1000);
+    Manager.Update();
+    ResourceManager::LoadResource<BudgetTestResource>("Test/Budget_C"_hs, 1000);
+    Manager.Update();
+
+    // Resources that can't be evicted still count, but are never unloaded
+    std::shared_ptr<AsyncTestResource> Pinned = ResourceManager::LoadResource<AsyncTestResource>("Test/Budget_Pinned"_hs);
+    Pinned.reset();
+
+    REQUIRE(Manager.GetResidency(ResourceMemoryType::CPU).CurrentBytes == 3000);
+    REQUIRE(Manager.GetNumEvictions() == 0);
+
+    SECTION("The least recently used resource is evicted")
+    {
+        ResourceManager::LoadResource<BudgetTestResource>("Test/Budget_D"_hs, 1000);
+        Manager.Update();
+
+        REQUIRE(Manager.GetNumEvictions() == 1);
+        REQUIRE_FALSE(Manager.IsLoaded("Test/Budget_A"_hs));
+        REQUIRE(Manager.IsLoaded("Test/Budget_B"_hs));
+        REQUIRE(Manager.IsLoaded("Test/Budget_C"_hs));
+        REQUIRE(Manager.IsLoaded("Test/Budget_D"_hs));
+        REQUIRE(Manager.IsLoaded("Test/Budget_Pinned"_hs));
+
+        // Evicted resources stick around until frames in flight are done with them
+        REQUIRE(Manager.GetResidency(ResourceMemoryType::CPU).CurrentBytes == 4000);
+        for (int i = 0; i < 8; ++i)
+        {
+            Manager.Update();
+        }
+        REQUIRE(Manager.GetResidency(ResourceMemoryType::CPU).CurrentBytes == 3000);
+        REQUIRE(Manager.GetResidency(ResourceMemoryType::CPU).PeakBytes == 4000);
+
+        // Asking for it again just loads it again
+        std::shared_ptr<BudgetTestResource> A = ResourceManager::LoadResource<BudgetTestResource>("Test/Budget_A"_hs, 1000);
+        REQUIRE(A != nullptr);
+        REQUIRE(Manager.IsLoaded("Test/Budget_A"_hs));
+    }
+
+    SECTION("Resources that are in use are never evicted")
+    {
+        Manager.SetBudget(ResourceMemoryType::CPU, 500);
+        Manager.Update();
+
+        REQUIRE(Manager.GetNumEvictions() == 2);
+        REQUIRE(Manager.IsLoaded("Test/Budget_B"_hs));
+        REQUIRE_FALSE(Manager.IsLoaded("Test/Budget_A"_hs));
+        REQUIRE_FALSE(Manager.IsLoaded("Test/Budget_C"_hs));
+
+        // Once it is let go of it can go too
+        B.reset();
+        Manager.Update();
+        REQUIRE_FALSE(Manager.IsLoaded("Test/Budget_B"_hs));
+        REQUIRE(Manager.IsLoaded("Test/Budget_Pinned"_hs));
+    }
+
+    SECTION("No budget means nothing is evicted")
+    {
+        Manager.SetBudget(ResourceMemoryType::CPU, 0);
+        ResourceManager::LoadResource<BudgetTestResource>("Test/Budget_D"_hs, 1000);
+        Manager.Update();
+
+        REQUIRE(Manager.GetNumEvictions() == 0);
+        REQUIRE(Manager.IsLoaded("Test/Budget_A"_hs));
+    }
+
+    B.reset();
+    ResourceManager::Get().Shutdown();
+    Logger::Get().Shutdown();
+}
+
+TEST_CASE("Resource Handles", "[resource]")
+{
+    using namespace Fling;
+    Logger::Get().Init();
+    ResourceManager::Get().Init();
+
+    ResourceManager& Manager = ResourceManager::Get();
+    AsyncTestResource::FinalizeCallsNeeded = 1;
+
+    STATIC_REQUIRE(sizeof(ResourceHandle<AsyncTestResource>) == sizeof(uint32));
+    STATIC_REQUIRE(std::is_trivially_copyable<ResourceHandle<AsyncTestResource>>::value);
+
+    SECTION("Handles resolve to the loaded resource")
+    {
+        ResourceHandle<AsyncTestResource> Handle = ResourceManager::LoadResourceHandle<AsyncTestResource>("Test/Handle_A"_hs);
+        REQUIRE(Handle.IsValid());
+
+        AsyncTestResource* Resolved = ResourceManager::Resolve(Handle);
+        REQUIRE(Resolved != nullptr);
+        REQUIRE(Resolved == Manager.GetResourceOfType<AsyncTestResource>("Test/Handle_A"_hs).get());
+        REQUIRE(ResourceManager::GetHandlePath(Handle) == "Test/Handle_A");
+
+        // The same resource always gets the same slot
+        ResourceHandle<AsyncTestResource> Second = ResourceManager::LoadResourceHandle<AsyncTestResource>("Test/Handle_A"_hs);
+        REQUIRE(Second == Handle);
+        REQUIRE(ResourceManager::GetSlots<AsyncTestResource>().GetNumRefs(Handle) == 2);
+
+        ResourceManager::ReleaseHandle(Second);
+        REQUIRE_FALSE(Second.IsValid());
+        REQUIRE(ResourceManager::Resolve(Handle) == Resolved);
+
+        ResourceManager::ReleaseHandle(Handle);
+    }
+
+    SECTION("Released handles go stale")
+    {
+        ResourceHandle<AsyncTestResource> Handle = ResourceManager::LoadResourceHandle<AsyncTestResource>("Test/Handle_B"_hs);
+        ResourceHandle<AsyncTestResource> Copy = Handle;
+        ResourceManager::ReleaseHandle(Handle);
+
+        REQUIRE(Copy.IsValid());
+        REQUIRE(ResourceManager::Resolve(Copy) == nullptr);
+        REQUIRE(ResourceManager::GetHandlePath(Copy).empty());
+
+        // The slot is reused with a new generation, so the old copy still doesn't resolve
+        ResourceHandle<AsyncTestResource> Other = ResourceManager::LoadResourceHandle<AsyncTestResource>("Test/Handle_C"_hs);
+        REQUIRE(Other.GetIndex() == Copy.GetIndex());
+        REQUIRE(Other.GetGeneration() != Copy.GetGeneration());
+        REQUIRE(ResourceManager::Resolve(Other) != nullptr);
+        REQUIRE(ResourceManager::Resolve(Copy) == nullptr);
+
+        // Releasing a stale handle doesn't touch whoever has the slot now
+        ResourceManager::ReleaseHandle(Copy);
+        REQUIRE(ResourceManager::Resolve(Other) != nullptr);
+
+        ResourceManager::ReleaseHandle(Other);
+    }
+
+    SECTION("Slots are retired instead of wrapping their generation")
+    {
+        using TestHandle = ResourceHandle<AsyncTestResource>;
+        ResourceSlotArray<AsyncTestResource> Slots;
+
+        const TestHandle First = Slots.Acquire("Test/Handle_Wrap"_hs, "Test/Handle_Wrap");
+        REQUIRE(First.GetGeneration() == 1);
+        Slots.Release(First);
+
+        // Use the same slot until it runs out of generations
+        TestHandle Last;
+        for (uint32 Generation = 2; Generation <= TestHandle::MaxGeneration; ++Generation)
+        {
+            Last = Slots.Acquire("Test/Handle_Wrap"_hs, "Test/Handle_Wrap");
+            REQUIRE(Last.GetIndex() == First.GetIndex());
+            REQUIRE(Last.GetGeneration() == Generation);
+            REQUIRE(Slots.GetNumRefs(First) == 0);
+            Slots.Release(Last);
+        }
+
+        // The next one gets a new slot, and nothing from the old one comes back to life
+        const TestHandle Next = Slots.Acquire("Test/Handle_Wrap"_hs, "Test/Handle_Wrap");
+        REQUIRE(Next.GetIndex() != First.GetIndex());
+        REQUIRE(Slots.GetNumRefs(Next) == 1);
+        REQUIRE(Slots.GetNumRefs(First) == 0);
+        REQUIRE(Slots.GetNumRefs(Last) == 0);
+        REQUIRE(Slots.GetNumRefs(TestHandle(First.GetIndex(), 1)) == 0);
+
+        Slots.Release(Next);
+        REQUIRE(Slots.GetNumLiveSlots() == 0);
+    }
+
+    SECTION("Handles keep resources from being evicted")
+    {
+        ResourceHandle<BudgetTestResource> Handle = ResourceManager::LoadResourceHandle<BudgetTestResource>("Test/Handle_Budget"_hs, 1000);
+        Manager.SetBudget(ResourceMemoryType::CPU, 500);
+        Manager.Update();
+
+        REQUIRE(Manager.IsLoaded("Test/Handle_Budget"_hs));
+        REQUIRE(ResourceManager::Resolve(Handle) != nullptr);
+
+        ResourceManager::ReleaseHandle(Handle);
+        Manager.Update();
+        REQUIRE_FALSE(Manager.IsLoaded("Test/Handle_Budget"_hs));
+    }
+
+    SECTION("Asynchronous handles resolve once the load is finished")
+    {
+        ResourceHandle<AsyncTestResource> Handle = ResourceManager::LoadResourceHandleAsync<AsyncTestResource>("Test/Handle_Async"_hs);
+        REQUIRE(Handle.IsValid());
+        REQUIRE(ResourceManager::Resolve(Handle) == nullptr);
+        REQUIRE(ResourceManager::GetHandlePath(Handle) == "Test/Handle_Async");
+
+        Manager.FlushAsyncLoads();
+
+        AsyncTestResource* Resolved = ResourceManager::Resolve(Handle);
+        REQUIRE(Resolved != nullptr);
+        REQUIRE(Resolved->m_FinalizeThread == std::this_thread::get_id());
+
+        ResourceManager::ReleaseHandle(Handle);
+    }
+
+    SECTION("Failed loads never resolve")
+    {
+        ResourceHandle<AsyncTestResource> Handle = ResourceManager::LoadResourceHandleAsync<AsyncTestResource>("Test/Handle_Missing"_hs);
+        Manager.FlushAsyncLoads();
+
+        REQUIRE(Handle.IsValid());
+        REQUIRE(ResourceManager::Resolve(Handle) == nullptr);
+        ResourceManager::ReleaseHandle(Handle);
+    }
+
+    SECTION("Shutdown makes every handle stale")
+    {
+        ResourceHandle<AsyncTestResource> Handle = ResourceManager::LoadResourceHandle<AsyncTestResource>("Test/Handle_Shutdown"_hs);
+        ResourceManager::Get().Shutdown();
+        REQUIRE(ResourceManager::Resolve(Handle) == nullptr);
+        ResourceManager::Get().Init();
+    }
+
+    REQUIRE(ResourceManager::GetSlots<AsyncTestResource>().GetNumLiveSlots() == 0);
+
+    ResourceManager::Get().Shutdown();
+    Logger::Get().Shutdown();
+}
+
+TEST_CASE("Asset Archives", "[resource]")
+{
+    using namespace Fling;
+    Logger::Get().Init();
+
+    const std::string ArchivePath = "AssetArchiveTest.flpk";
+    const std::string PatchPath = "AssetArchivePatch.flpk";
+
+    std::string Text;
+    for (int i = 0; i < 1000; ++i)
+    {
+        Text += "Line " + std::to_string(i % 10) + "\n";
+    }
+    std::vector<char> Noise(3000);
+    uint32 Seed = 1;
+    for (char& Byte : Noise)
+    {
+        Seed = Seed * 1664525u + 1013904223u;
+        Byte = static_cast<char>(Seed >> 24);
+    }
+
+    const auto ToString = [](const AssetData& t_Data) { return std::string(t_Data.GetView()); };
+
+    {
+        AssetArchiveBuilder Builder;
+        REQUIRE(Builder.AddData("Text/Lines.txt", Text.data(), Text.size()));
+        REQUIRE(Builder.AddData("Noise.bin", Noise.data(), Noise.size()));
+        REQUIRE(Builder.AddData("Empty.txt", nullptr, 0));
+        REQUIRE(Builder.AddData("Shared.txt", "Base", 4, false));
+        for (int i = 0; i < 100; ++i)
+        {
+            const std::string Path = "Many/" + std::to_string(i);
+            REQUIRE(Builder.AddData(Path, Path.data(), Path.size()));
+        }
+        REQUIRE(Builder.GetNumEntries() == 104);
+        REQUIRE(Builder.Write(ArchivePath));
+
+        AssetArchiveBuilder Patch;
+        REQUIRE(Patch.AddData("Shared.txt", "Patched", 7, false));
+        REQUIRE(Patch.Write(PatchPath));
+    }
+
+    SECTION("Entries can be found and read")
+    {
+        AssetArchive Archive;
+        REQUIRE(Archive.Open(ArchivePath));
+        REQUIRE(Archive.GetNumEntries() == 104);
+
+        const AssetArchiveEntry* Lines = Archive.Find(Guid{ "Text/Lines.txt" }, "Text/Lines.txt");
+        REQUIRE(Lines);
+        REQUIRE(Archive.GetEntryPath(*Lines) == "Text/Lines.txt");
+        REQUIRE(Lines->Offset % AssetArchiveBuilder::DefaultAlignment == 0);
+
+        // Text compresses, noise doesn't so it is stored as is and read in place
+        REQUIRE((Lines->Flags & AssetArchive::Entry_Compressed));
+        REQUIRE(Lines->StoredSize < Lines->Size);
+        AssetData Data;
+        REQUIRE(Archive.Read(*Lines, Data));
+        REQUIRE(Data.IsValid());
+        REQUIRE(Data.IsCopy());
+        REQUIRE(ToString(Data) == Text);
+
+        const AssetArchiveEntry* NoiseEntry = Archive.Find(Guid{ "Noise.bin" }, "Noise.bin");
+        REQUIRE(NoiseEntry);
+        REQUIRE_FALSE((NoiseEntry->Flags & AssetArchive::Entry_Compressed));
+        REQUIRE(Archive.Read(*NoiseEntry, Data));
+        REQUIRE_FALSE(Data.IsCopy());
+        REQUIRE(reinterpret_cast<uintptr_t>(Data.GetData()) % AssetArchiveBuilder::DefaultAlignment == 0);
+        REQUIRE(std::vector<char>(Data.GetData(), Data.GetData() + Data.GetSize()) == Noise);
+
+        const AssetArchiveEntry* Empty = Archive.Find(Guid{ "Empty.txt" }, "Empty.txt");
+        REQUIRE(Empty);
+        REQUIRE(Archive.Read(*Empty, Data));
+        REQUIRE(Data.GetSize() == 0);
+
+        size_t NumEntries = 0;
+        Archive.ForEachEntry([&](const AssetArchiveEntry& t_Entry)
+        {
+            AssetData EntryData;
+            REQUIRE(Archive.Read(t_Entry, EntryData));
+            ++NumEntries;
+        });
+        REQUIRE(NumEntries == Archive.GetNumEntries());
+
+        REQUIRE_FALSE(Archive.Contains(Guid{ "Missing.txt" }, "Missing.txt"));
+    }
+
+    SECTION("Data stays valid after the archive is closed")
+    {
+        AssetData Data;
+        {
+            AssetArchive Archive;
+            REQUIRE(Archive.Open(ArchivePath));
+            REQUIRE(Archive.Read(*Archive.Find(Guid{ "Noise.bin" }, "Noise.bin"), Data));
+        }
+        REQUIRE(std::vector<char>(Data.GetData(), Data.GetData() + Data.GetSize()) == Noise);
+    }
+
+    SECTION("Paths with the same hash are told apart")
+    {
+        static const char* CollidingPathA = "Collision/999666";
+        static const char* CollidingPathB = "Collision/1332280";
+
+        AssetArchiveBuilder Builder;
+        REQUIRE(Builder.AddData(CollidingPathA, "A", 1));
+        REQUIRE_FALSE(Builder.AddData(CollidingPathB, "B", 1));
+
+        // The same path replaces what was there
+        REQUIRE(Builder.AddData(CollidingPathA, "AA", 2));
+        REQUIRE(Builder.GetNumEntries() == 1);
+        REQUIRE(Builder.Write(ArchivePath));
+
+        AssetArchive Archive;
+        REQUIRE(Archive.Open(ArchivePath));
+        REQUIRE(Archive.Contains(Guid{ CollidingPathA }, CollidingPathA));
+        REQUIRE_FALSE(Archive.Contains(Guid{ CollidingPathB }, CollidingPathB));
+    }
+
+    SECTION("Corrupt archives are caught")
+    {
+        AssetArchiveEntry NoiseEntry;
+        {
+            AssetArchive Original;
+            REQUIRE(Original.Open(ArchivePath));
+            NoiseEntry = *Original.Find(Guid{ "Noise.bin" }, "Noise.bin");
+        }
+
+        // Flip a byte of the data, only the checksum can catch it
+        {
+            std::fstream File(ArchivePath, std::ios::binary | std::ios::in | std::ios::out);
+            File.seekp(static_cast<std::streamoff>(NoiseEntry.Offset + 10));
+            File.put(static_cast<char>(Noise[10] ^ 0xFF));
+        }
+        AssetArchive Archive;
+        REQUIRE(Archive.Open(ArchivePath));
+        AssetData Data;
+        REQUIRE_FALSE(Archive.Read(*Archive.Find(Guid{ "Noise.bin" }, "Noise.bin"), Data));
+        REQUIRE_FALSE(Data.IsValid());
+        REQUIRE(Archive.Read(*Archive.Find(Guid{ "Noise.bin" }, "Noise.bin"), Data, false));
+
+        // Not an archive at all
+        {
+            std::ofstream File(ArchivePath, std::ios::binary | std::ios::trunc);
+            File << "This is not an archive, but it is long enough to have a header in it";
+        }
+        REQUIRE_FALSE(Archive.Open(ArchivePath));
+        REQUIRE_FALSE(Archive.Open("ThisArchiveDoesNotExist.flpk"));
+    }
+
+    SECTION("The resource manager reads from the last mounted archive first")
+    {
+        ResourceManager::Get().Init();
+        ResourceManager& Manager = ResourceManager::Get();
+
+        REQUIRE(Manager.MountArchive(ArchivePath));
+        REQUIRE_FALSE(Manager.MountArchive("ThisArchiveDoesNotExist.flpk"));
+
+        AssetData Data;
+        REQUIRE(Manager.ReadAsset(Guid{ "Shared.txt" }, "Shared.txt", Data));
+        REQUIRE(ToString(Data) == "Base");
+
+        REQUIRE(Manager.MountArchive(PatchPath));
+        REQUIRE(Manager.GetNumMountedArchives() == 2);
+        REQUIRE(Manager.ReadAsset(Guid{ "Shared.txt" }, "Shared.txt", Data));
+        REQUIRE(ToString(Data) == "Patched");
+
+        // Only in the base archive
+        AssetData Lines;
+        REQUIRE(Manager.ReadAsset(Guid{ "Text/Lines.txt" }, "Text/Lines.txt", Lines));
+        REQUIRE(ToString(Lines) == Text);
+
+        REQUIRE_FALSE(Manager.ReadAsset(Guid{ "Missing/File.txt" }, "Missing/File.txt", Data));
+        REQUIRE_FALSE(Data.IsValid());
+
+        // Unmounting doesn't pull the rug out from under data that was already read
+        Manager.UnmountArchives();
+        REQUIRE(ToString(Lines) == Text);
+        REQUIRE_FALSE(Manager.ReadAsset(Guid{ "Shared.txt" }, "Shared.txt", Data));
+
+        ResourceManager::Get().Shutdown();
+    }
+
+    std::remove(ArchivePath.c_str());
+    std::remove(PatchPath.c_str());
+    Logger::Get().Shutdown();
+}
+
+TEST_CASE("Virtual File System", "[resource]")
+{
+    using namespace Fling;
+    Logger::Get().Init();
+
+    namespace fs = std::filesystem;
+    const std::string LooseDir = "VfsTestLoose";
+    const std::string ArchivePath = "VfsTest.flpk";
+
+    const auto WriteLooseFile = [&](const std::string& t_Path, const std::string& t_Contents)
+    {
+        const fs::path FullPath = fs::path(LooseDir) / t_Path;
+        fs::create_directories(FullPath.parent_path());
+        std::ofstream File(FullPath, std::ios::binary | std::ios::trunc);
+        File << t_Contents;
+    };
+    const auto ReadString = [](const VirtualFileSystem& t_Vfs, const std::string& t_Path)
+    {
+        AssetData Data;
+        return t_Vfs.Read(t_Path, Data) ? std::string(Data.GetView()) : std::string("<missing>");
+    };
+
+    fs::remove_all(LooseDir);
+    WriteLooseFile("Shared.txt", "Loose");
+    WriteLooseFile("LooseOnly.txt", "Loose only");
+    WriteLooseFile("Models/Cube.obj", "Cube");
+    WriteLooseFile("Models/Old/Sphere.obj", "Sphere");
+    {
+        AssetArchiveBuilder Builder;
+        REQUIRE(Builder.AddData("Shared.txt", "Packed", 6));
+        REQUIRE(Builder.AddData("Models/Packed.obj", "Packed model", 12));
+        REQUIRE(Builder.Write(ArchivePath));
+    }
+
+    VirtualFileSystem Vfs;
+    const VirtualFileSystem::MountId Loose = Vfs.MountDirectory(LooseDir, 0);
+    REQUIRE(Loose != VirtualFileSystem::InvalidMount);
+    REQUIRE(Vfs.MountDirectory("VfsTestDirectoryThatDoesNotExist", 0) == VirtualFileSystem::InvalidMount);
+    REQUIRE(Vfs.GetNumFiles() == 4);
+    REQUIRE(ReadString(Vfs, "Shared.txt") == "Loose");
+    REQUIRE(Vfs.GetSourceType("Shared.txt") == VfsMountType::Directory);
+
+    SECTION("Higher priority mounts win")
+    {
+        const VirtualFileSystem::MountId Archive = Vfs.MountArchive(ArchivePath, 100);
+        REQUIRE(Archive != VirtualFileSystem::InvalidMount);
+        REQUIRE(ReadString(Vfs, "Shared.txt") == "Packed");
+        REQUIRE(ReadString(Vfs, "LooseOnly.txt") == "Loose only");
+        REQUIRE(ReadString(Vfs, "Models/Packed.obj") == "Packed model");
+        REQUIRE(Vfs.GetNumFiles() == 5);
+
+        // Memory overlays go on top of both
+        const VirtualFileSystem::MountId Overlay = Vfs.MountMemory(200);
+        REQUIRE(Vfs.WriteMemoryFile(Overlay, "Shared.txt", "Memory", 6));
+        REQUIRE(Vfs.GetSourceType("Shared.txt") == VfsMountType::Memory);
+        AssetData FromMemory;
+        REQUIRE(Vfs.Read("Shared.txt", FromMemory));
+        REQUIRE(FromMemory.GetView() == "Memory");
+
+        // Writing again doesn't change data that was already read
+        REQUIRE(Vfs.WriteMemoryFile(Overlay, "Shared.txt", "Changed", 7));
+        REQUIRE(ReadString(Vfs, "Shared.txt") == "Changed");
+        REQUIRE(FromMemory.GetView() == "Memory");
+        REQUIRE_FALSE(Vfs.WriteMemoryFile(Archive, "Shared.txt", "Nope", 4));
+
+        // A lower priority mount that comes later doesn't win
+        const VirtualFileSystem::MountId LowOverlay = Vfs.MountMemory(-1);
+        REQUIRE(Vfs.WriteMemoryFile(LowOverlay, "LooseOnly.txt", "Hidden", 6));
+        REQUIRE(ReadString(Vfs, "LooseOnly.txt") == "Loose only");
+
+        // Unmounting falls back to whatever is underneath
+        REQUIRE(Vfs.Unmount(Overlay));
+        REQUIRE(ReadString(Vfs, "Shared.txt") == "Packed");
+        REQUIRE(FromMemory.GetView() == "Memory");
+        Vfs.UnmountAll(VfsMountType::Archive);
+        REQUIRE(ReadString(Vfs, "Shared.txt") == "Loose");
+        REQUIRE_FALSE(Vfs.Exists("Models/Packed.obj"));
+        REQUIRE_FALSE(Vfs.Unmount(Overlay));
+        REQUIRE(Vfs.GetNumMounts(VfsMountType::Memory) == 1);
+    }
+
+    SECTION("Directories are listed from the index")
+    {
+        REQUIRE(Vfs.MountArchive(ArchivePath, 100) != VirtualFileSystem::InvalidMount);
+
+        std::vector<std::string> Files;
+        std::vector<std::string> Dirs;
+        Vfs.ListDirectory("", Files, Dirs);
+        REQUIRE(Files == std::vector<std::string>{ "LooseOnly.txt", "Shared.txt" });
+        REQUIRE(Dirs == std::vector<std::string>{ "Models" });
+
+        Vfs.ListDirectory("Models", Files, Dirs);
+        REQUIRE(Files == std::vector<std::string>{ "Models/Cube.obj", "Models/Packed.obj" });
+        REQUIRE(Dirs == std::vector<std::string>{ "Models/Old" });
+    }
+
+    SECTION("New loose files are only seen once they are refreshed")
+    {
+        WriteLooseFile("Levels/New.json", "{}");
+        REQUIRE_FALSE(Vfs.Exists("Levels/New.json"));
+        Vfs.RefreshPath("Levels/New.json");
+        REQUIRE(ReadString(Vfs, "Levels/New.json") == "{}");
+
+        fs::remove(fs::path(LooseDir) / "LooseOnly.txt");
+        Vfs.RefreshPath("LooseOnly.txt");
+        REQUIRE_FALSE(Vfs.Exists("LooseOnly.txt"));
+
+        WriteLooseFile("Other.txt", "Other");
+        Vfs.Rescan();
+        REQUIRE(ReadString(Vfs, "Other.txt") == "Other");
+        REQUIRE(Vfs.GetNumFiles() == 5);
+    }
+
+    SECTION("File info comes without reading the file")
+    {
+        VfsFileInfo Info;
+        REQUIRE(Vfs.GetFileInfo(Guid{ "Models/Cube.obj" }, "Models/Cube.obj", Info));
+        REQUIRE(Info.Size == 4);
+        REQUIRE(Info.ModifiedTime != 0);
+        REQUIRE(Info.Hash == 0);
+
+        // Writing the file changes its modified time
+        const uint64 OldTime = Info.ModifiedTime;
+        const fs::path CubePath = fs::path(LooseDir) / "Models/Cube.obj";
+        fs::last_write_time(CubePath, fs::last_write_time(CubePath) + std::chrono::seconds(10));
+        REQUIRE(Vfs.GetFileInfo(Guid{ "Models/Cube.obj" }, "Models/Cube.obj", Info));
+        REQUIRE(Info.ModifiedTime != OldTime);
+
+        // Archives know the hash of their files
+        REQUIRE(Vfs.MountArchive(ArchivePath, 100) != VirtualFileSystem::InvalidMount);
+        REQUIRE(Vfs.GetFileInfo(Guid{ "Models/Packed.obj" }, "Models/Packed.obj", Info));
+        REQUIRE(Info.Size == 12);
+        REQUIRE(Info.ModifiedTime == 0);
+        REQUIRE(Info.Hash == HashBytes64("Packed model", 12));
+
+        const VirtualFileSystem::MountId Overlay = Vfs.MountMemory(200);
+        REQUIRE(Vfs.WriteMemoryFile(Overlay, "Memory.txt", "Memory", 6));
+        REQUIRE(Vfs.GetFileInfo(Guid{ "Memory.txt" }, "Memory.txt", Info));
+        REQUIRE(Info.Size == 6);
+        REQUIRE(Info.ModifiedTime == 0);
+
+        REQUIRE_FALSE(Vfs.GetFileInfo(Guid{ "Missing.txt" }, "Missing.txt", Info));
+    }
+
+    SECTION("Prefetched loose files are read once from memory")
+    {
+        REQUIRE(Vfs.MountArchive(ArchivePath, 100) != VirtualFileSystem::InvalidMount);
+
+        // Packed and missing files are skipped
+        REQUIRE(Vfs.Prefetch({ "LooseOnly.txt", "Models/Cube.obj", "Models/Packed.obj", "Missing.txt", "LooseOnly.txt" }) == 2);
+        REQUIRE(Vfs.GetNumPrefetched() == 2);
+
+        AssetData Data;
+        REQUIRE(Vfs.Read("LooseOnly.txt", Data));
+        REQUIRE(Data.GetView() == "Loose only");
+        REQUIRE(Vfs.GetNumPrefetched() == 1);
+
+        // Only handed out once, after that it comes off the disk again
+        REQUIRE(ReadString(Vfs, "LooseOnly.txt") == "Loose only");
+
+        // A file that changed isn't served stale
+        WriteLooseFile("Models/Cube.obj", "New cube");
+        Vfs.RefreshPath("Models/Cube.obj");
+        REQUIRE(Vfs.GetNumPrefetched() == 0);
+        REQUIRE(ReadString(Vfs, "Models/Cube.obj") == "New cube");
+
+        REQUIRE(Vfs.Prefetch({ "Shared.txt", "Models/Cube.obj" }) == 1);
+        Vfs.ClearPrefetched();
+        REQUIRE(Vfs.GetNumPrefetched() == 0);
+
+        // The reader is kept between batches, and made again when the backend changes
+        Vfs.SetReadBackend(FileReadBackend::ThreadPool);
+        REQUIRE(Vfs.Prefetch({ "LooseOnly.txt", "Models/Cube.obj" }) == 2);
+        REQUIRE(Vfs.Prefetch({ "LooseOnly.txt" }) == 1);
+        REQUIRE(ReadString(Vfs, "Models/Cube.obj") == "New cube");
+        Vfs.ClearPrefetched();
+    }
+
+    Vfs.UnmountAll();
+    REQUIRE(Vfs.GetNumFiles() == 0);
+    fs::remove_all(LooseDir);
+    std::remove(ArchivePath.c_str());
+    Logger::Get().Shutdown();
+}
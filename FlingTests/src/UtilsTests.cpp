@@ -10,8 +10,27 @@
 #include "Logger.h"
 #include "FreeList.h"
 #include "StackAllocator.h"
+#include "FrameAllocator.h"
+#include "VirtualArena.h"
+#include "MappedFile.h"
+#include "BatchFileReader.h"
+#include "JobSystem.h"
+#include "Misc/CommandLine.h"
+#include "Hash.h"
+#include "Compression.h"
+#include "Profiler.h"
+#include "Histogram.h"
+#include "Stats.h"
+#include "FixedTimestep.h"
 #include "Memory.h"
 #include "CircularBuffer.hpp"
+#include "PoolAllocator.hpp"
+#include "ConcurrentPoolAllocator.hpp"
+
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
 
 TEST_CASE("Timing", "[utils]")
 {
@@ -79,6 +98,121 @@ TEST_CASE("Free List", "[utils]")
 	freelist.Return(obj0);
 }
 
+TEST_CASE("Pool Allocator", "[utils]")
+{
+	using namespace Fling;
+
+	struct alignas(16) TestObj
+	{
+		TestObj(int32 t_Val) : Val(t_Val) {}
+		int32 Val = 0;
+		char Padding[20] = {};
+	};
+
+	SECTION("Grows on demand")
+	{
+		PoolAllocator<TestObj, 4> Pool;
+		REQUIRE(Pool.GetCapacity() == 0);
+
+		std::vector<TestObj*> Objs;
+		for (int32 i = 0; i < 10; ++i)
+		{
+			TestObj* Obj = Pool.New(i);
+			REQUIRE(Obj != nullptr);
+			REQUIRE(reinterpret_cast<uintptr_t>(Obj) % alignof(TestObj) == 0);
+			Objs.push_back(Obj);
+		}
+
+		REQUIRE(Pool.GetCapacity() == 12);
+		REQUIRE(Pool.GetNumAllocated() == 10);
+
+		for (int32 i = 0; i < 10; ++i)
+		{
+			REQUIRE(Objs[i]->Val == i);
+			Pool.Delete(Objs[i]);
+		}
+		REQUIRE(Pool.GetNumAllocated() == 0);
+	}
+
+	SECTION("Reuses freed memory")
+	{
+		PoolAllocator<TestObj, 4> Pool;
+		TestObj* First = Pool.New(1);
+		Pool.Delete(First);
+
+		TestObj* Second = Pool.New(2);
+		REQUIRE(First == Second);
+		REQUIRE(Pool.GetCapacity() == 4);
+		Pool.Delete(Second);
+	}
+}
+
+TEST_CASE("Concurrent Pool Allocator", "[utils]")
+{
+	using namespace Fling;
+
+	SECTION("Single thread")
+	{
+		ConcurrentPoolAllocator<int64, 8> Pool;
+		int64* A = Pool.New(7);
+		int64* B = Pool.New(8);
+		REQUIRE(A != B);
+		REQUIRE(*A == 7);
+		REQUIRE(*B == 8);
+
+		Pool.Delete(A);
+		REQUIRE(Pool.New(9) == A);
+
+		Pool.Delete(A);
+		Pool.Delete(B);
+		REQUIRE(Pool.GetNumAllocated() == 0);
+	}
+
+	SECTION("Many threads")
+	{
+		ConcurrentPoolAllocator<int64, 16> Pool;
+		constexpr int64 NumThreads = 4;
+		constexpr int64 NumIterations = 2000;
+
+		std::atomic<bool> bFailed { false };
+		std::vector<std::thread> Threads;
+		for (int64 t = 0; t < NumThreads; ++t)
+		{
+			Threads.emplace_back([&Pool, &bFailed, t]()
+			{
+				std::vector<int64*> Mine;
+				for (int64 i = 0; i < NumIterations; ++i)
+				{
+					Mine.push_back(Pool.New(t * NumIterations + i));
+					if (i % 3 == 0)
+					{
+						Pool.Delete(Mine.front());
+						Mine.erase(Mine.begin());
+					}
+				}
+
+				// Nobody else should have been handed our memory
+				for (int64* Val : Mine)
+				{
+					if (*Val / NumIterations != t)
+					{
+						bFailed = true;
+					}
+					Pool.Delete(Val);
+				}
+			});
+		}
+
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+
+		REQUIRE_FALSE(bFailed);
+		REQUIRE(Pool.GetNumAllocated() == 0);
+	}
+}
+
 TEST_CASE("Stack Allocator", "[utils]")
 {
     using namespace Fling;
@@ -86,8 +220,760 @@ TEST_CASE("Stack Allocator", "[utils]")
     char buf[1024] = {};
 
     StackAllocator stackAllocator(buf, buf + 1024);
-    // @TODO The stack allocator is broken and it seems to be rooted in 
-    // the AlignPointer method on linux. That's a relatively large problem
+    REQUIRE(stackAllocator.GetCapacity() == 1024);
+
+    SECTION("Allocations are aligned and inside the buffer")
+    {
+        void* a = stackAllocator.Allocate(10);
+        void* b = stackAllocator.Allocate(32, 16);
+        REQUIRE(a != nullptr);
+        REQUIRE(b != nullptr);
+        REQUIRE(reinterpret_cast<uintptr_t>(a) % 8 == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(b) % 16 == 0);
+        REQUIRE(static_cast<char*>(a) >= buf);
+        REQUIRE(static_cast<char*>(b) + 32 <= buf + 1024);
+        REQUIRE(b > a);
+
+        // Freeing in LIFO order gives the memory back
+        stackAllocator.Free(b);
+        REQUIRE(stackAllocator.Allocate(32, 16) == b);
+    }
+
+    SECTION("Out of memory")
+    {
+        REQUIRE(stackAllocator.Allocate(2048) == nullptr);
+        REQUIRE(stackAllocator.GetUsedSize() == 0);
+
+        REQUIRE(stackAllocator.Allocate(512) != nullptr);
+        REQUIRE(stackAllocator.Allocate(512) == nullptr);
+    }
+
+    SECTION("Reset")
+    {
+        void* a = stackAllocator.Allocate(100);
+        stackAllocator.Allocate(100);
+        REQUIRE(stackAllocator.GetUsedSize() > 200);
+
+        stackAllocator.Reset();
+        REQUIRE(stackAllocator.GetUsedSize() == 0);
+        REQUIRE(stackAllocator.Allocate(100) == a);
+    }
+}
+
+TEST_CASE("Frame Allocator", "[utils]")
+{
+    using namespace Fling;
+
+    Logger::Get().Init();
+    FrameAllocator& FrameAlloc = FrameAllocator::Get();
+    FrameAlloc.Init();
+
+    SECTION("Scratch vectors use frame memory")
+    {
+        ScratchVector<int32> Scratch;
+        for (int32 i = 0; i < 100; ++i)
+        {
+            Scratch.push_back(i);
+        }
+
+        REQUIRE(FrameAlloc.Owns(Scratch.data()));
+        REQUIRE(FrameAlloc.GetCurrentFrameUsage() >= 100 * sizeof(int32));
+        REQUIRE(FrameAlloc.GetHeapFallbackCount() == 0);
+    }
+
+    SECTION("Frames are double buffered")
+    {
+        void* FirstFrame = FrameAlloc.Allocate(64);
+        FrameAlloc.BeginFrame();
+        REQUIRE(FrameAlloc.GetCurrentFrameUsage() == 0);
+
+        void* SecondFrame = FrameAlloc.Allocate(64);
+        REQUIRE(SecondFrame != FirstFrame);
+
+        // Coming back around to the first frame resets it
+        FrameAlloc.BeginFrame();
+        REQUIRE(FrameAlloc.Allocate(64) == FirstFrame);
+    }
+
+    SECTION("Allocating from many threads at once")
+    {
+        static constexpr size_t NumThreads = 4;
+        static constexpr size_t NumAllocs = 2000;
+        std::vector<std::vector<uint64*>> Allocs(NumThreads);
+
+        std::vector<std::thread> Threads;
+        for (size_t t = 0; t < NumThreads; ++t)
+        {
+            Threads.emplace_back([&, t]()
+            {
+                for (size_t i = 0; i < NumAllocs; ++i)
+                {
+                    uint64* Mem = static_cast<uint64*>(FrameAlloc.Allocate(sizeof(uint64) * 4, 32));
+                    for (size_t j = 0; j < 4; ++j)
+                    {
+                        Mem[j] = t * NumAllocs + i;
+                    }
+                    Allocs[t].push_back(Mem);
+                }
+            });
+        }
+        for (std::thread& Thread : Threads)
+        {
+            Thread.join();
+        }
+
+        // Nothing overlapped, so nobody wrote over anyone else
+        for (size_t t = 0; t < NumThreads; ++t)
+        {
+            for (size_t i = 0; i < NumAllocs; ++i)
+            {
+                uint64* Mem = Allocs[t][i];
+                REQUIRE(reinterpret_cast<uintptr_t>(Mem) % 32 == 0);
+                REQUIRE(FrameAlloc.Owns(Mem));
+                for (size_t j = 0; j < 4; ++j)
+                {
+                    REQUIRE(Mem[j] == t * NumAllocs + i);
+                }
+            }
+        }
+        REQUIRE(FrameAlloc.GetCurrentFrameUsage() >= NumThreads * NumAllocs * sizeof(uint64) * 4);
+        REQUIRE(FrameAlloc.GetHeapFallbackCount() == 0);
+    }
+
+    SECTION("Falls back to the heap when full")
+    {
+        void* Big = FrameAlloc.Allocate(FrameAllocator::DefaultFrameSize * 2);
+        REQUIRE(Big != nullptr);
+        REQUIRE_FALSE(FrameAlloc.Owns(Big));
+        REQUIRE(FrameAlloc.GetHeapFallbackCount() == 1);
+        FrameAlloc.Free(Big);
+    }
+
+    FrameAlloc.Shutdown();
+}
+
+TEST_CASE("Virtual Arena", "[utils]")
+{
+    using namespace Fling;
+
+    Logger::Get().Init();
+
+    // Reserve way more than we will ever touch, this should only cost address space
+    VirtualArena Arena(size_t(1) << 30);
+    REQUIRE(Arena.IsValid());
+    REQUIRE(Arena.GetReservedSize() >= (size_t(1) << 30));
+    REQUIRE(Arena.GetCommittedSize() == 0);
+
+    SECTION("Allocate and align")
+    {
+        char* a = static_cast<char*>(Arena.Allocate(3));
+        REQUIRE(a != nullptr);
+
+        void* b = Arena.Allocate(16, 64);
+        REQUIRE(b != nullptr);
+        REQUIRE(reinterpret_cast<size_t>(b) % 64 == 0);
+
+        // Committed memory has to be writable
+        memset(a, 0xFF, 3);
+        memset(b, 0xFF, 16);
+        REQUIRE(Arena.GetCommittedSize() >= Arena.GetUsedSize());
+    }
+
+    SECTION("Commits more as it grows")
+    {
+        Arena.Allocate(16);
+        const size_t FirstCommit = Arena.GetCommittedSize();
+        REQUIRE(FirstCommit > 0);
+
+        char* Big = static_cast<char*>(Arena.Allocate(FirstCommit * 4));
+        REQUIRE(Big != nullptr);
+        Big[FirstCommit * 4 - 1] = 1;
+        REQUIRE(Arena.GetCommittedSize() > FirstCommit);
+    }
+
+    SECTION("Markers and scopes rewind")
+    {
+        void* a = Arena.Allocate(128);
+        VirtualArena::Marker Mark = Arena.GetMarker();
+
+        void* b = Arena.Allocate(256);
+        Arena.Rewind(Mark);
+        REQUIRE(Arena.GetUsedSize() == Mark.m_Offset);
+        REQUIRE(Arena.Allocate(256) == b);
+
+        {
+            VirtualArena::Scope Scope(Arena);
+            Arena.Allocate(1024);
+        }
+        REQUIRE(Arena.GetUsedSize() == Mark.m_Offset + 256);
+
+        Arena.Reset();
+        REQUIRE(Arena.GetUsedSize() == 0);
+        REQUIRE(Arena.Allocate(128) == a);
+    }
+
+    SECTION("Decommit gives memory back")
+    {
+        Arena.Allocate(4 * 1024 * 1024);
+        REQUIRE(Arena.GetCommittedSize() >= 4 * 1024 * 1024);
+
+        Arena.Reset();
+        Arena.Decommit();
+        REQUIRE(Arena.GetCommittedSize() == 0);
+
+        // Can still use it afterwards
+        char* a = static_cast<char*>(Arena.Allocate(64));
+        REQUIRE(a != nullptr);
+        a[63] = 1;
+    }
+
+    SECTION("Returns null when the reserve is used up")
+    {
+        VirtualArena Small(64 * 1024);
+        REQUIRE(Small.Allocate(Small.GetReservedSize()) != nullptr);
+        REQUIRE(Small.Allocate(1) == nullptr);
+    }
+
+    SECTION("Arena vectors")
+    {
+        ArenaVector<uint32> Vec { ArenaStlAllocator<uint32>(Arena) };
+        for (uint32 i = 0; i < 10000; ++i)
+        {
+            Vec.push_back(i);
+        }
+
+        REQUIRE(Vec[9999] == 9999);
+        REQUIRE(Arena.GetUsedSize() >= 10000 * sizeof(uint32));
+    }
+}
+
+TEST_CASE("Mapped File", "[utils]")
+{
+    using namespace Fling;
+
+    const std::string FilePath = "MappedFileTest.txt";
+    const std::string EmptyPath = "MappedFileTestEmpty.txt";
+
+    std::string Contents;
+    for (int i = 0; i < 5000; ++i)
+    {
+        Contents += "Line " + std::to_string(i) + "\n";
+    }
+    {
+        std::ofstream Out(FilePath, std::ios::binary);
+        Out << Contents;
+        std::ofstream Empty(EmptyPath, std::ios::binary);
+    }
+
+    SECTION("Maps the whole file")
+    {
+        MappedFile File(FilePath, MappedFileAccess::WillNeed);
+        REQUIRE(File.IsOpen());
+        REQUIRE(File.GetSize() == Contents.size());
+        REQUIRE(File.GetView() == Contents);
+
+        // Page aligned, so it can be read as words
+        REQUIRE(reinterpret_cast<uintptr_t>(File.GetData()) % 4096 == 0);
+    }
+
+    SECTION("Moving hands the mapping over")
+    {
+        MappedFile File(FilePath);
+        const char* Data = File.GetData();
+
+        MappedFile Moved(std::move(File));
+        REQUIRE_FALSE(File.IsOpen());
+        REQUIRE(File.GetData() == nullptr);
+        REQUIRE(Moved.GetData() == Data);
+
+        Moved.Close();
+        REQUIRE_FALSE(Moved.IsOpen());
+        REQUIRE(Moved.GetSize() == 0);
+    }
+
+    SECTION("Empty and missing files")
+    {
+        MappedFile Empty(EmptyPath);
+        REQUIRE(Empty.IsOpen());
+        REQUIRE(Empty.GetSize() == 0);
+        REQUIRE(Empty.GetView().empty());
+
+        MappedFile Missing;
+        REQUIRE_FALSE(Missing.Open("ThisFileDoesNotExist.txt"));
+        REQUIRE_FALSE(Missing.IsOpen());
+    }
+
+    std::remove(FilePath.c_str());
+    std::remove(EmptyPath.c_str());
+}
+
+TEST_CASE("Batch File Reader", "[utils]")
+{
+    using namespace Fling;
+    Logger::Get().Init();
+
+    // More files than fit in the queue at once, and sizes on both sides of a block
+    std::vector<std::string> Paths;
+    std::vector<std::string> Contents;
+    for (int i = 0; i < 40; ++i)
+    {
+        std::string Text;
+        const int Length = (i * 1031) % 9000;
+        for (int c = 0; c < Length; ++c)
+        {
+            Text += static_cast<char>('a' + (i + c) % 26);
+        }
+        Paths.push_back("BatchReadTest_" + std::to_string(i) + ".txt");
+        Contents.push_back(Text);
+
+        std::ofstream Out(Paths.back(), std::ios::binary);
+        Out << Text;
+    }
+
+    for (FileReadBackend Backend : { FileReadBackend::Auto, FileReadBackend::IoUring, FileReadBackend::ThreadPool })
+    {
+        BatchFileReader Reader(Backend, 8);
+        REQUIRE(Reader.GetBackend() != FileReadBackend::Auto);
+        if (Backend == FileReadBackend::ThreadPool)
+        {
+            REQUIRE(Reader.GetBackend() == FileReadBackend::ThreadPool);
+        }
+
+        for (const std::string& Path : Paths)
+        {
+            Reader.Add(Path);
+        }
+        const size_t Missing = Reader.Add("BatchReadTestThatDoesNotExist.txt");
+        REQUIRE(Reader.ReadAll() == Paths.size());
+
+        for (size_t i = 0; i < Paths.size(); ++i)
+        {
+            const BatchFileReader::Result& Result = Reader.GetResult(i);
+            REQUIRE(Result.bSuccess);
+            REQUIRE(Result.Size == Contents[i].size());
+            REQUIRE(reinterpret_cast<uintptr_t>(Result.Data) % BatchFileReader::DirectIOAlignment == 0);
+            REQUIRE(std::string(Result.Data, static_cast<size_t>(Result.Size)) == Contents[i]);
+        }
+        REQUIRE_FALSE(Reader.GetResult(Missing).bSuccess);
+
+        // Buffers that are taken outlive the reader's
+        std::shared_ptr<char> Taken = Reader.TakeBuffer(3);
+        REQUIRE(Taken.get() == Reader.GetResult(3).Data);
+
+        // Straight into a buffer of our own, only what was added since the last ReadAll is read
+        const size_t BufferSize = BatchFileReader::GetBufferSize(Contents[7].size());
+        void* Dest = AlignedAlloc(BufferSize, BatchFileReader::DirectIOAlignment);
+        const size_t Into = Reader.Add(Paths[7], Dest, BufferSize);
+        const size_t TooSmall = Reader.Add(Paths[7], Dest, BufferSize - BatchFileReader::DirectIOAlignment);
+        REQUIRE(Reader.ReadAll() == 1);
+        REQUIRE(Reader.GetResult(Into).Data == Dest);
+        REQUIRE(std::string(static_cast<const char*>(Dest), Contents[7].size()) == Contents[7]);
+        REQUIRE(Reader.TakeBuffer(Into) == nullptr);
+        REQUIRE_FALSE(Reader.GetResult(TooSmall).bSuccess);
+        AlignedFree(Dest);
+
+        Reader.Clear();
+        REQUIRE(Reader.GetNumReads() == 0);
+        REQUIRE(std::string(Taken.get(), Contents[3].size()) == Contents[3]);
+    }
+
+    // Blocking reads are shared out over the job system when it is running
+    {
+        REQUIRE(CommandLine::Get().LoadConfigVarsFromString("[ConsoleVariables]\nJobWorkerCount=3\n"));
+        JobSystem::Get().Init();
+
+        BatchFileReader Reader(FileReadBackend::ThreadPool);
+        for (const std::string& Path : Paths)
+        {
+            Reader.Add(Path);
+        }
+        REQUIRE(Reader.ReadAll() == Paths.size());
+        for (size_t i = 0; i < Paths.size(); ++i)
+        {
+            REQUIRE(std::string(Reader.GetResult(i).Data, static_cast<size_t>(Reader.GetResult(i).Size)) == Contents[i]);
+        }
+
+        JobSystem::Get().Shutdown();
+    }
+
+    for (const std::string& Path : Paths)
+    {
+        std::remove(Path.c_str());
+    }
+    Logger::Get().Shutdown();
+}
+
+TEST_CASE("Hash", "[utils]")
+{
+    using namespace Fling;
+
+    SECTION("Matches xxHash64")
+    {
+        REQUIRE(HashBytes64(nullptr, 0) == 0xEF46DB3751D8E999ull);
+    }
+
+    SECTION("Every byte changes the hash")
+    {
+        std::vector<char> Data(1000);
+        for (size_t i = 0; i < Data.size(); ++i)
+        {
+            Data[i] = static_cast<char>(i * 31);
+        }
+
+        const uint64 Original = HashBytes64(Data.data(), Data.size());
+        REQUIRE(HashBytes64(Data.data(), Data.size()) == Original);
+        REQUIRE(HashBytes64(Data.data(), Data.size(), 1) != Original);
+
+        // Hit the 32 byte stripes, the 8 and 4 byte tails and the last few single bytes
+        for (size_t i : { size_t(0), size_t(17), size_t(500), size_t(990), size_t(999) })
+        {
+            Data[i] ^= 1;
+            REQUIRE(HashBytes64(Data.data(), Data.size()) != Original);
+            Data[i] ^= 1;
+        }
+    }
+}
+
+TEST_CASE("Compression", "[utils]")
+{
+    using namespace Fling;
+
+    const auto RoundTrip = [](const std::vector<char>& t_Data)
+    {
+        std::vector<char> Compressed(Compression::GetMaxCompressedSize(t_Data.size()));
+        const size_t CompressedSize = Compression::Compress(t_Data.data(), t_Data.size(), Compressed.data(), Compressed.size());
+        REQUIRE(CompressedSize != 0);
+        Compressed.resize(CompressedSize);
+
+        std::vector<char> Decompressed(t_Data.size());
+        REQUIRE(Compression::Decompress(Compressed.data(), Compressed.size(), Decompressed.data(), Decompressed.size()));
+        REQUIRE(Decompressed == t_Data);
+        return Compressed;
+    };
+
+    SECTION("Repetitive data gets smaller")
+    {
+        std::string Text;
+        for (int i = 0; i < 2000; ++i)
+        {
+            Text += "v " + std::to_string(i % 37) + ".0 1.0 -1.0\n";
+        }
+        const std::vector<char> Data(Text.begin(), Text.end());
+        REQUIRE(RoundTrip(Data).size() < Data.size() / 4);
+
+        // Long runs make overlapping matches
+        REQUIRE(RoundTrip(std::vector<char>(100000, 'a')).size() < 1000);
+    }
+
+    SECTION("Random data still round trips")
+    {
+        std::mt19937 Rng(1234);
+        std::vector<char> Data(70000);
+        for (char& Byte : Data)
+        {
+            Byte = static_cast<char>(Rng());
+        }
+        REQUIRE(RoundTrip(Data).size() <= Compression::GetMaxCompressedSize(Data.size()));
+    }
+
+    SECTION("Tiny inputs")
+    {
+        RoundTrip({});
+        RoundTrip({ 'a' });
+        RoundTrip({ 'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c' });
+    }
+
+    SECTION("Corrupt data fails instead of overrunning")
+    {
+        std::vector<char> Data(5000);
+        for (size_t i = 0; i < Data.size(); ++i)
+        {
+            Data[i] = static_cast<char>(i % 13);
+        }
+        std::vector<char> Compressed = RoundTrip(Data);
+        std::vector<char> Out(Data.size());
+
+        // Too short, too long, and cut off
+        REQUIRE_FALSE(Compression::Decompress(Compressed.data(), Compressed.size(), Out.data(), Out.size() - 1));
+        std::vector<char> Bigger(Data.size() + 1);
+        REQUIRE_FALSE(Compression::Decompress(Compressed.data(), Compressed.size(), Bigger.data(), Bigger.size()));
+        REQUIRE_FALSE(Compression::Decompress(Compressed.data(), Compressed.size() / 2, Out.data(), Out.size()));
+
+        // An offset that points before the start of the output
+        const char BadOffset[] = { 0x10, 'a', 0x10, 0x00 };
+        REQUIRE_FALSE(Compression::Decompress(BadOffset, sizeof(BadOffset), Out.data(), 8));
+    }
+
+    SECTION("Too small an output buffer")
+    {
+        std::vector<char> Data(1000, 'x');
+        std::vector<char> Compressed(4);
+        REQUIRE(Compression::Compress(Data.data(), Data.size(), Compressed.data(), Compressed.size()) == 0);
+    }
+}
+
+TEST_CASE("Profiler", "[utils]")
+{
+    using namespace Fling;
+
+    Logger::Get().Init();
+    Profiler& Prof = Profiler::Get();
+    const std::string TracePath = "ProfilerTestTrace.json";
+
+    SECTION("Zones are only recorded while capturing")
+    {
+        {
+            FLING_PROFILE_SCOPE("Not Captured");
+        }
+
+        Prof.BeginCapture(1, TracePath);
+        Prof.BeginFrame();
+        REQUIRE(Prof.GetNumCapturedZones() == 0);
+        Prof.EndCapture();
+        REQUIRE_FALSE(Prof.IsCapturing());
+    }
+
+    SECTION("Naming a thread doesn't give it a zone buffer")
+    {
+        Prof.BeginCapture(1, TracePath);
+        Prof.BeginFrame();
+        const size_t NumBuffers = Prof.GetNumThreadBuffers();
+
+        size_t NumBuffersWhileNamed = 0;
+        std::thread Named([&Prof, &NumBuffersWhileNamed]()
+        {
+            Prof.SetThreadName("Named Only");
+            NumBuffersWhileNamed = Prof.GetNumThreadBuffers();
+        });
+        Named.join();
+
+        REQUIRE(NumBuffersWhileNamed == NumBuffers);
+        Prof.EndCapture();
+    }
+
+    SECTION("Captures nested zones from multiple threads")
+    {
+        Prof.BeginCapture(2, TracePath);
+        Prof.SetThreadName("Test \"Main\" Thread");
+
+        {
+            FLING_PROFILE_SCOPE("Outer");
+            {
+                FLING_PROFILE_SCOPE("Inner");
+            }
+        }
+
+        std::thread Other([&Prof]()
+        {
+            Prof.SetThreadName("Test Worker");
+            FLING_PROFILE_SCOPE("Other Thread");
+        });
+        Other.join();
+
+        Prof.BeginFrame();
+        REQUIRE(Prof.GetNumCapturedZones() == 3);
+        REQUIRE(Prof.IsCapturing());
+
+        // The trace is written once enough frames have gone by
+        Prof.BeginFrame();
+        Prof.BeginFrame();
+        REQUIRE_FALSE(Prof.IsCapturing());
+
+        std::ifstream TraceFile(TracePath);
+        REQUIRE(TraceFile.is_open());
+        std::stringstream Trace;
+        Trace << TraceFile.rdbuf();
+
+        const std::string TraceStr = Trace.str();
+        REQUIRE(TraceStr.find("\"traceEvents\"") != std::string::npos);
+        REQUIRE(TraceStr.find("\"Outer\"") != std::string::npos);
+        REQUIRE(TraceStr.find("\"Inner\"") != std::string::npos);
+        REQUIRE(TraceStr.find("\"Other Thread\"") != std::string::npos);
+        REQUIRE(TraceStr.find("Test \\\"Main\\\" Thread") != std::string::npos);
+        REQUIRE(TraceStr.find("\"Test Worker\"") != std::string::npos);
+    }
+
+    std::remove(TracePath.c_str());
+}
+
+TEST_CASE("Histogram", "[utils]")
+{
+    using namespace Fling;
+
+    SECTION("Buckets keep a few percent of precision")
+    {
+        for (uint64 Value : { uint64(0), uint64(1), uint64(31), uint64(32), uint64(1000), uint64(16667), uint64(123456), Histogram::MaxTrackableValue })
+        {
+            const uint32 Index = Histogram::GetBucketIndex(Value);
+            REQUIRE(Index < Histogram::NumBuckets);
+            REQUIRE(Histogram::GetBucketLowerBound(Index) <= Value);
+            REQUIRE(Histogram::GetBucketUpperBound(Index) >= Value);
+            REQUIRE(Histogram::GetBucketUpperBound(Index) - Histogram::GetBucketLowerBound(Index) <= Value / Histogram::SubBucketCount);
+        }
+
+        // Buckets are contiguous
+        for (uint32 i = 1; i < Histogram::NumBuckets; ++i)
+        {
+            REQUIRE(Histogram::GetBucketLowerBound(i) == Histogram::GetBucketUpperBound(i - 1) + 1);
+        }
+
+        REQUIRE(Histogram::GetBucketIndex(UINT64_MAX) == Histogram::NumBuckets - 1);
+    }
+
+    SECTION("Percentiles")
+    {
+        Histogram Hist;
+        REQUIRE(Hist.GetPercentile(50.0) == 0);
+
+        for (uint64 i = 1; i <= 1000; ++i)
+        {
+            Hist.Record(i);
+        }
+
+        REQUIRE(Hist.GetCount() == 1000);
+        REQUIRE(Hist.GetMin() == 1);
+        REQUIRE(Hist.GetMax() == 1000);
+        REQUIRE(Hist.GetMean() == Catch::Approx(500.5));
+
+        const uint64 P50 = Hist.GetPercentile(50.0);
+        const uint64 P99 = Hist.GetPercentile(99.0);
+        REQUIRE(P50 >= 500);
+        REQUIRE(P50 <= 500 + 500 / Histogram::SubBucketCount);
+        REQUIRE(P99 >= 990);
+        REQUIRE(P99 <= 1000);
+        REQUIRE(Hist.GetPercentile(100.0) == 1000);
+    }
+
+    SECTION("A single hitch shows up in the tail")
+    {
+        Histogram Hist;
+        for (uint32 i = 0; i < 999; ++i)
+        {
+            Hist.Record(16667);
+        }
+        Hist.Record(100000);
+
+        REQUIRE(Hist.GetPercentile(99.0) < 17500);
+        REQUIRE(Hist.GetPercentile(99.95) >= 100000);
+        REQUIRE(Hist.GetMax() == 100000);
+    }
+
+    SECTION("Rolling windows forget old values")
+    {
+        RollingHistogram<2> Rolling;
+        Rolling.Record(10);
+        Rolling.Rotate();
+        Rolling.Record(20);
+        REQUIRE(Rolling.GetCombined().GetCount() == 2);
+        REQUIRE(Rolling.GetCombined().GetMin() == 10);
+
+        Rolling.Rotate();
+        REQUIRE(Rolling.GetCombined().GetCount() == 1);
+        REQUIRE(Rolling.GetCombined().GetMin() == 20);
+        REQUIRE(Rolling.GetCurrentWindow().GetCount() == 0);
+    }
+
+    SECTION("Export")
+    {
+        Histogram Hist;
+        Hist.Record(5);
+        Hist.Record(5);
+        Hist.Record(100);
+
+        std::stringstream Out;
+        Hist.WriteCsv(Out, "Test");
+        REQUIRE(Out.str() == "Test,5,5,2\nTest,100,101,1\n");
+    }
+}
+
+TEST_CASE("Frame Stats", "[utils]")
+{
+    using namespace Fling;
+
+    Stats::Frames::Reset();
+    for (uint32 i = 0; i < 100; ++i)
+    {
+        Stats::Frames::TickStats(1.0f / 100.0f);
+    }
+
+    REQUIRE(Stats::Frames::GetTotalHistogram(Stats::Phase::Frame).GetCount() == 100);
+    REQUIRE(Stats::Frames::GetAverageFrameTime() == Catch::Approx(0.01f).epsilon(0.01));
+    REQUIRE(Stats::Frames::GetAverageFPS() == Catch::Approx(100.0f).epsilon(0.01));
+    REQUIRE(Stats::Frames::GetFrameTimePercentile(99.0) == Catch::Approx(0.01f).epsilon(0.05));
+
+    {
+        Stats::ScopedPhaseTimer Timer(Stats::Phase::World);
+    }
+    REQUIRE(Stats::Frames::GetTotalHistogram(Stats::Phase::World).GetCount() == 1);
+
+    Stats::Frames::Reset();
+    REQUIRE(Stats::Frames::GetTotalHistogram(Stats::Phase::Frame).GetCount() == 0);
+}
+
+TEST_CASE("Draw Stats", "[utils]")
+{
+    using namespace Fling;
+
+    Stats::Draws::Reset();
+    Stats::Draws::RecordFrame(1000, 4000, 10);
+    Stats::Draws::RecordFrame(500, 4000, 12);
+
+    REQUIRE(Stats::Draws::GetLastFrameTriangles() == 500);
+    REQUIRE(Stats::Draws::GetLastFrameFullDetailTriangles() == 4000);
+    REQUIRE(Stats::Draws::GetLastFrameDrawCount() == 12);
+    REQUIRE(Stats::Draws::GetTriangleHistogram().GetCount() == 2);
+    REQUIRE(Stats::Draws::GetTriangleHistogram().GetMax() == 1000);
+
+    Stats::Draws::Reset();
+    REQUIRE(Stats::Draws::GetLastFrameTriangles() == 0);
+    REQUIRE(Stats::Draws::GetTriangleHistogram().GetCount() == 0);
+}
+
+TEST_CASE("Fixed Timestep", "[utils]")
+{
+    using namespace Fling;
+
+    SECTION("Accumulates partial frames")
+    {
+        FixedTimestep Step(50.0f, 5);
+        REQUIRE(Step.GetStepSize() == Catch::Approx(0.02f));
+
+        REQUIRE(Step.Advance(0.01f) == 0);
+        REQUIRE(Step.GetAlpha() == Catch::Approx(0.5f));
+
+        REQUIRE(Step.Advance(0.015f) == 1);
+        REQUIRE(Step.GetAlpha() == Catch::Approx(0.25f).margin(0.0001));
+
+        REQUIRE(Step.Advance(0.04f) == 2);
+        REQUIRE(Step.GetTotalSteps() == 3);
+    }
+
+    SECTION("Renders faster than it simulates")
+    {
+        FixedTimestep Step(30.0f, 5);
+        uint32 TotalSteps = 0;
+        for (uint32 Frame = 0; Frame < 144; ++Frame)
+        {
+            TotalSteps += Step.Advance(1.0f / 144.0f);
+            REQUIRE(Step.GetAlpha() >= 0.0f);
+            REQUIRE(Step.GetAlpha() < 1.0f);
+        }
+
+        // One second worth of frames gives one second worth of steps
+        REQUIRE(TotalSteps >= 29);
+        REQUIRE(TotalSteps <= 30);
+    }
+
+    SECTION("Caps catch up steps")
+    {
+        FixedTimestep Step(60.0f, 4);
+        REQUIRE(Step.Advance(1.0f) == 4);
+        REQUIRE(Step.GetDroppedTime() == Catch::Approx(56.0 / 60.0).margin(0.001));
+        REQUIRE(Step.GetAlpha() < 1.0f);
+
+        // The backlog was thrown out, so the next frame is back to normal
+        REQUIRE(Step.Advance(1.0f / 60.0f) <= 1);
+    }
 }
 
 TEST_CASE("Aligned Alloc", "[utils]")
@@ -13,6 +13,7 @@
 #include "GeometrySubpass.h"
 #include "Mover.h"
 #include "ComponentTypeRegistry.h"
+#include "JobSystem.h"
 
 // Test command line args
 #include "Misc/CommandLine.h"
@@ -21,6 +22,9 @@ namespace Sandbox
 {
     using namespace Fling;
 
+    /** How many entities each job will update */
+    static constexpr uint32 UpdateChunkSize = 64;
+
     void Game::Init(entt::registry& t_Reg)
     {
         // Lets create an entity! 
@@ -65,13 +69,17 @@ namespace Sandbox
 
     void Game::Update(entt::registry& t_Reg, float DeltaTime)
     {
+        JobSystem& Jobs = JobSystem::Get();
+
         if (m_DoRotations)
         {
             glm::vec3 RotOffset(0.0f, 15.0f * DeltaTime, 0.0f);
 
             // For each active mesh renderer
-            t_Reg.view<Transform, Rotator>().each([&](auto ent, Transform& t_Trans, Rotator& t_MeshRend)
+            auto RotateView = t_Reg.view<Transform, Rotator>();
+            Jobs.ParallelForEach(RotateView, UpdateChunkSize, [&](entt::entity t_Ent)
             {
+                Transform& t_Trans = RotateView.get<Transform>(t_Ent);
                 const glm::vec3& curRot = t_Trans.GetRotation();
                 t_Trans.SetRotation(curRot + RotOffset);
             });
@@ -79,8 +87,11 @@ namespace Sandbox
 
         if (m_MovePointLights)
         {
-            t_Reg.view<Transform, Mover>().each([&](auto ent, Transform& t_Trans, Mover& t_Mover)
+            auto MoverView = t_Reg.view<Transform, Mover>();
+            Jobs.ParallelForEach(MoverView, UpdateChunkSize, [&](entt::entity t_Ent)
             {
+                Transform& t_Trans = MoverView.get<Transform>(t_Ent);
+                Mover& t_Mover = MoverView.get<Mover>(t_Ent);
                 glm::vec3 curPos = t_Trans.GetPos();
 
                 glm::vec3 DistanceToTarget = curPos - t_Mover.TargetPos;